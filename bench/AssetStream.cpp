@@ -0,0 +1,218 @@
+/*
+Frame times while res/pumpkin, res/sphere and res/teapot are loaded in the
+middle of a running frame loop. "blocking" parses and uploads all three
+with glBufferData inside one frame, as main.cpp did before streaming;
+"streaming" requests them from App::AssetStreamer and calls update() once
+per frame; "pooled" streams into an App::GeometryPool that starts too
+small, so it is rebuilt while meshes are half uploaded, then reads the pool
+back and fails unless every mesh matches PackMesh. A frame is paced at 60 Hz and timed from its start to glFinish,
+so GPU copies count. Runs once parsing the OBJ text and once from the
+binary cache.
+Usage: bench_asset_stream.out [budget KiB]
+*/
+#include "glad/glad.h"
+#include <GLFW/glfw3.h>
+#include <stdlib.h>
+#include <string.h>
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <vector>
+
+#include "GLFunctions.hpp"
+#include "GLState.hpp"
+#include "AssetStreamer.hpp"
+#include "GeometryPool.hpp"
+#include "Bench.hpp"
+
+static const char* ASSETS[] = { "res/pumpkin", "res/sphere", "res/teapot" };
+static const unsigned int ASSET_COUNT = sizeof(ASSETS) / sizeof(ASSETS[ 0 ]);
+// Frames before the load starts and at least after it.
+static const unsigned int LEAD_FRAMES = 10U;
+static const unsigned int FRAMES = 120U;
+static const double FRAME_SECONDS = 1.0 / 60.0;
+static const unsigned int STREAM_WORKERS = 2U;
+// First pool capacity, far below the three meshes.
+static const unsigned int POOL_VERTICES = 1024U;
+static const unsigned int POOL_INDICES = 3072U;
+
+struct Run {
+    std::vector< double >   frames;         // Seconds per frame from the load on.
+    unsigned int            residentFrame;  // Frames until every asset is drawable.
+    double                  residentTime;
+    App::GeometryPoolStats  pool;           // While every asset is resident, when pooled.
+};
+
+// Stand-in for a frame's own work; glFinish makes the frame time include
+// the GPU side of anything queued during the frame.
+static void EndFrame( void ) {
+    glClear( GL_COLOR_BUFFER_BIT );
+    glFinish();
+}
+
+static void Blocking( const bool in_useCache, Run* out_run ) {
+    std::vector< GLuint > buffers;
+    const Bench::Clock::time_point start = Bench::Clock::now();
+    for( unsigned int frame = 0U; frame < FRAMES; frame += 1U ) {
+        const Bench::Clock::time_point begin = Bench::Clock::now();
+        if( frame == 0U ) {
+            for( unsigned int asset = 0U; asset < ASSET_COUNT; asset += 1U ) {
+                App::MeshBuffer mesh;
+                if( mesh.load( ASSETS[ asset ], in_useCache ) == false )
+                    std::cerr << "Error: Parse error! " << ASSETS[ asset ] << std::endl;
+                GLuint arrays[ 3 ];
+                glGenBuffers( 3, arrays );
+                glBindBuffer( GL_ARRAY_BUFFER, arrays[ 0 ] );
+                glBufferData( GL_ARRAY_BUFFER, sizeof(AVertex) * mesh.vertexCount(), mesh.verticies(), GL_STATIC_DRAW );
+                glBindBuffer( GL_ARRAY_BUFFER, arrays[ 1 ] );
+                glBufferData( GL_ARRAY_BUFFER, sizeof(AColor) * mesh.vertexCount(), mesh.colors(), GL_STATIC_DRAW );
+                glBindBuffer( GL_ARRAY_BUFFER, arrays[ 2 ] );
+                glBufferData( GL_ARRAY_BUFFER, sizeof(AIndex) * mesh.faceCount(), mesh.indicies(), GL_STATIC_DRAW );
+                glBindBuffer( GL_ARRAY_BUFFER, 0U );
+                buffers.insert( buffers.end(), arrays, arrays + 3 );
+            }
+        }
+        EndFrame();
+        const Bench::Clock::time_point end = Bench::Clock::now();
+        out_run->frames.push_back( Bench::Seconds( begin, end ) );
+        if( frame == 0U ) {
+            out_run->residentFrame = 1U;
+            out_run->residentTime = Bench::Seconds( start, end );
+        }
+        std::this_thread::sleep_until( begin + std::chrono::duration_cast< Bench::Clock::duration >(
+            std::chrono::duration< double >( FRAME_SECONDS ) ) );
+    }
+    glDeleteBuffers( (GLsizei)buffers.size(), buffers.data() );
+}
+
+// Read the range of in_mesh back from the pool and compare it with a fresh
+// PackMesh of in_fileName.
+static bool Matches( const App::GeometryPool& in_pool, const App::MeshResource& in_mesh, const char* in_fileName ) {
+    App::MeshBuffer buffer;
+    PackedMesh packed;
+    if( in_mesh.poolMesh == App::GeometryPool::INVALID || buffer.load( in_fileName ) == false )
+        return false;
+    PackMesh( buffer, &packed );
+    const App::PoolMesh& mesh = in_pool.mesh( in_mesh.poolMesh );
+    if( packed.indexSize != in_pool.indexSize() || mesh.vertexCount != packed.verticies.size() )
+        return false;
+    std::vector< char > read( packed.indexBytes() );
+    App::GetGLState().bindBuffer( GL_COPY_READ_BUFFER, in_pool.indexBuffer() );
+    glGetBufferSubData( GL_COPY_READ_BUFFER, (GLintptr)in_pool.indexSize() * mesh.firstIndex, (GLsizeiptr)read.size(),
+        read.data() );
+    bool same = memcmp( read.data(), packed.indexData(), read.size() ) == 0;
+    read.resize( sizeof(PVertex) * mesh.vertexCount );
+    App::GetGLState().bindBuffer( GL_COPY_READ_BUFFER, in_pool.vertexBuffer() );
+    glGetBufferSubData( GL_COPY_READ_BUFFER, (GLintptr)( sizeof(PVertex) * mesh.baseVertex ), (GLsizeiptr)read.size(),
+        read.data() );
+    same = same && memcmp( read.data(), packed.verticies.data(), read.size() ) == 0;
+    read.resize( sizeof(PColor) * mesh.vertexCount );
+    App::GetGLState().bindBuffer( GL_COPY_READ_BUFFER, in_pool.colorBuffer() );
+    glGetBufferSubData( GL_COPY_READ_BUFFER, (GLintptr)( sizeof(PColor) * mesh.baseVertex ), (GLsizeiptr)read.size(),
+        read.data() );
+    same = same && memcmp( read.data(), packed.colors.data(), read.size() ) == 0;
+    return same;
+}
+
+// Returns false when io_pool is given and does not hold every mesh as packed.
+static bool Streaming( const bool in_useCache, const size_t in_budget, App::GeometryPool* io_pool, Run* out_run ) {
+    App::AssetStreamer streamer;
+    if( streamer.create( STREAM_WORKERS, in_budget, io_pool ) == false ) {
+        std::cerr << "Error: Asset streamer creation failed." << std::endl;
+        return false;
+    }
+    const Bench::Clock::time_point start = Bench::Clock::now();
+    for( unsigned int frame = 0U; frame < FRAMES || streamer.busy() == true; frame += 1U ) {
+        const Bench::Clock::time_point begin = Bench::Clock::now();
+        if( frame == 0U ) {
+            for( unsigned int asset = 0U; asset < ASSET_COUNT; asset += 1U )
+                streamer.request( ASSETS[ asset ], in_useCache );
+        }
+        streamer.update();
+        EndFrame();
+        const Bench::Clock::time_point end = Bench::Clock::now();
+        out_run->frames.push_back( Bench::Seconds( begin, end ) );
+        if( out_run->residentFrame == 0U && streamer.busy() == false ) {
+            out_run->residentFrame = frame + 1U;
+            out_run->residentTime = Bench::Seconds( start, end );
+        }
+        std::this_thread::sleep_until( begin + std::chrono::duration_cast< Bench::Clock::duration >(
+            std::chrono::duration< double >( FRAME_SECONDS ) ) );
+    }
+    if( io_pool != NULL )
+        out_run->pool = io_pool->stats();
+    bool same = true;
+    for( unsigned int asset = 0U; asset < ASSET_COUNT; asset += 1U ) {
+        if( streamer.resident( asset ) == false )
+            std::cerr << "Error: " << ASSETS[ asset ] << " is not resident." << std::endl;
+        else if( io_pool != NULL && Matches( *io_pool, streamer.resource( asset ), ASSETS[ asset ] ) == false ) {
+            std::cerr << "Error: " << ASSETS[ asset ] << " differs in the pool." << std::endl;
+            same = false;
+        }
+    }
+    return same;
+}
+
+static void Report( const char* name, const Run& in_run ) {
+    unsigned int missed = 0U;
+    double worst = 0.0;
+    for( size_t frame = 0U; frame < in_run.frames.size(); frame += 1U ) {
+        missed += in_run.frames[ frame ] > FRAME_SECONDS ? 1U : 0U;
+        worst = std::max( worst, in_run.frames[ frame ] );
+    }
+    std::cout << "    " << std::left << std::setw( 10 ) << name << std::right << std::fixed << std::setprecision( 2 )
+        << " p50 " << std::setw( 7 ) << Bench::Percentile( in_run.frames, 50.0 ) * 1e3 << " ms"
+        << "  p99 " << std::setw( 7 ) << Bench::Percentile( in_run.frames, 99.0 ) * 1e3 << " ms"
+        << "  max " << std::setw( 8 ) << worst * 1e3 << " ms"
+        << "  over 16.7 ms " << std::setw( 3 ) << missed
+        << "  resident after " << std::setw( 3 ) << in_run.residentFrame << " frames, "
+        << std::setw( 7 ) << in_run.residentTime * 1e3 << " ms" << std::endl;
+}
+
+int main( int argc, char** argv ) {
+    const size_t budget = ( argc > 1 ? (size_t)atoi( argv[ 1 ] ) : 256U ) * 1024U;
+    if( glfwInit() == GLFW_FALSE )
+        return EXIT_FAILURE;
+    glfwWindowHint( GLFW_CONTEXT_VERSION_MAJOR, 3 );
+    glfwWindowHint( GLFW_CONTEXT_VERSION_MINOR, 2 );
+    glfwWindowHint( GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE );
+    glfwWindowHint( GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE );
+    glfwWindowHint( GLFW_VISIBLE, GLFW_FALSE );
+    GLFWwindow* window = glfwCreateWindow( 64, 64, "bench", NULL, NULL );
+    if( window == NULL ) {
+        glfwTerminate();
+        return EXIT_FAILURE;
+    }
+    glfwMakeContextCurrent( window );
+    gladLoadGLLoader( (GLADloadproc) glfwGetProcAddress );
+    App::LoadGLFunctions( (GLADloadproc) glfwGetProcAddress );
+    for( unsigned int frame = 0U; frame < LEAD_FRAMES; frame += 1U )
+        EndFrame();
+
+    std::cout << "upload budget " << budget / 1024U << " KiB per frame" << std::endl;
+    const bool caches[ 2 ] = { false, true };
+    bool same = true;
+    for( unsigned int pass = 0U; pass < 2U; pass += 1U ) {
+        std::cout << ( caches[ pass ] ? "  binary cache" : "  OBJ parse" ) << std::endl;
+        Run blocking = Run(), streaming = Run(), pooled = Run();
+        Blocking( caches[ pass ], &blocking );
+        Streaming( caches[ pass ], budget, NULL, &streaming );
+        App::GeometryPool pool;
+        if( pool.create( POOL_VERTICES, POOL_INDICES, 2U ) == false ) {
+            std::cerr << "Error: Geometry pool creation failed." << std::endl;
+            return EXIT_FAILURE;
+        }
+        same = Streaming( caches[ pass ], budget, &pool, &pooled ) == true && same == true;
+        const App::GeometryPoolStats& stats = pooled.pool;
+        Report( "blocking", blocking );
+        Report( "streaming", streaming );
+        Report( "pooled", pooled );
+        std::cout << "    pool " << stats.meshes << " meshes, " << stats.verticesUsed << " of " << stats.vertexCapacity
+            << " vertices, " << stats.compactions << " rebuilds" << std::endl;
+        pool.release();
+    }
+
+    glfwDestroyWindow( window );
+    glfwTerminate();
+    return same == true ? EXIT_SUCCESS : EXIT_FAILURE;
+}
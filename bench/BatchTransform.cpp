@@ -0,0 +1,159 @@
+/*
+Model and MVP matrices for N bodies with position, rotation and scale.
+"glm" builds each body as translate * mat4_cast * scale * base and then
+viewProjection * model, one object at a time; the kernels run
+App::BatchTransform over the same bodies as structure of arrays.
+Every kernel is checked against the scalar kernel (bit-identical is
+expected, so the largest difference is reported in ULPs) and against glm
+with a relative tolerance. Exits with failure when a check fails.
+Usage: bench_batch_transform.out [bodies]
+*/
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <cmath>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+
+#include "glm/glm.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+#include "glm/gtc/quaternion.hpp"
+#include "glm/gtc/type_ptr.hpp"
+
+#include "BatchTransform.hpp"
+#include "Bench.hpp"
+
+// glm and the kernels order their operations differently.
+static const float GLM_TOLERANCE = 1e-5f;
+
+struct Bodies {
+    std::vector< float >    arrays[ 10 ];   // Position, rotation, scale.
+    App::TransformSoA       soa;
+};
+
+static void MakeBodies( const unsigned int in_count, Bodies* out_bodies ) {
+    srand( 1U );
+    for( unsigned int array = 0U; array < 10U; array += 1U )
+        out_bodies->arrays[ array ].resize( in_count );
+    for( unsigned int index = 0U; index < in_count; index += 1U ) {
+        float q[ 4 ], length = 0.f;
+        for( unsigned int axis = 0U; axis < 4U; axis += 1U ) {
+            q[ axis ] = rand() / (float)RAND_MAX * 2.f - 1.f;
+            length += q[ axis ] * q[ axis ];
+        }
+        length = std::sqrt( std::max( length, 1e-6f ) );
+        for( unsigned int axis = 0U; axis < 3U; axis += 1U ) {
+            out_bodies->arrays[ axis ][ index ] = rand() / (float)RAND_MAX * 2000.f - 1000.f;
+            out_bodies->arrays[ 7U + axis ][ index ] = 0.5f + rand() / (float)RAND_MAX * 1.5f;
+        }
+        for( unsigned int axis = 0U; axis < 4U; axis += 1U )
+            out_bodies->arrays[ 3U + axis ][ index ] = q[ axis ] / length;
+    }
+    for( unsigned int axis = 0U; axis < 3U; axis += 1U ) {
+        out_bodies->soa.position[ axis ] = &out_bodies->arrays[ axis ][ 0 ];
+        out_bodies->soa.scale[ axis ] = &out_bodies->arrays[ 7U + axis ][ 0 ];
+    }
+    for( unsigned int axis = 0U; axis < 4U; axis += 1U )
+        out_bodies->soa.rotation[ axis ] = &out_bodies->arrays[ 3U + axis ][ 0 ];
+}
+
+// Distance between two floats in units in the last place.
+static uint32_t Ulps( const float a, const float b ) {
+    int32_t ia, ib;
+    memcpy( &ia, &a, sizeof(ia) );
+    memcpy( &ib, &b, sizeof(ib) );
+    if( ia < 0 )
+        ia = (int32_t)( 0x80000000U - (uint32_t)ia );
+    if( ib < 0 )
+        ib = (int32_t)( 0x80000000U - (uint32_t)ib );
+    return ia > ib ? (uint32_t)( ia - ib ) : (uint32_t)( ib - ia );
+}
+
+static uint32_t MaxUlps( const std::vector< float >& a, const std::vector< float >& b ) {
+    uint32_t worst = 0U;
+    for( size_t index = 0U; index < a.size(); index += 1U )
+        worst = std::max( worst, Ulps( a[ index ], b[ index ] ) );
+    return worst;
+}
+
+// Largest |a - b| / ( 1 + |b| ).
+static float MaxRelative( const std::vector< float >& a, const std::vector< float >& b ) {
+    float worst = 0.f;
+    for( size_t index = 0U; index < a.size(); index += 1U )
+        worst = std::max( worst, std::fabs( a[ index ] - b[ index ] ) / ( 1.f + std::fabs( b[ index ] ) ) );
+    return worst;
+}
+
+static void Report( const char* name, const double seconds, const unsigned int count ) {
+    std::cout << "    " << std::left << std::setw( 8 ) << name << std::right << std::fixed << std::setprecision( 2 )
+        << std::setw( 8 ) << seconds * 1e9 / count << " ns/body";
+}
+
+static bool Run( const unsigned int in_count ) {
+    Bodies bodies;
+    MakeBodies( in_count, &bodies );
+    const glm::mat4 base = glm::rotate( glm::mat4( 1.f ), glm::radians( -90.f ), glm::vec3( 1.f, 0.f, 0.f ) )
+        * glm::scale( glm::mat4( 1.f ), glm::vec3( 0.2f, 0.2f, 0.2f ) )
+        * glm::translate( glm::mat4( 1.f ), glm::vec3( 0.f, 0.f, 100.f ) );
+    const glm::mat4 viewProjection = glm::perspective( glm::radians( 45.f ), 4.f / 3.f, 0.1f, 2000.f )
+        * glm::lookAt( glm::vec3( 0.f, 65.f, 30.f ), glm::vec3( 0.f, 50.f, 0.f ), glm::vec3( 0.f, 1.f, 0.f ) );
+    std::cout << in_count << " bodies" << std::endl;
+
+    std::vector< float > glmModels( 16U * in_count ), glmMvps( 16U * in_count );
+    const double glmTime = Bench::BestOf( 5U, [ & ]() {
+        for( unsigned int index = 0U; index < in_count; index += 1U ) {
+            const glm::vec3 position( bodies.arrays[ 0 ][ index ], bodies.arrays[ 1 ][ index ], bodies.arrays[ 2 ][ index ] );
+            const glm::quat rotation( bodies.arrays[ 6 ][ index ], bodies.arrays[ 3 ][ index ],
+                bodies.arrays[ 4 ][ index ], bodies.arrays[ 5 ][ index ] );
+            const glm::vec3 scale( bodies.arrays[ 7 ][ index ], bodies.arrays[ 8 ][ index ], bodies.arrays[ 9 ][ index ] );
+            const glm::mat4 model = glm::translate( glm::mat4( 1.f ), position ) * glm::mat4_cast( rotation )
+                * glm::scale( glm::mat4( 1.f ), scale ) * base;
+            const glm::mat4 mvp = viewProjection * model;
+            memcpy( &glmModels[ 16U * index ], glm::value_ptr( model ), sizeof(model) );
+            memcpy( &glmMvps[ 16U * index ], glm::value_ptr( mvp ), sizeof(mvp) );
+        }
+    } );
+    Report( "glm", glmTime, in_count );
+    std::cout << std::endl;
+
+    bool passed = true;
+    std::vector< float > scalarModels, scalarMvps;
+    const App::TransformKernel kernels[ 3 ] = { App::KernelScalar, App::KernelSSE, App::KernelAVX };
+    for( unsigned int kernel = 0U; kernel < 3U; kernel += 1U ) {
+        if( App::TransformKernelSupported( kernels[ kernel ] ) == false )
+            continue;
+        std::vector< float > models( 16U * in_count ), mvps( 16U * in_count );
+        const double time = Bench::BestOf( 5U, [ & ]() {
+            App::BatchTransform( bodies.soa, in_count, glm::value_ptr( base ), glm::value_ptr( viewProjection ),
+                &models[ 0 ], &mvps[ 0 ], 16U * sizeof(float), kernels[ kernel ] );
+        } );
+        if( kernels[ kernel ] == App::KernelScalar ) {
+            scalarModels = models;
+            scalarMvps = mvps;
+        }
+        const uint32_t ulps = std::max( MaxUlps( models, scalarModels ), MaxUlps( mvps, scalarMvps ) );
+        const float relative = std::max( MaxRelative( models, glmModels ), MaxRelative( mvps, glmMvps ) );
+        const bool ok = ulps == 0U && relative <= GLM_TOLERANCE;
+        passed = passed && ok;
+        Report( App::TransformKernelName( kernels[ kernel ] ), time, in_count );
+        std::cout << std::setw( 7 ) << glmTime / time << "x  vs scalar " << ulps << " ulp, vs glm "
+            << std::scientific << std::setprecision( 1 ) << relative << std::fixed
+            << ( ok ? "" : "  FAILED" ) << std::endl;
+    }
+    return passed;
+}
+
+int main( int argc, char** argv ) {
+    std::cout << "best kernel " << App::TransformKernelName( App::BestTransformKernel() ) << std::endl;
+    bool passed = true;
+    if( argc > 1 ) {
+        passed = Run( (unsigned int)atoi( argv[ 1 ] ) );
+    } else {
+        // Odd counts leave a scalar tail after the SIMD steps.
+        const unsigned int counts[ 3 ] = { 1003U, 10000U, 100007U };
+        for( unsigned int count = 0U; count < 3U; count += 1U )
+            passed = Run( counts[ count ] ) && passed;
+    }
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,69 @@
+#ifndef __BENCH__
+#define __BENCH__
+
+#include <chrono>
+#include <algorithm>
+#include <vector>
+
+namespace Bench {
+
+typedef std::chrono::steady_clock Clock;
+
+inline double Seconds( const Clock::time_point begin, const Clock::time_point end ) {
+    return std::chrono::duration<double>( end - begin ).count();
+}
+
+// Run func repeat times and return the fastest run in seconds.
+template< typename Func >
+double BestOf( const unsigned int repeat, Func func ) {
+    double best = 0.0;
+    for( unsigned int run = 0U; run < repeat; run += 1U ) {
+        Clock::time_point begin = Clock::now();
+        func();
+        double elapsed = Seconds( begin, Clock::now() );
+        if( run == 0U || elapsed < best )
+            best = elapsed;
+    }
+    return best;
+}
+
+// Call func in_warmup times untimed, then time in_samples batches of
+// in_batch calls. Returns the seconds per call of each batch; batching
+// keeps the clock's own cost out of short operations.
+template< typename Func >
+std::vector< double > Sample( const unsigned int in_warmup, const unsigned int in_samples,
+    const unsigned int in_batch, Func func ) {
+    for( unsigned int run = 0U; run < in_warmup; run += 1U )
+        func();
+    std::vector< double > samples( in_samples );
+    for( unsigned int sample = 0U; sample < in_samples; sample += 1U ) {
+        Clock::time_point begin = Clock::now();
+        for( unsigned int run = 0U; run < in_batch; run += 1U )
+            func();
+        samples[ sample ] = Seconds( begin, Clock::now() ) / in_batch;
+    }
+    return samples;
+}
+
+// Nearest-rank percentile, in_percent in [0, 100]. Sorts a copy.
+inline double Percentile( std::vector< double > in_samples, const double in_percent ) {
+    if( in_samples.empty() )
+        return 0.0;
+    std::sort( in_samples.begin(), in_samples.end() );
+    size_t rank = (size_t)( in_percent / 100.0 * ( in_samples.size() - 1U ) + 0.5 );
+    return in_samples[ std::min( rank, in_samples.size() - 1U ) ];
+}
+
+// Median absolute deviation from the median: a spread that a few
+// preempted samples do not inflate.
+inline double MedianAbsoluteDeviation( const std::vector< double >& in_samples ) {
+    const double median = Percentile( in_samples, 50.0 );
+    std::vector< double > deviations( in_samples.size() );
+    for( size_t index = 0U; index < in_samples.size(); index += 1U )
+        deviations[ index ] = in_samples[ index ] > median ? in_samples[ index ] - median : median - in_samples[ index ];
+    return Percentile( deviations, 50.0 );
+}
+
+}
+
+#endif
@@ -0,0 +1,224 @@
+/*
+Pair finding by each broadphase over unit boxes in three distributions:
+"uniform" fills a cube evenly, "clustered" gathers the boxes around
+CLUSTERS centres, "moving" is uniform with every box moving each frame.
+build is creating every proxy plus the first pair update; frame is the
+median of FRAMES frames of setAabb on every box, as a world does for
+awake bodies, then a pair update. pairs is the count after the last one.
+The hash tests exact bounds. The tree fattens leaves that moved and drops
+stale pairs a few at a time, and sweep and prune rounds bounds outwards,
+so their counts can be higher. After the last update the tree's pairs
+whose boxes really overlap are the exact set; the bench fails unless the
+hash holds exactly those pairs, on every distribution.
+Sweep and prune inserts in time linear in the proxies already there, so
+it only runs up to SWEEP_LIMIT boxes.
+Usage: bench_broadphase.out [max objects]
+*/
+#include <stdlib.h>
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <vector>
+
+#include "PhysicsWorld.hpp"
+#include "LinearMath/btAabbUtil2.h"
+#include "Bench.hpp"
+
+static const unsigned int OBJECT_COUNTS[] = { 1000U, 10000U, 50000U, 200000U };
+static const unsigned int FRAMES = 30U;
+static const btScalar HALF_EXTENT = 0.5f;
+// Boxes per unit volume: about 0.8 overlaps each when uniform.
+static const double DENSITY = 0.1;
+static const unsigned int CLUSTERS = 16U;
+static const btScalar SPEED = 5.f;
+static const btScalar TIME_STEP = 1.f / 60.f;
+static const unsigned int SWEEP_LIMIT = 50000U;
+// Most proxies btAxisSweep3 takes.
+static const unsigned int SWEEP16_LIMIT = 32766U;
+
+enum Distribution {
+    DistributionUniform, DistributionClustered, DistributionMoving
+};
+
+struct Boxes {
+    btAlignedObjectArray< btVector3 >   centers;
+    btAlignedObjectArray< btVector3 >   velocities;
+    btScalar                            side;       // Of the cube they stay in.
+};
+
+struct Outcome {
+    double                              build;      // Seconds.
+    double                              frame;      // Median seconds.
+    int                                 pairs;
+    std::vector< unsigned long long >   overlaps;   // Sorted box index pairs, tree and hash only.
+};
+
+static void Generate( const Distribution in_distribution, const unsigned int in_count, Boxes* out_boxes ) {
+    std::mt19937 random( 12345U );
+    const btScalar side = (btScalar)std::cbrt( in_count / DENSITY );
+    std::uniform_real_distribution< btScalar > inside( HALF_EXTENT, side - HALF_EXTENT );
+    std::uniform_real_distribution< btScalar > velocity( -SPEED, SPEED );
+    std::normal_distribution< btScalar > spread( 0.f, side / 12.f );
+    btVector3 centres[ CLUSTERS ];
+    for( unsigned int cluster = 0U; cluster < CLUSTERS; cluster += 1U )
+        centres[ cluster ].setValue( inside( random ), inside( random ), inside( random ) );
+
+    out_boxes->side = side;
+    out_boxes->centers.resize( (int)in_count );
+    out_boxes->velocities.resize( (int)in_count );
+    for( unsigned int index = 0U; index < in_count; index += 1U ) {
+        btVector3& center = out_boxes->centers[ (int)index ];
+        if( in_distribution == DistributionClustered ) {
+            center = centres[ index % CLUSTERS ] + btVector3( spread( random ), spread( random ), spread( random ) );
+            for( int axis = 0; axis < 3; axis += 1 )
+                btClamp( center[ axis ], HALF_EXTENT, side - HALF_EXTENT );
+        } else
+            center.setValue( inside( random ), inside( random ), inside( random ) );
+        if( in_distribution == DistributionMoving )
+            out_boxes->velocities[ (int)index ].setValue( velocity( random ), velocity( random ), velocity( random ) );
+        else
+            out_boxes->velocities[ (int)index ].setValue( 0.f, 0.f, 0.f );
+    }
+}
+
+// Move every box one step, bouncing off the sides of the cube.
+static void Advance( Boxes* io_boxes ) {
+    for( int index = 0; index < io_boxes->centers.size(); index += 1 ) {
+        btVector3& center = io_boxes->centers[ index ];
+        btVector3& velocity = io_boxes->velocities[ index ];
+        center += velocity * TIME_STEP;
+        for( int axis = 0; axis < 3; axis += 1 )
+            if( center[ axis ] < HALF_EXTENT || center[ axis ] > io_boxes->side - HALF_EXTENT ) {
+                velocity[ axis ] = -velocity[ axis ];
+                btClamp( center[ axis ], HALF_EXTENT, io_boxes->side - HALF_EXTENT );
+            }
+    }
+}
+
+// Every pair of in_broadphase as first << 32 | second box index, sorted.
+// With in_exact set, pairs whose boxes do not overlap are left out.
+static void Overlaps( btBroadphaseInterface* in_broadphase, const Boxes& in_boxes, const bool in_exact,
+    std::vector< unsigned long long >* out_pairs ) {
+    const btVector3 half( HALF_EXTENT, HALF_EXTENT, HALF_EXTENT );
+    const btBroadphasePairArray& pairs = in_broadphase->getOverlappingPairCache()->getOverlappingPairArray();
+    out_pairs->clear();
+    out_pairs->reserve( (size_t)pairs.size() );
+    for( int index = 0; index < pairs.size(); index += 1 ) {
+        // Proxies carry their box index plus one.
+        unsigned long long first = (size_t)pairs[ index ].m_pProxy0->m_clientObject - 1U,
+            second = (size_t)pairs[ index ].m_pProxy1->m_clientObject - 1U;
+        if( first > second )
+            std::swap( first, second );
+        const btVector3& a = in_boxes.centers[ (int)first ];
+        const btVector3& b = in_boxes.centers[ (int)second ];
+        if( in_exact == true && TestAabbAgainstAabb2( a - half, a + half, b - half, b + half ) == false )
+            continue;
+        out_pairs->push_back( first << 32 | second );
+    }
+    std::sort( out_pairs->begin(), out_pairs->end() );
+}
+
+static Outcome Run( const App::PhysicsBroadphase in_type, const Boxes& in_boxes ) {
+    Boxes boxes = in_boxes;
+    const int count = boxes.centers.size();
+    App::BroadphaseOptions options;
+    options.type = in_type;
+    for( int axis = 0; axis < 3; axis += 1 ) {
+        options.worldMin[ axis ] = 0.f;
+        options.worldMax[ axis ] = boxes.side;
+    }
+    options.maxProxies = (unsigned int)count + 1U;
+    options.cellSize = 4.f * HALF_EXTENT;    // Twice a box.
+    btDefaultCollisionConfiguration configuration;
+    btCollisionDispatcher dispatcher( &configuration );
+    btBroadphaseInterface* broadphase = App::CreateBroadphase( options );
+    std::vector< btBroadphaseProxy* > proxies( (size_t)count );
+    const btVector3 half( HALF_EXTENT, HALF_EXTENT, HALF_EXTENT );
+
+    Outcome outcome;
+    Bench::Clock::time_point begin = Bench::Clock::now();
+    for( int index = 0; index < count; index += 1 ) {
+        const btVector3& center = boxes.centers[ index ];
+        proxies[ (size_t)index ] = broadphase->createProxy( center - half, center + half, BOX_SHAPE_PROXYTYPE,
+            (void*)( (size_t)index + 1U ), btBroadphaseProxy::DefaultFilter, btBroadphaseProxy::AllFilter, &dispatcher );
+    }
+    broadphase->calculateOverlappingPairs( &dispatcher );
+    outcome.build = Bench::Seconds( begin, Bench::Clock::now() );
+
+    std::vector< double > frames( FRAMES );
+    for( unsigned int frame = 0U; frame < FRAMES; frame += 1U ) {
+        Advance( &boxes );
+        begin = Bench::Clock::now();
+        for( int index = 0; index < count; index += 1 ) {
+            const btVector3& center = boxes.centers[ index ];
+            broadphase->setAabb( proxies[ (size_t)index ], center - half, center + half, &dispatcher );
+        }
+        broadphase->calculateOverlappingPairs( &dispatcher );
+        frames[ frame ] = Bench::Seconds( begin, Bench::Clock::now() );
+    }
+    outcome.frame = Bench::Percentile( frames, 50.0 );
+    outcome.pairs = broadphase->getOverlappingPairCache()->getNumOverlappingPairs();
+    if( in_type == App::BroadphaseTree || in_type == App::BroadphaseHash )
+        Overlaps( broadphase, boxes, in_type == App::BroadphaseTree, &outcome.overlaps );
+
+    // Sweep and prune frees its handles with itself, and removing them one
+    // by one costs as much as adding them.
+    if( in_type == App::BroadphaseTree || in_type == App::BroadphaseHash )
+        for( int index = 0; index < count; index += 1 )
+            broadphase->destroyProxy( proxies[ (size_t)index ], &dispatcher );
+    delete broadphase;
+    return outcome;
+}
+
+int main( int argc, char** argv ) {
+    const unsigned int maxObjects = argc > 1 ? (unsigned int)atoi( argv[ 1 ] ) : OBJECT_COUNTS[ 3 ];
+    const App::PhysicsBroadphase TYPES[] = {
+        App::BroadphaseTree, App::BroadphaseSweep, App::BroadphaseSweep32, App::BroadphaseHash };
+    const char* TYPE_NAMES[] = { "tree", "sweep", "sweep32", "hash" };
+    const char* DISTRIBUTION_NAMES[] = { "uniform", "clustered", "moving" };
+
+    std::cout << std::left << std::setw( 11 ) << "spread" << std::setw( 9 ) << "objects" << std::setw( 9 ) << "phase"
+        << std::right << std::setw( 11 ) << "build ms" << std::setw( 11 ) << "frame ms" << std::setw( 10 ) << "pairs"
+        << std::endl;
+    bool agree = true;
+    for( unsigned int distribution = 0U; distribution < 3U; distribution += 1U ) {
+        for( unsigned int count = 0U; count < sizeof( OBJECT_COUNTS ) / sizeof( OBJECT_COUNTS[ 0 ] ); count += 1U ) {
+            const unsigned int objects = OBJECT_COUNTS[ count ];
+            if( objects > maxObjects )
+                break;
+            Boxes boxes;
+            Generate( (Distribution)distribution, objects, &boxes );
+            std::vector< unsigned long long > exact;
+            for( unsigned int type = 0U; type < 4U; type += 1U ) {
+                std::cout << std::left << std::setw( 11 ) << DISTRIBUTION_NAMES[ distribution ]
+                    << std::setw( 9 ) << objects << std::setw( 9 ) << TYPE_NAMES[ type ] << std::right;
+                const bool sweep = TYPES[ type ] == App::BroadphaseSweep || TYPES[ type ] == App::BroadphaseSweep32;
+                if( ( sweep == true && objects > SWEEP_LIMIT )
+                    || ( TYPES[ type ] == App::BroadphaseSweep && objects > SWEEP16_LIMIT ) ) {
+                    std::cout << std::setw( 11 ) << "-" << std::setw( 11 ) << "-" << std::setw( 10 ) << "-" << std::endl;
+                    continue;
+                }
+                const Outcome outcome = Run( TYPES[ type ], boxes );
+                std::cout << std::fixed << std::setprecision( 2 ) << std::setw( 11 ) << outcome.build * 1e3
+                    << std::setprecision( 3 ) << std::setw( 11 ) << outcome.frame * 1e3
+                    << std::setw( 10 ) << outcome.pairs;
+                if( TYPES[ type ] == App::BroadphaseTree )
+                    exact.swap( outcome.overlaps );
+                else if( TYPES[ type ] == App::BroadphaseHash && outcome.overlaps != exact ) {
+                    std::vector< unsigned long long > missing, extra;
+                    std::set_difference( exact.begin(), exact.end(), outcome.overlaps.begin(), outcome.overlaps.end(),
+                        std::back_inserter( missing ) );
+                    std::set_difference( outcome.overlaps.begin(), outcome.overlaps.end(), exact.begin(), exact.end(),
+                        std::back_inserter( extra ) );
+                    std::cout << "  MISMATCH, " << missing.size() << " overlaps missing, " << extra.size() << " extra";
+                    agree = false;
+                }
+                std::cout << std::endl;
+            }
+        }
+    }
+    return agree == true ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,168 @@
+/*
+Frustum culling of N bounding spheres scattered through a cube around the
+camera, about a tenth of them in view.
+"scalar" is the per-sphere loop DrawList used before, "linear" is
+App::CullSpheres, "tree" culls a prebuilt App::SphereBvh and "tree+refit"
+also refits it after the spheres moved, as DrawList does every frame.
+Each method must find the same visible set as "scalar"; exits with failure
+when one does not.
+Usage: bench_frustum_cull.out [spheres]
+*/
+#include <stdlib.h>
+#include <cmath>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <iterator>
+#include <vector>
+
+#include "FrustumCull.hpp"
+#include "Bench.hpp"
+
+static const unsigned int FRAMES = 50U;
+// Distance between neighbor spheres and their radius.
+static const float SPACING = 20.f;
+static const float RADIUS = 8.f;
+// How far a sphere moves per frame.
+static const float SPEED = 0.5f;
+
+// Camera at the origin looking down -z; normalized, pointing inwards.
+static void Planes( const float in_fovY, const float in_aspect, const float in_near, const float in_far,
+    float out_planes[ 6 ][ 4 ] ) {
+    const float halfY = in_fovY * 0.5f, halfX = std::atan( std::tan( halfY ) * in_aspect );
+    const float planes[ 6 ][ 4 ] = {
+        { std::cos( halfX ), 0.f, -std::sin( halfX ), 0.f },
+        { -std::cos( halfX ), 0.f, -std::sin( halfX ), 0.f },
+        { 0.f, std::cos( halfY ), -std::sin( halfY ), 0.f },
+        { 0.f, -std::cos( halfY ), -std::sin( halfY ), 0.f },
+        { 0.f, 0.f, -1.f, -in_near },
+        { 0.f, 0.f, 1.f, in_far } };
+    for( unsigned int plane = 0U; plane < 6U; plane += 1U )
+        for( unsigned int column = 0U; column < 4U; column += 1U )
+            out_planes[ plane ][ column ] = planes[ plane ][ column ];
+}
+
+static void Scalar( const float in_planes[ 6 ][ 4 ], const std::vector< float >& in_spheres,
+    std::vector< unsigned int >* out_visible ) {
+    out_visible->clear();
+    for( unsigned int index = 0U; index < in_spheres.size() / 4U; index += 1U ) {
+        const float* sphere = &in_spheres[ 4U * index ];
+        bool visible = true;
+        for( unsigned int plane = 0U; visible == true && plane < 6U; plane += 1U )
+            visible = in_planes[ plane ][ 0 ] * sphere[ 0 ] + in_planes[ plane ][ 1 ] * sphere[ 1 ]
+                + in_planes[ plane ][ 2 ] * sphere[ 2 ] + in_planes[ plane ][ 3 ] >= -sphere[ 3 ];
+        if( visible == true )
+            out_visible->push_back( index );
+    }
+}
+
+// Spheres missing from or extra in in_visible.
+static size_t Mismatches( std::vector< unsigned int > in_visible, const std::vector< unsigned int >& in_expected ) {
+    std::sort( in_visible.begin(), in_visible.end() );
+    std::vector< unsigned int > difference;
+    std::set_symmetric_difference( in_visible.begin(), in_visible.end(), in_expected.begin(), in_expected.end(),
+        std::back_inserter( difference ) );
+    return difference.size();
+}
+
+static void Report( const char* in_name, const std::vector< double >& in_times, const unsigned int in_count,
+    const App::CullStats& in_stats, const size_t in_mismatches ) {
+    const double median = Bench::Percentile( in_times, 50.0 );
+    std::cout << "    " << std::left << std::setw( 11 ) << in_name << std::right << std::fixed << std::setprecision( 1 )
+        << std::setw( 9 ) << median * 1e6 << " us " << std::setprecision( 2 ) << std::setw( 6 )
+        << median * 1e9 / in_count << " ns/sphere  nodes " << std::setw( 6 ) << in_stats.nodes
+        << "  tested " << std::setw( 6 ) << in_stats.tested << "  culled " << std::setw( 6 ) << in_stats.culled
+        << "  submitted " << std::setw( 6 ) << in_stats.submitted << ( in_mismatches == 0U ? "" : "  FAILED" )
+        << std::endl;
+}
+
+static bool Run( const unsigned int in_count ) {
+    // Constant density, so the share in view does not depend on in_count.
+    const float side = SPACING * std::cbrt( (float)in_count );
+    srand( 1U );
+    std::vector< float > spheres( 4U * in_count ), velocities( 3U * in_count );
+    for( unsigned int index = 0U; index < in_count; index += 1U ) {
+        for( unsigned int axis = 0U; axis < 3U; axis += 1U ) {
+            spheres[ 4U * index + axis ] = ( rand() / (float)RAND_MAX - 0.5f ) * side;
+            velocities[ 3U * index + axis ] = ( rand() / (float)RAND_MAX - 0.5f ) * 2.f * SPEED;
+        }
+        spheres[ 4U * index + 3U ] = RADIUS;
+    }
+    float planes[ 6 ][ 4 ];
+    Planes( 1.0471976f, 16.f / 9.f, 0.1f, side * 0.5f, planes );
+    std::cout << in_count << " spheres" << std::endl;
+
+    std::vector< unsigned int > expected, visible;
+    std::vector< double > times;
+    App::CullStats stats = { 0U, 0U, 0U, 0U };
+    bool passed = true;
+
+    for( unsigned int frame = 0U; frame < FRAMES; frame += 1U ) {
+        const Bench::Clock::time_point begin = Bench::Clock::now();
+        Scalar( planes, spheres, &expected );
+        times.push_back( Bench::Seconds( begin, Bench::Clock::now() ) );
+    }
+    stats.tested = in_count;
+    stats.submitted = (unsigned int)expected.size();
+    stats.culled = in_count - stats.submitted;
+    Report( "scalar", times, in_count, stats, 0U );
+
+    times.clear();
+    for( unsigned int frame = 0U; frame < FRAMES; frame += 1U ) {
+        visible.clear();
+        const Bench::Clock::time_point begin = Bench::Clock::now();
+        App::CullSpheres( planes, &spheres[ 0 ], in_count, &visible, &stats );
+        times.push_back( Bench::Seconds( begin, Bench::Clock::now() ) );
+    }
+    size_t mismatches = Mismatches( visible, expected );
+    passed = passed && mismatches == 0U;
+    Report( "linear", times, in_count, stats, mismatches );
+
+    App::SphereBvh tree;
+    const Bench::Clock::time_point buildBegin = Bench::Clock::now();
+    tree.build( &spheres[ 0 ], in_count );
+    const double buildTime = Bench::Seconds( buildBegin, Bench::Clock::now() );
+    times.clear();
+    for( unsigned int frame = 0U; frame < FRAMES; frame += 1U ) {
+        visible.clear();
+        const Bench::Clock::time_point begin = Bench::Clock::now();
+        tree.cull( planes, &visible, &stats );
+        times.push_back( Bench::Seconds( begin, Bench::Clock::now() ) );
+    }
+    mismatches = Mismatches( visible, expected );
+    passed = passed && mismatches == 0U;
+    Report( "tree", times, in_count, stats, mismatches );
+
+    // Move every sphere between frames; only the refit and cull are timed.
+    times.clear();
+    mismatches = 0U;
+    for( unsigned int frame = 0U; frame < FRAMES; frame += 1U ) {
+        for( unsigned int index = 0U; index < in_count; index += 1U )
+            for( unsigned int axis = 0U; axis < 3U; axis += 1U )
+                spheres[ 4U * index + axis ] += velocities[ 3U * index + axis ];
+        visible.clear();
+        const Bench::Clock::time_point begin = Bench::Clock::now();
+        tree.update( &spheres[ 0 ], in_count );
+        tree.cull( planes, &visible, &stats );
+        times.push_back( Bench::Seconds( begin, Bench::Clock::now() ) );
+        Scalar( planes, spheres, &expected );
+        mismatches += Mismatches( visible, expected );
+    }
+    passed = passed && mismatches == 0U;
+    Report( "tree+refit", times, in_count, stats, mismatches );
+    std::cout << "    build " << std::setprecision( 2 ) << buildTime * 1e3 << " ms, " << tree.nodeCount()
+        << " nodes, " << tree.rebuilds() << " builds" << std::endl;
+    return passed;
+}
+
+int main( int argc, char** argv ) {
+    bool passed = true;
+    if( argc > 1 ) {
+        passed = Run( (unsigned int)atoi( argv[ 1 ] ) );
+    } else {
+        const unsigned int counts[ 4 ] = { 1000U, 10000U, 30000U, 100000U };
+        for( unsigned int count = 0U; count < 4U; count += 1U )
+            passed = Run( counts[ count ] ) && passed;
+    }
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
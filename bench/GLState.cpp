@@ -0,0 +1,311 @@
+/*
+Driver calls per frame for a scene of N meshes, each drawn as four LOD
+ranges of instanced cubes in wireframe, with the frame structure of
+main.cpp. "direct" calls GL the way main.cpp did before App::GLState: it
+sets every capability each frame, unbinds each buffer after use and resets
+the VAO, polygon mode and capabilities at the end. "cached" states what
+each step needs through App::GLState and restores nothing.
+Reports state calls issued and skipped, the CPU time to submit a frame and
+the frame time up to glFinish. Both must render the same image; exits with
+failure when they do not.
+Usage: bench_gl_state.out [meshes]
+*/
+#include "glad/glad.h"
+#include <GLFW/glfw3.h>
+#include <stdlib.h>
+#include <string.h>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+
+#include "GLFunctions.hpp"
+#include "GLState.hpp"
+#include "Bench.hpp"
+
+static const unsigned int FRAMES = 200U;
+static const unsigned int LOD_COUNT = 4U;
+static const unsigned int INSTANCES_PER_RANGE = 4U;
+static const unsigned int SIZE = 64U;
+
+static const char* VERTEX_SHADER =
+    "#version 150\n"
+    "in vec4 in_position;\n"
+    "in vec4 in_color;\n"
+    "in mat4 in_model;\n"
+    "in vec4 in_instanceColor;\n"
+    "out vec4 o_color;\n"
+    "void main() { gl_Position = in_model * in_position; o_color = in_color * in_instanceColor; }\n";
+static const char* FRAGMENT_SHADER =
+    "#version 150\n"
+    "in vec4 o_color;\n"
+    "out vec4 o_fragColor;\n"
+    "void main() { o_fragColor = o_color; }\n";
+
+struct Mesh {
+    GLuint  vertexBuffer;
+    GLuint  colorBuffer;
+    GLuint  indexBuffer;
+};
+
+struct Scene {
+    GLuint              program;
+    GLuint              vertexArray;
+    GLuint              instanceBuffer;
+    GLuint              positionLoc, colorLoc, modelLoc, instanceColorLoc;
+    std::vector< Mesh > meshes;
+};
+
+struct Counts {
+    unsigned long long  issued;
+    unsigned long long  skipped;
+};
+
+static GLuint Compile( const GLenum in_type, const char* in_source ) {
+    const GLuint shader = glCreateShader( in_type );
+    glShaderSource( shader, 1, &in_source, NULL );
+    glCompileShader( shader );
+    return shader;
+}
+
+// Every mesh is a unit cube with its own buffers and its own color. The
+// instances tile the viewport, one tile per range.
+static void CreateScene( const unsigned int in_meshes, Scene* out_scene ) {
+    const GLuint vertex = Compile( GL_VERTEX_SHADER, VERTEX_SHADER ),
+        fragment = Compile( GL_FRAGMENT_SHADER, FRAGMENT_SHADER );
+    out_scene->program = glCreateProgram();
+    glAttachShader( out_scene->program, vertex );
+    glAttachShader( out_scene->program, fragment );
+    glLinkProgram( out_scene->program );
+    glDeleteShader( vertex );
+    glDeleteShader( fragment );
+    out_scene->positionLoc = (GLuint)glGetAttribLocation( out_scene->program, "in_position" );
+    out_scene->colorLoc = (GLuint)glGetAttribLocation( out_scene->program, "in_color" );
+    out_scene->modelLoc = (GLuint)glGetAttribLocation( out_scene->program, "in_model" );
+    out_scene->instanceColorLoc = (GLuint)glGetAttribLocation( out_scene->program, "in_instanceColor" );
+
+    const float positions[ 8 ][ 4 ] = {
+        { -1.f, -1.f, -1.f, 1.f }, { 1.f, -1.f, -1.f, 1.f }, { 1.f, 1.f, -1.f, 1.f }, { -1.f, 1.f, -1.f, 1.f },
+        { -1.f, -1.f, 1.f, 1.f }, { 1.f, -1.f, 1.f, 1.f }, { 1.f, 1.f, 1.f, 1.f }, { -1.f, 1.f, 1.f, 1.f } };
+    const unsigned int indicies[ 36 ] = { 0U, 2U, 1U, 0U, 3U, 2U, 4U, 5U, 6U, 4U, 6U, 7U, 0U, 1U, 5U, 0U, 5U, 4U,
+        3U, 6U, 2U, 3U, 7U, 6U, 0U, 4U, 7U, 0U, 7U, 3U, 1U, 2U, 6U, 1U, 6U, 5U };
+    out_scene->meshes.resize( in_meshes );
+    for( unsigned int index = 0U; index < in_meshes; index += 1U ) {
+        Mesh& mesh = out_scene->meshes[ index ];
+        float colors[ 8 ][ 4 ];
+        for( unsigned int vertex = 0U; vertex < 8U; vertex += 1U ) {
+            colors[ vertex ][ 0 ] = ( index % 4U ) / 3.f;
+            colors[ vertex ][ 1 ] = ( index / 4U % 4U ) / 3.f;
+            colors[ vertex ][ 2 ] = vertex / 7.f;
+            colors[ vertex ][ 3 ] = 1.f;
+        }
+        GLuint buffers[ 3 ];
+        glGenBuffers( 3, buffers );
+        glBindBuffer( GL_ARRAY_BUFFER, buffers[ 0 ] );
+        glBufferData( GL_ARRAY_BUFFER, sizeof(positions), positions, GL_STATIC_DRAW );
+        glBindBuffer( GL_ARRAY_BUFFER, buffers[ 1 ] );
+        glBufferData( GL_ARRAY_BUFFER, sizeof(colors), colors, GL_STATIC_DRAW );
+        glBindBuffer( GL_ARRAY_BUFFER, buffers[ 2 ] );
+        glBufferData( GL_ARRAY_BUFFER, sizeof(indicies), indicies, GL_STATIC_DRAW );
+        mesh.vertexBuffer = buffers[ 0 ];
+        mesh.colorBuffer = buffers[ 1 ];
+        mesh.indexBuffer = buffers[ 2 ];
+    }
+
+    // A model matrix and a color per instance, ranges back to back.
+    const unsigned int ranges = in_meshes * LOD_COUNT, instances = ranges * INSTANCES_PER_RANGE;
+    unsigned int side = 1U;
+    while( side * side < instances )
+        side += 1U;
+    const float scale = 0.8f / side;
+    std::vector< float > data( 20U * instances, 0.f );
+    for( unsigned int instance = 0U; instance < instances; instance += 1U ) {
+        float* model = &data[ 20U * instance ];
+        model[ 0 ] = model[ 5 ] = model[ 10 ] = scale;
+        model[ 12 ] = -1.f + ( 2.f * ( instance % side ) + 1.f ) / side;
+        model[ 13 ] = -1.f + ( 2.f * ( instance / side ) + 1.f ) / side;
+        model[ 15 ] = 1.f;
+        model[ 16 ] = model[ 17 ] = model[ 18 ] = model[ 19 ] = 1.f;
+    }
+    glGenBuffers( 1, &out_scene->instanceBuffer );
+    glBindBuffer( GL_ARRAY_BUFFER, out_scene->instanceBuffer );
+    glBufferData( GL_ARRAY_BUFFER, sizeof(float) * data.size(), &data[ 0 ], GL_STATIC_DRAW );
+    glBindBuffer( GL_ARRAY_BUFFER, 0U );
+
+    glGenVertexArrays( 1, &out_scene->vertexArray );
+    glBindVertexArray( out_scene->vertexArray );
+    const App::VertexAttribDivisorProc vertexAttribDivisor = App::GetGLFunctions().vertexAttribDivisor;
+    glEnableVertexAttribArray( out_scene->positionLoc );
+    glEnableVertexAttribArray( out_scene->colorLoc );
+    for( GLuint column = 0U; column < 4U; column += 1U ) {
+        glEnableVertexAttribArray( out_scene->modelLoc + column );
+        vertexAttribDivisor( out_scene->modelLoc + column, 1U );
+    }
+    glEnableVertexAttribArray( out_scene->instanceColorLoc );
+    vertexAttribDivisor( out_scene->instanceColorLoc, 1U );
+    glBindVertexArray( 0U );
+}
+
+static void ReleaseScene( Scene* io_scene ) {
+    for( size_t index = 0U; index < io_scene->meshes.size(); index += 1U ) {
+        const Mesh& mesh = io_scene->meshes[ index ];
+        const GLuint buffers[ 3 ] = { mesh.vertexBuffer, mesh.colorBuffer, mesh.indexBuffer };
+        App::GetGLState().deleteBuffers( 3, buffers );
+    }
+    App::GetGLState().deleteBuffers( 1, &io_scene->instanceBuffer );
+    App::GetGLState().deleteVertexArrays( 1, &io_scene->vertexArray );
+    App::GetGLState().deleteProgram( io_scene->program );
+    io_scene->meshes.clear();
+}
+
+static void InstancePointers( const Scene& in_scene, const unsigned int in_first ) {
+    const size_t offset = sizeof(float) * 20U * in_first;
+    for( GLuint column = 0U; column < 4U; column += 1U )
+        glVertexAttribPointer( in_scene.modelLoc + column, 4, GL_FLOAT, GL_FALSE, sizeof(float) * 20U,
+            (GLvoid*)( offset + sizeof(float) * 4U * column ) );
+    glVertexAttribPointer( in_scene.instanceColorLoc, 4, GL_FLOAT, GL_FALSE, sizeof(float) * 20U,
+        (GLvoid*)( offset + sizeof(float) * 16U ) );
+}
+
+// One frame as main.cpp issued it before the cache; every state call reaches
+// the driver.
+static void DirectFrame( const Scene& in_scene, Counts* io_counts ) {
+    glViewport( 0, 0, SIZE, SIZE );
+    glClearColor( 0.f, 0.f, 0.f, 1.f );
+    glEnable( GL_DEPTH_TEST );
+    glEnable( GL_CULL_FACE );
+    glCullFace( GL_BACK );
+    glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
+    glUseProgram( in_scene.program );
+    glBindVertexArray( in_scene.vertexArray );
+    glPolygonMode( GL_FRONT_AND_BACK, GL_LINE );
+    io_counts->issued += 8U;
+    for( size_t index = 0U; index < in_scene.meshes.size(); index += 1U ) {
+        const Mesh& mesh = in_scene.meshes[ index ];
+        glBindBuffer( GL_ARRAY_BUFFER, mesh.vertexBuffer );
+        glVertexAttribPointer( in_scene.positionLoc, 4, GL_FLOAT, GL_FALSE, 0, (GLvoid*) 0 );
+        glBindBuffer( GL_ARRAY_BUFFER, mesh.colorBuffer );
+        glVertexAttribPointer( in_scene.colorLoc, 4, GL_FLOAT, GL_FALSE, 0, (GLvoid*) 0 );
+        glBindBuffer( GL_ARRAY_BUFFER, 0U );
+        glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, mesh.indexBuffer );
+        io_counts->issued += 4U;
+        for( unsigned int lod = 0U; lod < LOD_COUNT; lod += 1U ) {
+            glBindBuffer( GL_ARRAY_BUFFER, in_scene.instanceBuffer );
+            InstancePointers( in_scene, ( (unsigned int)index * LOD_COUNT + lod ) * INSTANCES_PER_RANGE );
+            glBindBuffer( GL_ARRAY_BUFFER, 0U );
+            glDrawElementsInstanced( GL_TRIANGLES, 36, GL_UNSIGNED_INT, (GLvoid*) 0, INSTANCES_PER_RANGE );
+            io_counts->issued += 2U;
+        }
+    }
+    glPolygonMode( GL_FRONT_AND_BACK, GL_FILL );
+    glBindVertexArray( 0U );
+    glDisable( GL_CULL_FACE );
+    glDisable( GL_DEPTH_TEST );
+    io_counts->issued += 4U;
+}
+
+// The same frame through App::GLState, as main.cpp issues it now.
+static void CachedFrame( const Scene& in_scene, Counts* io_counts ) {
+    App::GLState& state = App::GetGLState();
+    const App::GLStateStats before = state.totalStats();
+    state.beginFrame();
+    state.viewport( 0, 0, SIZE, SIZE );
+    state.clearColor( 0.f, 0.f, 0.f, 1.f );
+    state.enable( GL_DEPTH_TEST );
+    state.enable( GL_CULL_FACE );
+    state.cullFace( GL_BACK );
+    glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
+    state.useProgram( in_scene.program );
+    state.bindVertexArray( in_scene.vertexArray );
+    state.polygonMode( GL_LINE );
+    for( size_t index = 0U; index < in_scene.meshes.size(); index += 1U ) {
+        const Mesh& mesh = in_scene.meshes[ index ];
+        state.bindBuffer( GL_ARRAY_BUFFER, mesh.vertexBuffer );
+        glVertexAttribPointer( in_scene.positionLoc, 4, GL_FLOAT, GL_FALSE, 0, (GLvoid*) 0 );
+        state.bindBuffer( GL_ARRAY_BUFFER, mesh.colorBuffer );
+        glVertexAttribPointer( in_scene.colorLoc, 4, GL_FLOAT, GL_FALSE, 0, (GLvoid*) 0 );
+        state.bindBuffer( GL_ELEMENT_ARRAY_BUFFER, mesh.indexBuffer );
+        for( unsigned int lod = 0U; lod < LOD_COUNT; lod += 1U ) {
+            state.bindBuffer( GL_ARRAY_BUFFER, in_scene.instanceBuffer );
+            InstancePointers( in_scene, ( (unsigned int)index * LOD_COUNT + lod ) * INSTANCES_PER_RANGE );
+            glDrawElementsInstanced( GL_TRIANGLES, 36, GL_UNSIGNED_INT, (GLvoid*) 0, INSTANCES_PER_RANGE );
+        }
+    }
+    io_counts->issued += state.totalStats().issued - before.issued;
+    io_counts->skipped += state.totalStats().skipped - before.skipped;
+}
+
+template< typename Frame >
+static void Measure( const char* in_name, const unsigned int in_meshes, Frame in_frame,
+    std::vector< unsigned char >* out_pixels ) {
+    std::vector< double > submits, frames;
+    Counts counts = { 0U, 0U };
+    for( unsigned int frame = 0U; frame < FRAMES; frame += 1U ) {
+        const Bench::Clock::time_point begin = Bench::Clock::now();
+        in_frame( &counts );
+        const Bench::Clock::time_point submitted = Bench::Clock::now();
+        glFinish();
+        submits.push_back( Bench::Seconds( begin, submitted ) );
+        frames.push_back( Bench::Seconds( begin, Bench::Clock::now() ) );
+    }
+    out_pixels->resize( 4U * SIZE * SIZE );
+    glReadPixels( 0, 0, SIZE, SIZE, GL_RGBA, GL_UNSIGNED_BYTE, &( *out_pixels )[ 0 ] );
+    std::cout << "    " << std::left << std::setw( 7 ) << in_name << std::right << std::fixed
+        << std::setprecision( 1 ) << "state calls issued " << std::setw( 6 ) << (double)counts.issued / FRAMES
+        << "  skipped " << std::setw( 6 ) << (double)counts.skipped / FRAMES << "  submit " << std::setprecision( 2 )
+        << std::setw( 7 ) << Bench::Percentile( submits, 50.0 ) * 1e6 << " us  frame " << std::setw( 8 )
+        << Bench::Percentile( frames, 50.0 ) * 1e6 << " us  ("
+        << in_meshes * LOD_COUNT << " draws)" << std::endl;
+}
+
+static bool Run( const unsigned int in_meshes ) {
+    Scene scene;
+    CreateScene( in_meshes, &scene );
+    // CreateScene bound buffers behind the cache's back.
+    App::GetGLState().invalidate();
+    std::cout << in_meshes << " meshes" << std::endl;
+    std::vector< unsigned char > direct, cached;
+    Measure( "direct", in_meshes, [ & ]( Counts* io_counts ) { DirectFrame( scene, io_counts ); }, &direct );
+    App::GetGLState().invalidate();
+    Measure( "cached", in_meshes, [ & ]( Counts* io_counts ) { CachedFrame( scene, io_counts ); }, &cached );
+    ReleaseScene( &scene );
+    const bool same = memcmp( &direct[ 0 ], &cached[ 0 ], direct.size() ) == 0;
+    if( same == false )
+        std::cout << "    FAILED: images differ" << std::endl;
+    return same;
+}
+
+int main( int argc, char** argv ) {
+    if( glfwInit() == GLFW_FALSE )
+        return EXIT_FAILURE;
+    glfwWindowHint( GLFW_CONTEXT_VERSION_MAJOR, 3 );
+    glfwWindowHint( GLFW_CONTEXT_VERSION_MINOR, 2 );
+    glfwWindowHint( GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE );
+    glfwWindowHint( GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE );
+    glfwWindowHint( GLFW_VISIBLE, GLFW_FALSE );
+    GLFWwindow* window = glfwCreateWindow( SIZE, SIZE, "bench", NULL, NULL );
+    if( window == NULL ) {
+        glfwTerminate();
+        return EXIT_FAILURE;
+    }
+    glfwMakeContextCurrent( window );
+    gladLoadGLLoader( (GLADloadproc) glfwGetProcAddress );
+    App::LoadGLFunctions( (GLADloadproc) glfwGetProcAddress );
+    if( App::GetGLFunctions().vertexAttribDivisor == NULL ) {
+        std::cout << "Error: Instanced arrays are not supported." << std::endl;
+        glfwTerminate();
+        return EXIT_FAILURE;
+    }
+
+    bool passed = true;
+    if( argc > 1 ) {
+        passed = Run( (unsigned int)atoi( argv[ 1 ] ) );
+    } else {
+        const unsigned int counts[ 4 ] = { 1U, 4U, 16U, 64U };
+        for( unsigned int count = 0U; count < 4U; count += 1U )
+            passed = Run( counts[ count ] ) && passed;
+    }
+
+    glfwDestroyWindow( window );
+    glfwTerminate();
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
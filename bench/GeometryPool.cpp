@@ -0,0 +1,421 @@
+/*
+Draw submission for a scene of N distinct meshes, copies of res/cube,
+res/shape, res/pumpkin, res/sphere and res/teapot, each drawn as a few
+instances of its first DRAW_FACES faces. "per-mesh" binds each mesh's own
+VAO and buffers and issues a glDrawElementsInstanced per mesh, as the
+asset streamer's meshes are drawn.
+"pool" puts every mesh in one App::GeometryPool and submits the same draws
+as glDrawElementsInstancedBaseVertex calls; "pool MDI" submits them all
+with one glMultiDrawElementsIndirect. Reports the CPU time to submit a
+frame and the frame time up to glFinish. All must render the same image.
+The churn phase then adds and removes meshes at random in a pool that
+starts small, and reports fragmentation, rebuilds and their cost; the
+meshes left must still render as their own buffers do.
+Exits with failure when images differ.
+Usage: bench_geometry_pool.out [meshes]
+*/
+#include "glad/glad.h"
+#include <GLFW/glfw3.h>
+#include <stdlib.h>
+#include <string.h>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+
+#include "GLFunctions.hpp"
+#include "GLState.hpp"
+#include "GeometryPool.hpp"
+#include "Bench.hpp"
+
+static const char* SOURCES[] = { "res/cube", "res/shape", "res/pumpkin", "res/sphere", "res/teapot" };
+static const unsigned int SOURCE_COUNT = sizeof(SOURCES) / sizeof(SOURCES[ 0 ]);
+static const unsigned int FRAMES = 100U;
+static const unsigned int INSTANCES_PER_MESH = 2U;
+// Faces drawn per mesh while timing submission, like a coarse LOD, so the
+// rasterizer does not hide the CPU cost.
+static const unsigned int DRAW_FACES = 64U;
+static const unsigned int SIZE = 64U;
+static const unsigned int CHURN_STEPS = 4000U;
+static const unsigned int CHURN_REPORT = 500U;
+static const unsigned int CHURN_MAX_LIVE = 200U;
+
+// Decoding is folded into the model matrices, so positions go straight
+// through.
+static const char* VERTEX_SHADER =
+    "#version 150\n"
+    "in vec4 in_position;\n"
+    "in vec4 in_color;\n"
+    "in mat4 in_model;\n"
+    "in vec4 in_instanceColor;\n"
+    "out vec4 o_color;\n"
+    "void main() { gl_Position = in_model * vec4( in_position.xyz, 1.0 ); o_color = in_color * in_instanceColor; }\n";
+static const char* FRAGMENT_SHADER =
+    "#version 150\n"
+    "in vec4 o_color;\n"
+    "out vec4 o_fragColor;\n"
+    "void main() { o_fragColor = o_color; }\n";
+
+struct Program {
+    GLuint  program;
+    GLuint  positionLoc, colorLoc, modelLoc, instanceColorLoc;
+};
+
+// A mesh with buffers of its own.
+struct MeshBuffers {
+    GLuint  vertexArray;
+    GLuint  buffers[ 3 ];
+    GLenum  type;
+    GLsizei count;
+};
+
+static GLuint Compile( const GLenum in_type, const char* in_source ) {
+    const GLuint shader = glCreateShader( in_type );
+    glShaderSource( shader, 1, &in_source, NULL );
+    glCompileShader( shader );
+    return shader;
+}
+
+static void CreateProgram( Program* out_program ) {
+    const GLuint vertex = Compile( GL_VERTEX_SHADER, VERTEX_SHADER ),
+        fragment = Compile( GL_FRAGMENT_SHADER, FRAGMENT_SHADER );
+    out_program->program = glCreateProgram();
+    glAttachShader( out_program->program, vertex );
+    glAttachShader( out_program->program, fragment );
+    glLinkProgram( out_program->program );
+    glDeleteShader( vertex );
+    glDeleteShader( fragment );
+    out_program->positionLoc = (GLuint)glGetAttribLocation( out_program->program, "in_position" );
+    out_program->colorLoc = (GLuint)glGetAttribLocation( out_program->program, "in_color" );
+    out_program->modelLoc = (GLuint)glGetAttribLocation( out_program->program, "in_model" );
+    out_program->instanceColorLoc = (GLuint)glGetAttribLocation( out_program->program, "in_instanceColor" );
+}
+
+static void CreateMeshBuffers( const PackedMesh& in_mesh, const Program& in_program,
+    App::InstanceBuffer* io_instances, MeshBuffers* out_mesh ) {
+    App::GLState& state = App::GetGLState();
+    glGenVertexArrays( 1, &out_mesh->vertexArray );
+    state.bindVertexArray( out_mesh->vertexArray );
+    glGenBuffers( 3, out_mesh->buffers );
+    state.bindBuffer( GL_ARRAY_BUFFER, out_mesh->buffers[ 0 ] );
+    glBufferData( GL_ARRAY_BUFFER, sizeof(PVertex) * in_mesh.verticies.size(), in_mesh.verticies.data(),
+        GL_STATIC_DRAW );
+    glVertexAttribPointer( in_program.positionLoc, 4, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(PVertex), (GLvoid*) 0 );
+    glEnableVertexAttribArray( in_program.positionLoc );
+    state.bindBuffer( GL_ARRAY_BUFFER, out_mesh->buffers[ 1 ] );
+    glBufferData( GL_ARRAY_BUFFER, sizeof(PColor) * in_mesh.colors.size(), in_mesh.colors.data(),
+        GL_STATIC_DRAW );
+    glVertexAttribPointer( in_program.colorLoc, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(PColor), (GLvoid*) 0 );
+    glEnableVertexAttribArray( in_program.colorLoc );
+    state.bindBuffer( GL_ELEMENT_ARRAY_BUFFER, out_mesh->buffers[ 2 ] );
+    glBufferData( GL_ELEMENT_ARRAY_BUFFER, in_mesh.indexBytes(), in_mesh.indexData(), GL_STATIC_DRAW );
+    io_instances->attach( in_program.modelLoc, in_program.instanceColorLoc );
+    out_mesh->type = in_mesh.indexSize == 2U ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+    out_mesh->count = (GLsizei)( in_mesh.indexBytes() / in_mesh.indexSize );
+}
+
+static void ReleaseMeshBuffers( std::vector< MeshBuffers >* io_meshes ) {
+    for( size_t index = 0U; index < io_meshes->size(); index += 1U ) {
+        App::GetGLState().deleteBuffers( 3, ( *io_meshes )[ index ].buffers );
+        App::GetGLState().deleteVertexArrays( 1, &( *io_meshes )[ index ].vertexArray );
+    }
+    io_meshes->clear();
+}
+
+// Instances of in_sources[ index ] tile the viewport, INSTANCES_PER_MESH
+// tiles per mesh, each mesh scaled into its tile.
+static void LayoutInstances( const std::vector< PackedMesh >& in_packed,
+    const std::vector< unsigned int >& in_sources, std::vector< App::AInstance >* out_instances ) {
+    const unsigned int instances = (unsigned int)in_sources.size() * INSTANCES_PER_MESH;
+    unsigned int side = 1U;
+    while( side * side < instances )
+        side += 1U;
+    out_instances->resize( instances );
+    for( unsigned int instance = 0U; instance < instances; instance += 1U ) {
+        const PositionDecode& decode = in_packed[ in_sources[ instance / INSTANCES_PER_MESH ] ].decode;
+        const float extent = std::max( decode.scale[ 0 ], std::max( decode.scale[ 1 ], decode.scale[ 2 ] ) );
+        const float scale = 1.6f / side / extent;
+        float model[ 16 ] = { scale, 0.f, 0.f, 0.f, 0.f, scale, 0.f, 0.f, 0.f, 0.f, scale, 0.f,
+            -1.f + ( 2.f * ( instance % side ) + 1.f ) / side, -1.f + ( 2.f * ( instance / side ) + 1.f ) / side,
+            0.f, 1.f };
+        // Center the box on the tile.
+        for( unsigned int axis = 0U; axis < 3U; axis += 1U )
+            model[ 12U + axis ] -= model[ 5U * axis ] * ( decode.offset[ axis ] + 0.5f * decode.scale[ axis ] );
+        App::AInstance& out = ( *out_instances )[ instance ];
+        App::FoldDecode( model, decode, out.model );
+        out.color[ 0 ] = out.color[ 1 ] = out.color[ 2 ] = out.color[ 3 ] = 1.f;
+        out.color[ instance % 3U ] = 0.5f;
+    }
+}
+
+static void BeginFrame( const Program& in_program ) {
+    App::GLState& state = App::GetGLState();
+    state.beginFrame();
+    state.viewport( 0, 0, SIZE, SIZE );
+    state.clearColor( 0.f, 0.f, 0.f, 1.f );
+    state.enable( GL_DEPTH_TEST );
+    glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
+    state.useProgram( in_program.program );
+}
+
+static void FillInstances( const std::vector< App::AInstance >& in_instances, App::InstanceBuffer* io_buffer ) {
+    App::AInstance* instances = io_buffer->begin();
+    memcpy( instances, in_instances.data(), sizeof(App::AInstance) * in_instances.size() );
+}
+
+// in_faces 0 draws whole meshes.
+static void PerMeshFrame( const Program& in_program, const std::vector< MeshBuffers >& in_meshes,
+    const std::vector< App::AInstance >& in_instances, const unsigned int in_faces, App::InstanceBuffer* io_buffer ) {
+    BeginFrame( in_program );
+    FillInstances( in_instances, io_buffer );
+    for( size_t index = 0U; index < in_meshes.size(); index += 1U ) {
+        const MeshBuffers& mesh = in_meshes[ index ];
+        App::GetGLState().bindVertexArray( mesh.vertexArray );
+        io_buffer->bind( (unsigned int)index * INSTANCES_PER_MESH );
+        const GLsizei count = in_faces == 0U ? mesh.count : std::min( mesh.count, (GLsizei)( 3U * in_faces ) );
+        glDrawElementsInstanced( GL_TRIANGLES, count, mesh.type, (GLvoid*) 0, INSTANCES_PER_MESH );
+    }
+    io_buffer->end();
+}
+
+struct PoolScene {
+    App::GeometryPool*                              pool;
+    GLuint                                          vertexArray;
+    unsigned int                                    generation;
+    std::vector< App::DrawElementsIndirectCommand > commands;
+};
+
+static void PoolFrame( const Program& in_program, const std::vector< unsigned int >& in_handles,
+    const std::vector< App::AInstance >& in_instances, const unsigned int in_faces, App::InstanceBuffer* io_buffer,
+    PoolScene* io_scene ) {
+    BeginFrame( in_program );
+    FillInstances( in_instances, io_buffer );
+    App::GetGLState().bindVertexArray( io_scene->vertexArray );
+    if( io_scene->generation != io_scene->pool->generation() ) {
+        io_scene->pool->bind( in_program.positionLoc, in_program.colorLoc );
+        io_scene->generation = io_scene->pool->generation();
+    }
+    io_scene->commands.clear();
+    for( size_t index = 0U; index < in_handles.size(); index += 1U )
+        io_scene->pool->appendCommand( in_handles[ index ], INSTANCES_PER_MESH,
+            (unsigned int)index * INSTANCES_PER_MESH, &io_scene->commands, 0U, in_faces );
+    io_scene->pool->draw( io_scene->commands, io_buffer );
+    io_buffer->end();
+}
+
+template< typename Frame >
+static void Measure( const char* in_name, const unsigned int in_draws, Frame in_frame,
+    std::vector< unsigned char >* out_pixels ) {
+    std::vector< double > submits, frames;
+    for( unsigned int frame = 0U; frame < FRAMES; frame += 1U ) {
+        const Bench::Clock::time_point begin = Bench::Clock::now();
+        in_frame();
+        const Bench::Clock::time_point submitted = Bench::Clock::now();
+        glFinish();
+        submits.push_back( Bench::Seconds( begin, submitted ) );
+        frames.push_back( Bench::Seconds( begin, Bench::Clock::now() ) );
+    }
+    out_pixels->resize( 4U * SIZE * SIZE );
+    glReadPixels( 0, 0, SIZE, SIZE, GL_RGBA, GL_UNSIGNED_BYTE, &( *out_pixels )[ 0 ] );
+    std::cout << "    " << std::left << std::setw( 9 ) << in_name << std::right << std::fixed
+        << std::setprecision( 2 ) << "submit " << std::setw( 8 ) << Bench::Percentile( submits, 50.0 ) * 1e6
+        << " us  " << std::setw( 6 ) << Bench::Percentile( submits, 50.0 ) * 1e9 / in_draws << " ns/draw  frame "
+        << std::setw( 9 ) << Bench::Percentile( frames, 50.0 ) * 1e6 << " us" << std::endl;
+}
+
+static bool Same( const char* in_name, const std::vector< unsigned char >& in_expected,
+    const std::vector< unsigned char >& in_pixels ) {
+    if( memcmp( &in_expected[ 0 ], &in_pixels[ 0 ], in_expected.size() ) == 0 )
+        return true;
+    std::cout << "    FAILED: " << in_name << " image differs" << std::endl;
+    return false;
+}
+
+static bool Submission( const unsigned int in_meshes, const std::vector< PackedMesh >& in_packed,
+    const Program& in_program, const unsigned int in_indexSize ) {
+    std::vector< unsigned int > sources( in_meshes );
+    for( unsigned int index = 0U; index < in_meshes; index += 1U )
+        sources[ index ] = index % SOURCE_COUNT;
+    std::vector< App::AInstance > instances;
+    LayoutInstances( in_packed, sources, &instances );
+    App::InstanceBuffer buffer;
+    buffer.create( (unsigned int)instances.size() );
+
+    std::vector< MeshBuffers > meshes( in_meshes );
+    unsigned int vertices = 0U, indices = 0U;
+    for( unsigned int index = 0U; index < in_meshes; index += 1U ) {
+        CreateMeshBuffers( in_packed[ sources[ index ] ], in_program, &buffer, &meshes[ index ] );
+        vertices += (unsigned int)in_packed[ sources[ index ] ].verticies.size();
+        indices += (unsigned int)meshes[ index ].count;
+    }
+    App::GeometryPool pool;
+    pool.create( vertices, indices, in_indexSize );
+    std::vector< unsigned int > handles( in_meshes );
+    for( unsigned int index = 0U; index < in_meshes; index += 1U )
+        handles[ index ] = pool.add( in_packed[ sources[ index ] ] );
+    PoolScene scene;
+    scene.pool = &pool;
+    scene.generation = pool.generation() - 1U;
+    glGenVertexArrays( 1, &scene.vertexArray );
+    App::GetGLState().bindVertexArray( scene.vertexArray );
+    buffer.attach( in_program.modelLoc, in_program.instanceColorLoc );
+
+    std::cout << in_meshes << " meshes, " << instances.size() << " instances, " << vertices << " vertices, "
+        << indices / 3U << " faces" << std::endl;
+    std::vector< unsigned char > perMesh, based, indirect;
+    Measure( "per-mesh", in_meshes, [ & ]() { PerMeshFrame( in_program, meshes, instances, DRAW_FACES, &buffer ); },
+        &perMesh );
+    pool.setIndirect( false );
+    Measure( "pool", in_meshes, [ & ]() { PoolFrame( in_program, handles, instances, DRAW_FACES, &buffer, &scene ); },
+        &based );
+    bool passed = Same( "pool", perMesh, based );
+    pool.setIndirect( true );
+    if( pool.indirect() == true ) {
+        Measure( "pool MDI", in_meshes,
+            [ & ]() { PoolFrame( in_program, handles, instances, DRAW_FACES, &buffer, &scene ); }, &indirect );
+        passed = Same( "pool MDI", perMesh, indirect ) && passed;
+    } else {
+        std::cout << "    pool MDI: glMultiDrawElementsIndirect is not supported" << std::endl;
+    }
+
+    App::GetGLState().deleteVertexArrays( 1, &scene.vertexArray );
+    ReleaseMeshBuffers( &meshes );
+    return passed;
+}
+
+static void ReportPool( const unsigned int in_step, const App::GeometryPool& in_pool ) {
+    const App::GeometryPoolStats stats = in_pool.stats();
+    std::cout << "    step " << std::setw( 5 ) << in_step << "  meshes " << std::setw( 4 ) << stats.meshes
+        << std::fixed << std::setprecision( 2 ) << "  vertices " << std::setw( 6 )
+        << 100.0 * stats.verticesUsed / stats.vertexCapacity << "% of " << std::setw( 8 ) << stats.vertexCapacity
+        << " frag " << stats.vertexFragmentation << "  indices " << std::setw( 6 )
+        << 100.0 * stats.indicesUsed / stats.indexCapacity << "% of " << std::setw( 8 ) << stats.indexCapacity
+        << " frag " << stats.indexFragmentation << "  rebuilds " << stats.compactions << " (" << stats.grows
+        << " grown)" << std::endl;
+}
+
+// Add and remove meshes at random, deterministically, then check the pool
+// still draws what the meshes' own buffers draw.
+static bool Churn( const std::vector< PackedMesh >& in_packed, const Program& in_program,
+    const unsigned int in_indexSize ) {
+    App::GeometryPool pool;
+    pool.create( 1U << 14, 3U << 14, in_indexSize );
+    std::vector< unsigned int > handles, sources;
+    unsigned int random = 12345U;
+    double addSeconds = 0.0, rebuildSeconds = 0.0, slowestRebuild = 0.0;
+    unsigned int adds = 0U, rebuilds = 0U;
+    std::cout << "churn, " << CHURN_STEPS << " adds and removes" << std::endl;
+    for( unsigned int step = 1U; step <= CHURN_STEPS; step += 1U ) {
+        random = random * 1664525U + 1013904223U;
+        const unsigned int roll = random >> 8;
+        if( handles.size() < 8U || ( roll % 100U < 55U && handles.size() < CHURN_MAX_LIVE ) ) {
+            const unsigned int source = ( roll / 100U ) % SOURCE_COUNT;
+            const unsigned long long before = pool.stats().compactions;
+            const Bench::Clock::time_point begin = Bench::Clock::now();
+            handles.push_back( pool.add( in_packed[ source ] ) );
+            glFinish();
+            const double seconds = Bench::Seconds( begin, Bench::Clock::now() );
+            sources.push_back( source );
+            if( pool.stats().compactions != before ) {
+                rebuildSeconds += seconds;
+                slowestRebuild = std::max( slowestRebuild, seconds );
+                rebuilds += 1U;
+            } else {
+                addSeconds += seconds;
+                adds += 1U;
+            }
+        } else {
+            const size_t index = ( roll / 100U ) % handles.size();
+            pool.remove( handles[ index ] );
+            handles[ index ] = handles.back();
+            handles.pop_back();
+            sources[ index ] = sources.back();
+            sources.pop_back();
+        }
+        if( step % CHURN_REPORT == 0U )
+            ReportPool( step, pool );
+    }
+    std::cout << std::fixed << std::setprecision( 2 ) << "    add " << addSeconds * 1e6 / std::max( adds, 1U )
+        << " us avg; add with rebuild " << rebuildSeconds * 1e6 / std::max( rebuilds, 1U ) << " us avg, "
+        << slowestRebuild * 1e6 << " us max" << std::endl;
+    const Bench::Clock::time_point begin = Bench::Clock::now();
+    pool.compact();
+    glFinish();
+    const double compactSeconds = Bench::Seconds( begin, Bench::Clock::now() );
+    std::cout << "    compact " << compactSeconds * 1e6 << " us" << std::endl;
+    ReportPool( CHURN_STEPS, pool );
+
+    std::vector< App::AInstance > instances;
+    LayoutInstances( in_packed, sources, &instances );
+    App::InstanceBuffer buffer;
+    buffer.create( (unsigned int)instances.size() );
+    std::vector< MeshBuffers > meshes( handles.size() );
+    for( size_t index = 0U; index < handles.size(); index += 1U )
+        CreateMeshBuffers( in_packed[ sources[ index ] ], in_program, &buffer, &meshes[ index ] );
+    PoolScene scene;
+    scene.pool = &pool;
+    scene.generation = pool.generation() - 1U;
+    glGenVertexArrays( 1, &scene.vertexArray );
+    App::GetGLState().bindVertexArray( scene.vertexArray );
+    buffer.attach( in_program.modelLoc, in_program.instanceColorLoc );
+    std::vector< unsigned char > perMesh( 4U * SIZE * SIZE ), pooled( 4U * SIZE * SIZE );
+    PerMeshFrame( in_program, meshes, instances, 0U, &buffer );
+    glReadPixels( 0, 0, SIZE, SIZE, GL_RGBA, GL_UNSIGNED_BYTE, &perMesh[ 0 ] );
+    PoolFrame( in_program, handles, instances, 0U, &buffer, &scene );
+    glReadPixels( 0, 0, SIZE, SIZE, GL_RGBA, GL_UNSIGNED_BYTE, &pooled[ 0 ] );
+    App::GetGLState().deleteVertexArrays( 1, &scene.vertexArray );
+    ReleaseMeshBuffers( &meshes );
+    return Same( "churned pool", perMesh, pooled );
+}
+
+int main( int argc, char** argv ) {
+    std::vector< PackedMesh > packed( SOURCE_COUNT );
+    unsigned int indexSize = 2U;
+    for( unsigned int source = 0U; source < SOURCE_COUNT; source += 1U ) {
+        App::MeshBuffer mesh;
+        if( mesh.load( SOURCES[ source ] ) == false ) {
+            std::cout << SOURCES[ source ] << ": parse error" << std::endl;
+            return EXIT_FAILURE;
+        }
+        PackMesh( mesh, &packed[ source ] );
+        indexSize = std::max( indexSize, packed[ source ].indexSize );
+    }
+
+    if( glfwInit() == GLFW_FALSE )
+        return EXIT_FAILURE;
+    glfwWindowHint( GLFW_CONTEXT_VERSION_MAJOR, 3 );
+    glfwWindowHint( GLFW_CONTEXT_VERSION_MINOR, 2 );
+    glfwWindowHint( GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE );
+    glfwWindowHint( GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE );
+    glfwWindowHint( GLFW_VISIBLE, GLFW_FALSE );
+    GLFWwindow* window = glfwCreateWindow( SIZE, SIZE, "bench", NULL, NULL );
+    if( window == NULL ) {
+        glfwTerminate();
+        return EXIT_FAILURE;
+    }
+    glfwMakeContextCurrent( window );
+    gladLoadGLLoader( (GLADloadproc) glfwGetProcAddress );
+    App::LoadGLFunctions( (GLADloadproc) glfwGetProcAddress );
+    if( App::GetGLFunctions().vertexAttribDivisor == NULL ) {
+        std::cout << "Error: Instanced arrays are not supported." << std::endl;
+        glfwTerminate();
+        return EXIT_FAILURE;
+    }
+    std::cout << indexSize * 8U << "-bit pool indices" << std::endl;
+
+    Program program;
+    CreateProgram( &program );
+    bool passed = true;
+    if( argc > 1 ) {
+        passed = Submission( (unsigned int)atoi( argv[ 1 ] ), packed, program, indexSize );
+    } else {
+        const unsigned int counts[ 3 ] = { 10U, 100U, 1000U };
+        for( unsigned int count = 0U; count < 3U; count += 1U )
+            passed = Submission( counts[ count ], packed, program, indexSize ) && passed;
+    }
+    passed = Churn( packed, program, indexSize ) && passed;
+    App::GetGLState().deleteProgram( program.program );
+
+    glfwDestroyWindow( window );
+    glfwTerminate();
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,306 @@
+/*
+Latency from writing a file to the end of the first frame drawn with what
+was rebuilt from it, through App::FileWatcher, App::ProgramReloader and
+App::AssetStreamer::reload wired as in main.cpp. Copies of the shaders and
+of res/teapot in bench_reload/ are rewritten while a frame loop paced at
+60 Hz draws the mesh. Every round saves a vertex shader and a mesh that
+build, then a shader that does not compile and a mesh without faces; both
+failures must leave the previous version drawing. Frame times show what
+rebuilding costs the render loop.
+Usage: bench_hot_reload.out [rounds]
+*/
+#include "glad/glad.h"
+#include <GLFW/glfw3.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "GLFunctions.hpp"
+#include "GLState.hpp"
+#include "ProgramCache.hpp"
+#include "ProgramReloader.hpp"
+#include "AssetStreamer.hpp"
+#include "FileWatcher.hpp"
+#include "Bench.hpp"
+
+static const char* DIRECTORY = "bench_reload";
+static const char* VERTEX_SHADER = "bench_reload/vertex.shader";
+static const char* FRAGMENT_SHADER = "bench_reload/fragment.shader";
+static const char* PROGRAM_CACHE = "bench_reload/program.cache";
+static const char* MESH = "bench_reload/teapot";
+static const unsigned int SIZE = 64U;
+static const double FRAME_SECONDS = 1.0 / 60.0;
+// Frames a reload may take before the round fails.
+static const unsigned int TIMEOUT_FRAMES = 600U;
+
+static bool ReadFile( const char* in_fileName, std::string* out_text ) {
+    std::ifstream file( in_fileName, std::ios::binary );
+    std::ostringstream text;
+    text << file.rdbuf();
+    *out_text = text.str();
+    return file.good();
+}
+
+static bool WriteFile( const char* in_fileName, const std::string& in_text ) {
+    std::ofstream file( in_fileName, std::ios::binary | std::ios::trunc );
+    file.write( in_text.data(), (std::streamsize)in_text.size() );
+    return file.good();
+}
+
+// The render loop of main.cpp reduced to one mesh and one body.
+struct Scene {
+    App::FileWatcher            watcher;
+    App::ProgramReloader        reloader;
+    App::AssetStreamer          streamer;
+    unsigned int                shaderFiles[ 2 ];
+    unsigned int                meshFile;
+    unsigned int                mesh;
+    GLuint                      program;
+    GLuint                      vertexArray;
+    GLuint                      uniformBuffers[ 2 ];
+    const App::MeshResource*    boundMesh;
+    unsigned int                boundVersion;
+    Bench::Clock::time_point    nextFrame;
+    std::vector< double >       frames;
+    // Results of the last frame.
+    unsigned int                programSwaps;
+    unsigned int                programFailures;
+    unsigned int                meshSwaps;
+    unsigned int                meshFailures;
+    unsigned int                lit;
+};
+
+static void BindProgram( Scene* io_scene ) {
+    App::GLState& glState = App::GetGLState();
+    const GLuint program = io_scene->program;
+    glState.useProgram( program );
+    glState.uniformBlockBinding( program, glGetUniformBlockIndex( program, "ColorPrefix" ), 1U );
+    glState.uniformBlockBinding( program, glGetUniformBlockIndex( program, "ColorSuffix" ), 2U );
+    const float identity[ 16 ] = { 1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f };
+    glUniformMatrix4fv( glGetUniformLocation( program, "in_viewProjection" ), 1, GL_FALSE, identity );
+    const GLint modelLoc = glGetAttribLocation( program, "in_model" ),
+        instanceColorLoc = glGetAttribLocation( program, "in_instanceColor" );
+    for( GLuint column = 0U; column < 4U; column += 1U )
+        glVertexAttrib4fv( (GLuint)modelLoc + column, identity + 4U * column );
+    glVertexAttrib4f( (GLuint)instanceColorLoc, 1.f, 1.f, 1.f, 1.f );
+}
+
+// Fit the mesh into clip space, whatever its bounds.
+static void BindMesh( Scene* io_scene ) {
+    App::GLState& glState = App::GetGLState();
+    const App::MeshResource& mesh = io_scene->streamer.resource( io_scene->mesh );
+    const GLuint program = io_scene->program;
+    const GLint positionLoc = glGetAttribLocation( program, "in_position" ),
+        colorLoc = glGetAttribLocation( program, "in_color" );
+    glState.bindVertexArray( io_scene->vertexArray );
+    glState.bindBuffer( GL_ARRAY_BUFFER, mesh.vertexBuffer );
+    glVertexAttribPointer( (GLuint)positionLoc, 4, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(PVertex), (GLvoid*) 0 );
+    glEnableVertexAttribArray( (GLuint)positionLoc );
+    glState.bindBuffer( GL_ARRAY_BUFFER, mesh.colorBuffer );
+    glVertexAttribPointer( (GLuint)colorLoc, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(PColor), (GLvoid*) 0 );
+    glEnableVertexAttribArray( (GLuint)colorLoc );
+    glState.bindBuffer( GL_ELEMENT_ARRAY_BUFFER, mesh.indexBuffer );
+    const float radius = mesh.volume.radius > 0.f ? mesh.volume.radius : 1.f;
+    float offset[ 3 ], scale[ 3 ];
+    for( unsigned int axis = 0U; axis < 3U; axis += 1U ) {
+        offset[ axis ] = ( mesh.decode.offset[ axis ] - mesh.volume.center[ axis ] ) / radius;
+        scale[ axis ] = mesh.decode.scale[ axis ] / radius;
+    }
+    glUniform3fv( glGetUniformLocation( program, "in_positionOffset" ), 1, offset );
+    glUniform3fv( glGetUniformLocation( program, "in_positionScale" ), 1, scale );
+    io_scene->boundMesh = &mesh;
+    io_scene->boundVersion = io_scene->streamer.version( io_scene->mesh );
+}
+
+// One paced frame: dispatch changes, swap in what finished, draw, finish.
+static void Frame( Scene* io_scene ) {
+    std::this_thread::sleep_until( io_scene->nextFrame );
+    const Bench::Clock::time_point begin = Bench::Clock::now();
+    io_scene->nextFrame = begin + std::chrono::microseconds( (long long)( FRAME_SECONDS * 1e6 ) );
+    io_scene->programSwaps = io_scene->programFailures = io_scene->meshSwaps = io_scene->meshFailures = 0U;
+
+    std::vector< App::FileWatcher::Change > changes;
+    io_scene->watcher.poll( &changes );
+    for( size_t change = 0U; change < changes.size(); change += 1U ) {
+        if( changes[ change ].file == io_scene->meshFile )
+            io_scene->streamer.reload( io_scene->mesh );
+        else
+            io_scene->reloader.request( changes[ change ].time );
+    }
+    App::ProgramReload reload;
+    while( io_scene->reloader.poll( &reload ) == true ) {
+        if( reload.program == 0U ) {
+            io_scene->programFailures += 1U;
+            continue;
+        }
+        App::GetGLState().deleteProgram( io_scene->program );
+        io_scene->program = reload.program;
+        BindProgram( io_scene );
+        BindMesh( io_scene );
+        io_scene->programSwaps += 1U;
+    }
+    io_scene->streamer.update();
+    for( size_t index = 0U; index < io_scene->streamer.reloads().size(); index += 1U ) {
+        if( io_scene->streamer.reloads()[ index ].succeeded == true )
+            io_scene->meshSwaps += 1U;
+        else
+            io_scene->meshFailures += 1U;
+    }
+    const App::MeshResource& mesh = io_scene->streamer.resource( io_scene->mesh );
+    if( &mesh != io_scene->boundMesh || io_scene->streamer.version( io_scene->mesh ) != io_scene->boundVersion )
+        BindMesh( io_scene );
+    glClear( GL_COLOR_BUFFER_BIT );
+    glDrawElements( GL_TRIANGLES, 3 * mesh.faceCount, mesh.indexType, (GLvoid*) 0 );
+    std::vector< unsigned char > pixels( 4U * SIZE * SIZE );
+    glReadPixels( 0, 0, SIZE, SIZE, GL_RGBA, GL_UNSIGNED_BYTE, &pixels[ 0 ] );
+    io_scene->lit = 0U;
+    for( size_t pixel = 0U; pixel < pixels.size(); pixel += 4U )
+        io_scene->lit += pixels[ pixel ] != 0U ? 1U : 0U;
+    io_scene->frames.push_back( Bench::Seconds( begin, Bench::Clock::now() ) );
+}
+
+// Run frames until the counter in_result of a frame is set; returns seconds
+// from in_saved to the end of that frame, or -1 on timeout.
+static double Await( Scene* io_scene, unsigned int Scene::* in_result, const Bench::Clock::time_point in_saved ) {
+    for( unsigned int frame = 0U; frame < TIMEOUT_FRAMES; frame += 1U ) {
+        Frame( io_scene );
+        if( io_scene->*in_result != 0U )
+            return Bench::Seconds( in_saved, Bench::Clock::now() );
+    }
+    return -1.0;
+}
+
+static void Report( const char* in_name, const std::vector< double >& in_times ) {
+    std::cout << "    " << std::left << std::setw( 7 ) << in_name << std::right << std::fixed << std::setprecision( 2 )
+        << "  median " << std::setw( 8 ) << Bench::Percentile( in_times, 50.0 ) * 1e3 << " ms  max "
+        << std::setw( 8 ) << Bench::Percentile( in_times, 100.0 ) * 1e3 << " ms" << std::endl;
+}
+
+int main( int argc, char** argv ) {
+    const unsigned int rounds = argc > 1 ? (unsigned int)atoi( argv[ 1 ] ) : 5U;
+    std::string vertex, fragment, teapot;
+    if( ReadFile( "src/shader/vertex.shader", &vertex ) == false
+        || ReadFile( "src/shader/fragment.shader", &fragment ) == false || ReadFile( "res/teapot", &teapot ) == false ) {
+        std::cerr << "Error: Run from the repository root." << std::endl;
+        return EXIT_FAILURE;
+    }
+    mkdir( DIRECTORY, 0755 );
+    WriteFile( VERTEX_SHADER, vertex );
+    WriteFile( FRAGMENT_SHADER, fragment );
+    WriteFile( MESH, teapot );
+
+    if( glfwInit() == GLFW_FALSE )
+        return EXIT_FAILURE;
+    glfwWindowHint( GLFW_CONTEXT_VERSION_MAJOR, 3 );
+    glfwWindowHint( GLFW_CONTEXT_VERSION_MINOR, 2 );
+    glfwWindowHint( GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE );
+    glfwWindowHint( GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE );
+    glfwWindowHint( GLFW_VISIBLE, GLFW_FALSE );
+    GLFWwindow* window = glfwCreateWindow( SIZE, SIZE, "bench", NULL, NULL );
+    GLFWwindow* reloadContext = window != NULL ? glfwCreateWindow( 1, 1, "reload", NULL, window ) : NULL;
+    if( reloadContext == NULL ) {
+        glfwTerminate();
+        return EXIT_FAILURE;
+    }
+    glfwMakeContextCurrent( window );
+    gladLoadGLLoader( (GLADloadproc) glfwGetProcAddress );
+    App::LoadGLFunctions( (GLADloadproc) glfwGetProcAddress );
+    glViewport( 0, 0, SIZE, SIZE );
+    std::cout << glGetString( GL_RENDERER ) << ", " << glGetString( GL_VERSION ) << std::endl;
+
+    Scene* scene = new Scene();
+    App::ProgramCacheStatus status;
+    scene->program = App::LoadProgram( vertex, fragment, PROGRAM_CACHE, &status );
+    const float colors[ 2 ][ 2 ] = { { 1.f, 1.f }, { 1.f, 1.f } };
+    glGenBuffers( 2, scene->uniformBuffers );
+    for( GLuint block = 0U; block < 2U; block += 1U ) {
+        App::GetGLState().bindBuffer( GL_UNIFORM_BUFFER, scene->uniformBuffers[ block ] );
+        glBufferData( GL_UNIFORM_BUFFER, sizeof(colors[ block ]), colors[ block ], GL_STATIC_DRAW );
+        App::GetGLState().bindBufferBase( GL_UNIFORM_BUFFER, block + 1U, scene->uniformBuffers[ block ] );
+    }
+    glGenVertexArrays( 1, &scene->vertexArray );
+    scene->streamer.create( 1U, 256U * 1024U );
+    scene->mesh = scene->streamer.request( MESH );
+    BindProgram( scene );
+    BindMesh( scene );
+    scene->reloader.create( VERTEX_SHADER, FRAGMENT_SHADER, PROGRAM_CACHE,
+        [ reloadContext ]() { glfwMakeContextCurrent( reloadContext ); },
+        []() { glfwMakeContextCurrent( NULL ); } );
+    scene->shaderFiles[ 0 ] = scene->watcher.watch( VERTEX_SHADER );
+    scene->shaderFiles[ 1 ] = scene->watcher.watch( FRAGMENT_SHADER );
+    scene->meshFile = scene->watcher.watch( MESH );
+    scene->watcher.start();
+    std::cout << "  watching " << ( scene->watcher.native() ? "with inotify" : "by polling" ) << std::endl;
+
+    scene->nextFrame = Bench::Clock::now();
+    while( scene->streamer.resident( scene->mesh ) == false )
+        Frame( scene );
+    Frame( scene );
+    scene->frames.clear();
+
+    std::vector< double > shaderTimes, meshTimes;
+    bool passed = scene->lit > 0U;
+    for( unsigned int round = 0U; round < rounds && passed == true; round += 1U ) {
+        std::ostringstream marker;
+        marker << " round " << round << "\n";
+        const GLuint before = scene->program;
+        Bench::Clock::time_point saved = Bench::Clock::now();
+        WriteFile( VERTEX_SHADER, vertex + "\n//" + marker.str() );
+        const double shader = Await( scene, &Scene::programSwaps, saved );
+        passed = shader >= 0.0 && scene->program != before && scene->lit > 0U;
+        shaderTimes.push_back( shader );
+
+        const GLuint good = scene->program;
+        saved = Bench::Clock::now();
+        WriteFile( VERTEX_SHADER, vertex + "\nvoid broken() { undeclared = 1.0; }\n" );
+        passed = passed && Await( scene, &Scene::programFailures, saved ) >= 0.0 && scene->program == good;
+        Frame( scene );
+        passed = passed && scene->lit > 0U;
+
+        const unsigned int version = scene->streamer.version( scene->mesh );
+        saved = Bench::Clock::now();
+        WriteFile( MESH, teapot + "\n#" + marker.str() );
+        const double mesh = Await( scene, &Scene::meshSwaps, saved );
+        Frame( scene );
+        const unsigned int reloaded = scene->streamer.version( scene->mesh );
+        passed = passed && mesh >= 0.0 && reloaded != version && scene->lit > 0U;
+        meshTimes.push_back( mesh );
+
+        saved = Bench::Clock::now();
+        WriteFile( MESH, std::string() );
+        passed = passed && Await( scene, &Scene::meshFailures, saved ) >= 0.0
+            && scene->streamer.version( scene->mesh ) == reloaded;
+        Frame( scene );
+        passed = passed && scene->lit > 0U;
+        if( passed == false )
+            std::cout << "    round " << round << " FAILED" << std::endl;
+    }
+
+    std::cout << "  " << shaderTimes.size() << " rounds, save to end of the first frame drawn with it" << std::endl;
+    Report( "shader", shaderTimes );
+    Report( "mesh", meshTimes );
+    Report( "frame", scene->frames );
+
+    scene->watcher.stop();
+    scene->reloader.release();
+    scene->streamer.release();
+    App::GetGLState().deleteProgram( scene->program );
+    App::GetGLState().deleteBuffers( 2, scene->uniformBuffers );
+    App::GetGLState().deleteVertexArrays( 1, &scene->vertexArray );
+    delete scene;
+    glfwDestroyWindow( reloadContext );
+    glfwDestroyWindow( window );
+    glfwTerminate();
+
+    const char* files[] = { VERTEX_SHADER, FRAGMENT_SHADER, PROGRAM_CACHE, MESH, "bench_reload/teapot.cache" };
+    for( unsigned int file = 0U; file < sizeof(files) / sizeof(files[ 0 ]); file += 1U )
+        remove( files[ file ] );
+    rmdir( DIRECTORY );
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,93 @@
+/*
+Post-transform vertex cache report: ACMR and ATVR on a simulated FIFO cache
+before and after each index optimization pass, plus pass timings. "load" is
+OptimizeMesh(), what MeshBuffer bakes into the cache; a mesh whose load
+order simulates more misses than its raw order on the 16 entry FIFO is
+flagged and fails the run.
+Run from the repository root so that res/ is reachable.
+*/
+#include <iostream>
+#include <iomanip>
+
+#include "ObjParser.hpp"
+#include "MeshBuffer.hpp"
+#include "IndexOptimizer.hpp"
+#include "Bench.hpp"
+
+static const char* MESHES[] = { "res/teapot", "res/pumpkin", "res/sphere" };
+static const unsigned int CACHE_SIZES[] = { 16U, 32U };
+static const unsigned int REPEAT = 5U;
+
+static void Report( const char* name, const std::vector< AIndex >& indicies,
+    const unsigned int vertexCount, const double seconds ) {
+    std::cout << "  " << std::left << std::setw( 10 ) << name << std::right << std::fixed;
+    for( unsigned int index = 0U; index < sizeof( CACHE_SIZES ) / sizeof( CACHE_SIZES[ 0 ] ); index += 1U ) {
+        const VertexCacheStats stats = AnalyzeVertexCache( indicies, vertexCount, CACHE_SIZES[ index ] );
+        std::cout << "  fifo" << std::setw( 2 ) << CACHE_SIZES[ index ]
+            << " acmr " << std::setprecision( 3 ) << stats.acmr
+            << " atvr " << stats.atvr;
+    }
+    if( seconds > 0.0 )
+        std::cout << std::setw( 10 ) << std::setprecision( 3 ) << seconds * 1e3 << " ms";
+    std::cout << std::endl;
+}
+
+int main( void ) {
+    int status = EXIT_SUCCESS;
+    for( unsigned int index = 0U; index < sizeof( MESHES ) / sizeof( MESHES[ 0 ] ); index += 1U ) {
+        const char* meshPath = MESHES[ index ];
+        Mesh mesh;
+        if( FileMapMesh( meshPath, &mesh ) == false ) {
+            std::cout << "Error: File not exist, " << meshPath << std::endl;
+            return EXIT_FAILURE;
+        }
+        std::vector< AVertex > verticies;
+        std::vector< AColor > colors;
+        std::vector< AIndex > raw;
+        ConvertMesh( mesh, &verticies, &colors, &raw );
+        const unsigned int vertexCount = (unsigned int)verticies.size();
+        std::cout << meshPath << ": " << vertexCount << " vertices, " << raw.size() << " triangles" << std::endl;
+        Report( "raw", raw, vertexCount, 0.0 );
+
+        std::vector< AIndex > forsyth;
+        const double forsythTime = Bench::BestOf( REPEAT, [ & ]() {
+            forsyth = raw;
+            OptimizeVertexCache( &forsyth, vertexCount );
+        } );
+        Report( "forsyth", forsyth, vertexCount, forsythTime );
+
+        std::vector< AIndex > overdraw;
+        const double overdrawTime = Bench::BestOf( REPEAT, [ & ]() {
+            overdraw = forsyth;
+            OptimizeOverdraw( &overdraw, verticies );
+        } );
+        Report( "overdraw", overdraw, vertexCount, overdrawTime );
+
+        std::vector< AIndex > fetch;
+        std::vector< unsigned int > remap;
+        unsigned int fetchCount = 0U;
+        const double fetchTime = Bench::BestOf( REPEAT, [ & ]() {
+            fetch = overdraw;
+            fetchCount = OptimizeVertexFetch( &fetch, vertexCount, &remap );
+        } );
+        Report( "fetch", fetch, fetchCount, fetchTime );
+
+        std::vector< AVertex > loadVerticies;
+        std::vector< AColor > loadColors;
+        std::vector< AIndex > load;
+        const double loadTime = Bench::BestOf( REPEAT, [ & ]() {
+            loadVerticies = verticies;
+            loadColors = colors;
+            load = raw;
+            OptimizeMesh( &loadVerticies, &loadColors, &load );
+        } );
+        Report( "load", load, (unsigned int)loadVerticies.size(), loadTime );
+        const float rawAcmr = AnalyzeVertexCache( raw, vertexCount ).acmr;
+        const float loadAcmr = AnalyzeVertexCache( load, (unsigned int)loadVerticies.size() ).acmr;
+        if( loadAcmr > rawAcmr ) {
+            std::cout << "  REGRESSION: fifo16 acmr " << rawAcmr << " -> " << loadAcmr << std::endl;
+            status = EXIT_FAILURE;
+        }
+    }
+    return status;
+}
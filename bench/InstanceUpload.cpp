@@ -0,0 +1,128 @@
+/*
+CPU cost of feeding per-body transforms to the GPU.
+Per-object: one MVP multiply, one glUniformMatrix4fv copy and one
+glDrawElements per body, as main.cpp drew before instancing.
+Instanced: App::ComposeInstance writes model matrix and color into a ring
+region, either straight into the mapped memory or staged and copied in LOD
+order as main.cpp does. GL calls are counted, not issued.
+Usage: bench_instance_upload.out [frames]
+*/
+#include <stdlib.h>
+#include <string.h>
+#include <cmath>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+
+#include "InstanceBuffer.hpp"
+#include "Bench.hpp"
+
+static const unsigned int LOD_COUNT = 4U;
+// Attribute pointers set by InstanceBuffer::bind(): four model columns and a color.
+static const unsigned int BIND_CALLS = 5U;
+
+// Column-major out = a * b.
+static void Multiply( const float* a, const float* b, float* out ) {
+    for( unsigned int column = 0U; column < 4U; column += 1U )
+        for( unsigned int row = 0U; row < 4U; row += 1U )
+            out[ 4U * column + row ] = a[ row ] * b[ 4U * column ] + a[ 4U + row ] * b[ 4U * column + 1U ]
+                + a[ 8U + row ] * b[ 4U * column + 2U ] + a[ 12U + row ] * b[ 4U * column + 3U ];
+}
+
+struct Body {
+    float position[ 3 ];
+    float rotation[ 4 ];
+    float color[ 4 ];
+};
+
+static void Report( const char* name, const double seconds, const unsigned int bodies,
+    const unsigned long long calls ) {
+    std::cout << "    " << std::left << std::setw( 20 ) << name << std::right << std::fixed
+        << std::setprecision( 2 ) << std::setw( 9 ) << seconds * 1e9 / bodies << " ns/body "
+        << std::setw( 9 ) << bodies * sizeof(App::AInstance) / seconds / 1e9 << " GB/s "
+        << std::setw( 9 ) << calls << " GL calls/frame" << std::endl;
+}
+
+static void Run( const unsigned int bodyCount, const unsigned int frames ) {
+    std::vector< Body > bodies( bodyCount );
+    for( unsigned int index = 0U; index < bodyCount; index += 1U ) {
+        const float angle = 0.001f * index;
+        Body& body = bodies[ index ];
+        body.position[ 0 ] = (float)( index % 100U );
+        body.position[ 1 ] = 50.f;
+        body.position[ 2 ] = -(float)( index / 100U );
+        body.rotation[ 0 ] = 0.f;
+        body.rotation[ 1 ] = std::sin( angle );
+        body.rotation[ 2 ] = 0.f;
+        body.rotation[ 3 ] = std::cos( angle );
+        body.color[ 0 ] = body.color[ 1 ] = body.color[ 2 ] = body.color[ 3 ] = 1.f;
+    }
+    float base[ 16 ] = { 0.2f, 0.f, 0.f, 0.f, 0.f, 0.f, -0.2f, 0.f, 0.f, 0.2f, 0.f, 0.f, 0.f, 20.f, 0.f, 1.f };
+    float viewProjection[ 16 ] = { 1.8f, 0.f, 0.f, 0.f, 0.f, 2.4f, 0.f, 0.f, 0.f, 0.f, -1.f, -1.f, 0.f, -50.f, 30.f, 0.f };
+    // Stand-ins for the driver's uniform storage and the mapped ring.
+    std::vector< float > uniform( 16U );
+    std::vector< App::AInstance > ring( App::InstanceBuffer::REGIONS * bodyCount );
+    std::vector< App::AInstance > staged( bodyCount );
+    std::vector< unsigned int > lods( bodyCount );
+    for( unsigned int index = 0U; index < bodyCount; index += 1U )
+        lods[ index ] = std::min( index * LOD_COUNT / bodyCount, LOD_COUNT - 1U );
+    float checksum = 0.f;
+
+    std::cout << bodyCount << " bodies, " << sizeof(App::AInstance) << " bytes per instance" << std::endl;
+
+    const double perObject = Bench::BestOf( 3U, [ & ]() {
+        for( unsigned int frame = 0U; frame < frames; frame += 1U ) {
+            for( unsigned int index = 0U; index < bodyCount; index += 1U ) {
+                App::AInstance instance;
+                float mvp[ 16 ];
+                App::ComposeInstance( bodies[ index ].position, bodies[ index ].rotation, base,
+                    bodies[ index ].color, &instance );
+                Multiply( viewProjection, instance.model, mvp );
+                memcpy( &uniform[ 0 ], mvp, sizeof(mvp) );
+                checksum += uniform[ index & 15U ];
+            }
+        }
+    } ) / frames;
+    Report( "per-object", perObject, bodyCount, 2ULL * bodyCount );
+
+    const double direct = Bench::BestOf( 3U, [ & ]() {
+        for( unsigned int frame = 0U; frame < frames; frame += 1U ) {
+            App::AInstance* region = &ring[ ( frame % App::InstanceBuffer::REGIONS ) * bodyCount ];
+            for( unsigned int index = 0U; index < bodyCount; index += 1U )
+                App::ComposeInstance( bodies[ index ].position, bodies[ index ].rotation, base,
+                    bodies[ index ].color, region + index );
+            checksum += region[ frame % bodyCount ].model[ 0 ];
+        }
+    } ) / frames;
+    Report( "instanced direct", direct, bodyCount, 1ULL + BIND_CALLS + 1ULL );
+
+    const double sorted = Bench::BestOf( 3U, [ & ]() {
+        for( unsigned int frame = 0U; frame < frames; frame += 1U ) {
+            unsigned int first[ LOD_COUNT + 1U ] = { 0U };
+            for( unsigned int index = 0U; index < bodyCount; index += 1U ) {
+                App::ComposeInstance( bodies[ index ].position, bodies[ index ].rotation, base,
+                    bodies[ index ].color, &staged[ index ] );
+                first[ lods[ index ] + 1U ] += 1U;
+            }
+            for( unsigned int level = 0U; level < LOD_COUNT; level += 1U )
+                first[ level + 1U ] += first[ level ];
+            App::AInstance* region = &ring[ ( frame % App::InstanceBuffer::REGIONS ) * bodyCount ];
+            for( unsigned int index = 0U; index < bodyCount; index += 1U )
+                memcpy( region + first[ lods[ index ] ]++, &staged[ index ], sizeof(App::AInstance) );
+            checksum += region[ frame % bodyCount ].model[ 0 ];
+        }
+    } ) / frames;
+    Report( "instanced by LOD", sorted, bodyCount, 1ULL + LOD_COUNT * ( BIND_CALLS + 1ULL ) );
+
+    // The CPU work is a small part of the per-object path; the 2 * bodies
+    // GL calls each cost a driver validation and are what instancing removes.
+    std::cout << "    checksum " << checksum << std::endl;
+}
+
+int main( int argc, char** argv ) {
+    const unsigned int frames = argc > 1 ? (unsigned int)atoi( argv[ 1 ] ) : 100U;
+    Run( 1000U, frames );
+    Run( 10000U, frames );
+    Run( 100000U, frames );
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,119 @@
+/*
+Cost of a log call on the calling thread. "endl" is the old Application::log
+path: format with an ostream and flush per line. "push" queues a record for
+the writer thread; "filtered" is a push below the level. Per-call p50/p99
+come from timing every call. "per frame" pushes FRAME_MESSAGES records and
+sleeps a frame; the burst runs have four threads log flat out, so drops
+there show how the bounded ring sheds load when the writer falls behind.
+Usage: bench_logger.out [messages]
+*/
+#include <stdlib.h>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "Logger.hpp"
+#include "Bench.hpp"
+
+static const unsigned int THREADS = 4U;
+static const unsigned int FRAME_MESSAGES = 256U;
+static const char* LOG_PATH = "bench_log.txt";
+
+static void Report( const char* name, const std::vector< double >& samples, const double total ) {
+    std::cout << "  " << std::left << std::setw( 12 ) << name << std::right << std::fixed << std::setprecision( 1 )
+        << std::setw( 9 ) << total * 1e9 / samples.size() << " ns/call  p50 "
+        << std::setw( 8 ) << Bench::Percentile( samples, 50.0 ) * 1e9 << " ns  p99 "
+        << std::setw( 9 ) << Bench::Percentile( samples, 99.0 ) * 1e9 << " ns" << std::endl;
+}
+
+static void FormatValue( const App::LogRecord& in_record, std::string* out_text ) {
+    out_text->append( "Frame " + std::to_string( in_record.arguments[ 0 ] )
+        + " value " + std::to_string( in_record.arguments[ 1 ] ) + "." );
+}
+
+int main( int argc, char** argv ) {
+    const unsigned int messages = argc > 1 ? (unsigned int)atoi( argv[ 1 ] ) : 200000U;
+    std::vector< double > samples( messages );
+
+    {
+        std::ofstream out( LOG_PATH );
+        const Bench::Clock::time_point begin = Bench::Clock::now();
+        for( unsigned int index = 0U; index < messages; index += 1U ) {
+            const Bench::Clock::time_point call = Bench::Clock::now();
+            std::stringbuf info;
+            std::ostream stream( &info );
+            stream << "Frame " << index << " value " << index * 7U << ".";
+            out << "Info: " << info.str() << std::endl;
+            samples[ index ] = Bench::Seconds( call, Bench::Clock::now() );
+        }
+        Report( "endl", samples, Bench::Seconds( begin, Bench::Clock::now() ) );
+    }
+
+    {
+        std::ofstream out( LOG_PATH );
+        App::Logger logger( &out );
+        const Bench::Clock::time_point begin = Bench::Clock::now();
+        for( unsigned int index = 0U; index < messages; index += 1U ) {
+            const Bench::Clock::time_point call = Bench::Clock::now();
+            logger.push( App::Info, FormatValue, (int)index, (int)( index * 7U ) );
+            samples[ index ] = Bench::Seconds( call, Bench::Clock::now() );
+        }
+        const double pushed = Bench::Seconds( begin, Bench::Clock::now() );
+        logger.flush();
+        Report( "push", samples, pushed );
+        std::cout << "  flush " << std::setprecision( 1 ) << Bench::Seconds( begin, Bench::Clock::now() ) * 1e3
+            << " ms after first push, " << logger.dropped() << " dropped" << std::endl;
+
+        logger.setLevel( App::Warning );
+        const Bench::Clock::time_point filteredBegin = Bench::Clock::now();
+        for( unsigned int index = 0U; index < messages; index += 1U ) {
+            const Bench::Clock::time_point call = Bench::Clock::now();
+            logger.push( App::Info, FormatValue, (int)index, (int)( index * 7U ) );
+            samples[ index ] = Bench::Seconds( call, Bench::Clock::now() );
+        }
+        Report( "filtered", samples, Bench::Seconds( filteredBegin, Bench::Clock::now() ) );
+    }
+
+    {
+        std::ofstream out( LOG_PATH );
+        App::Logger logger( &out );
+        const unsigned int frames = std::max( messages / FRAME_MESSAGES, 1U );
+        std::vector< double > frameSamples( frames * FRAME_MESSAGES );
+        double pushed = 0.0;
+        for( unsigned int frame = 0U; frame < frames; frame += 1U ) {
+            const Bench::Clock::time_point begin = Bench::Clock::now();
+            for( unsigned int index = 0U; index < FRAME_MESSAGES; index += 1U ) {
+                const Bench::Clock::time_point call = Bench::Clock::now();
+                logger.push( App::Info, FormatValue, (int)frame, (int)index );
+                frameSamples[ frame * FRAME_MESSAGES + index ] = Bench::Seconds( call, Bench::Clock::now() );
+            }
+            pushed += Bench::Seconds( begin, Bench::Clock::now() );
+            std::this_thread::sleep_for( std::chrono::milliseconds( 16 ) );
+        }
+        logger.flush();
+        Report( "per frame", frameSamples, pushed );
+        std::cout << "  " << logger.dropped() << " of " << frameSamples.size() << " dropped" << std::endl;
+    }
+
+    {
+        std::ofstream out( LOG_PATH );
+        App::Logger logger( &out );
+        const Bench::Clock::time_point begin = Bench::Clock::now();
+        std::vector< std::thread > threads;
+        for( unsigned int thread = 0U; thread < THREADS; thread += 1U )
+            threads.push_back( std::thread( [ & ]() {
+                for( unsigned int index = 0U; index < messages / THREADS; index += 1U )
+                    logger.push( App::Info, FormatValue, (int)index, (int)thread );
+            } ) );
+        for( unsigned int thread = 0U; thread < THREADS; thread += 1U )
+            threads[ thread ].join();
+        logger.flush();
+        std::cout << "  " << THREADS << " threads " << std::setprecision( 1 )
+            << Bench::Seconds( begin, Bench::Clock::now() ) * 1e9 / messages << " ns/call, "
+            << logger.dropped() << " of " << messages << " dropped" << std::endl;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,66 @@
+/*
+Mesh startup time through App::MeshBuffer for every mesh in res/:
+    text    parse OBJ and convert, no cache
+    cold    no cache on disk: parse, convert and write the cache
+    warm    map an up-to-date cache
+Run from the repository root so that res/ is reachable.
+*/
+#include <stdio.h>
+#include <string.h>
+#include <iostream>
+#include <iomanip>
+
+#include "MeshBuffer.hpp"
+#include "MeshCache.hpp"
+#include "Bench.hpp"
+
+static const char* MESHES[] = {
+    "res/cube", "res/shape", "res/teapot", "res/pumpkin", "res/sphere"
+};
+static const unsigned int REPEAT = 10U;
+
+static bool SameBuffer( const App::MeshBuffer& a, const App::MeshBuffer& b ) {
+    return a.vertexCount() == b.vertexCount() && a.faceCount() == b.faceCount()
+        && memcmp( a.verticies(), b.verticies(), sizeof(AVertex) * a.vertexCount() ) == 0
+        && memcmp( a.colors(), b.colors(), sizeof(AColor) * a.vertexCount() ) == 0
+        && memcmp( a.indicies(), b.indicies(), sizeof(AIndex) * a.faceCount() ) == 0;
+}
+
+int main( void ) {
+    int status = EXIT_SUCCESS;
+    std::cout << std::left << std::setw( 14 ) << "mesh" << std::right
+        << std::setw( 11 ) << "text ms" << std::setw( 11 ) << "cold ms"
+        << std::setw( 11 ) << "warm ms" << std::setw( 10 ) << "speedup" << std::endl;
+    for( unsigned int index = 0U; index < sizeof( MESHES ) / sizeof( MESHES[ 0 ] ); index += 1U ) {
+        const char* meshPath = MESHES[ index ];
+        const std::string cachePath = MeshCachePath( meshPath );
+
+        const double textTime = Bench::BestOf( REPEAT, [ meshPath ]() {
+            App::MeshBuffer mesh;
+            mesh.load( meshPath, false );
+        } );
+        const double coldTime = Bench::BestOf( REPEAT, [ meshPath, &cachePath ]() {
+            remove( cachePath.c_str() );
+            App::MeshBuffer mesh;
+            mesh.load( meshPath );
+        } );
+        const double warmTime = Bench::BestOf( REPEAT, [ meshPath ]() {
+            App::MeshBuffer mesh;
+            mesh.load( meshPath );
+        } );
+
+        App::MeshBuffer text, warm;
+        text.load( meshPath, false );
+        warm.load( meshPath );
+        const bool same = warm.cached() && SameBuffer( text, warm );
+        if( same == false )
+            status = EXIT_FAILURE;
+
+        std::cout << std::left << std::setw( 14 ) << meshPath << std::right << std::fixed
+            << std::setprecision( 3 ) << std::setw( 11 ) << textTime * 1e3
+            << std::setw( 11 ) << coldTime * 1e3 << std::setw( 11 ) << warmTime * 1e3
+            << std::setprecision( 1 ) << std::setw( 9 ) << textTime / warmTime << "x"
+            << ( same ? "" : "  MISMATCH" ) << std::endl;
+    }
+    return status;
+}
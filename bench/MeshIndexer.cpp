@@ -0,0 +1,52 @@
+/*
+Vertex welding report: unique interleaved vertices, index counts, GPU bytes
+and build time of IndexMesh() with and without epsilon welding.
+Run from the repository root so that res/ is reachable.
+*/
+#include <iostream>
+#include <iomanip>
+
+#include "ObjParser.hpp"
+#include "MeshIndexer.hpp"
+#include "Bench.hpp"
+
+static const char* MESHES[] = { "res/cube", "res/teapot", "res/sphere" };
+static const float WELD_EPSILON = 1e-4f;
+static const unsigned int REPEAT = 10U;
+
+static void Report( const char* name, const IndexedMesh& mesh, const size_t corners, const double seconds ) {
+    // Without indexing every corner is its own vertex.
+    const size_t flatBytes = corners * sizeof( AInterleavedVertex );
+    const size_t bytes = mesh.verticies.size() * sizeof( AInterleavedVertex )
+        + mesh.indicies.size() * sizeof( AIndex );
+    std::cout << "  " << std::left << std::setw( 8 ) << name << std::right
+        << std::setw( 9 ) << mesh.verticies.size() << " vertices"
+        << std::setw( 9 ) << mesh.indicies.size() * 3U << " indices"
+        << std::setw( 10 ) << bytes << " B (flat " << flatBytes << " B, "
+        << std::fixed << std::setprecision( 1 ) << 100.0 * bytes / flatBytes << "%)"
+        << std::setw( 9 ) << std::setprecision( 3 ) << seconds * 1e3 << " ms" << std::endl;
+}
+
+int main( void ) {
+    for( unsigned int index = 0U; index < sizeof( MESHES ) / sizeof( MESHES[ 0 ] ); index += 1U ) {
+        const char* meshPath = MESHES[ index ];
+        Mesh mesh;
+        if( FileMapMesh( meshPath, &mesh ) == false ) {
+            std::cout << "Error: File not exist, " << meshPath << std::endl;
+            return EXIT_FAILURE;
+        }
+        std::cout << meshPath << ": " << mesh.v.size() << " v, " << mesh.vn.size() << " vn, "
+            << mesh.vt.size() << " vt, " << mesh.f.size() << " f" << std::endl;
+
+        IndexedMesh exact, welded;
+        const double exactTime = Bench::BestOf( REPEAT, [ &mesh, &exact ]() {
+            IndexMesh( mesh, &exact );
+        } );
+        const double weldTime = Bench::BestOf( REPEAT, [ &mesh, &welded ]() {
+            IndexMesh( mesh, &welded, WELD_EPSILON );
+        } );
+        Report( "exact", exact, mesh.f.size() * 3U, exactTime );
+        Report( "welded", welded, mesh.f.size() * 3U, weldTime );
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,207 @@
+/*
+CPU memory spent loading every mesh in res/. Each mode runs in a child
+process of its own so peak RSS is its alone.
+"baseline": FileLoadMesh() then the vertex, color and index copies
+main.cpp used to allocate; the Mesh and the copies are held, as main.cpp
+held them. Every other mode is also reported relative to it.
+"text": App::MeshBuffer parses the OBJ text and keeps the result, as a
+physics mesh needs it. "streamed": as App::AssetStreamer does, the
+MeshBuffer is packed and released, and the packed arrays are dropped
+once uploaded. "cached": App::MeshBuffer maps the binary cache.
+Reports heap allocations, bytes allocated, peak and held heap, and peak
+RSS. Allocations are counted through operator new. "text" and "streamed"
+also optimize each mesh and build its LOD chain, which the baseline never
+did, so they allocate more in total.
+Usage: bench_mesh_memory.out
+*/
+#include <stdlib.h>
+#include <stdio.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include <new>
+#include <vector>
+
+#include "util.h"
+#include "MeshBuffer.hpp"
+#include "VertexPacking.hpp"
+
+static const char* MESHES[] = { "res/cube", "res/shape", "res/pumpkin", "res/sphere", "res/teapot" };
+static const unsigned int MESH_COUNT = sizeof(MESHES) / sizeof(MESHES[ 0 ]);
+
+// Heap traffic through operator new. A header in front of every block
+// remembers its size for operator delete.
+static size_t allocations = 0U, allocatedBytes = 0U, liveBytes = 0U, peakBytes = 0U;
+static const size_t HEADER = 16U;
+
+void* operator new( size_t in_size ) {
+    char* block = static_cast< char* >( malloc( in_size + HEADER ) );
+    if( block == NULL )
+        throw std::bad_alloc();
+    *reinterpret_cast< size_t* >( block ) = in_size;
+    allocations += 1U;
+    allocatedBytes += in_size;
+    liveBytes += in_size;
+    peakBytes = std::max( peakBytes, liveBytes );
+    return block + HEADER;
+}
+void* operator new[]( size_t in_size ) {
+    return operator new( in_size );
+}
+void* operator new( size_t in_size, const std::nothrow_t& ) noexcept {
+    try {
+        return operator new( in_size );
+    } catch( const std::bad_alloc& ) {
+        return NULL;
+    }
+}
+void operator delete( void* in_pointer ) noexcept {
+    if( in_pointer == NULL )
+        return;
+    char* block = static_cast< char* >( in_pointer ) - HEADER;
+    liveBytes -= *reinterpret_cast< size_t* >( block );
+    free( block );
+}
+void operator delete[]( void* in_pointer ) noexcept {
+    operator delete( in_pointer );
+}
+
+// Percent change from in_baseline to in_value.
+static double Change( const double in_baseline, const double in_value ) {
+    return in_baseline > 0.0 ? ( in_value / in_baseline - 1.0 ) * 100.0 : 0.0;
+}
+
+static double PeakRssMiB( void ) {
+    struct rusage usage;
+    getrusage( RUSAGE_SELF, &usage );
+#ifdef __APPLE__
+    return usage.ru_maxrss / ( 1024.0 * 1024.0 );
+#else
+    return usage.ru_maxrss / 1024.0;
+#endif
+}
+
+// What a mode used, sent from its child process.
+struct Usage {
+    size_t  allocations;
+    double  allocated;  // MiB
+    double  peak;
+    double  held;
+    double  rss;
+};
+
+struct LegacyMesh {
+    Mesh        mesh;
+    AVertex*    verticies;
+    AColor*     colors;
+    AIndex*     indicies;
+};
+
+static bool Baseline( void ) {
+    std::vector< LegacyMesh* > meshes;
+    for( unsigned int index = 0U; index < MESH_COUNT; index += 1U ) {
+        LegacyMesh* legacy = new LegacyMesh;
+        if( FileLoadMesh( MESHES[ index ], &legacy->mesh ) == false )
+            return false;
+        const Mesh& mesh = legacy->mesh;
+        std::vector< AVertex > verticies;
+        std::vector< AColor > colors;
+        std::vector< AIndex > indicies;
+        ConvertMesh( mesh, &verticies, &colors, &indicies );
+        legacy->verticies = new AVertex[ verticies.size() ];
+        legacy->colors = new AColor[ colors.size() ];
+        legacy->indicies = new AIndex[ indicies.size() ];
+        std::copy( verticies.begin(), verticies.end(), legacy->verticies );
+        std::copy( colors.begin(), colors.end(), legacy->colors );
+        std::copy( indicies.begin(), indicies.end(), legacy->indicies );
+        meshes.push_back( legacy );
+    }
+    return true;
+}
+
+static bool Text( const bool in_useCache ) {
+    std::vector< App::MeshBuffer* > meshes;
+    for( unsigned int index = 0U; index < MESH_COUNT; index += 1U ) {
+        meshes.push_back( new App::MeshBuffer );
+        if( meshes.back()->load( MESHES[ index ], in_useCache ) == false )
+            return false;
+    }
+    return true;
+}
+
+static bool Streamed( void ) {
+    for( unsigned int index = 0U; index < MESH_COUNT; index += 1U ) {
+        App::MeshBuffer mesh;
+        if( mesh.load( MESHES[ index ], false ) == false )
+            return false;
+        PackedMesh packed;
+        PackMesh( mesh, &packed );
+        mesh.release();
+        // The GPU owns the packed arrays from here on.
+    }
+    return true;
+}
+
+// Run in_mode in a child process and print its usage, with the change
+// from in_baseline unless it is NULL.
+template< typename Mode >
+static bool Run( const char* in_name, Mode in_mode, const Usage* in_baseline, Usage* out_usage ) {
+    int channel[ 2 ];
+    if( pipe( channel ) != 0 )
+        return false;
+    std::cout.flush();
+    const pid_t child = fork();
+    if( child == 0 ) {
+        close( channel[ 0 ] );
+        allocations = allocatedBytes = liveBytes = peakBytes = 0U;
+        const bool loaded = in_mode();
+        // The meshes are deliberately left alive: held bytes are what a
+        // running program keeps.
+        const Usage usage = { allocations, allocatedBytes / 1048576.0, peakBytes / 1048576.0, liveBytes / 1048576.0,
+            PeakRssMiB() };
+        const bool sent = write( channel[ 1 ], &usage, sizeof( usage ) ) == (ssize_t)sizeof( usage );
+        _exit( loaded && sent ? EXIT_SUCCESS : EXIT_FAILURE );
+    }
+    close( channel[ 1 ] );
+    const bool received = child > 0 && read( channel[ 0 ], out_usage, sizeof( *out_usage ) ) == (ssize_t)sizeof( *out_usage );
+    close( channel[ 0 ] );
+    int status = 0;
+    if( child < 0 || waitpid( child, &status, 0 ) != child )
+        return false;
+    if( received == false || WIFEXITED( status ) == false || WEXITSTATUS( status ) != EXIT_SUCCESS ) {
+        std::cout << "    " << in_name << " FAILED" << std::endl;
+        return false;
+    }
+    const Usage& usage = *out_usage;
+    printf( "    %-9s %9zu allocations %9.2f MiB allocated %8.2f MiB peak heap %8.2f MiB held %8.2f MiB peak RSS\n",
+        in_name, usage.allocations, usage.allocated, usage.peak, usage.held, usage.rss );
+    if( in_baseline != NULL )
+        printf( "    %-9s %+8.0f%%%13s%+8.0f%%%15s%+7.0f%%%15s%+7.0f%%%10s%+7.0f%%\n",
+            "", Change( (double)in_baseline->allocations, (double)usage.allocations ), "",
+            Change( in_baseline->allocated, usage.allocated ), "", Change( in_baseline->peak, usage.peak ), "",
+            Change( in_baseline->held, usage.held ), "", Change( in_baseline->rss, usage.rss ) );
+    fflush( stdout );
+    return true;
+}
+
+int main( int argc, char** argv ) {
+    // Make sure the caches exist for the cached run.
+    for( unsigned int index = 0U; index < MESH_COUNT; index += 1U ) {
+        App::MeshBuffer mesh;
+        if( mesh.load( MESHES[ index ] ) == false ) {
+            std::cout << MESHES[ index ] << ": parse error" << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    std::cout << "Loading all of res/, " << MESH_COUNT << " meshes, changes relative to the baseline" << std::endl;
+    Usage baseline, usage;
+    if( Run( "baseline", []() { return Baseline(); }, NULL, &baseline ) == false )
+        return EXIT_FAILURE;
+    bool passed = Run( "text", []() { return Text( false ); }, &baseline, &usage );
+    passed = Run( "streamed", []() { return Streamed(); }, &baseline, &usage ) && passed;
+    passed = Run( "cached", []() { return Text( true ); }, &baseline, &usage ) && passed;
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,146 @@
+/*
+LOD chain report: triangle count, quadric error, measured deviation and
+build time of every level, plus cold/warm load of the cached chain.
+Run from the repository root so that res/ is reachable.
+*/
+#include <stdio.h>
+#include <cmath>
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+
+#include "ObjParser.hpp"
+#include "MeshBuffer.hpp"
+#include "MeshCache.hpp"
+#include "IndexOptimizer.hpp"
+#include "MeshSimplifier.hpp"
+#include "Bench.hpp"
+
+static const char* MESHES[] = { "res/teapot", "res/pumpkin", "res/sphere" };
+static const unsigned int REPEAT = 3U;
+// Deviation is measured on at most this many source vertices.
+static const size_t DEVIATION_SAMPLES = 2000U;
+
+struct Vec {
+    double x, y, z;
+};
+static Vec Sub( const Vec& a, const Vec& b ) { Vec r = { a.x - b.x, a.y - b.y, a.z - b.z }; return r; }
+static double Dot( const Vec& a, const Vec& b ) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+static Vec ToVec( const AVertex& v ) { Vec r = { v.x, v.y, v.z }; return r; }
+
+// Squared distance from p to triangle abc (Ericson, Real-Time Collision Detection 5.1.5).
+static double PointTriangle( const Vec& p, const Vec& a, const Vec& b, const Vec& c ) {
+    const Vec ab = Sub( b, a ), ac = Sub( c, a ), ap = Sub( p, a );
+    const double d1 = Dot( ab, ap ), d2 = Dot( ac, ap );
+    Vec q;
+    if( d1 <= 0 && d2 <= 0 ) q = a;
+    else {
+        const Vec bp = Sub( p, b );
+        const double d3 = Dot( ab, bp ), d4 = Dot( ac, bp );
+        const Vec cp = Sub( p, c );
+        const double d5 = Dot( ab, cp ), d6 = Dot( ac, cp );
+        const double vc = d1 * d4 - d3 * d2, vb = d5 * d2 - d1 * d6, va = d3 * d6 - d5 * d4;
+        if( d3 >= 0 && d4 <= d3 ) q = b;
+        else if( d6 >= 0 && d5 <= d6 ) q = c;
+        else if( vc <= 0 && d1 >= 0 && d3 <= 0 ) {
+            const double t = d1 / ( d1 - d3 );
+            Vec r = { a.x + t * ab.x, a.y + t * ab.y, a.z + t * ab.z }; q = r;
+        }
+        else if( vb <= 0 && d2 >= 0 && d6 <= 0 ) {
+            const double t = d2 / ( d2 - d6 );
+            Vec r = { a.x + t * ac.x, a.y + t * ac.y, a.z + t * ac.z }; q = r;
+        }
+        else if( va <= 0 && ( d4 - d3 ) >= 0 && ( d5 - d6 ) >= 0 ) {
+            const double t = ( d4 - d3 ) / ( ( d4 - d3 ) + ( d5 - d6 ) );
+            Vec r = { b.x + t * ( c.x - b.x ), b.y + t * ( c.y - b.y ), b.z + t * ( c.z - b.z ) }; q = r;
+        }
+        else {
+            const double denom = 1.0 / ( va + vb + vc );
+            const double v = vb * denom, w = vc * denom;
+            Vec r = { a.x + ab.x * v + ac.x * w, a.y + ab.y * v + ac.y * w, a.z + ab.z * v + ac.z * w }; q = r;
+        }
+    }
+    const Vec d = Sub( p, q );
+    return Dot( d, d );
+}
+
+// Largest distance from sampled vertices to the simplified surface.
+static double Deviation( const std::vector< AVertex >& verticies, const AIndex* faces, const size_t faceCount ) {
+    const size_t stride = std::max< size_t >( 1U, verticies.size() / DEVIATION_SAMPLES );
+    double worst = 0.0;
+    for( size_t vertex = 0U; vertex < verticies.size(); vertex += stride ) {
+        const Vec p = ToVec( verticies[ vertex ] );
+        double best = 1e300;
+        for( size_t face = 0U; face < faceCount; face += 1U ) {
+            best = std::min( best, PointTriangle( p, ToVec( verticies[ faces[ face ].a ] ),
+                ToVec( verticies[ faces[ face ].b ] ), ToVec( verticies[ faces[ face ].c ] ) ) );
+        }
+        worst = std::max( worst, best );
+    }
+    return std::sqrt( worst );
+}
+
+int main( void ) {
+    for( unsigned int index = 0U; index < sizeof( MESHES ) / sizeof( MESHES[ 0 ] ); index += 1U ) {
+        const char* meshPath = MESHES[ index ];
+        Mesh mesh;
+        if( FileMapMesh( meshPath, &mesh ) == false ) {
+            std::cout << "Error: File not exist, " << meshPath << std::endl;
+            return EXIT_FAILURE;
+        }
+        std::vector< AVertex > verticies;
+        std::vector< AColor > colors;
+        std::vector< AIndex > indicies;
+        ConvertMesh( mesh, &verticies, &colors, &indicies );
+        OptimizeMesh( &verticies, &colors, &indicies );
+
+        AVertex low = verticies[ 0 ], high = verticies[ 0 ];
+        for( size_t vertex = 0U; vertex < verticies.size(); vertex += 1U ) {
+            low.x = std::min( low.x, verticies[ vertex ].x ); high.x = std::max( high.x, verticies[ vertex ].x );
+            low.y = std::min( low.y, verticies[ vertex ].y ); high.y = std::max( high.y, verticies[ vertex ].y );
+            low.z = std::min( low.z, verticies[ vertex ].z ); high.z = std::max( high.z, verticies[ vertex ].z );
+        }
+        const double extent = std::sqrt( Dot( Sub( ToVec( high ), ToVec( low ) ), Sub( ToVec( high ), ToVec( low ) ) ) );
+
+        std::vector< AIndex > chain;
+        std::vector< MeshLod > lods;
+        const double chainTime = Bench::BestOf( REPEAT, [ & ]() {
+            BuildLodChain( verticies, indicies, DEFAULT_LOD_RATIOS, DEFAULT_LOD_COUNT, &chain, &lods );
+        } );
+        std::cout << meshPath << ": extent " << std::fixed << std::setprecision( 2 ) << extent
+            << ", chain built in " << std::setprecision( 3 ) << chainTime * 1e3 << " ms" << std::endl;
+
+        std::vector< AIndex > previous( indicies ), level;
+        for( size_t lod = 0U; lod < lods.size(); lod += 1U ) {
+            double levelTime = 0.0;
+            if( lod > 0U ) {
+                const size_t target = (size_t)( DEFAULT_LOD_RATIOS[ lod ] * indicies.size() );
+                levelTime = Bench::BestOf( REPEAT, [ & ]() {
+                    SimplifyMesh( verticies, previous, target, &level );
+                } );
+                previous.swap( level );
+            }
+            const double deviation = Deviation( verticies, &chain[ lods[ lod ].firstFace ], lods[ lod ].faceCount );
+            std::cout << "  lod " << lod << std::setw( 5 ) << std::setprecision( 0 )
+                << DEFAULT_LOD_RATIOS[ lod ] * 100.f << "%" << std::setw( 8 ) << lods[ lod ].faceCount << " tris"
+                << "  error " << std::setprecision( 4 ) << lods[ lod ].error
+                << " (" << std::setprecision( 3 ) << 100.0 * lods[ lod ].error / extent << "%)"
+                << "  deviation " << std::setprecision( 4 ) << deviation
+                << std::setw( 10 ) << std::setprecision( 3 ) << levelTime * 1e3 << " ms" << std::endl;
+        }
+
+        // Generation cost is paid once; later loads map the cached chain.
+        remove( MeshCachePath( meshPath ).c_str() );
+        App::MeshBuffer buffer;
+        const Bench::Clock::time_point begin = Bench::Clock::now();
+        buffer.load( meshPath );
+        const double cold = Bench::Seconds( begin, Bench::Clock::now() );
+        const double warm = Bench::BestOf( REPEAT, [ meshPath ]() {
+            App::MeshBuffer cached;
+            cached.load( meshPath );
+        } );
+        std::cout << "  cache cold " << std::setprecision( 3 ) << cold * 1e3 << " ms, warm "
+            << warm * 1e3 << " ms, " << buffer.lodCount() << " levels" << std::endl;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,101 @@
+/*
+Thread scaling of FileMapMeshParallel() on a synthetic mesh built by tiling
+res/pumpkin. Usage: bench_obj_parallel.out [tiles] [max threads]
+Run from the repository root so that res/ is reachable.
+*/
+#include <stdio.h>
+#include <string.h>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <thread>
+
+#include "util.h"
+#include "ObjParser.hpp"
+#include "Bench.hpp"
+
+static const char* SOURCE_PATH = "res/pumpkin";
+static const char* TILED_PATH = "bin/pumpkin_tiled.obj";
+static const unsigned int REPEAT = 3U;
+
+// Write in_tiles copies of the source, offsetting face indices of each copy.
+static bool TileMesh( const Mesh& in_mesh, const unsigned int in_tiles, const char* in_fileName ) {
+    std::ofstream file( in_fileName );
+    if( file.good() == false )
+        return false;
+    char line[ 128 ];
+    for( unsigned int tile = 0U; tile < in_tiles; tile += 1U ) {
+        const unsigned int base = tile * (unsigned int)in_mesh.v.size();
+        const float shift = 100.f * tile;
+        for( size_t index = 0U; index < in_mesh.v.size(); index += 1U ) {
+            snprintf( line, sizeof( line ), "v %f %f %f\n",
+                in_mesh.v[ index ].x + shift, in_mesh.v[ index ].y, in_mesh.v[ index ].z );
+            file << line;
+        }
+        for( size_t index = 0U; index < in_mesh.f.size(); index += 1U ) {
+            const Face& face = in_mesh.f[ index ];
+            snprintf( line, sizeof( line ), "f %u %u %u\n",
+                face.verticies[ 0 ].v + base, face.verticies[ 1 ].v + base,
+                face.verticies[ 2 ].v + base );
+            file << line;
+        }
+    }
+    return file.good();
+}
+
+static bool SameMesh( const Mesh& a, const Mesh& b ) {
+    return a.v.size() == b.v.size() && a.vn.size() == b.vn.size()
+        && a.vt.size() == b.vt.size() && a.f.size() == b.f.size()
+        && ( a.v.empty() || memcmp( &a.v[ 0 ], &b.v[ 0 ], sizeof(Vector3f) * a.v.size() ) == 0 )
+        && ( a.f.empty() || memcmp( &a.f[ 0 ], &b.f[ 0 ], sizeof(Face) * a.f.size() ) == 0 );
+}
+
+int main( int argc, char** argv ) {
+    const unsigned int tiles = argc > 1 ? (unsigned int)atoi( argv[ 1 ] ) : 64U;
+    unsigned int maxThreads = argc > 2 ? (unsigned int)atoi( argv[ 2 ] )
+        : std::thread::hardware_concurrency();
+    if( maxThreads == 0U )
+        maxThreads = 1U;
+
+    Mesh source;
+    if( FileMapMesh( SOURCE_PATH, &source ) == false
+        || TileMesh( source, tiles, TILED_PATH ) == false ) {
+        std::cout << "Error: Cannot build " << TILED_PATH << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::ifstream probe( TILED_PATH, std::ios::binary | std::ios::ate );
+    const double megaBytes = (double)probe.tellg() / 1e6;
+
+    Mesh serial;
+    FileMapMesh( TILED_PATH, &serial );
+    const double serialTime = Bench::BestOf( REPEAT, []() {
+        Mesh mesh;
+        FileMapMesh( TILED_PATH, &mesh );
+    } );
+    std::cout << TILED_PATH << ": " << tiles << " tiles, " << std::fixed
+        << std::setprecision( 1 ) << megaBytes << " MB, "
+        << serial.v.size() << " v, " << serial.f.size() << " f" << std::endl;
+    std::cout << "  serial     " << std::setw( 9 ) << std::setprecision( 2 )
+        << serialTime * 1e3 << " ms" << std::setw( 9 ) << std::setprecision( 1 )
+        << megaBytes / serialTime << " MB/s" << std::endl;
+
+    int status = EXIT_SUCCESS;
+    for( unsigned int threads = 1U; threads <= maxThreads; threads += 1U ) {
+        Mesh parallel;
+        FileMapMeshParallel( TILED_PATH, &parallel, threads );
+        const bool same = SameMesh( serial, parallel );
+        if( same == false )
+            status = EXIT_FAILURE;
+        const double time = Bench::BestOf( REPEAT, [ threads ]() {
+            Mesh mesh;
+            FileMapMeshParallel( TILED_PATH, &mesh, threads );
+        } );
+        std::cout << "  threads " << std::setw( 2 ) << threads << " "
+            << std::setw( 9 ) << std::setprecision( 2 ) << time * 1e3 << " ms"
+            << std::setw( 9 ) << std::setprecision( 1 ) << megaBytes / time << " MB/s"
+            << std::setw( 7 ) << std::setprecision( 2 ) << serialTime / time << "x"
+            << ( same ? "" : "  MISMATCH" ) << std::endl;
+    }
+    remove( TILED_PATH );
+    return status;
+}
@@ -0,0 +1,81 @@
+/*
+OBJ loading throughput: FileLoadMesh() against FileMapMesh().
+Run from the repository root so that res/ is reachable.
+*/
+#include <stdio.h>
+#include <string.h>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+
+#include "util.h"
+#include "ObjParser.hpp"
+#include "Bench.hpp"
+
+static const char* MESHES[] = {
+    "res/cube", "res/shape", "res/teapot", "res/pumpkin", "res/sphere"
+};
+static const unsigned int REPEAT = 10U;
+
+static bool SameVectors( const std::vector< Vector3f >& a, const std::vector< Vector3f >& b ) {
+    return a.size() == b.size()
+        && ( a.empty() || memcmp( &a[ 0 ], &b[ 0 ], sizeof(Vector3f) * a.size() ) == 0 );
+}
+static bool SameMesh( const Mesh& a, const Mesh& b ) {
+    return SameVectors( a.v, b.v ) && SameVectors( a.vn, b.vn ) && SameVectors( a.vt, b.vt )
+        && a.f.size() == b.f.size()
+        && ( a.f.empty() || memcmp( &a.f[ 0 ], &b.f[ 0 ], sizeof(Face) * a.f.size() ) == 0 );
+}
+static void CountFile( const char* in_fileName, size_t* out_bytes, size_t* out_lines ) {
+    std::ifstream file( in_fileName, std::ios::binary );
+    std::string input;
+    *out_bytes = 0U;
+    *out_lines = 0U;
+    while( std::getline( file, input ) ) {
+        *out_bytes += input.length() + 1U;
+        *out_lines += 1U;
+    }
+}
+static void Report( const char* name, const double seconds, const size_t bytes, const size_t lines ) {
+    std::cout << "  " << std::left << std::setw( 12 ) << name << std::right << std::fixed
+        << std::setw( 10 ) << std::setprecision( 3 ) << seconds * 1e3 << " ms"
+        << std::setw( 10 ) << std::setprecision( 1 ) << bytes / seconds / 1e6 << " MB/s"
+        << std::setw( 12 ) << std::setprecision( 0 ) << lines / seconds << " lines/s"
+        << std::endl;
+}
+
+int main( void ) {
+    int status = EXIT_SUCCESS;
+    for( unsigned int index = 0U; index < sizeof( MESHES ) / sizeof( MESHES[ 0 ] ); index += 1U ) {
+        const char* meshPath = MESHES[ index ];
+        size_t bytes, lines;
+        CountFile( meshPath, &bytes, &lines );
+
+        Mesh reference, mapped;
+        if( FileLoadMesh( meshPath, &reference ) == false
+            || FileMapMesh( meshPath, &mapped ) == false ) {
+            std::cout << "Error: File not exist, " << meshPath << std::endl;
+            status = EXIT_FAILURE;
+            continue;
+        }
+        const bool same = SameMesh( reference, mapped );
+        if( same == false )
+            status = EXIT_FAILURE;
+
+        double streamTime = Bench::BestOf( REPEAT, [ meshPath ]() {
+            Mesh mesh;
+            FileLoadMesh( meshPath, &mesh );
+        } );
+        double mapTime = Bench::BestOf( REPEAT, [ meshPath ]() {
+            Mesh mesh;
+            FileMapMesh( meshPath, &mesh );
+        } );
+
+        std::cout << meshPath << " (" << bytes << " bytes, " << lines << " lines, "
+            << ( same ? "identical" : "MISMATCH" ) << ")" << std::endl;
+        Report( "getline", streamTime, bytes, lines );
+        Report( "mmap", mapTime, bytes, lines );
+        std::cout << "  speedup " << std::setprecision( 2 ) << streamTime / mapTime << "x" << std::endl;
+    }
+    return status;
+}
@@ -0,0 +1,96 @@
+/*
+Bullet collision shapes built from shared MeshBuffer geometry: bytes shared
+with the renderer, bytes Bullet allocates on top, BVH build time and
+serialized BVH reload time.
+Run from the repository root so that res/ is reachable.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <string>
+
+#include "LinearMath/btAlignedAllocator.h"
+
+#include "MeshBuffer.hpp"
+#include "PhysicsMesh.hpp"
+#include "Bench.hpp"
+
+static const char* MESHES[] = { "res/teapot", "res/sphere", "res/pumpkin" };
+static const unsigned int REPEAT = 5U;
+
+// Count live bytes allocated through btAlignedAlloc.
+static size_t liveBytes = 0U;
+static const size_t PREFIX = 16U;
+static void* CountingAlloc( size_t size ) {
+    char* block = static_cast<char*>( malloc( size + PREFIX ) );
+    *reinterpret_cast<size_t*>( block ) = size;
+    liveBytes += size;
+    return block + PREFIX;
+}
+static void CountingFree( void* pointer ) {
+    if( pointer == NULL )
+        return;
+    char* block = static_cast<char*>( pointer ) - PREFIX;
+    liveBytes -= *reinterpret_cast<size_t*>( block );
+    free( block );
+}
+
+int main( void ) {
+    btAlignedAllocSetCustom( CountingAlloc, CountingFree );
+    std::cout << std::left << std::setw( 13 ) << "mesh" << std::right
+        << std::setw( 11 ) << "shared B" << std::setw( 11 ) << "bvh B" << std::setw( 11 ) << "bvh ms"
+        << std::setw( 11 ) << "reload ms" << std::setw( 11 ) << "file B"
+        << std::setw( 11 ) << "gimpact B" << std::setw( 12 ) << "gimpact ms" << std::endl;
+    for( unsigned int index = 0U; index < sizeof( MESHES ) / sizeof( MESHES[ 0 ] ); index += 1U ) {
+        const char* meshPath = MESHES[ index ];
+        App::MeshBuffer mesh;
+        if( mesh.load( meshPath ) == false ) {
+            std::cout << "Error: File not exist, " << meshPath << std::endl;
+            return EXIT_FAILURE;
+        }
+        const std::string bvhPath = std::string( meshPath ) + ".bvh";
+        remove( bvhPath.c_str() );
+
+        App::PhysicsMesh physics( mesh );
+
+        size_t before = liveBytes;
+        btBvhTriangleMeshShape* bvhShape = physics.createStaticShape();
+        const size_t bvhBytes = liveBytes - before;
+        delete bvhShape;
+        const double bvhTime = Bench::BestOf( REPEAT, [ &physics ]() {
+            delete physics.createStaticShape();
+        } );
+
+        // First call writes the file, the next ones restore it.
+        delete physics.createStaticShape( bvhPath.c_str() );
+        double reload = 0.0;
+        {
+            App::PhysicsMesh restored( mesh );
+            const Bench::Clock::time_point begin = Bench::Clock::now();
+            btBvhTriangleMeshShape* shape = restored.createStaticShape( bvhPath.c_str() );
+            reload = Bench::Seconds( begin, Bench::Clock::now() );
+            delete shape;
+        }
+        std::ifstream file( bvhPath.c_str(), std::ios::binary | std::ios::ate );
+        const long long fileBytes = (long long)file.tellg();
+
+        before = liveBytes;
+        btGImpactMeshShape* dynamicShape = physics.createDynamicShape();
+        const size_t gimpactBytes = liveBytes - before;
+        delete dynamicShape;
+        const double gimpactTime = Bench::BestOf( REPEAT, [ &physics ]() {
+            delete physics.createDynamicShape();
+        } );
+
+        std::cout << std::left << std::setw( 13 ) << meshPath << std::right << std::fixed
+            << std::setw( 11 ) << physics.sharedBytes() << std::setw( 11 ) << bvhBytes
+            << std::setprecision( 3 ) << std::setw( 11 ) << bvhTime * 1e3
+            << std::setw( 11 ) << reload * 1e3 << std::setw( 11 ) << fileBytes
+            << std::setw( 11 ) << gimpactBytes << std::setw( 12 ) << gimpactTime * 1e3 << std::endl;
+    }
+    std::cout << "shared B is referenced by both the GL upload and Bullet; a btTriangleMesh copy would add it again."
+        << std::endl;
+    return EXIT_SUCCESS;
+}
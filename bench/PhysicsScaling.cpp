@@ -0,0 +1,184 @@
+/*
+Multithreaded stepping from 1 to N threads, with Bullet's thread pool and
+with OpenMP when this build has them, over two scenes of boxes:
+"pile" stacks them like bricks into one block, a single island that
+btSequentialImpulseConstraintSolverMt has to split; "scatter" stands them
+in short separate stacks, many islands solved side by side.
+Reports the median step time and the speedup over the single-threaded
+world. A run is stable when no value is NaN, no box fell through the
+ground, nothing moves faster than a fall could make it, and the mean
+height is within HEIGHT_TOLERANCE of the single-threaded run's. The
+widest run is repeated to show whether it reproduces bit for bit.
+Build with make BULLET_MT=1 or BULLET_MT=openmp.
+Usage: bench_physics_scaling.out [bodies] [steps]
+*/
+#include <stdlib.h>
+#include <string.h>
+#include <cmath>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+
+#include "PhysicsWorld.hpp"
+#include "Bench.hpp"
+
+static const unsigned int DEFAULT_BODIES = 4000U;
+static const unsigned int DEFAULT_STEPS = 300U;
+static const btScalar TIME_STEP = 1.f / 60.f;
+static const btScalar HALF_EXTENT = 0.5f;
+static const unsigned int PILE_LAYERS = 20U;
+static const unsigned int STACK_HEIGHT = 4U;
+static const double HEIGHT_TOLERANCE = 0.1;
+// Faster than a box dropped from the top of the pile can fall.
+static const btScalar MAX_SPEED = 25.f;
+
+enum Scene {
+    ScenePile, SceneScatter
+};
+
+struct Outcome {
+    double              step;           // Median seconds per step.
+    double              meanHeight;
+    double              minHeight;
+    double              maxSpeed;
+    bool                finite;
+    unsigned long long  hash;           // Of every final position and velocity.
+};
+
+static void BuildScene( App::PhysicsWorld* io_world, const Scene in_scene, btCollisionShape* in_ground,
+    btCollisionShape* in_box, const unsigned int in_bodies ) {
+    btTransform transform;
+    transform.setIdentity();
+    io_world->addBody( in_ground, 0.f, transform );
+    const btScalar size = 2.f * HALF_EXTENT;
+    for( unsigned int index = 0U; index < in_bodies; index += 1U ) {
+        btVector3 origin;
+        if( in_scene == ScenePile ) {
+            // Touching columns with every other layer shifted half a box,
+            // like bricks, so the whole pile is one island.
+            const unsigned int side = (unsigned int)std::ceil( std::sqrt( (double)in_bodies / PILE_LAYERS ) );
+            const unsigned int column = index % ( side * side ), layer = index / ( side * side );
+            const btScalar shift = ( layer % 2U ) * HALF_EXTENT;
+            origin = btVector3( size * ( column % side ) + shift, HALF_EXTENT + 1.02f * size * layer,
+                size * ( column / side ) + shift );
+        } else {
+            const unsigned int side = (unsigned int)std::ceil( std::sqrt( (double)in_bodies / STACK_HEIGHT ) );
+            const unsigned int column = index / STACK_HEIGHT, layer = index % STACK_HEIGHT;
+            origin = btVector3( 3.f * size * ( column % side ), HALF_EXTENT + 1.02f * size * layer,
+                3.f * size * ( column / side ) );
+        }
+        transform.setOrigin( origin );
+        io_world->addBody( in_box, 1.f, transform );
+    }
+}
+
+static void Hash( const btVector3& in_vector, unsigned long long* io_hash ) {
+    unsigned char bytes[ 3U * sizeof( btScalar ) ];
+    memcpy( bytes, in_vector.m_floats, sizeof( bytes ) );
+    for( size_t index = 0U; index < sizeof( bytes ); index += 1U )
+        *io_hash = ( *io_hash ^ bytes[ index ] ) * 1099511628211ULL;
+}
+
+static Outcome Run( const Scene in_scene, const unsigned int in_bodies, const unsigned int in_steps,
+    const App::PhysicsScheduler in_scheduler, const unsigned int in_threads ) {
+    // Shapes first, so they outlive the world.
+    btStaticPlaneShape ground( btVector3( 0.f, 1.f, 0.f ), 0.f );
+    btBoxShape box( btVector3( HALF_EXTENT, HALF_EXTENT, HALF_EXTENT ) );
+    App::PhysicsWorld world( in_scheduler, in_threads );
+    BuildScene( &world, in_scene, &ground, &box, in_bodies );
+
+    std::vector< double > steps( in_steps );
+    for( unsigned int step = 0U; step < in_steps; step += 1U ) {
+        const Bench::Clock::time_point begin = Bench::Clock::now();
+        world.step( TIME_STEP );
+        steps[ step ] = Bench::Seconds( begin, Bench::Clock::now() );
+    }
+
+    Outcome outcome;
+    outcome.step = Bench::Percentile( steps, 50.0 );
+    outcome.meanHeight = 0.0;
+    outcome.minHeight = HUGE_VAL;
+    outcome.maxSpeed = 0.0;
+    outcome.finite = true;
+    outcome.hash = 14695981039346656037ULL;
+    const btCollisionObjectArray& objects = world.world()->getCollisionObjectArray();
+    unsigned int moving = 0U;
+    for( int index = 0; index < objects.size(); index += 1 ) {
+        const btRigidBody* body = btRigidBody::upcast( objects[ index ] );
+        if( body->getInvMass() == 0.f )
+            continue;
+        const btVector3& origin = body->getWorldTransform().getOrigin();
+        const btVector3& velocity = body->getLinearVelocity();
+        outcome.finite = outcome.finite && std::isfinite( origin.x() ) && std::isfinite( origin.y() )
+            && std::isfinite( origin.z() ) && std::isfinite( velocity.length() );
+        outcome.meanHeight += origin.y();
+        outcome.minHeight = std::min( outcome.minHeight, (double)origin.y() );
+        outcome.maxSpeed = std::max( outcome.maxSpeed, (double)velocity.length() );
+        Hash( origin, &outcome.hash );
+        Hash( velocity, &outcome.hash );
+        moving += 1U;
+    }
+    outcome.meanHeight /= std::max( moving, 1U );
+    return outcome;
+}
+
+static bool Stable( const Outcome& in_outcome, const Outcome& in_serial ) {
+    return in_outcome.finite == true && in_outcome.minHeight > -HALF_EXTENT && in_outcome.maxSpeed < MAX_SPEED
+        && std::fabs( in_outcome.meanHeight - in_serial.meanHeight ) <= HEIGHT_TOLERANCE * in_serial.meanHeight;
+}
+
+static void Print( const char* in_scene, const char* in_scheduler, const unsigned int in_threads,
+    const Outcome& in_outcome, const Outcome& in_serial, const bool in_stable ) {
+    std::cout << std::left << std::setw( 9 ) << in_scene << std::setw( 8 ) << in_scheduler << std::right
+        << std::setw( 4 ) << in_threads << std::fixed << std::setprecision( 3 )
+        << std::setw( 10 ) << in_outcome.step * 1e3 << std::setprecision( 2 )
+        << std::setw( 8 ) << in_serial.step / in_outcome.step << "x"
+        << std::setprecision( 3 ) << std::setw( 9 ) << in_outcome.meanHeight << std::setw( 9 ) << in_outcome.minHeight
+        << std::setprecision( 2 ) << std::setw( 8 ) << in_outcome.maxSpeed
+        << "  " << ( in_stable == true ? "stable" : "UNSTABLE" ) << std::endl;
+}
+
+int main( int argc, char** argv ) {
+    const unsigned int bodies = argc > 1 ? (unsigned int)std::max( atoi( argv[ 1 ] ), 1 ) : DEFAULT_BODIES;
+    const unsigned int steps = argc > 2 ? (unsigned int)std::max( atoi( argv[ 2 ] ), 1 ) : DEFAULT_STEPS;
+    const App::PhysicsScheduler SCHEDULERS[] = { App::SchedulerPool, App::SchedulerOpenMP };
+    const char* SCHEDULER_NAMES[] = { "pool", "openmp" };
+    const char* SCENE_NAMES[] = { "pile", "scatter" };
+
+    std::cout << bodies << " boxes, " << steps << " steps" << std::endl;
+    if( App::PhysicsSchedulerAvailable( App::SchedulerPool ) == false
+        && App::PhysicsSchedulerAvailable( App::SchedulerOpenMP ) == false )
+        std::cout << "Bullet was built without BT_THREADSAFE: only the single-threaded world runs." << std::endl;
+    std::cout << std::left << std::setw( 9 ) << "scene" << std::setw( 8 ) << "tasks" << std::right
+        << std::setw( 4 ) << "n" << std::setw( 10 ) << "step ms" << std::setw( 9 ) << "speedup"
+        << std::setw( 9 ) << "mean y" << std::setw( 9 ) << "min y" << std::setw( 8 ) << "max v" << std::endl;
+    bool stable = true;
+    for( unsigned int scene = 0U; scene < 2U; scene += 1U ) {
+        const Outcome serial = Run( (Scene)scene, bodies, steps, App::SchedulerNone, 1U );
+        const bool serialStable = Stable( serial, serial );
+        Print( SCENE_NAMES[ scene ], "none", 1U, serial, serial, serialStable );
+        stable = stable && serialStable;
+        for( unsigned int kind = 0U; kind < 2U; kind += 1U ) {
+            if( App::PhysicsSchedulerAvailable( SCHEDULERS[ kind ] ) == false )
+                continue;
+            const unsigned int maxThreads = App::PhysicsMaxThreads( SCHEDULERS[ kind ] );
+            // Powers of two, then every thread.
+            Outcome widest = serial;
+            unsigned int threads = 1U;
+            while( true ) {
+                widest = Run( (Scene)scene, bodies, steps, SCHEDULERS[ kind ], threads );
+                const bool runStable = Stable( widest, serial );
+                Print( SCENE_NAMES[ scene ], SCHEDULER_NAMES[ kind ], threads, widest, serial, runStable );
+                stable = stable && runStable;
+                if( threads == maxThreads )
+                    break;
+                threads = std::min( threads * 2U, maxThreads );
+            }
+            const Outcome repeat = Run( (Scene)scene, bodies, steps, SCHEDULERS[ kind ], maxThreads );
+            std::cout << "    repeat on " << maxThreads << " threads: "
+                << ( repeat.hash == widest.hash ? "bit-identical" : "differs, contact order follows thread timing" )
+                << std::endl;
+        }
+    }
+    return stable == true ? EXIT_SUCCESS : EXIT_FAILURE;
+}
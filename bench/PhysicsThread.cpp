@@ -0,0 +1,135 @@
+/*
+Decoupling of simulation and rendering.
+A render loop at RENDER_RATE reads interpolated transforms while the world
+is stepped at 60 Hz, either on App::PhysicsThread or inline in the loop as
+main.cpp would without it. Reports step jitter and frame times for a light
+and a heavy scene. Usage: bench_physics_thread.out [seconds]
+*/
+#include <stdlib.h>
+#include <cmath>
+#include <iostream>
+#include <iomanip>
+#include <thread>
+
+#include "PhysicsWorld.hpp"
+#include "PhysicsThread.hpp"
+#include "Bench.hpp"
+
+static const double STEP_RATE = 60.0;
+static const double RENDER_RATE = 144.0;
+// CPU time the fake renderer spends per frame.
+static const double RENDER_WORK = 0.002;
+
+static void BuildScene( App::PhysicsWorld* world, btCollisionShape* ground, btCollisionShape* box,
+    const unsigned int bodies ) {
+    btTransform transform;
+    transform.setIdentity();
+    world->addBody( ground, 0.f, transform );
+    const unsigned int side = (unsigned int)std::ceil( std::sqrt( (double)bodies / 10.0 ) );
+    for( unsigned int index = 0U; index < bodies; index += 1U ) {
+        const unsigned int layer = index / ( side * side );
+        const unsigned int cell = index % ( side * side );
+        transform.setOrigin( btVector3( 2.5f * ( cell % side ), 2.f + 2.5f * layer, 2.5f * ( cell / side ) ) );
+        world->addBody( box, 1.f, transform );
+    }
+}
+
+static void Spin( const double seconds ) {
+    const Bench::Clock::time_point end = Bench::Clock::now()
+        + std::chrono::duration_cast< Bench::Clock::duration >( std::chrono::duration< double >( seconds ) );
+    while( Bench::Clock::now() < end ) {}
+}
+
+static void PrintSeries( const char* name, const std::vector< double >& samples, const double scale ) {
+    double mean = 0.0, variance = 0.0;
+    for( size_t index = 0U; index < samples.size(); index += 1U )
+        mean += samples[ index ];
+    mean /= std::max< size_t >( samples.size(), 1U );
+    for( size_t index = 0U; index < samples.size(); index += 1U )
+        variance += ( samples[ index ] - mean ) * ( samples[ index ] - mean );
+    variance /= std::max< size_t >( samples.size(), 1U );
+    std::cout << "    " << std::left << std::setw( 16 ) << name << std::right << std::fixed << std::setprecision( 3 )
+        << " mean " << std::setw( 8 ) << mean * scale << "  sd " << std::setw( 7 ) << std::sqrt( variance ) * scale
+        << "  p50 " << std::setw( 8 ) << Bench::Percentile( samples, 50.0 ) * scale
+        << "  p99 " << std::setw( 8 ) << Bench::Percentile( samples, 99.0 ) * scale
+        << "  max " << std::setw( 8 ) << Bench::Percentile( samples, 100.0 ) * scale << " ms" << std::endl;
+}
+
+// Render loop paced at RENDER_RATE; returns frame times in seconds.
+template< typename Frame >
+static std::vector< double > RenderLoop( const double seconds, Frame frame ) {
+    std::vector< double > frameTimes;
+    const Bench::Clock::duration period = std::chrono::duration_cast< Bench::Clock::duration >(
+        std::chrono::duration< double >( 1.0 / RENDER_RATE ) );
+    const Bench::Clock::time_point end = Bench::Clock::now()
+        + std::chrono::duration_cast< Bench::Clock::duration >( std::chrono::duration< double >( seconds ) );
+    Bench::Clock::time_point last = Bench::Clock::now(), next = last;
+    while( last < end ) {
+        frame();
+        Spin( RENDER_WORK );
+        next += period;
+        std::this_thread::sleep_until( next );
+        const Bench::Clock::time_point now = Bench::Clock::now();
+        frameTimes.push_back( Bench::Seconds( last, now ) );
+        last = now;
+    }
+    return frameTimes;
+}
+
+static void RunScene( const unsigned int bodies, const double seconds ) {
+    btStaticPlaneShape ground( btVector3( 0.f, 1.f, 0.f ), 0.f );
+    btBoxShape box( btVector3( 1.f, 1.f, 1.f ) );
+    std::cout << bodies << " bodies" << std::endl;
+
+    // Threaded.
+    {
+        App::PhysicsWorld world;
+        BuildScene( &world, &ground, &box, bodies );
+        App::PhysicsThread simulation( &world, STEP_RATE );
+        std::vector< App::BodyTransform > transforms;
+        simulation.start();
+        std::vector< double > frames = RenderLoop( seconds, [ &simulation, &transforms ]() {
+            simulation.read( App::PhysicsThread::Clock::now(), &transforms );
+        } );
+        simulation.stop();
+
+        std::vector< double > intervals;
+        const std::vector< double >& starts = simulation.stepStarts();
+        for( size_t index = 1U; index < starts.size(); index += 1U )
+            intervals.push_back( starts[ index ] - starts[ index - 1U ] );
+        std::cout << "  physics thread (" << starts.size() << " steps, " << frames.size() << " frames)" << std::endl;
+        PrintSeries( "step interval", intervals, 1e3 );
+        PrintSeries( "step duration", simulation.stepDurations(), 1e3 );
+        PrintSeries( "frame time", frames, 1e3 );
+    }
+
+    // Inline: the render loop steps the world itself whenever a step is due.
+    {
+        App::PhysicsWorld world;
+        BuildScene( &world, &ground, &box, bodies );
+        std::vector< App::BodyTransform > transforms;
+        std::vector< double > durations;
+        const Bench::Clock::time_point start = Bench::Clock::now();
+        unsigned long long steps = 0U;
+        std::vector< double > frames = RenderLoop( seconds, [ & ]() {
+            const double now = Bench::Seconds( start, Bench::Clock::now() );
+            while( steps < (unsigned long long)( now * STEP_RATE ) ) {
+                const Bench::Clock::time_point begin = Bench::Clock::now();
+                world.step( (btScalar)( 1.0 / STEP_RATE ) );
+                durations.push_back( Bench::Seconds( begin, Bench::Clock::now() ) );
+                steps += 1U;
+            }
+            world.readTransforms( &transforms );
+        } );
+        std::cout << "  inline (" << steps << " steps, " << frames.size() << " frames)" << std::endl;
+        PrintSeries( "step duration", durations, 1e3 );
+        PrintSeries( "frame time", frames, 1e3 );
+    }
+}
+
+int main( int argc, char** argv ) {
+    const double seconds = argc > 1 ? atof( argv[ 1 ] ) : 5.0;
+    RunScene( 100U, seconds );
+    RunScene( 3000U, seconds );
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,76 @@
+/*
+Cost of a profiler scope. The loop body is a few dependent multiplies;
+"compiled out" is the same loop as PROFILE_SCOPE expands to without
+APP_PROFILE. Also times the Chrome trace export of full rings.
+Usage: bench_profiler.out [iterations]
+*/
+#include <stdlib.h>
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <vector>
+
+#include "Profiler.hpp"
+#include "Bench.hpp"
+
+static const unsigned int THREADS = 4U;
+
+static unsigned int Work( unsigned int value ) {
+    for( unsigned int round = 0U; round < 4U; round += 1U )
+        value = value * 2654435761U + 1U;
+    return value;
+}
+
+static void Report( const char* name, const double seconds, const unsigned int iterations ) {
+    std::cout << "  " << std::left << std::setw( 24 ) << name << std::right << std::fixed
+        << std::setprecision( 2 ) << std::setw( 8 ) << seconds * 1e9 / iterations << " ns/iteration" << std::endl;
+}
+
+int main( int argc, char** argv ) {
+    const unsigned int iterations = argc > 1 ? (unsigned int)atoi( argv[ 1 ] ) : 10000000U;
+    volatile unsigned int sink = 0U;
+
+    const double baseline = Bench::BestOf( 3U, [ & ]() {
+        unsigned int value = 1U;
+        for( unsigned int index = 0U; index < iterations; index += 1U ) {
+            do {} while( false );
+            value = Work( value );
+        }
+        sink = value;
+    } );
+    Report( "compiled out", baseline, iterations );
+
+    PROFILE_THREAD( "bench" );
+    const double scoped = Bench::BestOf( 3U, [ & ]() {
+        unsigned int value = 1U;
+        for( unsigned int index = 0U; index < iterations; index += 1U ) {
+            PROFILE_SCOPE( "work" );
+            value = Work( value );
+        }
+        sink = value;
+    } );
+    Report( "PROFILE_SCOPE", scoped, iterations );
+
+    // Every thread has its own ring, so concurrent scopes share nothing.
+    const double threaded = Bench::BestOf( 3U, [ & ]() {
+        std::vector< std::thread > threads;
+        for( unsigned int thread = 0U; thread < THREADS; thread += 1U )
+            threads.push_back( std::thread( [ & ]() {
+                unsigned int value = 1U;
+                for( unsigned int index = 0U; index < iterations / THREADS; index += 1U ) {
+                    PROFILE_SCOPE( "work" );
+                    value = Work( value );
+                }
+                sink = value;
+            } ) );
+        for( unsigned int thread = 0U; thread < THREADS; thread += 1U )
+            threads[ thread ].join();
+    } );
+    Report( "PROFILE_SCOPE, 4 threads", threaded, iterations );
+
+    const Bench::Clock::time_point begin = Bench::Clock::now();
+    const bool written = PROFILE_WRITE_TRACE( "bench_profile.json" );
+    std::cout << "  trace export " << std::setprecision( 1 ) << Bench::Seconds( begin, Bench::Clock::now() ) * 1e3
+        << " ms" << ( written ? "" : " (failed)" ) << std::endl;
+    return EXIT_SUCCESS;
+}
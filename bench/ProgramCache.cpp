@@ -0,0 +1,173 @@
+/*
+Time from shader sources to the first finished draw with the program, the
+part of startup App::LoadProgram replaces.
+"cold" compiles and links src/shader/vertex.shader and fragment.shader and
+writes the cache; "warm" restores the binary written by the cold run before
+it. Every round appends a new comment to both sources, so neither this
+cache nor a cache inside the driver has seen them before the cold run.
+Both programs must draw the same pixels; exits with failure when they do
+not, or when the warm run does not hit.
+Usage: bench_program_cache.out [rounds]
+*/
+#include "glad/glad.h"
+#include <GLFW/glfw3.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
+#include "GLFunctions.hpp"
+#include "ProgramCache.hpp"
+#include "Bench.hpp"
+
+static const char* CACHE_NAME = "bench_program.cache";
+static const unsigned int SIZE = 64U;
+
+struct Target {
+    GLuint  vertexArray;
+    GLuint  vertexBuffer;
+    GLuint  uniformBuffers[ 2 ];
+};
+
+// A triangle in normalized 16-bit positions, as the streamer uploads them,
+// and the color blocks the fragment shader reads.
+static void CreateTarget( Target* out_target ) {
+    const unsigned short positions[ 3 ][ 4 ] = {
+        { 8192U, 8192U, 32768U, 65535U }, { 57344U, 16384U, 32768U, 65535U }, { 32768U, 57344U, 32768U, 65535U } };
+    glGenVertexArrays( 1, &out_target->vertexArray );
+    glBindVertexArray( out_target->vertexArray );
+    glGenBuffers( 1, &out_target->vertexBuffer );
+    glBindBuffer( GL_ARRAY_BUFFER, out_target->vertexBuffer );
+    glBufferData( GL_ARRAY_BUFFER, sizeof(positions), positions, GL_STATIC_DRAW );
+    const float colors[ 2 ][ 2 ] = { { 1.f, 0.5f }, { 0.25f, 1.f } };
+    glGenBuffers( 2, out_target->uniformBuffers );
+    for( GLuint block = 0U; block < 2U; block += 1U ) {
+        glBindBuffer( GL_UNIFORM_BUFFER, out_target->uniformBuffers[ block ] );
+        glBufferData( GL_UNIFORM_BUFFER, sizeof(colors[ block ]), colors[ block ], GL_STATIC_DRAW );
+        glBindBufferBase( GL_UNIFORM_BUFFER, block + 1U, out_target->uniformBuffers[ block ] );
+    }
+}
+
+static void ReleaseTarget( Target* io_target ) {
+    glDeleteBuffers( 2, io_target->uniformBuffers );
+    glDeleteBuffers( 1, &io_target->vertexBuffer );
+    glDeleteVertexArrays( 1, &io_target->vertexArray );
+}
+
+// Draw once with in_program and wait for it; drivers may finish compiling
+// at the first draw.
+static void Draw( const GLuint in_program, std::vector< unsigned char >* out_pixels ) {
+    glUseProgram( in_program );
+    glUniformBlockBinding( in_program, glGetUniformBlockIndex( in_program, "ColorPrefix" ), 1U );
+    glUniformBlockBinding( in_program, glGetUniformBlockIndex( in_program, "ColorSuffix" ), 2U );
+    const float identity[ 16 ] = { 1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f };
+    const float offset[ 3 ] = { -1.f, -1.f, -0.5f }, scale[ 3 ] = { 2.f, 2.f, 1.f };
+    glUniformMatrix4fv( glGetUniformLocation( in_program, "in_viewProjection" ), 1, GL_FALSE, identity );
+    glUniform3fv( glGetUniformLocation( in_program, "in_positionOffset" ), 1, offset );
+    glUniform3fv( glGetUniformLocation( in_program, "in_positionScale" ), 1, scale );
+    const GLint positionLoc = glGetAttribLocation( in_program, "in_position" ),
+        colorLoc = glGetAttribLocation( in_program, "in_color" ),
+        modelLoc = glGetAttribLocation( in_program, "in_model" ),
+        instanceColorLoc = glGetAttribLocation( in_program, "in_instanceColor" );
+    glVertexAttribPointer( (GLuint)positionLoc, 4, GL_UNSIGNED_SHORT, GL_TRUE, 0, (GLvoid*) 0 );
+    glEnableVertexAttribArray( (GLuint)positionLoc );
+    glVertexAttrib4f( (GLuint)colorLoc, 1.f, 0.75f, 0.5f, 1.f );
+    for( GLuint column = 0U; column < 4U; column += 1U )
+        glVertexAttrib4fv( (GLuint)modelLoc + column, identity + 4U * column );
+    glVertexAttrib4f( (GLuint)instanceColorLoc, 1.f, 1.f, 1.f, 1.f );
+    glClear( GL_COLOR_BUFFER_BIT );
+    glDrawArrays( GL_TRIANGLES, 0, 3 );
+    glFinish();
+    out_pixels->resize( 4U * SIZE * SIZE );
+    glReadPixels( 0, 0, SIZE, SIZE, GL_RGBA, GL_UNSIGNED_BYTE, &( *out_pixels )[ 0 ] );
+}
+
+static double Load( const std::string& in_vertex, const std::string& in_fragment, App::ProgramCacheStatus* out_status,
+    std::vector< unsigned char >* out_pixels ) {
+    const Bench::Clock::time_point begin = Bench::Clock::now();
+    const GLuint program = App::LoadProgram( in_vertex, in_fragment, CACHE_NAME, out_status );
+    if( program != 0U )
+        Draw( program, out_pixels );
+    const double seconds = Bench::Seconds( begin, Bench::Clock::now() );
+    glDeleteProgram( program );
+    return seconds;
+}
+
+static void Report( const char* in_name, const std::vector< double >& in_times ) {
+    std::cout << "    " << std::left << std::setw( 5 ) << in_name << std::right << std::fixed << std::setprecision( 2 )
+        << "  median " << std::setw( 8 ) << Bench::Percentile( in_times, 50.0 ) * 1e3 << " ms  min "
+        << std::setw( 8 ) << Bench::Percentile( in_times, 0.0 ) * 1e3 << " ms  max " << std::setw( 8 )
+        << Bench::Percentile( in_times, 100.0 ) * 1e3 << " ms" << std::endl;
+}
+
+int main( int argc, char** argv ) {
+    const unsigned int rounds = argc > 1 ? (unsigned int)atoi( argv[ 1 ] ) : 10U;
+    if( glfwInit() == GLFW_FALSE )
+        return EXIT_FAILURE;
+    glfwWindowHint( GLFW_CONTEXT_VERSION_MAJOR, 3 );
+    glfwWindowHint( GLFW_CONTEXT_VERSION_MINOR, 2 );
+    glfwWindowHint( GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE );
+    glfwWindowHint( GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE );
+    glfwWindowHint( GLFW_VISIBLE, GLFW_FALSE );
+    GLFWwindow* window = glfwCreateWindow( SIZE, SIZE, "bench", NULL, NULL );
+    if( window == NULL ) {
+        glfwTerminate();
+        return EXIT_FAILURE;
+    }
+    glfwMakeContextCurrent( window );
+    gladLoadGLLoader( (GLADloadproc) glfwGetProcAddress );
+    App::LoadGLFunctions( (GLADloadproc) glfwGetProcAddress );
+    glViewport( 0, 0, SIZE, SIZE );
+
+    std::string vertex, fragment;
+    if( App::ReadShaderSource( "src/shader/vertex.shader", &vertex ) == false
+        || App::ReadShaderSource( "src/shader/fragment.shader", &fragment ) == false )
+        return EXIT_FAILURE;
+    std::cout << glGetString( GL_RENDERER ) << ", " << glGetString( GL_VERSION ) << std::endl;
+
+    Target target;
+    CreateTarget( &target );
+    std::vector< double > cold, warm;
+    size_t binaryBytes = 0U;
+    bool passed = true;
+    for( unsigned int round = 0U; round < rounds; round += 1U ) {
+        std::ostringstream marker;
+        marker << "\n// round " << round << " of " << rounds << "\n";
+        const std::string roundVertex = vertex + marker.str(), roundFragment = fragment + marker.str();
+        remove( CACHE_NAME );
+        App::ProgramCacheStatus coldStatus, warmStatus;
+        std::vector< unsigned char > coldPixels, warmPixels;
+        cold.push_back( Load( roundVertex, roundFragment, &coldStatus, &coldPixels ) );
+        if( coldStatus == App::ProgramCacheUnsupported ) {
+            std::cout << "    program binaries are not supported; every launch compiles" << std::endl;
+            break;
+        }
+        FILE* file = fopen( CACHE_NAME, "rb" );
+        if( file != NULL ) {
+            fseek( file, 0, SEEK_END );
+            binaryBytes = (size_t)ftell( file );
+            fclose( file );
+        }
+        warm.push_back( Load( roundVertex, roundFragment, &warmStatus, &warmPixels ) );
+        if( warmStatus != App::ProgramCacheHit || coldPixels.empty() == true || coldPixels != warmPixels ) {
+            std::cout << "    round " << round << " FAILED: cold " << App::ProgramCacheStatusName( coldStatus )
+                << ", warm " << App::ProgramCacheStatusName( warmStatus )
+                << ( coldPixels == warmPixels ? "" : ", pixels differ" ) << std::endl;
+            passed = false;
+        }
+    }
+    remove( CACHE_NAME );
+    ReleaseTarget( &target );
+
+    std::cout << "  " << rounds << " rounds, cache file " << binaryBytes << " bytes" << std::endl;
+    Report( "cold", cold );
+    if( warm.empty() == false )
+        Report( "warm", warm );
+
+    glfwDestroyWindow( window );
+    glfwTerminate();
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
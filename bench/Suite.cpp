@@ -0,0 +1,333 @@
+/*
+Microbenchmark suite for `make bench`; needs no window or GPU.
+Covers OBJ loading (FileLoadMesh() and FileMapMesh()), ConvertMesh(), the
+camera and per-body MVP matrices the render loop builds with glm, and
+Bullet world steps with N falling boxes. Every benchmark runs untimed
+warm-up calls, then times a number of samples, and reports the median
+and median absolute deviation (MAD), which a few preempted samples do
+not move, along with min, p90 and mean.
+--report writes the results as JSON. --baseline compares them with
+earlier reports, one per run of the suite; give it once per file. The
+reference is the median of the runs' medians. A benchmark regresses when
+its median is more than --tolerance percent above the reference and the
+gap also exceeds NOISE_MADS times the larger MAD and the spread between
+the slowest and fastest baseline run. A run's MAD only covers noise
+within that process; the spread covers what changes between processes,
+such as code and heap placement. Exits with failure on any regression.
+Usage: bench.out [--report FILE] [--baseline FILE]... [--tolerance PERCENT] [--filter TEXT]
+*/
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "glm/glm.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+#include "glm/gtc/quaternion.hpp"
+
+#include "util.h"
+#include "ObjParser.hpp"
+#include "MeshBuffer.hpp"
+#include "PhysicsWorld.hpp"
+#include "Bench.hpp"
+
+static const char* MESH_PATH = "res/pumpkin";
+static const unsigned int BODY_COUNTS[] = { 100U, 1000U, 4000U };
+static const unsigned int BODY_COUNT_COUNT = sizeof(BODY_COUNTS) / sizeof(BODY_COUNTS[ 0 ]);
+static const unsigned int MVP_BODIES = 1024U;
+static const double STEP_RATE = 60.0;
+static const double DEFAULT_TOLERANCE = 10.0;
+static const double NOISE_MADS = 3.0;
+
+struct Result {
+    std::string     name;
+    unsigned int    batch;
+    unsigned int    samples;
+    double          median;     // Seconds per call, as every field below.
+    double          mad;
+    double          min;
+    double          p90;
+    double          mean;
+};
+
+struct Options {
+    std::string                 report;
+    std::vector< std::string >  baselines;
+    std::string                 filter;
+    double                      tolerance;
+};
+
+// Keeps the optimizer from dropping work whose result is unused.
+static volatile float sink = 0.f;
+
+static std::string Format( const double in_seconds ) {
+    std::ostringstream stream;
+    stream << std::fixed << std::setprecision( 2 );
+    if( in_seconds >= 1e-3 )
+        stream << in_seconds * 1e3 << " ms";
+    else if( in_seconds >= 1e-6 )
+        stream << in_seconds * 1e6 << " us";
+    else
+        stream << in_seconds * 1e9 << " ns";
+    return stream.str();
+}
+
+class Suite {
+public:
+    explicit Suite( const Options& in_options ) : _options( in_options ) {}
+
+    bool wanted( const std::string& in_name ) const {
+        return _options.filter.empty() || in_name.find( _options.filter ) != std::string::npos;
+    }
+
+    template< typename Func >
+    void run( const std::string& in_name, const unsigned int in_warmup, const unsigned int in_samples,
+        const unsigned int in_batch, Func func ) {
+        if( wanted( in_name ) == false )
+            return;
+        const std::vector< double > samples = Bench::Sample( in_warmup, in_samples, in_batch, func );
+        Result result;
+        result.name = in_name;
+        result.batch = in_batch;
+        result.samples = in_samples;
+        result.median = Bench::Percentile( samples, 50.0 );
+        result.mad = Bench::MedianAbsoluteDeviation( samples );
+        result.min = Bench::Percentile( samples, 0.0 );
+        result.p90 = Bench::Percentile( samples, 90.0 );
+        double sum = 0.0;
+        for( size_t index = 0U; index < samples.size(); index += 1U )
+            sum += samples[ index ];
+        result.mean = sum / samples.size();
+        _results.push_back( result );
+        std::cout << "  " << std::left << std::setw( 28 ) << in_name << std::right << " median " << std::setw( 11 )
+            << Format( result.median ) << "  MAD " << std::setw( 11 ) << Format( result.mad ) << "  min "
+            << std::setw( 11 ) << Format( result.min ) << "  p90 " << std::setw( 11 ) << Format( result.p90 )
+            << std::endl;
+    }
+
+    void writeJson( std::ostream& out_stream ) const {
+        out_stream << std::fixed << std::setprecision( 1 ) << "{\n  \"benchmarks\": {";
+        for( size_t index = 0U; index < _results.size(); index += 1U ) {
+            const Result& result = _results[ index ];
+            out_stream << ( index == 0U ? "\n" : ",\n" ) << "    \"" << result.name << "\": { "
+                << "\"batch\": " << result.batch
+                << ", \"samples\": " << result.samples
+                << ", \"median_ns\": " << result.median * 1e9
+                << ", \"mad_ns\": " << result.mad * 1e9
+                << ", \"min_ns\": " << result.min * 1e9
+                << ", \"p90_ns\": " << result.p90 * 1e9
+                << ", \"mean_ns\": " << result.mean * 1e9 << " }";
+        }
+        out_stream << "\n  }\n}" << std::endl;
+    }
+
+    // Compare with the reports in in_fileNames, one run each; false on any
+    // regression.
+    bool compare( const std::vector< std::string >& in_fileNames ) const {
+        std::vector< Result > baseline;
+        unsigned int runs = 0U;
+        for( size_t index = 0U; index < in_fileNames.size(); index += 1U ) {
+            std::ifstream file( in_fileNames[ index ].c_str() );
+            if( file.good() == false ) {
+                std::cout << "No baseline at " << in_fileNames[ index ] << "; skipped." << std::endl;
+                continue;
+            }
+            std::string line;
+            while( std::getline( file, line ) ) {
+                Result result;
+                if( ParseLine( line, &result ) == true )
+                    baseline.push_back( result );
+            }
+            runs += 1U;
+        }
+        if( runs == 0U ) {
+            std::cout << "No baseline; nothing to compare." << std::endl;
+            return true;
+        }
+        std::cout << "Against " << runs << " baseline run" << ( runs > 1U ? "s" : "" ) << ", tolerance "
+            << _options.tolerance << "%" << std::endl;
+        bool passed = true;
+        for( size_t index = 0U; index < _results.size(); index += 1U ) {
+            const Result& result = _results[ index ];
+            std::vector< double > medians;
+            double mad = result.mad;
+            for( size_t entry = 0U; entry < baseline.size(); entry += 1U ) {
+                if( baseline[ entry ].name == result.name && baseline[ entry ].median > 0.0 ) {
+                    medians.push_back( baseline[ entry ].median );
+                    mad = std::max( mad, baseline[ entry ].mad );
+                }
+            }
+            std::cout << "  " << std::left << std::setw( 28 ) << result.name << std::right;
+            if( medians.empty() == true ) {
+                std::cout << " new" << std::endl;
+                continue;
+            }
+            const double reference = Bench::Percentile( medians, 50.0 );
+            const double spread = *std::max_element( medians.begin(), medians.end() )
+                - *std::min_element( medians.begin(), medians.end() );
+            const double change = 100.0 * ( result.median / reference - 1.0 );
+            const double gap = result.median - reference;
+            const bool regressed = change > _options.tolerance && gap > NOISE_MADS * mad && gap > spread;
+            std::cout << " " << std::setw( 11 ) << Format( reference ) << " -> " << std::setw( 11 )
+                << Format( result.median ) << std::showpos << std::fixed << std::setprecision( 1 ) << std::setw( 8 )
+                << change << "%" << std::noshowpos << "  spread " << std::setw( 11 ) << Format( spread )
+                << ( regressed ? "  REGRESSED" : "" ) << std::endl;
+            passed = passed && regressed == false;
+        }
+        return passed;
+    }
+
+private:
+    // One benchmark line as writeJson() formats it.
+    static bool ParseLine( const std::string& in_line, Result* out_result ) {
+        const size_t nameBegin = in_line.find( '"' ), nameEnd = in_line.find( "\": {" );
+        if( nameBegin == std::string::npos || nameEnd == std::string::npos || nameEnd <= nameBegin )
+            return false;
+        out_result->name = in_line.substr( nameBegin + 1U, nameEnd - nameBegin - 1U );
+        return ParseField( in_line, "\"median_ns\": ", &out_result->median )
+            && ParseField( in_line, "\"mad_ns\": ", &out_result->mad );
+    }
+
+    static bool ParseField( const std::string& in_line, const char* in_key, double* out_seconds ) {
+        const size_t position = in_line.find( in_key );
+        if( position == std::string::npos )
+            return false;
+        *out_seconds = atof( in_line.c_str() + position + strlen( in_key ) ) * 1e-9;
+        return true;
+    }
+
+private:
+    Options                 _options;
+    std::vector< Result >   _results;
+};
+
+static bool MeshBenchmarks( Suite* io_suite ) {
+    Mesh mesh;
+    if( FileMapMesh( MESH_PATH, &mesh ) == false || mesh.f.empty() ) {
+        std::cout << MESH_PATH << ": parse error" << std::endl;
+        return false;
+    }
+    io_suite->run( "obj_load_getline/pumpkin", 2U, 15U, 1U, [ & ]() {
+        Mesh loaded;
+        FileLoadMesh( MESH_PATH, &loaded );
+        sink = sink + (float)loaded.f.size();
+    } );
+    io_suite->run( "obj_load_mmap/pumpkin", 3U, 30U, 1U, [ & ]() {
+        Mesh loaded;
+        FileMapMesh( MESH_PATH, &loaded );
+        sink = sink + (float)loaded.f.size();
+    } );
+    std::vector< AVertex > verticies;
+    std::vector< AColor > colors;
+    std::vector< AIndex > indicies;
+    io_suite->run( "convert_mesh/pumpkin", 5U, 50U, 1U, [ & ]() {
+        ConvertMesh( mesh, &verticies, &colors, &indicies );
+        sink = sink + verticies[ 0 ].x;
+    } );
+    return true;
+}
+
+// The render loop's matrices: the camera once a frame, then one MVP per
+// body as main.cpp built them before instancing.
+static void MatrixBenchmarks( Suite* io_suite ) {
+    const float width = 1280.f, height = 720.f;
+    io_suite->run( "mvp_camera", 100U, 50U, 10000U, [ & ]() {
+        const glm::mat4 projection = glm::perspectiveFov( glm::radians( 45.f ), width, height, 0.1f, 500.f );
+        const glm::mat4 view = glm::lookAt( glm::vec3( 0.f, 65.f, 30.f ), glm::vec3( 0.f, 50.f, 0.f ),
+            glm::vec3( 0.f, 1.f, 0.f ) );
+        const glm::mat4 viewProjection = projection * view;
+        sink = sink + viewProjection[ 0 ][ 0 ];
+    } );
+
+    std::vector< glm::vec3 > positions( MVP_BODIES );
+    std::vector< glm::quat > rotations( MVP_BODIES );
+    for( unsigned int body = 0U; body < MVP_BODIES; body += 1U ) {
+        positions[ body ] = glm::vec3( (float)( body % 32U ), 50.f, -(float)( body / 32U ) );
+        rotations[ body ] = glm::angleAxis( 0.01f * body, glm::vec3( 0.f, 1.f, 0.f ) );
+    }
+    const glm::mat4 base = glm::scale( glm::mat4( 1.f ), glm::vec3( 0.2f ) );
+    const glm::mat4 viewProjection = glm::perspectiveFov( glm::radians( 45.f ), width, height, 0.1f, 500.f )
+        * glm::lookAt( glm::vec3( 0.f, 65.f, 30.f ), glm::vec3( 0.f, 50.f, 0.f ), glm::vec3( 0.f, 1.f, 0.f ) );
+    std::vector< glm::mat4 > mvps( MVP_BODIES );
+    std::ostringstream name;
+    name << "mvp_bodies/" << MVP_BODIES;
+    io_suite->run( name.str(), 10U, 50U, 20U, [ & ]() {
+        for( unsigned int body = 0U; body < MVP_BODIES; body += 1U )
+            mvps[ body ] = viewProjection * glm::translate( glm::mat4( 1.f ), positions[ body ] )
+                * glm::mat4_cast( rotations[ body ] ) * base;
+        sink = sink + mvps[ MVP_BODIES - 1U ][ 3 ][ 3 ];
+    } );
+}
+
+// Boxes in layers above a ground plane, kept awake so the cost of a step
+// does not fall as the stack settles.
+static void PhysicsBenchmarks( Suite* io_suite ) {
+    btStaticPlaneShape ground( btVector3( 0.f, 1.f, 0.f ), 0.f );
+    btBoxShape box( btVector3( 1.f, 1.f, 1.f ) );
+    for( unsigned int count = 0U; count < BODY_COUNT_COUNT; count += 1U ) {
+        const unsigned int bodies = BODY_COUNTS[ count ];
+        std::ostringstream name;
+        name << "bullet_step/" << bodies;
+        if( io_suite->wanted( name.str() ) == false )
+            continue;
+        App::PhysicsWorld world;
+        btTransform transform;
+        transform.setIdentity();
+        world.addBody( &ground, 0.f, transform );
+        const unsigned int side = (unsigned int)std::ceil( std::sqrt( (double)bodies / 10.0 ) );
+        for( unsigned int index = 0U; index < bodies; index += 1U ) {
+            const unsigned int layer = index / ( side * side ), cell = index % ( side * side );
+            transform.setOrigin( btVector3( 2.5f * ( cell % side ), 2.f + 2.5f * layer, 2.5f * ( cell / side ) ) );
+            world.addBody( &box, 1.f, transform )->setActivationState( DISABLE_DEACTIVATION );
+        }
+        io_suite->run( name.str(), 30U, 60U, 1U, [ & ]() { world.step( (btScalar)( 1.0 / STEP_RATE ) ); } );
+    }
+}
+
+int main( int argc, char** argv ) {
+    Options options;
+    options.tolerance = DEFAULT_TOLERANCE;
+    for( int arg = 1; arg < argc; arg += 1 ) {
+        const std::string flag = argv[ arg ];
+        if( arg + 1 >= argc ) {
+            std::cout << "Error: " << flag << " needs a value." << std::endl;
+            return EXIT_FAILURE;
+        }
+        if( flag == "--report" )
+            options.report = argv[ ++arg ];
+        else if( flag == "--baseline" )
+            options.baselines.push_back( argv[ ++arg ] );
+        else if( flag == "--tolerance" )
+            options.tolerance = atof( argv[ ++arg ] );
+        else if( flag == "--filter" )
+            options.filter = argv[ ++arg ];
+        else {
+            std::cout << "Error: unknown option " << flag << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    Suite suite( options );
+    if( MeshBenchmarks( &suite ) == false )
+        return EXIT_FAILURE;
+    MatrixBenchmarks( &suite );
+    PhysicsBenchmarks( &suite );
+
+    if( options.report.empty() == false ) {
+        std::ofstream report( options.report.c_str() );
+        suite.writeJson( report );
+        if( report.good() == false ) {
+            std::cout << "Error: cannot write " << options.report << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    if( options.baselines.empty() == false && suite.compare( options.baselines ) == false )
+        return EXIT_FAILURE;
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,130 @@
+/*
+Bytes per vertex and reconstruction error of the packed formats for every
+bundled mesh. Positions are compared with the float positions; colors with
+the float colors clamped to [ 0, 1 ], which is what RGBA8 can hold, and the
+components that had to be clamped are counted. The meshes carry no
+per-vertex normals through the pipeline, so area-weighted vertex normals
+are built from the faces to measure the octahedral encoding.
+Exits with failure when an error exceeds its quantization bound.
+Usage: bench_vertex_packing.out [mesh ...]
+*/
+#include <stdlib.h>
+#include <float.h>
+#include <cmath>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+
+#include "MeshBuffer.hpp"
+#include "VertexPacking.hpp"
+#include "Bench.hpp"
+
+static const char* MESHES[] = { "res/cube", "res/shape", "res/pumpkin", "res/sphere", "res/teapot" };
+static const unsigned int MESH_COUNT = sizeof(MESHES) / sizeof(MESHES[ 0 ]);
+// 16-bit octahedral normals stay well below this, in degrees.
+static const float NORMAL_BOUND = 0.005f;
+
+static void VertexNormals( const App::MeshBuffer& in_mesh, std::vector< float >* out_normals ) {
+    out_normals->assign( 3U * in_mesh.vertexCount(), 0.f );
+    // Level 0 only; the other levels reuse the same vertices.
+    const unsigned int faces = in_mesh.lodCount() > 0U ? in_mesh.lods()[ 0 ].faceCount : 0U;
+    for( unsigned int face = 0U; face < faces; face += 1U ) {
+        const unsigned int* corners = &in_mesh.indicies()[ face ].a;
+        const float* a = &in_mesh.verticies()[ corners[ 0 ] ].x;
+        const float* b = &in_mesh.verticies()[ corners[ 1 ] ].x;
+        const float* c = &in_mesh.verticies()[ corners[ 2 ] ].x;
+        const float u[ 3 ] = { b[ 0 ] - a[ 0 ], b[ 1 ] - a[ 1 ], b[ 2 ] - a[ 2 ] },
+            v[ 3 ] = { c[ 0 ] - a[ 0 ], c[ 1 ] - a[ 1 ], c[ 2 ] - a[ 2 ] };
+        const float cross[ 3 ] = { u[ 1 ] * v[ 2 ] - u[ 2 ] * v[ 1 ], u[ 2 ] * v[ 0 ] - u[ 0 ] * v[ 2 ],
+            u[ 0 ] * v[ 1 ] - u[ 1 ] * v[ 0 ] };
+        for( unsigned int corner = 0U; corner < 3U; corner += 1U )
+            for( unsigned int axis = 0U; axis < 3U; axis += 1U )
+                ( *out_normals )[ 3U * corners[ corner ] + axis ] += cross[ axis ];
+    }
+}
+
+static bool Run( const char* in_fileName ) {
+    App::MeshBuffer mesh;
+    if( mesh.load( in_fileName ) == false ) {
+        std::cout << in_fileName << ": parse error" << std::endl;
+        return false;
+    }
+    PackedMesh packed;
+    const unsigned int vertexCount = mesh.vertexCount();
+    const double packTime = Bench::BestOf( 5U, [ & ]() { PackMesh( mesh, &packed ); } );
+
+    const size_t floatVertex = sizeof(AVertex) + sizeof(AColor), packedVertex = sizeof(PVertex) + sizeof(PColor);
+    const size_t floatBytes = floatVertex * vertexCount + sizeof(AIndex) * mesh.faceCount(),
+        packedBytes = packedVertex * vertexCount + packed.indexBytes();
+
+    float positionError = 0.f, positionBound = 0.f;
+    // Half a step, plus float rounding in the decode.
+    for( unsigned int axis = 0U; axis < 3U; axis += 1U )
+        positionBound = std::max( positionBound, packed.decode.scale[ axis ] * 0.5f / 65535.f
+            + 2.f * FLT_EPSILON * ( std::abs( packed.decode.offset[ axis ] ) + std::abs( packed.decode.scale[ axis ] ) ) );
+    float colorError = 0.f;
+    unsigned int clamped = 0U;
+    for( unsigned int index = 0U; index < vertexCount; index += 1U ) {
+        float position[ 3 ], color[ 4 ];
+        UnpackPosition( packed.verticies[ index ], packed.decode, position );
+        UnpackColor( packed.colors[ index ], color );
+        for( unsigned int axis = 0U; axis < 3U; axis += 1U )
+            positionError = std::max( positionError, std::abs( position[ axis ] - ( &mesh.verticies()[ index ].x )[ axis ] ) );
+        for( unsigned int channel = 0U; channel < 4U; channel += 1U ) {
+            const float source = ( &mesh.colors()[ index ].r )[ channel ];
+            const float displayable = std::min( std::max( source, 0.f ), 1.f );
+            clamped += displayable != source ? 1U : 0U;
+            colorError = std::max( colorError, std::abs( color[ channel ] - displayable ) );
+        }
+    }
+
+    std::vector< float > normals;
+    VertexNormals( mesh, &normals );
+    double normalError = 0.0;
+    for( unsigned int index = 0U; index < vertexCount; index += 1U ) {
+        float* normal = &normals[ 3U * index ];
+        const float length = std::sqrt( normal[ 0 ] * normal[ 0 ] + normal[ 1 ] * normal[ 1 ] + normal[ 2 ] * normal[ 2 ] );
+        if( length == 0.f )
+            continue;
+        for( unsigned int axis = 0U; axis < 3U; axis += 1U )
+            normal[ axis ] /= length;
+        PNormal encoded;
+        float decoded[ 3 ];
+        PackNormal( normal, &encoded );
+        UnpackNormal( encoded, decoded );
+        // atan2 of the cross and dot products stays accurate for tiny angles.
+        const double dot = (double)normal[ 0 ] * decoded[ 0 ] + (double)normal[ 1 ] * decoded[ 1 ]
+            + (double)normal[ 2 ] * decoded[ 2 ];
+        const double cross[ 3 ] = { (double)normal[ 1 ] * decoded[ 2 ] - (double)normal[ 2 ] * decoded[ 1 ],
+            (double)normal[ 2 ] * decoded[ 0 ] - (double)normal[ 0 ] * decoded[ 2 ],
+            (double)normal[ 0 ] * decoded[ 1 ] - (double)normal[ 1 ] * decoded[ 0 ] };
+        const double sine = std::sqrt( cross[ 0 ] * cross[ 0 ] + cross[ 1 ] * cross[ 1 ] + cross[ 2 ] * cross[ 2 ] );
+        normalError = std::max( normalError, std::atan2( sine, dot ) * 180.0 / 3.14159265358979 );
+    }
+
+    const bool passed = positionError <= positionBound && colorError <= 0.5f / 255.f + FLT_EPSILON
+        && normalError <= NORMAL_BOUND;
+    std::cout << in_fileName << ": " << vertexCount << " vertices, " << mesh.faceCount() << " triangles over all LODs" << std::endl
+        << std::fixed << std::setprecision( 1 )
+        << "    vertex  " << floatVertex << " -> " << packedVertex << " bytes, index " << sizeof(unsigned int)
+        << " -> " << packed.indexSize << " bytes, total " << floatBytes / 1024.0 << " -> " << packedBytes / 1024.0
+        << " KiB (" << 100.0 * packedBytes / floatBytes << "%)" << std::endl
+        << std::scientific << std::setprecision( 2 )
+        << "    position max error " << positionError << " (bound " << positionBound << "), color "
+        << colorError << " with " << clamped << " components clamped, normal " << normalError << " deg" << std::endl
+        << std::fixed << "    pack " << packTime * 1e9 / std::max( vertexCount, 1U ) << " ns/vertex"
+        << ( passed ? "" : "  FAILED" ) << std::endl;
+    return passed;
+}
+
+int main( int argc, char** argv ) {
+    bool passed = true;
+    if( argc > 1 ) {
+        for( int arg = 1; arg < argc; arg += 1 )
+            passed = Run( argv[ arg ] ) && passed;
+    } else {
+        for( unsigned int mesh = 0U; mesh < MESH_COUNT; mesh += 1U )
+            passed = Run( MESHES[ mesh ] ) && passed;
+    }
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,200 @@
+/*
+Warm restart from a .bullet snapshot against a cold rebuild of the scene.
+The scene: the teapot as a static triangle mesh with a BVH, a ground plane,
+and bodies dropped in a grid onto them, each a convex hull of one res/ mesh.
+"cold" parses the meshes, builds the shapes and adds the bodies; "cold+sim"
+also runs the steps the snapshot was taken after. The saved world and the
+restored one are then stepped side by side and compared bit for bit.
+Run from the repository root. Usage: bench_world_snapshot.out [max bodies]
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <cmath>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+
+#include "BulletCollision/CollisionShapes/btShapeHull.h"
+
+#include "MeshBuffer.hpp"
+#include "PhysicsMesh.hpp"
+#include "PhysicsWorld.hpp"
+#include "WorldSnapshot.hpp"
+#include "Bench.hpp"
+
+static const char* HULL_MESHES[] = { "res/cube", "res/sphere", "res/pumpkin", "res/shape" };
+static const unsigned int HULL_COUNT = sizeof( HULL_MESHES ) / sizeof( HULL_MESHES[ 0 ] );
+static const char* STATIC_MESH = "res/teapot";
+static const char* SNAPSHOT_FILE = "bin/bench_world_snapshot.bullet";
+static const unsigned int BODY_COUNTS[] = { 1000U, 10000U, 100000U };
+static const btScalar TIME_STEP = 1.f / 60.f;
+// Steps before the snapshot, so bodies are moving and in contact.
+static const unsigned int SETTLE_STEPS = 30U;
+static const unsigned int CHECK_STEPS = 30U;
+
+// Everything a cold start builds; shapes must outlive the world.
+struct Scene {
+    std::vector< App::MeshBuffer* >         meshes;
+    App::PhysicsMesh*                       staticMesh;
+    btBvhTriangleMeshShape*                 staticShape;
+    btStaticPlaneShape*                     ground;
+    std::vector< btConvexHullShape* >       hulls;
+
+    Scene( void ) : staticMesh( NULL ), staticShape( NULL ), ground( NULL ) {}
+    ~Scene( void ) {
+        for( size_t index = 0U; index < hulls.size(); index += 1U )
+            delete hulls[ index ];
+        delete ground;
+        delete staticShape;
+        delete staticMesh;
+        for( size_t index = 0U; index < meshes.size(); index += 1U )
+            delete meshes[ index ];
+    }
+};
+
+static App::MeshBuffer* LoadMesh( Scene* io_scene, const char* in_path ) {
+    App::MeshBuffer* mesh = new App::MeshBuffer;
+    io_scene->meshes.push_back( mesh );
+    return mesh->load( in_path ) == true ? mesh : NULL;
+}
+
+// Hull of the mesh scaled to a radius of one, reduced by btShapeHull to a
+// few dozen points so that contacts stay cheap.
+static btConvexHullShape* CreateHull( const App::MeshBuffer& in_mesh ) {
+    const AVertex* verticies = in_mesh.verticies();
+    btScalar radius = 0.f;
+    for( unsigned int index = 0U; index < in_mesh.vertexCount(); index += 1U )
+        radius = btMax( radius, btVector3( verticies[ index ].x, verticies[ index ].y, verticies[ index ].z ).length() );
+    btConvexHullShape full;
+    for( unsigned int index = 0U; index < in_mesh.vertexCount(); index += 1U )
+        full.addPoint( btVector3( verticies[ index ].x, verticies[ index ].y, verticies[ index ].z ) / radius, false );
+    full.recalcLocalAabb();
+    btShapeHull reduced( &full );
+    reduced.buildHull( full.getMargin() );
+    return new btConvexHullShape( reinterpret_cast<const btScalar*>( reduced.getVertexPointer() ),
+        reduced.numVertices() );
+}
+
+static bool BuildScene( Scene* io_scene, App::PhysicsWorld* io_world, const unsigned int in_bodies ) {
+    for( unsigned int index = 0U; index < HULL_COUNT; index += 1U ) {
+        const App::MeshBuffer* mesh = LoadMesh( io_scene, HULL_MESHES[ index ] );
+        if( mesh == NULL )
+            return false;
+        io_scene->hulls.push_back( CreateHull( *mesh ) );
+    }
+    const App::MeshBuffer* teapot = LoadMesh( io_scene, STATIC_MESH );
+    if( teapot == NULL )
+        return false;
+    io_scene->staticMesh = new App::PhysicsMesh( *teapot );
+    io_scene->staticShape = io_scene->staticMesh->createStaticShape();
+    io_scene->ground = new btStaticPlaneShape( btVector3( 0.f, 1.f, 0.f ), 0.f );
+
+    btTransform transform;
+    transform.setIdentity();
+    io_world->addBody( io_scene->ground, 0.f, transform );
+    io_world->addBody( io_scene->staticShape, 0.f, transform );
+    const unsigned int side = (unsigned int)std::ceil( std::sqrt( (double)in_bodies / 10.0 ) );
+    for( unsigned int index = 0U; index < in_bodies; index += 1U ) {
+        const unsigned int layer = index / ( side * side );
+        const unsigned int cell = index % ( side * side );
+        transform.setOrigin( btVector3( 2.5f * ( cell % side - 0.5f * side ), 3.f + 2.5f * layer,
+            2.5f * ( cell / side - 0.5f * side ) ) );
+        io_world->addBody( io_scene->hulls[ index % HULL_COUNT ], 1.f, transform );
+    }
+    return true;
+}
+
+// Only x, y and z: the fourth lane of a btVector3 is not always written.
+static bool SameBits( const btVector3& in_left, const btVector3& in_right ) {
+    return memcmp( in_left.m_floats, in_right.m_floats, 3U * sizeof( btScalar ) ) == 0;
+}
+
+static bool SameState( const btRigidBody& in_left, const btRigidBody& in_right ) {
+    const btTransform& left = in_left.getWorldTransform();
+    const btTransform& right = in_right.getWorldTransform();
+    for( int row = 0; row < 3; row += 1 )
+        if( SameBits( left.getBasis()[ row ], right.getBasis()[ row ] ) == false )
+            return false;
+    return SameBits( left.getOrigin(), right.getOrigin() ) == true
+        && SameBits( in_left.getLinearVelocity(), in_right.getLinearVelocity() ) == true
+        && SameBits( in_left.getAngularVelocity(), in_right.getAngularVelocity() ) == true;
+}
+
+// First step whose poses or velocities differ in any bit, or 0 when all
+// in_steps match.
+static unsigned int FirstDivergence( App::PhysicsWorld* io_left, App::PhysicsWorld* io_right,
+    const unsigned int in_steps ) {
+    const btCollisionObjectArray& left = io_left->world()->getCollisionObjectArray();
+    const btCollisionObjectArray& right = io_right->world()->getCollisionObjectArray();
+    if( left.size() != right.size() )
+        return 1U;
+    for( unsigned int step = 1U; step <= in_steps; step += 1U ) {
+        io_left->step( TIME_STEP );
+        io_right->step( TIME_STEP );
+        for( int index = 0; index < left.size(); index += 1 )
+            if( SameState( *btRigidBody::upcast( left[ index ] ), *btRigidBody::upcast( right[ index ] ) ) == false )
+                return step;
+    }
+    return 0U;
+}
+
+int main( int argc, char** argv ) {
+    const unsigned int maxBodies = argc > 1 ? (unsigned int)atoi( argv[ 1 ] ) : BODY_COUNTS[ 2 ];
+    std::cout << std::right << std::setw( 8 ) << "bodies" << std::setw( 10 ) << "file MiB"
+        << std::setw( 10 ) << "cold ms" << std::setw( 13 ) << "cold+sim ms" << std::setw( 10 ) << "save ms"
+        << std::setw( 12 ) << "restore ms" << std::setw( 9 ) << "speedup" << "  stepping" << std::endl;
+    bool identical = true;
+    for( unsigned int count = 0U; count < sizeof( BODY_COUNTS ) / sizeof( BODY_COUNTS[ 0 ] ); count += 1U ) {
+        const unsigned int bodies = BODY_COUNTS[ count ];
+        if( bodies > maxBodies )
+            break;
+        Scene scene;
+        App::PhysicsWorld world;
+        Bench::Clock::time_point begin = Bench::Clock::now();
+        if( BuildScene( &scene, &world, bodies ) == false ) {
+            std::cout << "Error: cannot load the meshes in res/" << std::endl;
+            return EXIT_FAILURE;
+        }
+        const double cold = Bench::Seconds( begin, Bench::Clock::now() );
+        begin = Bench::Clock::now();
+        for( unsigned int step = 0U; step < SETTLE_STEPS; step += 1U )
+            world.step( TIME_STEP );
+        const double simulated = Bench::Seconds( begin, Bench::Clock::now() );
+
+        begin = Bench::Clock::now();
+        if( App::WorldSnapshot::save( &world, SNAPSHOT_FILE ) == false ) {
+            std::cout << "Error: cannot write " << SNAPSHOT_FILE << std::endl;
+            return EXIT_FAILURE;
+        }
+        const double save = Bench::Seconds( begin, Bench::Clock::now() );
+        FILE* file = fopen( SNAPSHOT_FILE, "rb" );
+        fseek( file, 0, SEEK_END );
+        const long fileBytes = ftell( file );
+        fclose( file );
+
+        // The world is declared after the snapshot so it goes first.
+        App::WorldSnapshot snapshot;
+        App::PhysicsWorld restored;
+        begin = Bench::Clock::now();
+        if( snapshot.load( SNAPSHOT_FILE, &restored ) == false ) {
+            std::cout << "Error: cannot restore " << SNAPSHOT_FILE << std::endl;
+            return EXIT_FAILURE;
+        }
+        const double restore = Bench::Seconds( begin, Bench::Clock::now() );
+
+        const unsigned int diverged = FirstDivergence( &world, &restored, CHECK_STEPS );
+        identical = identical && diverged == 0U;
+        std::cout << std::setw( 8 ) << bodies << std::fixed << std::setprecision( 2 )
+            << std::setw( 10 ) << fileBytes / 1048576.0
+            << std::setprecision( 1 ) << std::setw( 10 ) << cold * 1e3 << std::setw( 13 ) << ( cold + simulated ) * 1e3
+            << std::setw( 10 ) << save * 1e3 << std::setw( 12 ) << restore * 1e3
+            << std::setw( 8 ) << ( cold + simulated ) / restore << "x  ";
+        if( diverged == 0U )
+            std::cout << "identical for " << CHECK_STEPS << " steps" << std::endl;
+        else
+            std::cout << "DIVERGED at step " << diverged << std::endl;
+    }
+    remove( SNAPSHOT_FILE );
+    return identical == true ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -1,12 +1,38 @@
 #include "Application.hpp"
 
-#include <sstream>
+#include <stdlib.h>
+#include <algorithm>
 
 App::Application* App::Application::_instance = NULL;
 
 App::Application* App::Application::getInstance() {
     if( App::Application::_instance == NULL )
-        App::Application::_instance = new Application();
+        App::Application::_instance = new Application( RunOptions() );
+    return App::Application::_instance;
+}
+
+App::Application* App::Application::getInstance( const int argc, char** argv ) {
+    if( App::Application::_instance != NULL )
+        return App::Application::_instance;
+    RunOptions options;
+    for( int index = 1; index < argc; index += 1 ) {
+        const std::string argument( argv[ index ] );
+        if( argument == "--headless" )
+            options.headless = true;
+        else if( argument == "--frames" && index + 1 < argc )
+            options.frames = (unsigned int)std::max( atoi( argv[ ++index ] ), 1 );
+        else if( argument == "--report" && index + 1 < argc )
+            options.report = argv[ ++index ];
+        else if( argument == "--physics-threads" && index + 1 < argc )
+            options.physicsThreads = (unsigned int)std::max( atoi( argv[ ++index ] ), 0 );
+        else if( argument == "--physics-openmp" )
+            options.physicsOpenMP = true;
+        else if( argument == "--physics-broadphase" && index + 1 < argc )
+            options.physicsBroadphase = argv[ ++index ];
+        else
+            std::cerr << "Warning: Unknown argument " << argument << "." << std::endl;
+    }
+    App::Application::_instance = new Application( options );
     return App::Application::_instance;
 }
 
@@ -65,27 +91,45 @@ static const std::string resolveValue( const int hint, const int value ) {
     }
 }
 
+// Runs on the logger thread, so hint() only queues two ints.
+static void FormatHint( const App::LogRecord& in_record, std::string* out_text ) {
+    out_text->append( "Change hint " );
+    out_text->append( resolveHint( in_record.arguments[ 0 ] ) );
+    out_text->append( " with " );
+    out_text->append( resolveValue( in_record.arguments[ 0 ], in_record.arguments[ 1 ] ) );
+    out_text->append( "." );
+}
+
 const App::Application* App::Application::hint( const int hint,
     const int value ) const {
     if( _initialized == false )
         return NULL;
     glfwWindowHint( hint, value );
-    std::stringbuf info;
-    std::ostream stream( &info );
-    stream << "Change hint " << resolveHint( hint )
-        << " with " << resolveValue( hint, value ) << ".";
-    App::Application::log( App::LogType::Info, info.str() );
+    _logger.push( App::LogType::Info, FormatHint, hint, value );
     return this;
 }
 
 const App::Application* App::Application::setLogStream( std::ostream& to ) {
     App::Application::log( App::LogType::Info, "Changing log outstream." );
-    _out = &to;
+    _logger.setStream( &to );
     App::Application::log( App::LogType::Info, "Changed log outstream." );
     return this;
 }
 
+const App::RunOptions& App::Application::options( void ) const {
+    return _options;
+}
+
+bool App::Application::headless( void ) const {
+    return _options.headless;
+}
+
 void App::Application::init( void ) {
+    // Headless runs never touch GLFW, so they work without a display.
+    if( _options.headless == true ) {
+        App::Application::log( App::LogType::Info, "Headless, GLFW is not initialized." );
+        return;
+    }
     /*
     Initialize glfw.
     IF SUCCESS, YOU MUST CALL glfwTerminate() BEFORE EXIT.
@@ -108,23 +152,21 @@ void App::Application::init( void ) {
 }
 
 void App::Application::log( const App::LogType type,
-    const std::string& info ) const {
-    switch( type ) {
-        case App::LogType::Info :
-        (*_out) << "Info: " << info << std::endl;
-        break;;
-
-        case App::LogType::Warning :
-        (*_out) << "Warning: " << info << std::endl;
-        break;
-
-        case App::LogType::Error :
-        (*_out) << "Error: " << info << std::endl;
+    const char* info ) const {
+    _logger.push( type, info );
+    // Write everything queued so far before leaving.
+    if( type == App::LogType::Error ) {
+        _logger.stop();
         exit( EXIT_FAILURE );
-        break;
-
-        default :
-        App::Application::log( App::LogType::Error, "Not implemented." );
-        break;
     }
-}
\ No newline at end of file
+}
+
+void App::Application::log( const App::LogType type,
+    const std::string& info ) const {
+    App::Application::log( type, info.c_str() );
+}
+
+void App::Application::StopLogger( void ) {
+    if( App::Application::_instance != NULL )
+        App::Application::_instance->_logger.stop();
+}
@@ -2,15 +2,32 @@
 #define __APPLICATION__
 
 #include <GLFW/glfw3.h>
+#include <stdlib.h>
 #include <iostream>
 #include <string>
 
 #include "WindowConfig.hpp"
+#include "Logger.hpp"
 
 namespace App {
 
-enum LogType {
-    Info, Warning, Error
+// Command line options.
+//   --headless         Run without GLFW or GL and report frame timings.
+//   --frames N         Frames to run in headless mode.
+//   --report FILE      Write the headless JSON report to FILE, not stdout.
+//   --physics-threads N  Step physics on N threads, 0 for every core.
+//   --physics-openmp   Run those threads with OpenMP, not Bullet's pool.
+//   --physics-broadphase NAME  tree, sweep, sweep32 or hash.
+struct RunOptions {
+    RunOptions( void ) : headless( false ), frames( 600U ), physicsThreads( 1U ), physicsOpenMP( false ),
+        physicsBroadphase( "tree" ) {}
+
+    bool            headless;
+    unsigned int    frames;
+    std::string     report;
+    unsigned int    physicsThreads;
+    bool            physicsOpenMP;
+    std::string     physicsBroadphase;
 };
 
 class Application {
@@ -18,12 +35,17 @@ class Application {
 // Singleton pattern.
 public:
     static Application* getInstance();
+    // Parse the command line on the first call; later calls ignore it.
+    static Application* getInstance( const int argc, char** argv );
 private:
     static Application* _instance;
 
 // Constructor and distructor.
 private:
-    Application( void ) : _initialized( false ), _out( &std::cout ) {
+    Application( const RunOptions& options ) : _initialized( false ),
+        _logger( options.headless ? &std::cerr : &std::cout ), _options( options ) {
+        // Stray exit() calls still get every queued message written.
+        atexit( StopLogger );
         log( App::LogType::Info, "Application starts." );
         init();
     }
@@ -35,20 +57,27 @@ public:
             glfwTerminate();
         }
         log( App::LogType::Warning, "Program exits." );
+        _logger.stop();
         exit( EXIT_SUCCESS );
     }
 
 public:
     const Application* hint( const int hint, const int value ) const;
     const Application* setLogStream( std::ostream& to );
+    const RunOptions& options( void ) const;
+    bool headless( void ) const;
 
 private:
+    void log( const LogType type, const char* info ) const;
     void log( const LogType type, const std::string& info ) const;
     void init( void );
 
+    static void StopLogger( void );
+
 private:
     bool            _initialized;
-    std::ostream*   _out;
+    mutable Logger  _logger;
+    RunOptions      _options;
 
 };
 
@@ -0,0 +1,197 @@
+#include "FileWatcher.hpp"
+
+#include <stddef.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#if defined( __linux__ )
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#endif
+
+namespace {
+
+// Split in_path at its last '/'; the directory of a bare name is ".".
+void SplitPath( const std::string& in_path, std::string* out_directory, std::string* out_name ) {
+    const size_t slash = in_path.rfind( '/' );
+    if( slash == std::string::npos ) {
+        *out_directory = ".";
+        *out_name = in_path;
+    } else {
+        *out_directory = slash == 0U ? "/" : in_path.substr( 0U, slash );
+        *out_name = in_path.substr( slash + 1U );
+    }
+}
+
+}
+
+App::FileWatcher::FileWatcher( void ) : _notify( -1 ), _stopping( false ) {
+    _wake[ 0 ] = _wake[ 1 ] = -1;
+}
+
+App::FileWatcher::~FileWatcher( void ) {
+    stop();
+}
+
+unsigned int App::FileWatcher::watch( const char* in_fileName ) {
+    for( size_t file = 0U; file < _files.size(); file += 1U ) {
+        if( _files[ file ].path == in_fileName )
+            return (unsigned int)file;
+    }
+    File file;
+    file.path = in_fileName;
+    SplitPath( file.path, &file.directory, &file.name );
+    file.watch = -1;
+    file.size = file.mtime = -1;
+    _files.push_back( file );
+    return (unsigned int)( _files.size() - 1U );
+}
+
+const std::string& App::FileWatcher::fileName( const unsigned int in_file ) const {
+    return _files[ in_file ].path;
+}
+
+bool App::FileWatcher::start( void ) {
+    stop();
+    _stopping = false;
+    _changes.clear();
+    for( size_t file = 0U; file < _files.size(); file += 1U )
+        Stat( _files[ file ].path.c_str(), &_files[ file ].size, &_files[ file ].mtime );
+#if defined( __linux__ )
+    _notify = inotify_init1( IN_NONBLOCK | IN_CLOEXEC );
+    if( _notify >= 0 && pipe( _wake ) == 0 ) {
+        // One watch per directory; inotify returns the same descriptor for
+        // a directory watched twice.
+        bool watched = true;
+        for( size_t file = 0U; file < _files.size() && watched == true; file += 1U ) {
+            _files[ file ].watch = inotify_add_watch( _notify, _files[ file ].directory.c_str(),
+                IN_CLOSE_WRITE | IN_MOVED_TO );
+            watched = _files[ file ].watch >= 0;
+        }
+        if( watched == true ) {
+            _thread = std::thread( &FileWatcher::run, this );
+            return true;
+        }
+    }
+    // No inotify: fall back to polling.
+    stop();
+    _stopping = false;
+#endif
+    _thread = std::thread( &FileWatcher::runPolling, this );
+    return true;
+}
+
+void App::FileWatcher::stop( void ) {
+    {
+        std::lock_guard< std::mutex > lock( _mutex );
+        _stopping = true;
+    }
+    _stopped.notify_all();
+    if( _wake[ 1 ] >= 0 ) {
+        const char wake = 0;
+        const ssize_t written = write( _wake[ 1 ], &wake, 1U );
+        (void)written;
+    }
+    if( _thread.joinable() == true )
+        _thread.join();
+    for( unsigned int end = 0U; end < 2U; end += 1U ) {
+        if( _wake[ end ] >= 0 )
+            close( _wake[ end ] );
+        _wake[ end ] = -1;
+    }
+    if( _notify >= 0 )
+        close( _notify );
+    _notify = -1;
+    for( size_t file = 0U; file < _files.size(); file += 1U )
+        _files[ file ].watch = -1;
+}
+
+bool App::FileWatcher::native( void ) const {
+    return _notify >= 0;
+}
+
+bool App::FileWatcher::poll( std::vector< Change >* out_changes ) {
+    out_changes->clear();
+    std::lock_guard< std::mutex > lock( _mutex );
+    out_changes->swap( _changes );
+    return out_changes->empty() == false;
+}
+
+// Watcher thread on Linux: wait for inotify events until stop().
+void App::FileWatcher::run( void ) {
+#if defined( __linux__ )
+    // Aligned for struct inotify_event; holds many events per read().
+    alignas( struct inotify_event ) char events[ 4096 ];
+    while( true ) {
+        struct pollfd descriptors[ 2 ] = { { _notify, POLLIN, 0 }, { _wake[ 0 ], POLLIN, 0 } };
+        if( ::poll( descriptors, 2, -1 ) < 0 )
+            continue;
+        if( descriptors[ 1 ].revents != 0 )
+            return;
+        const Clock::time_point now = Clock::now();
+        ssize_t length = 0;
+        while( ( length = read( _notify, events, sizeof( events ) ) ) > 0 ) {
+            for( ssize_t offset = 0; offset < length; ) {
+                const struct inotify_event* event = reinterpret_cast< const struct inotify_event* >( events + offset );
+                offset += (ssize_t)( sizeof( struct inotify_event ) + event->len );
+                if( event->len == 0U )
+                    continue;
+                for( size_t file = 0U; file < _files.size(); file += 1U ) {
+                    if( _files[ file ].watch == event->wd && _files[ file ].name == event->name )
+                        changed( (unsigned int)file, now );
+                }
+            }
+        }
+    }
+#endif
+}
+
+// Watcher thread elsewhere: compare size and mtime every POLL_INTERVAL.
+void App::FileWatcher::runPolling( void ) {
+    while( true ) {
+        {
+            std::unique_lock< std::mutex > lock( _mutex );
+            _stopped.wait_for( lock, std::chrono::milliseconds( POLL_INTERVAL ),
+                [ this ]() { return _stopping == true; } );
+            if( _stopping == true )
+                return;
+        }
+        const Clock::time_point now = Clock::now();
+        for( size_t file = 0U; file < _files.size(); file += 1U ) {
+            long long size = -1, mtime = -1;
+            // A file missing in the middle of a save is picked up once it
+            // is back.
+            if( Stat( _files[ file ].path.c_str(), &size, &mtime ) == false )
+                continue;
+            if( size == _files[ file ].size && mtime == _files[ file ].mtime )
+                continue;
+            _files[ file ].size = size;
+            _files[ file ].mtime = mtime;
+            changed( (unsigned int)file, now );
+        }
+    }
+}
+
+// Queue in_file unless a change of it is already waiting.
+void App::FileWatcher::changed( const unsigned int in_file, const Clock::time_point in_time ) {
+    std::lock_guard< std::mutex > lock( _mutex );
+    for( size_t change = 0U; change < _changes.size(); change += 1U ) {
+        if( _changes[ change ].file == in_file )
+            return;
+    }
+    const Change change = { in_file, in_time };
+    _changes.push_back( change );
+}
+
+bool App::FileWatcher::Stat( const char* in_path, long long* out_size, long long* out_mtime ) {
+    struct stat info;
+    if( stat( in_path, &info ) != 0 )
+        return false;
+    *out_size = (long long)info.st_size;
+#if defined( __APPLE__ )
+    *out_mtime = (long long)info.st_mtimespec.tv_sec * 1000000000LL + info.st_mtimespec.tv_nsec;
+#else
+    *out_mtime = (long long)info.st_mtim.tv_sec * 1000000000LL + info.st_mtim.tv_nsec;
+#endif
+    return true;
+}
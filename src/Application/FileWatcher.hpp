@@ -0,0 +1,88 @@
+#ifndef __FILE_WATCHER__
+#define __FILE_WATCHER__
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace App {
+
+/*
+Reports files that were written, on a thread of its own.
+On Linux the thread blocks on inotify, watching the directory of each file
+for IN_CLOSE_WRITE and IN_MOVED_TO: editors that save through a temporary
+file and rename only produce the latter. Elsewhere it compares size and
+mtime every POLL_INTERVAL, so a change is seen up to that much later.
+
+    watcher.watch( "src/shader/vertex.shader" );
+    watcher.start();
+    ...
+    watcher.poll( &changes );               // once per frame
+
+Files are added before start(); every method except the thread's runs on
+the thread owning the watcher.
+*/
+class FileWatcher {
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Change {
+        unsigned int        file;   // Handle from watch().
+        Clock::time_point   time;   // First write not yet polled.
+    };
+
+    FileWatcher( void );
+    ~FileWatcher( void );
+
+    // Returns the handle of in_fileName; watching a file again returns the
+    // first handle.
+    unsigned int watch( const char* in_fileName );
+    const std::string& fileName( const unsigned int in_file ) const;
+
+    bool start( void );
+    void stop( void );
+    // True when changes come from inotify rather than polling.
+    bool native( void ) const;
+
+    // Replace out_changes with the files written since the last call, each
+    // once. Returns false when there are none.
+    bool poll( std::vector< Change >* out_changes );
+
+    static const unsigned int POLL_INTERVAL = 100U;    // Milliseconds.
+
+private:
+    FileWatcher( const FileWatcher& );
+    FileWatcher& operator=( const FileWatcher& );
+
+    struct File {
+        std::string         path;
+        std::string         directory;
+        std::string         name;       // Within directory.
+        int                 watch;      // inotify watch descriptor.
+        long long           size;
+        long long           mtime;      // Nanoseconds since the epoch.
+    };
+
+    void run( void );
+    void runPolling( void );
+    void changed( const unsigned int in_file, const Clock::time_point in_time );
+    static bool Stat( const char* in_path, long long* out_size, long long* out_mtime );
+
+private:
+    std::vector< File >         _files;
+    std::thread                 _thread;
+    int                         _notify;    // inotify descriptor, -1 when polling.
+    int                         _wake[ 2 ]; // Pipe that ends run().
+
+    std::mutex                  _mutex;
+    std::condition_variable     _stopped;
+    std::vector< Change >       _changes;   // Guarded by _mutex.
+    bool                        _stopping;  // Guarded by _mutex.
+};
+
+}
+
+#endif
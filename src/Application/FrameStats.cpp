@@ -0,0 +1,52 @@
+#include "FrameStats.hpp"
+
+#include <algorithm>
+#include <iomanip>
+
+unsigned int App::FrameStats::addStage( const std::string& in_name ) {
+    _names.push_back( in_name );
+    _samples.push_back( std::vector< double >() );
+    return (unsigned int)_names.size() - 1U;
+}
+
+void App::FrameStats::record( const unsigned int in_stage, const double in_seconds ) {
+    _samples[ in_stage ].push_back( in_seconds );
+}
+
+void App::FrameStats::setInfo( const std::string& in_key, const double in_value ) {
+    _info.push_back( std::make_pair( in_key, in_value ) );
+}
+
+double App::FrameStats::percentile( const unsigned int in_stage, const double in_percent ) const {
+    std::vector< double > sorted( _samples[ in_stage ] );
+    if( sorted.empty() )
+        return 0.0;
+    std::sort( sorted.begin(), sorted.end() );
+    const size_t rank = (size_t)( in_percent / 100.0 * ( sorted.size() - 1U ) + 0.5 );
+    return sorted[ std::min( rank, sorted.size() - 1U ) ];
+}
+
+void App::FrameStats::writeJson( std::ostream& out_stream ) const {
+    const std::ios::fmtflags flags = out_stream.flags();
+    out_stream << std::fixed << std::setprecision( 4 ) << "{\n  \"info\": {";
+    for( size_t index = 0U; index < _info.size(); index += 1U )
+        out_stream << ( index == 0U ? "\n" : ",\n" ) << "    \"" << _info[ index ].first << "\": "
+            << _info[ index ].second;
+    out_stream << "\n  },\n  \"stages\": {";
+    for( unsigned int stage = 0U; stage < _names.size(); stage += 1U ) {
+        const std::vector< double >& samples = _samples[ stage ];
+        double sum = 0.0;
+        for( size_t index = 0U; index < samples.size(); index += 1U )
+            sum += samples[ index ];
+        const double mean = samples.empty() ? 0.0 : sum / samples.size();
+        out_stream << ( stage == 0U ? "\n" : ",\n" ) << "    \"" << _names[ stage ] << "\": { "
+            << "\"samples\": " << samples.size()
+            << ", \"mean_ms\": " << mean * 1e3
+            << ", \"p50_ms\": " << percentile( stage, 50.0 ) * 1e3
+            << ", \"p95_ms\": " << percentile( stage, 95.0 ) * 1e3
+            << ", \"p99_ms\": " << percentile( stage, 99.0 ) * 1e3
+            << ", \"max_ms\": " << percentile( stage, 100.0 ) * 1e3 << " }";
+    }
+    out_stream << "\n  }\n}" << std::endl;
+    out_stream.flags( flags );
+}
@@ -0,0 +1,59 @@
+#ifndef __FRAME_STATS__
+#define __FRAME_STATS__
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace App {
+
+/*
+Wall-clock samples per named stage of a frame, summarized as JSON:
+
+    { "info": { ... }, "stages": { "physics": { "samples": 600,
+      "mean_ms": ..., "p50_ms": ..., "p95_ms": ..., "p99_ms": ..., "max_ms": ... }, ... } }
+*/
+class FrameStats {
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    // Register a stage; stages are reported in registration order.
+    unsigned int addStage( const std::string& in_name );
+    void record( const unsigned int in_stage, const double in_seconds );
+    // Numeric run description, e.g. frame and body counts.
+    void setInfo( const std::string& in_key, const double in_value );
+
+    // Nearest-rank percentile of a stage in seconds, in_percent in [0, 100].
+    double percentile( const unsigned int in_stage, const double in_percent ) const;
+    void writeJson( std::ostream& out_stream ) const;
+
+private:
+    std::vector< std::string >              _names;
+    std::vector< std::vector< double > >    _samples;
+    std::vector< std::pair< std::string, double > > _info;
+};
+
+// Records the lifetime of the scope into a stage.
+class StageTimer {
+public:
+    StageTimer( FrameStats* io_stats, const unsigned int in_stage )
+        : _stats( io_stats ), _stage( in_stage ), _begin( FrameStats::Clock::now() ) {}
+    ~StageTimer( void ) {
+        _stats->record( _stage,
+            std::chrono::duration< double >( FrameStats::Clock::now() - _begin ).count() );
+    }
+
+private:
+    StageTimer( const StageTimer& );
+    StageTimer& operator=( const StageTimer& );
+
+private:
+    FrameStats*                 _stats;
+    unsigned int                _stage;
+    FrameStats::Clock::time_point _begin;
+};
+
+}
+
+#endif
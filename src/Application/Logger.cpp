@@ -0,0 +1,195 @@
+#include "Logger.hpp"
+
+#include <stdint.h>
+#include <string.h>
+#include <chrono>
+
+namespace {
+
+// Longest a queued record waits for the writer when nobody flushes.
+const std::chrono::milliseconds WRITE_INTERVAL( 10 );
+// Records between wake-ups of a sleeping writer; a power of two.
+const size_t WAKE_EVERY = App::Logger::CAPACITY / 4U;
+
+}
+
+App::Logger::Logger( std::ostream* in_out ) : _enqueue( 0U ), _dequeue( 0U ), _level( Info ),
+    _dropped( 0U ), _reportedDrops( 0U ), _running( true ), _producers( 0 ), _written( 0U ), _out( in_out ) {
+    for( size_t index = 0U; index < CAPACITY; index += 1U )
+        _cells[ index ].sequence.store( index, std::memory_order_relaxed );
+    _thread = std::thread( &Logger::run, this );
+}
+
+App::Logger::~Logger( void ) {
+    stop();
+}
+
+void App::Logger::setLevel( const LogType in_level ) {
+    _level.store( in_level, std::memory_order_relaxed );
+}
+
+bool App::Logger::enabled( const LogType in_type ) const {
+    return in_type >= _level.load( std::memory_order_relaxed );
+}
+
+bool App::Logger::push( const LogType in_type, const char* in_text ) {
+    if( enabled( in_type ) == false )
+        return false;
+    LogRecord record;
+    record.type = in_type;
+    record.format = NULL;
+    strncpy( record.text, in_text, LogRecord::TEXT_SIZE - 1U );
+    record.text[ LogRecord::TEXT_SIZE - 1U ] = '\0';
+    return tryPush( record );
+}
+
+bool App::Logger::push( const LogType in_type, LogFormatter in_format, const int in_first, const int in_second ) {
+    if( enabled( in_type ) == false )
+        return false;
+    LogRecord record;
+    record.type = in_type;
+    record.format = in_format;
+    record.arguments[ 0 ] = in_first;
+    record.arguments[ 1 ] = in_second;
+    record.text[ 0 ] = '\0';
+    return tryPush( record );
+}
+
+void App::Logger::flush( void ) {
+    const size_t target = _enqueue.load( std::memory_order_acquire );
+    std::unique_lock< std::mutex > lock( _mutex );
+    if( _running.load() == false )
+        return;
+    _wake.notify_one();
+    _flushed.wait( lock, [ this, target ]() { return _written >= target; } );
+}
+
+void App::Logger::setStream( std::ostream* in_out ) {
+    flush();
+    std::lock_guard< std::mutex > lock( _mutex );
+    _out = in_out;
+}
+
+void App::Logger::stop( void ) {
+    {
+        std::lock_guard< std::mutex > lock( _mutex );
+        if( _running.load() == false )
+            return;
+        _running.store( false );
+        _wake.notify_one();
+    }
+    _thread.join();
+}
+
+unsigned long long App::Logger::dropped( void ) const {
+    return _dropped.load( std::memory_order_relaxed );
+}
+
+bool App::Logger::tryPush( const LogRecord& in_record ) {
+    // Counted before _running is read: a writer that sees stop() also sees
+    // this producer and waits for its record. Both are sequentially
+    // consistent, so one of the two always sees the other.
+    _producers.fetch_add( 1 );
+    // After stop() there is no writer; write in place.
+    if( _running.load() == false ) {
+        _producers.fetch_sub( 1 );
+        std::string line;
+        Format( in_record, &line );
+        std::lock_guard< std::mutex > lock( _mutex );
+        ( *_out ) << line;
+        _out->flush();
+        return true;
+    }
+    size_t position = _enqueue.load( std::memory_order_relaxed );
+    Cell* cell = NULL;
+    while( true ) {
+        cell = &_cells[ position & ( CAPACITY - 1U ) ];
+        const size_t sequence = cell->sequence.load( std::memory_order_acquire );
+        const intptr_t difference = (intptr_t)sequence - (intptr_t)position;
+        if( difference == 0 ) {
+            if( _enqueue.compare_exchange_weak( position, position + 1U, std::memory_order_relaxed ) == true )
+                break;
+        } else if( difference < 0 ) {
+            // Full: the writer has not freed this cell since the last lap.
+            _dropped.fetch_add( 1U, std::memory_order_relaxed );
+            _producers.fetch_sub( 1 );
+            return false;
+        } else {
+            position = _enqueue.load( std::memory_order_relaxed );
+        }
+    }
+    cell->record = in_record;
+    cell->sequence.store( position + 1U, std::memory_order_release );
+    _producers.fetch_sub( 1 );
+    // Bursts wake the writer early instead of waiting out WRITE_INTERVAL.
+    if( ( position & ( WAKE_EVERY - 1U ) ) == WAKE_EVERY - 1U )
+        _wake.notify_one();
+    return true;
+}
+
+// Format every committed record into io_batch and free its cell.
+size_t App::Logger::drain( std::string* io_batch ) {
+    size_t count = 0U;
+    while( true ) {
+        Cell& cell = _cells[ _dequeue & ( CAPACITY - 1U ) ];
+        if( cell.sequence.load( std::memory_order_acquire ) != _dequeue + 1U )
+            break;
+        Format( cell.record, io_batch );
+        cell.sequence.store( _dequeue + CAPACITY, std::memory_order_release );
+        _dequeue += 1U;
+        count += 1U;
+    }
+    return count;
+}
+
+void App::Logger::run( void ) {
+    std::string batch;
+    while( true ) {
+        batch.clear();
+        const size_t count = drain( &batch );
+        const unsigned long long dropped = _dropped.load( std::memory_order_relaxed );
+        if( dropped != _reportedDrops ) {
+            batch += "Warning: " + std::to_string( dropped - _reportedDrops ) + " log messages dropped.\n";
+            _reportedDrops = dropped;
+        }
+
+        std::unique_lock< std::mutex > lock( _mutex );
+        if( batch.empty() == false ) {
+            ( *_out ) << batch;
+            _out->flush();
+        }
+        if( count > 0U ) {
+            _written += count;
+            _flushed.notify_all();
+            continue;
+        }
+        // Producers still in tryPush(), and records reserved but not yet
+        // committed, keep the writer alive, so stop() returns only once
+        // every record pushed while it ran is written.
+        if( _running.load() == false && _producers.load() == 0
+            && _dequeue == _enqueue.load( std::memory_order_acquire ) )
+            break;
+        _wake.wait_for( lock, WRITE_INTERVAL );
+    }
+}
+
+void App::Logger::Format( const LogRecord& in_record, std::string* io_batch ) {
+    switch( in_record.type ) {
+        case Info :
+        io_batch->append( "Info: " );
+        break;
+
+        case Warning :
+        io_batch->append( "Warning: " );
+        break;
+
+        case Error :
+        io_batch->append( "Error: " );
+        break;
+    }
+    if( in_record.format != NULL )
+        in_record.format( in_record, io_batch );
+    else
+        io_batch->append( in_record.text );
+    io_batch->push_back( '\n' );
+}
@@ -0,0 +1,99 @@
+#ifndef __LOGGER__
+#define __LOGGER__
+
+#include <stddef.h>
+#include <atomic>
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace App {
+
+enum LogType {
+    Info, Warning, Error
+};
+
+struct LogRecord;
+// Turns a record into its message text on the writer thread.
+typedef void ( *LogFormatter )( const LogRecord& in_record, std::string* out_text );
+
+// Fixed-size message; longer text is truncated.
+struct LogRecord {
+    static const size_t TEXT_SIZE = 96U;
+
+    LogType         type;
+    LogFormatter    format;         // NULL for plain text.
+    int             arguments[ 2 ];
+    char            text[ TEXT_SIZE ];
+};
+
+/*
+Asynchronous logger.
+Producers copy fixed-size records into a bounded lock-free multi-producer
+ring (Vyukov's sequence-numbered cells) and return; a writer thread formats
+them in batches and writes each batch with one flush. Records below the
+level are rejected before anything is copied. When the ring is full the
+record is dropped and counted, and the writer reports the count.
+*/
+class Logger {
+public:
+    explicit Logger( std::ostream* in_out );
+    ~Logger( void );
+
+    void setLevel( const LogType in_level );
+    bool enabled( const LogType in_type ) const;
+
+    // Return false when the record was filtered or dropped.
+    bool push( const LogType in_type, const char* in_text );
+    bool push( const LogType in_type, LogFormatter in_format, const int in_first, const int in_second );
+
+    // Block until every record pushed before the call is written.
+    void flush( void );
+    // Flush, then write to in_out from now on.
+    void setStream( std::ostream* in_out );
+    // Flush and join the writer, which first waits for producers already
+    // pushing. Later records are written synchronously.
+    void stop( void );
+
+    unsigned long long dropped( void ) const;
+
+    static const size_t CAPACITY = 1024U;   // Power of two.
+
+private:
+    Logger( const Logger& );
+    Logger& operator=( const Logger& );
+
+    bool tryPush( const LogRecord& in_record );
+    size_t drain( std::string* io_batch );
+    void run( void );
+
+    static void Format( const LogRecord& in_record, std::string* io_batch );
+
+private:
+    struct Cell {
+        std::atomic< size_t >   sequence;
+        LogRecord               record;
+    };
+
+    Cell                        _cells[ CAPACITY ];
+    alignas( 64 ) std::atomic< size_t > _enqueue;
+    alignas( 64 ) size_t        _dequeue;           // Writer thread only.
+    std::atomic< int >          _level;
+    std::atomic< unsigned long long > _dropped;
+    unsigned long long          _reportedDrops;     // Writer thread only.
+    std::atomic< bool >         _running;
+    std::atomic< int >          _producers;         // Threads inside tryPush().
+
+    std::mutex                  _mutex;
+    std::condition_variable     _wake;              // Writer waits here.
+    std::condition_variable     _flushed;           // flush() waits here.
+    size_t                      _written;           // Records written, guarded by _mutex.
+    std::ostream*               _out;               // Guarded by _mutex.
+    std::thread                 _thread;
+};
+
+}
+
+#endif
@@ -0,0 +1,112 @@
+#ifndef __FLAT_HASH_MAP__
+#define __FLAT_HASH_MAP__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace App {
+
+/*
+Insert-only open-addressing hash map with linear probing.
+Keys and values live in one flat array whose capacity is a power of two, so
+a lookup is a multiply, a mask and usually a single cache line.
+Hash must be a functor returning a well-mixed uint64_t.
+*/
+template< typename Key, typename Value, typename Hash >
+class FlatHashMap {
+public:
+    explicit FlatHashMap( const size_t in_expected = 16U ) : _size( 0U ) {
+        reserve( in_expected );
+    }
+
+    // Grow so that in_count entries fit below the maximum load factor.
+    void reserve( const size_t in_count ) {
+        size_t capacity = 16U;
+        while( capacity * MAX_LOAD_NUMERATOR < in_count * MAX_LOAD_DENOMINATOR )
+            capacity *= 2U;
+        if( capacity > _slots.size() )
+            rehash( capacity );
+    }
+
+    // Return the value stored for in_key, inserting in_value if it is absent.
+    // out_inserted tells which of the two happened.
+    Value& findOrInsert( const Key& in_key, const Value& in_value, bool* out_inserted = NULL ) {
+        if( ( _size + 1U ) * MAX_LOAD_DENOMINATOR > _slots.size() * MAX_LOAD_NUMERATOR )
+            rehash( _slots.size() * 2U );
+        Slot& slot = probe( in_key );
+        const bool inserted = ( slot.used == false );
+        if( inserted ) {
+            slot.used = true;
+            slot.key = in_key;
+            slot.value = in_value;
+            _size += 1U;
+        }
+        if( out_inserted != NULL )
+            *out_inserted = inserted;
+        return slot.value;
+    }
+
+    // Return NULL if in_key is absent.
+    const Value* find( const Key& in_key ) const {
+        const size_t mask = _slots.size() - 1U;
+        for( size_t index = (size_t)Hash()( in_key ) & mask; ; index = ( index + 1U ) & mask ) {
+            const Slot& slot = _slots[ index ];
+            if( slot.used == false )
+                return NULL;
+            if( slot.key == in_key )
+                return &slot.value;
+        }
+    }
+
+    size_t size( void ) const {
+        return _size;
+    }
+
+private:
+    struct Slot {
+        Key     key;
+        Value   value;
+        bool    used;
+        Slot( void ) : key(), value(), used( false ) {}
+    };
+
+    // Load factor limit of 7/8 keeps probe sequences short.
+    static const size_t MAX_LOAD_NUMERATOR = 7U;
+    static const size_t MAX_LOAD_DENOMINATOR = 8U;
+
+    Slot& probe( const Key& in_key ) {
+        const size_t mask = _slots.size() - 1U;
+        size_t index = (size_t)Hash()( in_key ) & mask;
+        while( _slots[ index ].used == true && ( _slots[ index ].key == in_key ) == false )
+            index = ( index + 1U ) & mask;
+        return _slots[ index ];
+    }
+
+    void rehash( const size_t in_capacity ) {
+        std::vector< Slot > old( in_capacity );
+        old.swap( _slots );
+        for( size_t index = 0U; index < old.size(); index += 1U ) {
+            if( old[ index ].used == true )
+                probe( old[ index ].key ) = old[ index ];
+        }
+    }
+
+private:
+    std::vector< Slot > _slots;
+    size_t              _size;
+};
+
+// 64-bit finalizer from MurmurHash3; spreads every input bit over the output.
+inline uint64_t MixHash( uint64_t in_value ) {
+    in_value ^= in_value >> 33;
+    in_value *= 0xff51afd7ed558ccdULL;
+    in_value ^= in_value >> 33;
+    in_value *= 0xc4ceb9fe1a85ec53ULL;
+    in_value ^= in_value >> 33;
+    return in_value;
+}
+
+}
+
+#endif
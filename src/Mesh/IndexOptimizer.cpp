@@ -0,0 +1,356 @@
+#include "IndexOptimizer.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+const unsigned int NONE = ~0U;
+
+// Forsyth's tuning constants.
+const unsigned int FORSYTH_CACHE_SIZE = 32U;
+const float CACHE_DECAY_POWER = 1.5f;
+const float LAST_TRIANGLE_SCORE = 0.75f;
+const float VALENCE_BOOST_SCALE = 2.f;
+const float VALENCE_BOOST_POWER = 0.5f;
+
+// Cache size used to find cluster boundaries for overdraw ordering.
+const unsigned int CLUSTER_CACHE_SIZE = 16U;
+
+inline const unsigned int* Corners( const std::vector< AIndex >& in_indicies, const size_t in_face ) {
+    return reinterpret_cast<const unsigned int*>( &in_indicies[ in_face ] );
+}
+
+float ComputeVertexScore( const int in_cachePosition, const unsigned int in_liveTriangles ) {
+    if( in_liveTriangles == 0U )
+        return -1.f;
+    float score = 0.f;
+    if( in_cachePosition >= 0 ) {
+        if( in_cachePosition < 3 ) {
+            // The last triangle's vertices get a fixed score so that the
+            // next triangle does not simply reuse the same edge.
+            score = LAST_TRIANGLE_SCORE;
+        }
+        else {
+            const float scale = 1.f / ( FORSYTH_CACHE_SIZE - 3U );
+            score = std::pow( 1.f - ( in_cachePosition - 3 ) * scale, CACHE_DECAY_POWER );
+        }
+    }
+    // Vertices with few triangles left are finished off first.
+    score += VALENCE_BOOST_SCALE * std::pow( (float)in_liveTriangles, -VALENCE_BOOST_POWER );
+    return score;
+}
+
+// Scores for every cache position and small valence, so the inner loop
+// avoids pow().
+const unsigned int SCORE_TABLE_VALENCE = 32U;
+struct ScoreTable {
+    float score[ FORSYTH_CACHE_SIZE + 1U ][ SCORE_TABLE_VALENCE ];
+    ScoreTable( void ) {
+        for( unsigned int position = 0U; position <= FORSYTH_CACHE_SIZE; position += 1U )
+            for( unsigned int valence = 0U; valence < SCORE_TABLE_VALENCE; valence += 1U )
+                score[ position ][ valence ] = ComputeVertexScore(
+                    position == FORSYTH_CACHE_SIZE ? -1 : (int)position, valence );
+    }
+};
+
+float VertexScore( const int in_cachePosition, const unsigned int in_liveTriangles ) {
+    static const ScoreTable table;
+    if( in_liveTriangles >= SCORE_TABLE_VALENCE )
+        return ComputeVertexScore( in_cachePosition, in_liveTriangles );
+    const unsigned int position = in_cachePosition < 0 ? FORSYTH_CACHE_SIZE : (unsigned int)in_cachePosition;
+    return table.score[ position ][ in_liveTriangles ];
+}
+
+// Per-triangle FIFO cache misses.
+void SimulateMisses( const std::vector< AIndex >& in_indicies, const unsigned int in_vertexCount,
+    const unsigned int in_cacheSize, std::vector< unsigned char >* out_misses ) {
+    std::vector< unsigned int > stamps( in_vertexCount, NONE );
+    unsigned int transforms = 0U;
+    out_misses->assign( in_indicies.size(), 0U );
+    for( size_t face = 0U; face < in_indicies.size(); face += 1U ) {
+        const unsigned int* corners = Corners( in_indicies, face );
+        for( unsigned int corner = 0U; corner < 3U; corner += 1U ) {
+            const unsigned int vertex = corners[ corner ];
+            if( stamps[ vertex ] == NONE || transforms - stamps[ vertex ] >= in_cacheSize ) {
+                stamps[ vertex ] = transforms;
+                transforms += 1U;
+                ( *out_misses )[ face ] += 1U;
+            }
+        }
+    }
+}
+
+// Every corner compared on its own: a largest index plus one wraps to 0
+// for ~0U.
+bool IndiciesInRange( const std::vector< AIndex >& in_indicies, const size_t in_vertexCount ) {
+    for( size_t face = 0U; face < in_indicies.size(); face += 1U ) {
+        const unsigned int* corners = Corners( in_indicies, face );
+        for( unsigned int corner = 0U; corner < 3U; corner += 1U )
+            if( corners[ corner ] >= in_vertexCount )
+                return false;
+    }
+    return true;
+}
+
+struct Cluster {
+    size_t  begin, end;
+    float   sortKey;
+};
+
+}
+
+VertexCacheStats AnalyzeVertexCache( const std::vector< AIndex >& in_indicies,
+    const unsigned int in_vertexCount, const unsigned int in_cacheSize ) {
+    std::vector< unsigned int > stamps( in_vertexCount, NONE );
+    unsigned int transforms = 0U, referenced = 0U;
+    for( size_t face = 0U; face < in_indicies.size(); face += 1U ) {
+        const unsigned int* corners = Corners( in_indicies, face );
+        for( unsigned int corner = 0U; corner < 3U; corner += 1U ) {
+            const unsigned int vertex = corners[ corner ];
+            if( stamps[ vertex ] == NONE )
+                referenced += 1U;
+            if( stamps[ vertex ] == NONE || transforms - stamps[ vertex ] >= in_cacheSize ) {
+                stamps[ vertex ] = transforms;
+                transforms += 1U;
+            }
+        }
+    }
+    VertexCacheStats stats;
+    stats.transforms = transforms;
+    stats.acmr = in_indicies.empty() ? 0.f : (float)transforms / in_indicies.size();
+    stats.atvr = referenced == 0U ? 0.f : (float)transforms / referenced;
+    return stats;
+}
+
+void OptimizeVertexCache( std::vector< AIndex >* io_indicies, const unsigned int in_vertexCount ) {
+    const std::vector< AIndex >& input = *io_indicies;
+    const size_t faceCount = input.size();
+    if( faceCount == 0U )
+        return;
+
+    // Vertex to triangle adjacency. live[ v ] counts the triangles of v that
+    // are not emitted yet; they are kept at the front of v's list.
+    std::vector< unsigned int > live( in_vertexCount, 0U ), offsets( in_vertexCount + 1U, 0U );
+    for( size_t face = 0U; face < faceCount; face += 1U ) {
+        const unsigned int* corners = Corners( input, face );
+        for( unsigned int corner = 0U; corner < 3U; corner += 1U )
+            live[ corners[ corner ] ] += 1U;
+    }
+    for( unsigned int vertex = 0U; vertex < in_vertexCount; vertex += 1U )
+        offsets[ vertex + 1U ] = offsets[ vertex ] + live[ vertex ];
+    std::vector< unsigned int > adjacency( offsets[ in_vertexCount ] ), fill( offsets.begin(), offsets.end() - 1 );
+    for( size_t face = 0U; face < faceCount; face += 1U ) {
+        const unsigned int* corners = Corners( input, face );
+        for( unsigned int corner = 0U; corner < 3U; corner += 1U )
+            adjacency[ fill[ corners[ corner ] ]++ ] = (unsigned int)face;
+    }
+
+    std::vector< int > cachePosition( in_vertexCount, -1 );
+    std::vector< float > vertexScore( in_vertexCount );
+    for( unsigned int vertex = 0U; vertex < in_vertexCount; vertex += 1U )
+        vertexScore[ vertex ] = VertexScore( -1, live[ vertex ] );
+    std::vector< float > faceScore( faceCount );
+    std::vector< bool > emitted( faceCount, false );
+    size_t best = 0U;
+    for( size_t face = 0U; face < faceCount; face += 1U ) {
+        const unsigned int* corners = Corners( input, face );
+        faceScore[ face ] = vertexScore[ corners[ 0 ] ] + vertexScore[ corners[ 1 ] ] + vertexScore[ corners[ 2 ] ];
+        if( faceScore[ face ] > faceScore[ best ] )
+            best = face;
+    }
+
+    std::vector< unsigned int > cache, nextCache;
+    cache.reserve( FORSYTH_CACHE_SIZE + 3U );
+    nextCache.reserve( FORSYTH_CACHE_SIZE + 3U );
+    std::vector< AIndex > result;
+    result.reserve( faceCount );
+    size_t cursor = 0U;
+    for( size_t step = 0U; step < faceCount; step += 1U ) {
+        if( best == NONE ) {
+            // Dead end: no triangle touches the cache, continue in input order.
+            while( emitted[ cursor ] )
+                cursor += 1U;
+            best = cursor;
+        }
+        result.push_back( input[ best ] );
+        emitted[ best ] = true;
+
+        const unsigned int* corners = Corners( input, best );
+        nextCache.clear();
+        for( unsigned int corner = 0U; corner < 3U; corner += 1U ) {
+            const unsigned int vertex = corners[ corner ];
+            unsigned int* list = &adjacency[ offsets[ vertex ] ];
+            unsigned int* found = std::find( list, list + live[ vertex ], (unsigned int)best );
+            if( found != list + live[ vertex ] ) {
+                std::swap( *found, list[ live[ vertex ] - 1U ] );
+                live[ vertex ] -= 1U;
+            }
+            if( std::find( nextCache.begin(), nextCache.end(), vertex ) == nextCache.end() )
+                nextCache.push_back( vertex );
+        }
+        for( size_t entry = 0U; entry < cache.size(); entry += 1U ) {
+            if( std::find( corners, corners + 3, cache[ entry ] ) == corners + 3 )
+                nextCache.push_back( cache[ entry ] );
+        }
+
+        for( size_t entry = 0U; entry < nextCache.size(); entry += 1U ) {
+            const unsigned int vertex = nextCache[ entry ];
+            cachePosition[ vertex ] = entry < FORSYTH_CACHE_SIZE ? (int)entry : -1;
+            vertexScore[ vertex ] = VertexScore( cachePosition[ vertex ], live[ vertex ] );
+        }
+
+        // Only triangles around the cache changed score.
+        best = NONE;
+        float bestScore = -1.f;
+        for( size_t entry = 0U; entry < nextCache.size(); entry += 1U ) {
+            const unsigned int vertex = nextCache[ entry ];
+            for( unsigned int it = offsets[ vertex ]; it < offsets[ vertex ] + live[ vertex ]; it += 1U ) {
+                const unsigned int face = adjacency[ it ];
+                const unsigned int* around = Corners( input, face );
+                faceScore[ face ] = vertexScore[ around[ 0 ] ] + vertexScore[ around[ 1 ] ] + vertexScore[ around[ 2 ] ];
+                if( faceScore[ face ] > bestScore ) {
+                    bestScore = faceScore[ face ];
+                    best = face;
+                }
+            }
+        }
+
+        if( nextCache.size() > FORSYTH_CACHE_SIZE )
+            nextCache.resize( FORSYTH_CACHE_SIZE );
+        cache.swap( nextCache );
+    }
+    io_indicies->swap( result );
+}
+
+void OptimizeOverdraw( std::vector< AIndex >* io_indicies, const std::vector< AVertex >& in_verticies,
+    const float in_threshold ) {
+    const std::vector< AIndex >& input = *io_indicies;
+    const size_t faceCount = input.size();
+    if( faceCount < 2U )
+        return;
+    if( IndiciesInRange( input, in_verticies.size() ) == false )
+        return;
+    const unsigned int vertexCount = (unsigned int)in_verticies.size();
+
+    // A triangle whose three vertices all miss starts a new cluster.
+    std::vector< unsigned char > misses;
+    SimulateMisses( input, vertexCount, CLUSTER_CACHE_SIZE, &misses );
+    std::vector< Cluster > clusters;
+    for( size_t face = 0U; face < faceCount; face += 1U ) {
+        if( face == 0U || misses[ face ] == 3U ) {
+            if( clusters.empty() == false )
+                clusters.back().end = face;
+            Cluster cluster = { face, faceCount, 0.f };
+            clusters.push_back( cluster );
+        }
+    }
+    if( clusters.size() < 2U )
+        return;
+
+    // Area-weighted centroid and normal of every cluster and of the mesh.
+    std::vector< float > centroids( clusters.size() * 3U, 0.f ), normals( clusters.size() * 3U, 0.f );
+    float mesh[ 3 ] = { 0.f, 0.f, 0.f }, meshArea = 0.f;
+    for( size_t index = 0U; index < clusters.size(); index += 1U ) {
+        float area = 0.f;
+        float* centroid = &centroids[ index * 3U ];
+        float* normal = &normals[ index * 3U ];
+        for( size_t face = clusters[ index ].begin; face < clusters[ index ].end; face += 1U ) {
+            const unsigned int* corners = Corners( input, face );
+            const AVertex& a = in_verticies[ corners[ 0 ] ];
+            const AVertex& b = in_verticies[ corners[ 1 ] ];
+            const AVertex& c = in_verticies[ corners[ 2 ] ];
+            const float e1[ 3 ] = { b.x - a.x, b.y - a.y, b.z - a.z };
+            const float e2[ 3 ] = { c.x - a.x, c.y - a.y, c.z - a.z };
+            const float cross[ 3 ] = {
+                e1[ 1 ] * e2[ 2 ] - e1[ 2 ] * e2[ 1 ],
+                e1[ 2 ] * e2[ 0 ] - e1[ 0 ] * e2[ 2 ],
+                e1[ 0 ] * e2[ 1 ] - e1[ 1 ] * e2[ 0 ] };
+            const float weight = std::sqrt( cross[ 0 ] * cross[ 0 ] + cross[ 1 ] * cross[ 1 ] + cross[ 2 ] * cross[ 2 ] );
+            centroid[ 0 ] += ( a.x + b.x + c.x ) / 3.f * weight;
+            centroid[ 1 ] += ( a.y + b.y + c.y ) / 3.f * weight;
+            centroid[ 2 ] += ( a.z + b.z + c.z ) / 3.f * weight;
+            normal[ 0 ] += cross[ 0 ];
+            normal[ 1 ] += cross[ 1 ];
+            normal[ 2 ] += cross[ 2 ];
+            area += weight;
+        }
+        for( unsigned int axis = 0U; axis < 3U; axis += 1U ) {
+            mesh[ axis ] += centroid[ axis ];
+            if( area > 0.f )
+                centroid[ axis ] /= area;
+        }
+        meshArea += area;
+        const float length = std::sqrt( normal[ 0 ] * normal[ 0 ] + normal[ 1 ] * normal[ 1 ] + normal[ 2 ] * normal[ 2 ] );
+        if( length > 0.f ) {
+            normal[ 0 ] /= length;
+            normal[ 1 ] /= length;
+            normal[ 2 ] /= length;
+        }
+    }
+    if( meshArea > 0.f ) {
+        mesh[ 0 ] /= meshArea;
+        mesh[ 1 ] /= meshArea;
+        mesh[ 2 ] /= meshArea;
+    }
+
+    // Clusters that face outward occlude the rest, so draw them first.
+    for( size_t index = 0U; index < clusters.size(); index += 1U ) {
+        const float* centroid = &centroids[ index * 3U ];
+        const float* normal = &normals[ index * 3U ];
+        clusters[ index ].sortKey =
+            ( centroid[ 0 ] - mesh[ 0 ] ) * normal[ 0 ]
+            + ( centroid[ 1 ] - mesh[ 1 ] ) * normal[ 1 ]
+            + ( centroid[ 2 ] - mesh[ 2 ] ) * normal[ 2 ];
+    }
+    std::stable_sort( clusters.begin(), clusters.end(), []( const Cluster& a, const Cluster& b ) {
+        return a.sortKey > b.sortKey;
+    } );
+
+    std::vector< AIndex > result;
+    result.reserve( faceCount );
+    for( size_t index = 0U; index < clusters.size(); index += 1U )
+        result.insert( result.end(), input.begin() + clusters[ index ].begin, input.begin() + clusters[ index ].end );
+
+    const float before = AnalyzeVertexCache( input, vertexCount, CLUSTER_CACHE_SIZE ).acmr;
+    const float after = AnalyzeVertexCache( result, vertexCount, CLUSTER_CACHE_SIZE ).acmr;
+    if( after <= before * in_threshold )
+        io_indicies->swap( result );
+}
+
+unsigned int OptimizeVertexFetch( std::vector< AIndex >* io_indicies, const unsigned int in_vertexCount,
+    std::vector< unsigned int >* out_remap ) {
+    out_remap->assign( in_vertexCount, NONE );
+    unsigned int next = 0U;
+    for( size_t face = 0U; face < io_indicies->size(); face += 1U ) {
+        unsigned int* corners = reinterpret_cast<unsigned int*>( &( *io_indicies )[ face ] );
+        for( unsigned int corner = 0U; corner < 3U; corner += 1U ) {
+            unsigned int& remapped = ( *out_remap )[ corners[ corner ] ];
+            if( remapped == NONE )
+                remapped = next++;
+            corners[ corner ] = remapped;
+        }
+    }
+    return next;
+}
+
+bool OptimizeMesh( std::vector< AVertex >* io_verticies, std::vector< AColor >* io_colors,
+    std::vector< AIndex >* io_indicies ) {
+    const unsigned int vertexCount = (unsigned int)io_verticies->size();
+    if( IndiciesInRange( *io_indicies, vertexCount ) == false
+        || ( io_colors != NULL && io_colors->size() != vertexCount ) )
+        return false;
+    // Meshes exported in a good order can lose to Forsyth's greedy walk, so
+    // keep the order that simulates fewer misses, as OptimizeOverdraw does.
+    std::vector< AIndex > cacheOrder( *io_indicies );
+    OptimizeVertexCache( &cacheOrder, vertexCount );
+    if( AnalyzeVertexCache( cacheOrder, vertexCount ).acmr < AnalyzeVertexCache( *io_indicies, vertexCount ).acmr )
+        io_indicies->swap( cacheOrder );
+    OptimizeOverdraw( io_indicies, *io_verticies );
+    std::vector< unsigned int > remap;
+    const unsigned int newCount = OptimizeVertexFetch( io_indicies, vertexCount, &remap );
+    RemapVertices( remap, newCount, io_verticies );
+    if( io_colors != NULL )
+        RemapVertices( remap, newCount, io_colors );
+    return true;
+}
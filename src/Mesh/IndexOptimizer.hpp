@@ -0,0 +1,63 @@
+#ifndef __INDEX_OPTIMIZER__
+#define __INDEX_OPTIMIZER__
+
+#include <stddef.h>
+#include <vector>
+
+#include "MeshBuffer.hpp"
+
+/*
+Index buffer optimization for the GPU post-transform vertex cache.
+All passes run on the CPU over zero-based AIndex triangles.
+*/
+
+struct VertexCacheStats {
+    float           acmr;           // Average cache miss ratio: transforms per triangle.
+    float           atvr;           // Average transform to vertex ratio: 1.0 is optimal.
+    unsigned int    transforms;     // Simulated vertex shader invocations.
+};
+
+// Simulate a FIFO post-transform cache of in_cacheSize entries.
+VertexCacheStats AnalyzeVertexCache( const std::vector< AIndex >& in_indicies,
+    const unsigned int in_vertexCount, const unsigned int in_cacheSize = 16U );
+
+// Reorder triangles with Forsyth's linear-speed vertex cache optimization.
+void OptimizeVertexCache( std::vector< AIndex >* io_indicies, const unsigned int in_vertexCount );
+
+/*
+Reorder clusters of a cache-optimized index buffer so that triangles facing
+away from the mesh centre are drawn first, which reduces overdraw.
+Clusters break where the simulated cache restarts; the new order is kept only
+if its ACMR is within in_threshold times the input ACMR.
+*/
+void OptimizeOverdraw( std::vector< AIndex >* io_indicies, const std::vector< AVertex >& in_verticies,
+    const float in_threshold = 1.05f );
+
+/*
+Renumber vertices in first-use order so vertex fetch walks memory linearly.
+out_remap[ old ] is the new index, or ~0U for an unreferenced vertex that is
+dropped. The index buffer is rewritten; return the new vertex count.
+Apply the same remap to every attribute array with RemapVertices().
+*/
+unsigned int OptimizeVertexFetch( std::vector< AIndex >* io_indicies, const unsigned int in_vertexCount,
+    std::vector< unsigned int >* out_remap );
+
+template< typename T >
+void RemapVertices( const std::vector< unsigned int >& in_remap, const unsigned int in_newCount,
+    std::vector< T >* io_verticies ) {
+    std::vector< T > result( in_newCount );
+    for( size_t index = 0U; index < in_remap.size() && index < io_verticies->size(); index += 1U ) {
+        if( in_remap[ index ] != ~0U )
+            result[ in_remap[ index ] ] = ( *io_verticies )[ index ];
+    }
+    io_verticies->swap( result );
+}
+
+// Run the cache, overdraw and fetch passes over a converted mesh. The cache
+// pass is kept only if it lowers the ACMR of a 16 entry FIFO. io_colors may
+// be NULL when colors are derived from the final positions.
+// Return false, leaving the arrays untouched, if an index is out of range.
+bool OptimizeMesh( std::vector< AVertex >* io_verticies, std::vector< AColor >* io_colors,
+    std::vector< AIndex >* io_indicies );
+
+#endif
@@ -0,0 +1,54 @@
+#include "MappedFile.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+bool App::MappedFile::open( const char* in_fileName ) {
+    close();
+
+    int fd = ::open( in_fileName, O_RDONLY );
+    if( fd < 0 )
+        return false;
+
+    struct stat info;
+    if( fstat( fd, &info ) != 0 ) {
+        ::close( fd );
+        return false;
+    }
+
+    // mmap() rejects zero-length mappings; an empty file is still a file.
+    if( info.st_size > 0 ) {
+        void* addr = mmap( NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+        if( addr == MAP_FAILED ) {
+            ::close( fd );
+            return false;
+        }
+        madvise( addr, (size_t)info.st_size, MADV_SEQUENTIAL );
+        _data = static_cast<const char*>( addr );
+        _size = (size_t)info.st_size;
+    }
+    // The mapping stays valid after the descriptor is closed.
+    ::close( fd );
+    _opened = true;
+    return true;
+}
+
+void App::MappedFile::close( void ) {
+    if( _data != NULL )
+        munmap( const_cast<char*>( _data ), _size );
+    _data = NULL;
+    _size = 0U;
+    _opened = false;
+}
+
+bool App::MappedFile::isOpen( void ) const {
+    return _opened;
+}
+const char* App::MappedFile::data( void ) const {
+    return _data;
+}
+size_t App::MappedFile::size( void ) const {
+    return _size;
+}
@@ -0,0 +1,41 @@
+#ifndef __MAPPED_FILE__
+#define __MAPPED_FILE__
+
+#include <stddef.h>
+
+namespace App {
+
+/*
+Read-only memory mapping of a whole file.
+The mapping lives as long as the object; data() is NOT null-terminated.
+*/
+class MappedFile {
+public:
+    MappedFile( void ) : _data( NULL ), _size( 0U ), _opened( false ) {}
+    explicit MappedFile( const char* in_fileName ) : MappedFile() {
+        open( in_fileName );
+    }
+    ~MappedFile( void ) {
+        close();
+    }
+
+    bool open( const char* in_fileName );
+    void close( void );
+
+    bool isOpen( void ) const;
+    const char* data( void ) const;
+    size_t size( void ) const;
+
+private:
+    MappedFile( const MappedFile& );
+    MappedFile& operator=( const MappedFile& );
+
+private:
+    const char*     _data;
+    size_t          _size;
+    bool            _opened;
+};
+
+}
+
+#endif
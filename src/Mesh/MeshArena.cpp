@@ -0,0 +1,29 @@
+#include "MeshArena.hpp"
+
+#include <new>
+
+bool App::MeshArena::reserve( const size_t in_bytes ) {
+    release();
+    if( in_bytes == 0U )
+        return true;
+    _data = static_cast< char* >( ::operator new( in_bytes, std::nothrow ) );
+    if( _data == NULL )
+        return false;
+    _capacity = in_bytes;
+    return true;
+}
+
+void App::MeshArena::release( void ) {
+    ::operator delete( _data );
+    _data = NULL;
+    _capacity = 0U;
+    _used = 0U;
+}
+
+size_t App::MeshArena::capacity( void ) const {
+    return _capacity;
+}
+
+size_t App::MeshArena::used( void ) const {
+    return _used;
+}
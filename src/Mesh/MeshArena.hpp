@@ -0,0 +1,68 @@
+#ifndef __MESH_ARENA__
+#define __MESH_ARENA__
+
+#include <stddef.h>
+
+namespace App {
+
+/*
+One heap block holding every array of a mesh.
+The arrays are sized up front, carved off the block in order and freed
+together by release(), so a mesh costs one allocation however many
+attributes it has, and nothing is over-allocated.
+
+    arena.reserve( MeshArena::bytes< AVertex >( vertexCount )
+        + MeshArena::bytes< AIndex >( faceCount ) );
+    AVertex* verticies = arena.allocate< AVertex >( vertexCount );
+    AIndex* indicies = arena.allocate< AIndex >( faceCount );
+    ...
+    arena.release();                        // every array at once
+*/
+class MeshArena {
+public:
+    MeshArena( void ) : _data( NULL ), _capacity( 0U ), _used( 0U ) {}
+    ~MeshArena( void ) {
+        release();
+    }
+
+    // Drop every array and hold in_bytes instead. Returns false when the
+    // block cannot be allocated.
+    bool reserve( const size_t in_bytes );
+    void release( void );
+
+    // in_count elements of T, or NULL when the block has no room left.
+    template< typename T >
+    T* allocate( const size_t in_count ) {
+        const size_t size = bytes< T >( in_count );
+        if( size > _capacity - _used )
+            return NULL;
+        T* array = reinterpret_cast< T* >( _data + _used );
+        _used += size;
+        return array;
+    }
+
+    // Room allocate< T >( in_count ) takes, alignment padding included.
+    template< typename T >
+    static size_t bytes( const size_t in_count ) {
+        return ( sizeof(T) * in_count + ALIGNMENT - 1U ) & ~( ALIGNMENT - 1U );
+    }
+
+    size_t capacity( void ) const;
+    size_t used( void ) const;
+
+    // Arrays are padded to this, so each is as aligned as the block.
+    static const size_t ALIGNMENT = 16U;
+
+private:
+    MeshArena( const MeshArena& );
+    MeshArena& operator=( const MeshArena& );
+
+private:
+    char*   _data;
+    size_t  _capacity;
+    size_t  _used;
+};
+
+}
+
+#endif
@@ -0,0 +1,213 @@
+#include "MeshBuffer.hpp"
+#include "MeshCache.hpp"
+#include "ObjParser.hpp"
+#include "IndexOptimizer.hpp"
+#include "MeshSimplifier.hpp"
+
+#include <cmath>
+#include <algorithm>
+
+bool ConvertMesh( const Mesh& in_mesh, std::vector< AVertex >* out_verticies,
+    std::vector< AColor >* out_colors, std::vector< AIndex >* out_indicies ) {
+    out_verticies->resize( in_mesh.v.size() );
+    for( size_t index = 0U; index < in_mesh.v.size(); index += 1U ) {
+        const Vector3f& position = in_mesh.v[ index ];
+        ( *out_verticies )[ index ].x = position.x;
+        ( *out_verticies )[ index ].y = position.y;
+        ( *out_verticies )[ index ].z = position.z;
+    }
+    if( out_colors != NULL ) {
+        out_colors->resize( in_mesh.v.size() );
+        if( out_colors->empty() == false )
+            ColorVerticies( &( *out_verticies )[ 0 ], out_verticies->size(), &( *out_colors )[ 0 ] );
+    }
+    // OBJ indices are 1-based; 0 is a missing corner.
+    const size_t vertexCount = in_mesh.v.size();
+    out_indicies->resize( in_mesh.f.size() );
+    for( size_t index = 0U; index < in_mesh.f.size(); index += 1U ) {
+        const Vertex* corners = in_mesh.f[ index ].verticies;
+        if( corners[ 0 ].v - 1U >= vertexCount || corners[ 1 ].v - 1U >= vertexCount
+            || corners[ 2 ].v - 1U >= vertexCount )
+            return false;
+        ( *out_indicies )[ index ].a = corners[ 0 ].v - 1;
+        ( *out_indicies )[ index ].b = corners[ 1 ].v - 1;
+        ( *out_indicies )[ index ].c = corners[ 2 ].v - 1;
+    }
+    return true;
+}
+
+void ColorVerticies( const AVertex* in_verticies, const size_t in_count, AColor* out_colors ) {
+    for( size_t index = 0U; index < in_count; index += 1U ) {
+        out_colors[ index ].r = std::abs( in_verticies[ index ].x ) / 50.f;
+        out_colors[ index ].g = std::abs( in_verticies[ index ].y ) / 50.f;
+        out_colors[ index ].b = ( std::abs( in_verticies[ index ].z ) - 100.f ) / 50.f;
+        out_colors[ index ].a = 1.f;
+    }
+}
+
+void MeasureVolume( const AVertex* in_verticies, const unsigned int in_count, MeshVolume* out_volume ) {
+    for( unsigned int axis = 0U; axis < 3U; axis += 1U ) {
+        out_volume->min[ axis ] = in_count > 0U ? ( &in_verticies[ 0 ].x )[ axis ] : 0.f;
+        out_volume->max[ axis ] = out_volume->min[ axis ];
+    }
+    for( unsigned int index = 1U; index < in_count; index += 1U ) {
+        const float* position = &in_verticies[ index ].x;
+        for( unsigned int axis = 0U; axis < 3U; axis += 1U ) {
+            out_volume->min[ axis ] = std::min( out_volume->min[ axis ], position[ axis ] );
+            out_volume->max[ axis ] = std::max( out_volume->max[ axis ], position[ axis ] );
+        }
+    }
+    // Centered on the box, the sphere through the farthest vertex is
+    // tighter than the one through the box corners.
+    float farthest = 0.f;
+    for( unsigned int axis = 0U; axis < 3U; axis += 1U )
+        out_volume->center[ axis ] = ( out_volume->min[ axis ] + out_volume->max[ axis ] ) * 0.5f;
+    for( unsigned int index = 0U; index < in_count; index += 1U ) {
+        const float x = in_verticies[ index ].x - out_volume->center[ 0 ],
+            y = in_verticies[ index ].y - out_volume->center[ 1 ],
+            z = in_verticies[ index ].z - out_volume->center[ 2 ];
+        farthest = std::max( farthest, x * x + y * y + z * z );
+    }
+    out_volume->radius = std::sqrt( farthest );
+}
+
+bool App::MeshBuffer::load( const char* in_fileName, const bool in_useCache ) {
+    release();
+
+    if( in_useCache == true ) {
+        MeshCacheView view;
+        if( MapMeshCache( in_fileName, &_cache, &view ) == MeshCacheValid ) {
+            _verticies = view.verticies;
+            _colors = view.colors;
+            _indicies = view.indicies;
+            _lods = view.lods;
+            _vertexCount = view.vertexCount;
+            _faceCount = view.faceCount;
+            _lodCount = view.lodCount;
+            MeasureVolume( _verticies, _vertexCount, &_volume );
+            _cached = true;
+            return true;
+        }
+        _cache.close();
+    }
+
+    MeshSourceStamp source;
+    {
+        // Only positions and indices are worked on; the colors follow from
+        // the final positions, straight into the arena.
+        std::vector< AVertex > verticies;
+        std::vector< AIndex > indicies;
+        std::vector< std::vector< AIndex > > levels;
+        std::vector< MeshLod > lods;
+        {
+            // The OBJ records and the mapping are dropped before the
+            // optimizer allocates. The cache is stamped with the bytes
+            // parsed here, not with the file as it is once written.
+            App::MappedFile file;
+            if( StatMeshSource( in_fileName, &source ) == false || file.open( in_fileName ) == false )
+                return false;
+            if( in_useCache == true )
+                source.hash = Checksum64( file.data(), file.size() );
+            Mesh mesh;
+            ParseMesh( file.data(), file.data() + file.size(), &mesh );
+            if( FacesInRange( mesh ) == false || ConvertMesh( mesh, &verticies, NULL, &indicies ) == false )
+                return false;
+        }
+        // Reorder for the post-transform cache and build the LOD chain once;
+        // the cache stores the result.
+        if( OptimizeMesh( &verticies, NULL, &indicies ) == false )
+            return false;
+        BuildLodLevels( verticies, indicies, DEFAULT_LOD_RATIOS, DEFAULT_LOD_COUNT, &levels, &lods );
+        if( store( &verticies, &indicies, &levels, lods ) == false )
+            return false;
+    }
+    MeasureVolume( _verticies, _vertexCount, &_volume );
+
+    if( in_useCache == true ) {
+        MeshCacheView view = { _verticies, _colors, _indicies, _lods, _vertexCount, _faceCount, _lodCount };
+        WriteMeshCache( in_fileName, source, view );
+    }
+    return true;
+}
+
+void App::MeshBuffer::release( void ) {
+    _cache.close();
+    _arena.release();
+    _verticies = NULL;
+    _colors = NULL;
+    _indicies = NULL;
+    _lods = NULL;
+    _vertexCount = 0U;
+    _faceCount = 0U;
+    _lodCount = 0U;
+    MeasureVolume( NULL, 0U, &_volume );
+    _cached = false;
+}
+
+// Move the finished arrays into one block of exactly their size, freeing
+// each working array once copied, and color the vertices in place. Level 0
+// is io_indicies, the other levels follow it. Return false, storing
+// nothing, when the block cannot be allocated.
+bool App::MeshBuffer::store( std::vector< AVertex >* io_verticies, std::vector< AIndex >* io_indicies,
+    std::vector< std::vector< AIndex > >* io_levels, const std::vector< MeshLod >& in_lods ) {
+    const size_t vertexCount = io_verticies->size();
+    size_t faceCount = io_indicies->size();
+    for( size_t level = 0U; level < io_levels->size(); level += 1U )
+        faceCount += ( *io_levels )[ level ].size();
+    if( _arena.reserve( MeshArena::bytes< AVertex >( vertexCount ) + MeshArena::bytes< AColor >( vertexCount )
+        + MeshArena::bytes< AIndex >( faceCount ) + MeshArena::bytes< MeshLod >( in_lods.size() ) ) == false )
+        return false;
+    AVertex* verticies = _arena.allocate< AVertex >( vertexCount );
+    AColor* colors = _arena.allocate< AColor >( vertexCount );
+    AIndex* indicies = _arena.allocate< AIndex >( faceCount );
+    MeshLod* lods = _arena.allocate< MeshLod >( in_lods.size() );
+    std::copy( io_verticies->begin(), io_verticies->end(), verticies );
+    std::vector< AVertex >().swap( *io_verticies );
+    ColorVerticies( verticies, vertexCount, colors );
+    AIndex* level = std::copy( io_indicies->begin(), io_indicies->end(), indicies );
+    std::vector< AIndex >().swap( *io_indicies );
+    for( size_t index = 0U; index < io_levels->size(); index += 1U ) {
+        level = std::copy( ( *io_levels )[ index ].begin(), ( *io_levels )[ index ].end(), level );
+        std::vector< AIndex >().swap( ( *io_levels )[ index ] );
+    }
+    std::copy( in_lods.begin(), in_lods.end(), lods );
+    _vertexCount = (unsigned int)vertexCount;
+    _faceCount = (unsigned int)faceCount;
+    _lodCount = (unsigned int)in_lods.size();
+    _verticies = _vertexCount > 0U ? verticies : NULL;
+    _colors = _vertexCount > 0U ? colors : NULL;
+    _indicies = _faceCount > 0U ? indicies : NULL;
+    _lods = lods;
+    return true;
+}
+
+const AVertex* App::MeshBuffer::verticies( void ) const {
+    return _verticies;
+}
+const AColor* App::MeshBuffer::colors( void ) const {
+    return _colors;
+}
+const AIndex* App::MeshBuffer::indicies( void ) const {
+    return _indicies;
+}
+unsigned int App::MeshBuffer::vertexCount( void ) const {
+    return _vertexCount;
+}
+unsigned int App::MeshBuffer::faceCount( void ) const {
+    return _faceCount;
+}
+const MeshLod* App::MeshBuffer::lods( void ) const {
+    return _lods;
+}
+unsigned int App::MeshBuffer::lodCount( void ) const {
+    return _lodCount;
+}
+const MeshVolume& App::MeshBuffer::volume( void ) const {
+    return _volume;
+}
+bool App::MeshBuffer::cached( void ) const {
+    return _cached;
+}
+size_t App::MeshBuffer::ownedBytes( void ) const {
+    return _arena.capacity();
+}
@@ -0,0 +1,112 @@
+#ifndef __MESH_BUFFER__
+#define __MESH_BUFFER__
+
+#include <vector>
+
+#include "util.h"
+#include "MappedFile.hpp"
+#include "MeshArena.hpp"
+
+// GPU-ready layouts consumed by glBufferData.
+struct AVertex {
+    float x, y, z;
+};
+struct AColor {
+    float r, g, b, a;
+};
+struct AIndex {
+    unsigned int a, b, c;
+};
+
+// One level of detail inside a concatenated index buffer.
+struct MeshLod {
+    unsigned int    firstFace;
+    unsigned int    faceCount;
+    float           error;          // Geometric error in object units.
+};
+
+// Object-space bounds of a mesh's vertices.
+struct MeshVolume {
+    float           min[ 3 ];
+    float           max[ 3 ];
+    float           center[ 3 ];    // Box center, also the sphere center.
+    float           radius;         // Distance to the farthest vertex.
+};
+
+// Measure the box and sphere of in_count vertices; all zero when empty.
+void MeasureVolume( const AVertex* in_verticies, const unsigned int in_count, MeshVolume* out_volume );
+
+// Convert struct Mesh to AVertex, AColor and zero-based AIndex arrays.
+// out_colors may be NULL; ColorVerticies() gives the same colors later.
+// Return false if a face corner is 0, missing, or past the last vertex; the
+// arrays are then incomplete.
+bool ConvertMesh( const Mesh& in_mesh, std::vector< AVertex >* out_verticies,
+    std::vector< AColor >* out_colors, std::vector< AIndex >* out_indicies );
+// The color of every vertex, which follows from its position.
+void ColorVerticies( const AVertex* in_verticies, const size_t in_count, AColor* out_colors );
+
+namespace App {
+
+/*
+Vertex, color and index arrays of a mesh, ready to hand to glBufferData.
+The arrays either point into a memory-mapped binary cache (see MeshCache.hpp)
+or, after a text parse, into one MeshArena block sized exactly for them.
+Nothing else of the parse is kept. Call release() as soon as the GPU and
+physics hold what they need; the streamer does so once the mesh is packed,
+so a PhysicsMesh, which points at these arrays, needs a MeshBuffer loaded
+and kept outside the streamer.
+*/
+class MeshBuffer {
+public:
+    MeshBuffer( void ) : _verticies( NULL ), _colors( NULL ), _indicies( NULL ),
+        _lods( NULL ), _vertexCount( 0U ), _faceCount( 0U ), _lodCount( 0U ), _cached( false ) {
+        MeasureVolume( NULL, 0U, &_volume );
+    }
+
+    // Load in_fileName from its binary cache. On a miss or a stale cache parse
+    // the OBJ text, optimize it for the vertex cache, build its LOD chain and
+    // regenerate the cache when in_useCache is set. Bounds are measured
+    // either way. Return false, writing no cache, if the file cannot be read
+    // or a face references a missing vertex.
+    bool load( const char* in_fileName, const bool in_useCache = true );
+    void release( void );
+
+    const AVertex* verticies( void ) const;
+    const AColor* colors( void ) const;
+    const AIndex* indicies( void ) const;
+    unsigned int vertexCount( void ) const;
+    // Triangles of every LOD; indicies() holds the levels back to back.
+    unsigned int faceCount( void ) const;
+    // Level 0 is the full mesh.
+    const MeshLod* lods( void ) const;
+    unsigned int lodCount( void ) const;
+    const MeshVolume& volume( void ) const;
+    bool cached( void ) const;
+    // Heap bytes held for the arrays; 0 when they are mapped.
+    size_t ownedBytes( void ) const;
+
+private:
+    MeshBuffer( const MeshBuffer& );
+    MeshBuffer& operator=( const MeshBuffer& );
+
+private:
+    bool store( std::vector< AVertex >* io_verticies, std::vector< AIndex >* io_indicies,
+        std::vector< std::vector< AIndex > >* io_levels, const std::vector< MeshLod >& in_lods );
+
+private:
+    MappedFile              _cache;
+    MeshArena               _arena;
+    const AVertex*          _verticies;
+    const AColor*           _colors;
+    const AIndex*           _indicies;
+    const MeshLod*          _lods;
+    unsigned int            _vertexCount;
+    unsigned int            _faceCount;
+    unsigned int            _lodCount;
+    MeshVolume              _volume;
+    bool                    _cached;
+};
+
+}
+
+#endif
@@ -0,0 +1,186 @@
+#include "MeshCache.hpp"
+
+#include <string.h>
+#include <stdio.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <fstream>
+
+namespace {
+
+uint64_t Align( const uint64_t in_offset ) {
+    return ( in_offset + MESH_CACHE_ALIGNMENT - 1U ) & ~( MESH_CACHE_ALIGNMENT - 1U );
+}
+
+bool StatSource( const char* in_sourceName, uint64_t* out_size, int64_t* out_mtime ) {
+    struct stat info;
+    if( stat( in_sourceName, &info ) != 0 )
+        return false;
+    *out_size = (uint64_t)info.st_size;
+    // Nanoseconds, so that two edits within one second are told apart.
+#if defined( __APPLE__ )
+    *out_mtime = (int64_t)info.st_mtimespec.tv_sec * 1000000000LL + info.st_mtimespec.tv_nsec;
+#else
+    *out_mtime = (int64_t)info.st_mtim.tv_sec * 1000000000LL + info.st_mtim.tv_nsec;
+#endif
+    return true;
+}
+
+bool HashSource( const char* in_sourceName, uint64_t* out_hash ) {
+    App::MappedFile source;
+    if( source.open( in_sourceName ) == false )
+        return false;
+    *out_hash = Checksum64( source.data(), source.size() );
+    return true;
+}
+
+// Rewrite only the source stamp of an otherwise valid cache.
+void TouchHeader( const std::string& in_cacheName, const MeshCacheHeader& in_header ) {
+    int fd = open( in_cacheName.c_str(), O_WRONLY );
+    if( fd < 0 )
+        return;
+    ssize_t written = pwrite( fd, &in_header, sizeof( MeshCacheHeader ), 0 );
+    (void)written;
+    close( fd );
+}
+
+}
+
+uint64_t Checksum64( const void* in_data, const size_t in_size ) {
+    const uint64_t prime = 0x100000001b3ULL;
+    const unsigned char* bytes = static_cast<const unsigned char*>( in_data );
+    uint64_t hash = 0xcbf29ce484222325ULL ^ (uint64_t)in_size;
+    size_t index = 0U;
+    for( ; index + 8U <= in_size; index += 8U ) {
+        uint64_t word;
+        memcpy( &word, bytes + index, 8U );
+        hash = ( hash ^ word ) * prime;
+        hash ^= hash >> 29;
+    }
+    for( ; index < in_size; index += 1U )
+        hash = ( hash ^ bytes[ index ] ) * prime;
+    return hash ^ ( hash >> 32 );
+}
+
+bool StatMeshSource( const char* in_sourceName, MeshSourceStamp* out_stamp ) {
+    out_stamp->hash = 0U;
+    return StatSource( in_sourceName, &out_stamp->size, &out_stamp->mtime );
+}
+
+std::string MeshCachePath( const char* in_sourceName ) {
+    return std::string( in_sourceName ) + ".cache";
+}
+
+MeshCacheStatus MapMeshCache( const char* in_sourceName, App::MappedFile* out_file,
+    MeshCacheView* out_view ) {
+    uint64_t sourceSize;
+    int64_t sourceMtime;
+    if( StatSource( in_sourceName, &sourceSize, &sourceMtime ) == false )
+        return MeshCacheMissing;
+
+    const std::string cacheName = MeshCachePath( in_sourceName );
+    if( out_file->open( cacheName.c_str() ) == false )
+        return MeshCacheMissing;
+
+    const char* data = out_file->data();
+    const uint64_t size = out_file->size();
+    if( size < Align( sizeof( MeshCacheHeader ) ) )
+        return MeshCacheCorrupt;
+
+    MeshCacheHeader header;
+    memcpy( &header, data, sizeof( MeshCacheHeader ) );
+    if( memcmp( header.magic, MESH_CACHE_MAGIC, sizeof( MESH_CACHE_MAGIC ) ) != 0
+        || header.version != MESH_CACHE_VERSION
+        || header.byteOrder != MESH_CACHE_BYTE_ORDER )
+        return MeshCacheCorrupt;
+
+    const uint64_t vertexEnd = (uint64_t)header.vertexOffset + sizeof( AVertex ) * header.vertexCount;
+    const uint64_t colorEnd = (uint64_t)header.colorOffset + sizeof( AColor ) * header.vertexCount;
+    const uint64_t indexEnd = (uint64_t)header.indexOffset + sizeof( AIndex ) * header.faceCount;
+    const uint64_t lodEnd = (uint64_t)header.lodOffset + sizeof( MeshLod ) * header.lodCount;
+    if( header.vertexOffset % MESH_CACHE_ALIGNMENT != 0U
+        || header.colorOffset % MESH_CACHE_ALIGNMENT != 0U
+        || header.indexOffset % MESH_CACHE_ALIGNMENT != 0U
+        || header.lodOffset % MESH_CACHE_ALIGNMENT != 0U
+        || header.vertexOffset < sizeof( MeshCacheHeader )
+        || vertexEnd > size || colorEnd > size || indexEnd > size || lodEnd > size )
+        return MeshCacheCorrupt;
+
+    // Cheap check first; only hash the source when its stamp moved.
+    if( header.sourceSize != sourceSize )
+        return MeshCacheStale;
+    if( header.sourceMtime != sourceMtime ) {
+        uint64_t sourceHash;
+        if( HashSource( in_sourceName, &sourceHash ) == false
+            || sourceHash != header.sourceHash )
+            return MeshCacheStale;
+        header.sourceMtime = sourceMtime;
+        TouchHeader( cacheName, header );
+    }
+
+    const uint64_t payload = Align( sizeof( MeshCacheHeader ) );
+    if( Checksum64( data + payload, size - payload ) != header.checksum )
+        return MeshCacheCorrupt;
+
+    out_view->verticies = reinterpret_cast<const AVertex*>( data + header.vertexOffset );
+    out_view->colors = reinterpret_cast<const AColor*>( data + header.colorOffset );
+    out_view->indicies = reinterpret_cast<const AIndex*>( data + header.indexOffset );
+    out_view->lods = reinterpret_cast<const MeshLod*>( data + header.lodOffset );
+    out_view->vertexCount = header.vertexCount;
+    out_view->faceCount = header.faceCount;
+    out_view->lodCount = header.lodCount;
+    return MeshCacheValid;
+}
+
+bool WriteMeshCache( const char* in_sourceName, const MeshSourceStamp& in_source, const MeshCacheView& in_view ) {
+    MeshCacheHeader header;
+    memset( &header, 0, sizeof( MeshCacheHeader ) );
+    memcpy( header.magic, MESH_CACHE_MAGIC, sizeof( MESH_CACHE_MAGIC ) );
+    header.version = MESH_CACHE_VERSION;
+    header.byteOrder = MESH_CACHE_BYTE_ORDER;
+    header.sourceSize = in_source.size;
+    header.sourceMtime = in_source.mtime;
+    header.sourceHash = in_source.hash;
+    header.vertexCount = in_view.vertexCount;
+    header.faceCount = in_view.faceCount;
+    header.lodCount = in_view.lodCount;
+
+    // Lay out the blocks in one buffer so the checksum covers the padding too.
+    const uint64_t payload = Align( sizeof( MeshCacheHeader ) );
+    const uint64_t vertexOffset = payload;
+    const uint64_t colorOffset = Align( vertexOffset + sizeof( AVertex ) * in_view.vertexCount );
+    const uint64_t indexOffset = Align( colorOffset + sizeof( AColor ) * in_view.vertexCount );
+    const uint64_t lodOffset = Align( indexOffset + sizeof( AIndex ) * in_view.faceCount );
+    const uint64_t total = lodOffset + sizeof( MeshLod ) * in_view.lodCount;
+    if( total > 0xffffffffULL )
+        return false;
+    header.vertexOffset = (uint32_t)vertexOffset;
+    header.colorOffset = (uint32_t)colorOffset;
+    header.indexOffset = (uint32_t)indexOffset;
+    header.lodOffset = (uint32_t)lodOffset;
+
+    std::vector< char > image( total, 0 );
+    if( in_view.vertexCount > 0U ) {
+        memcpy( &image[ vertexOffset ], in_view.verticies, sizeof( AVertex ) * in_view.vertexCount );
+        memcpy( &image[ colorOffset ], in_view.colors, sizeof( AColor ) * in_view.vertexCount );
+    }
+    if( in_view.faceCount > 0U )
+        memcpy( &image[ indexOffset ], in_view.indicies, sizeof( AIndex ) * in_view.faceCount );
+    if( in_view.lodCount > 0U )
+        memcpy( &image[ lodOffset ], in_view.lods, sizeof( MeshLod ) * in_view.lodCount );
+    header.checksum = Checksum64( &image[ payload ], total - payload );
+    memcpy( &image[ 0 ], &header, sizeof( MeshCacheHeader ) );
+
+    const std::string cacheName = MeshCachePath( in_sourceName );
+    const std::string tempName = cacheName + ".tmp";
+    {
+        std::ofstream file( tempName.c_str(), std::ios::binary | std::ios::trunc );
+        file.write( &image[ 0 ], (std::streamsize)total );
+        if( file.good() == false ) {
+            remove( tempName.c_str() );
+            return false;
+        }
+    }
+    return rename( tempName.c_str(), cacheName.c_str() ) == 0;
+}
@@ -0,0 +1,89 @@
+#ifndef __MESH_CACHE__
+#define __MESH_CACHE__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+
+#include "MeshBuffer.hpp"
+#include "MeshSimplifier.hpp"
+#include "MappedFile.hpp"
+
+/*
+Binary mesh cache, written next to the source as "<source>.cache".
+
+    MeshCacheHeader             padded to MESH_CACHE_ALIGNMENT
+    AVertex[ vertexCount ]      aligned to MESH_CACHE_ALIGNMENT
+    AColor[ vertexCount ]       aligned to MESH_CACHE_ALIGNMENT
+    AIndex[ faceCount ]         aligned to MESH_CACHE_ALIGNMENT, every LOD
+    MeshLod[ lodCount ]         aligned to MESH_CACHE_ALIGNMENT
+
+Blocks are stored in native byte order exactly as glBufferData expects them.
+A cache is stale when the source size or mtime changed and its content hash
+no longer matches.
+*/
+
+static const char MESH_CACHE_MAGIC[ 8 ] = { 'M', 'E', 'S', 'H', 'C', 'A', 'C', 'H' };
+static const uint32_t MESH_CACHE_VERSION = 4U;
+static const uint32_t MESH_CACHE_BYTE_ORDER = 0x01020304U;
+static const uint64_t MESH_CACHE_ALIGNMENT = 64U;
+
+struct MeshCacheHeader {
+    char        magic[ 8 ];
+    uint32_t    version;
+    uint32_t    byteOrder;
+    uint64_t    sourceSize;
+    int64_t     sourceMtime;    // Nanoseconds since the epoch.
+    uint64_t    sourceHash;
+    uint32_t    vertexCount;
+    uint32_t    faceCount;
+    uint32_t    vertexOffset;
+    uint32_t    colorOffset;
+    uint32_t    indexOffset;
+    uint32_t    lodCount;
+    uint32_t    lodOffset;
+    uint64_t    checksum;       // Checksum64 over everything after the header.
+};
+
+enum MeshCacheStatus {
+    MeshCacheValid, MeshCacheMissing, MeshCacheStale, MeshCacheCorrupt
+};
+
+// The source a cache was built from: size and mtime as stat() gave them
+// before the source was mapped, and Checksum64 of the mapped bytes.
+struct MeshSourceStamp {
+    uint64_t    size;
+    int64_t     mtime;
+    uint64_t    hash;
+};
+
+struct MeshCacheView {
+    const AVertex*  verticies;
+    const AColor*   colors;
+    const AIndex*   indicies;
+    const MeshLod*  lods;
+    uint32_t        vertexCount;
+    uint32_t        faceCount;
+    uint32_t        lodCount;
+};
+
+// Fast 64-bit non-cryptographic hash, 8 bytes per step.
+uint64_t Checksum64( const void* in_data, const size_t in_size );
+
+std::string MeshCachePath( const char* in_sourceName );
+
+// Map the cache of in_sourceName into out_file and validate it against the
+// source. out_view points into out_file when MeshCacheValid is returned.
+MeshCacheStatus MapMeshCache( const char* in_sourceName, App::MappedFile* out_file,
+    MeshCacheView* out_view );
+
+// Size and mtime of in_sourceName into out_stamp; the caller hashes the
+// bytes it parses. Stat before mapping: a save during the parse then
+// leaves the cache with an older stamp, which MapMeshCache() re-hashes.
+bool StatMeshSource( const char* in_sourceName, MeshSourceStamp* out_stamp );
+
+// Write the cache of in_sourceName, built from the source in_source
+// describes, atomically (temporary file and rename).
+bool WriteMeshCache( const char* in_sourceName, const MeshSourceStamp& in_source, const MeshCacheView& in_view );
+
+#endif
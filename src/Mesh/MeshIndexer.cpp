@@ -0,0 +1,131 @@
+#include "MeshIndexer.hpp"
+#include "FlatHashMap.hpp"
+
+#include <cmath>
+
+namespace {
+
+struct VertexKey {
+    unsigned int v, vn, vt;
+    bool operator==( const VertexKey& other ) const {
+        return v == other.v && vn == other.vn && vt == other.vt;
+    }
+};
+struct VertexKeyHash {
+    uint64_t operator()( const VertexKey& key ) const {
+        return App::MixHash( ( (uint64_t)key.v << 32 | key.vn ) ^ App::MixHash( key.vt ) );
+    }
+};
+
+struct CellKey {
+    int64_t x, y, z;
+    bool operator==( const CellKey& other ) const {
+        return x == other.x && y == other.y && z == other.z;
+    }
+};
+struct CellKeyHash {
+    uint64_t operator()( const CellKey& key ) const {
+        return App::MixHash( (uint64_t)key.x ^ App::MixHash( (uint64_t)key.y ^ App::MixHash( (uint64_t)key.z ) ) );
+    }
+};
+
+const unsigned int NONE = 0xffffffffU;
+
+// Attribute reference in OBJ (1-based) to a Vector3f, zero when absent.
+Vector3f Fetch( const std::vector< Vector3f >& in_array, const unsigned int in_reference ) {
+    if( in_reference == 0U || in_reference > in_array.size() ) {
+        Vector3f zero = { 0.f, 0.f, 0.f };
+        return zero;
+    }
+    return in_array[ in_reference - 1U ];
+}
+
+}
+
+unsigned int WeldPositions( const Mesh& in_mesh, const float in_epsilon,
+    std::vector< unsigned int >* out_remap ) {
+    const size_t count = in_mesh.v.size();
+    out_remap->resize( count );
+    if( in_epsilon <= 0.f ) {
+        for( size_t index = 0U; index < count; index += 1U )
+            ( *out_remap )[ index ] = (unsigned int)index;
+        return (unsigned int)count;
+    }
+
+    // Uniform grid with cell size epsilon: a match can only be in the 27
+    // cells around a position. Each cell heads a linked list of the distinct
+    // positions inside it.
+    App::FlatHashMap< CellKey, unsigned int, CellKeyHash > cells( count );
+    std::vector< unsigned int > next( count, NONE );
+    const double inverse = 1.0 / in_epsilon;
+    const float epsilonSquared = in_epsilon * in_epsilon;
+    unsigned int distinct = 0U;
+    for( size_t index = 0U; index < count; index += 1U ) {
+        const Vector3f& p = in_mesh.v[ index ];
+        const CellKey cell = {
+            (int64_t)std::floor( p.x * inverse ),
+            (int64_t)std::floor( p.y * inverse ),
+            (int64_t)std::floor( p.z * inverse ) };
+        unsigned int match = NONE;
+        for( int64_t dx = -1; dx <= 1 && match == NONE; ++dx )
+        for( int64_t dy = -1; dy <= 1 && match == NONE; ++dy )
+        for( int64_t dz = -1; dz <= 1 && match == NONE; ++dz ) {
+            const CellKey neighbour = { cell.x + dx, cell.y + dy, cell.z + dz };
+            const unsigned int* head = cells.find( neighbour );
+            for( unsigned int it = head ? *head : NONE; it != NONE; it = next[ it ] ) {
+                const Vector3f& q = in_mesh.v[ it ];
+                const float ex = p.x - q.x, ey = p.y - q.y, ez = p.z - q.z;
+                if( ex * ex + ey * ey + ez * ez <= epsilonSquared ) {
+                    match = it;
+                    break;
+                }
+            }
+        }
+        if( match != NONE ) {
+            ( *out_remap )[ index ] = ( *out_remap )[ match ];
+            continue;
+        }
+        bool inserted;
+        unsigned int& head = cells.findOrInsert( cell, (unsigned int)index, &inserted );
+        if( inserted == false ) {
+            next[ index ] = head;
+            head = (unsigned int)index;
+        }
+        ( *out_remap )[ index ] = (unsigned int)index;
+        distinct += 1U;
+    }
+    return distinct;
+}
+
+void IndexMesh( const Mesh& in_mesh, IndexedMesh* out_mesh, const float in_weldEpsilon ) {
+    std::vector< unsigned int > remap;
+    WeldPositions( in_mesh, in_weldEpsilon, &remap );
+
+    out_mesh->verticies.clear();
+    out_mesh->indicies.resize( in_mesh.f.size() );
+    App::FlatHashMap< VertexKey, unsigned int, VertexKeyHash > unique( in_mesh.v.size() );
+    for( size_t face = 0U; face < in_mesh.f.size(); face += 1U ) {
+        unsigned int* ref = reinterpret_cast<unsigned int*>( &out_mesh->indicies[ face ] );
+        for( unsigned int corner = 0U; corner < 3U; corner += 1U ) {
+            const Vertex& vertex = in_mesh.f[ face ].verticies[ corner ];
+            VertexKey key = { vertex.v, vertex.vn, vertex.vt };
+            if( key.v >= 1U && key.v <= remap.size() )
+                key.v = remap[ key.v - 1U ] + 1U;
+
+            bool inserted;
+            const unsigned int index = unique.findOrInsert( key,
+                (unsigned int)out_mesh->verticies.size(), &inserted );
+            if( inserted ) {
+                const Vector3f position = Fetch( in_mesh.v, key.v );
+                const Vector3f normal = Fetch( in_mesh.vn, key.vn );
+                const Vector3f texture = Fetch( in_mesh.vt, key.vt );
+                const AInterleavedVertex interleaved = {
+                    position.x, position.y, position.z,
+                    normal.x, normal.y, normal.z,
+                    texture.x, texture.y };
+                out_mesh->verticies.push_back( interleaved );
+            }
+            ref[ corner ] = index;
+        }
+    }
+}
@@ -0,0 +1,36 @@
+#ifndef __MESH_INDEXER__
+#define __MESH_INDEXER__
+
+#include <vector>
+
+#include "util.h"
+#include "MeshBuffer.hpp"
+
+// Interleaved position, normal and texture coordinate.
+struct AInterleavedVertex {
+    float px, py, pz;
+    float nx, ny, nz;
+    float u, v;
+};
+
+struct IndexedMesh {
+    std::vector< AInterleavedVertex >   verticies;
+    std::vector< AIndex >               indicies;
+};
+
+/*
+Build one interleaved vertex per unique (v, vn, vt) reference triple of
+in_mesh and a zero-based index buffer over them.
+With in_weldEpsilon > 0 positions closer than in_weldEpsilon are merged
+first, so near-duplicate positions with the same normal and texture
+coordinate references become a single vertex.
+Missing or out-of-range normal and texture references read as zero.
+*/
+void IndexMesh( const Mesh& in_mesh, IndexedMesh* out_mesh, const float in_weldEpsilon = 0.f );
+
+// Map every position of in_mesh to the first position within in_epsilon.
+// Return the number of distinct positions.
+unsigned int WeldPositions( const Mesh& in_mesh, const float in_epsilon,
+    std::vector< unsigned int >* out_remap );
+
+#endif
@@ -0,0 +1,303 @@
+#include "MeshSimplifier.hpp"
+#include "IndexOptimizer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <string.h>
+
+namespace {
+
+// Boundary edges get a perpendicular plane this much heavier than a face,
+// so open borders do not shrink.
+const double BOUNDARY_WEIGHT = 10.0;
+// Reject a collapse that turns a face normal by more than ~75 degrees.
+const double MAX_NORMAL_TURN_COS = 0.25;
+
+/*
+Symmetric 4x4 plane quadric plus the total weight of the planes, so that
+evaluate() is a weighted mean of squared distances.
+*/
+struct Quadric {
+    double a2, ab, ac, ad, b2, bc, bd, c2, cd, d2, w;
+
+    Quadric( void ) : a2( 0 ), ab( 0 ), ac( 0 ), ad( 0 ), b2( 0 ), bc( 0 ), bd( 0 ),
+        c2( 0 ), cd( 0 ), d2( 0 ), w( 0 ) {}
+
+    void addPlane( const double a, const double b, const double c, const double d,
+        const double weight, const bool counted ) {
+        a2 += weight * a * a; ab += weight * a * b; ac += weight * a * c; ad += weight * a * d;
+        b2 += weight * b * b; bc += weight * b * c; bd += weight * b * d;
+        c2 += weight * c * c; cd += weight * c * d;
+        d2 += weight * d * d;
+        if( counted )
+            w += weight;
+    }
+    void add( const Quadric& o ) {
+        a2 += o.a2; ab += o.ab; ac += o.ac; ad += o.ad; b2 += o.b2; bc += o.bc; bd += o.bd;
+        c2 += o.c2; cd += o.cd; d2 += o.d2; w += o.w;
+    }
+    double evaluate( const AVertex& p ) const {
+        const double x = p.x, y = p.y, z = p.z;
+        const double error = a2 * x * x + 2 * ab * x * y + 2 * ac * x * z + 2 * ad * x
+            + b2 * y * y + 2 * bc * y * z + 2 * bd * y
+            + c2 * z * z + 2 * cd * z + d2;
+        return std::max( 0.0, w > 0.0 ? error / w : error );
+    }
+};
+
+struct Collapse {
+    double          error;
+    unsigned int    from, to;
+    bool operator<( const Collapse& other ) const {
+        return error < other.error;
+    }
+};
+
+void Cross( const AVertex& a, const AVertex& b, const AVertex& c, double* out ) {
+    const double e1[ 3 ] = { (double)b.x - a.x, (double)b.y - a.y, (double)b.z - a.z };
+    const double e2[ 3 ] = { (double)c.x - a.x, (double)c.y - a.y, (double)c.z - a.z };
+    out[ 0 ] = e1[ 1 ] * e2[ 2 ] - e1[ 2 ] * e2[ 1 ];
+    out[ 1 ] = e1[ 2 ] * e2[ 0 ] - e1[ 0 ] * e2[ 2 ];
+    out[ 2 ] = e1[ 0 ] * e2[ 1 ] - e1[ 1 ] * e2[ 0 ];
+}
+double Length( const double* v ) {
+    return std::sqrt( v[ 0 ] * v[ 0 ] + v[ 1 ] * v[ 1 ] + v[ 2 ] * v[ 2 ] );
+}
+
+inline unsigned long long EdgeKey( unsigned int a, unsigned int b ) {
+    if( a > b )
+        std::swap( a, b );
+    return (unsigned long long)a << 32 | b;
+}
+
+void BuildQuadrics( const std::vector< AVertex >& in_verticies, const std::vector< unsigned int >& in_corners,
+    std::vector< Quadric >* out_quadrics ) {
+    out_quadrics->assign( in_verticies.size(), Quadric() );
+    std::vector< unsigned long long > edges;
+    edges.reserve( in_corners.size() );
+    for( size_t corner = 0U; corner < in_corners.size(); corner += 3U ) {
+        const unsigned int* face = &in_corners[ corner ];
+        const AVertex& a = in_verticies[ face[ 0 ] ];
+        double normal[ 3 ];
+        Cross( a, in_verticies[ face[ 1 ] ], in_verticies[ face[ 2 ] ], normal );
+        const double area = Length( normal );
+        if( area <= 0.0 )
+            continue;
+        const double n[ 3 ] = { normal[ 0 ] / area, normal[ 1 ] / area, normal[ 2 ] / area };
+        const double d = -( n[ 0 ] * a.x + n[ 1 ] * a.y + n[ 2 ] * a.z );
+        for( unsigned int k = 0U; k < 3U; k += 1U ) {
+            ( *out_quadrics )[ face[ k ] ].addPlane( n[ 0 ], n[ 1 ], n[ 2 ], d, area, true );
+            edges.push_back( EdgeKey( face[ k ], face[ ( k + 1U ) % 3U ] ) );
+        }
+    }
+    std::sort( edges.begin(), edges.end() );
+
+    // Edges used by a single face are on the border.
+    for( size_t corner = 0U; corner < in_corners.size(); corner += 3U ) {
+        const unsigned int* face = &in_corners[ corner ];
+        double normal[ 3 ];
+        Cross( in_verticies[ face[ 0 ] ], in_verticies[ face[ 1 ] ], in_verticies[ face[ 2 ] ], normal );
+        const double area = Length( normal );
+        if( area <= 0.0 )
+            continue;
+        for( unsigned int k = 0U; k < 3U; k += 1U ) {
+            const unsigned int u = face[ k ], v = face[ ( k + 1U ) % 3U ];
+            const unsigned long long key = EdgeKey( u, v );
+            std::vector< unsigned long long >::const_iterator first
+                = std::lower_bound( edges.begin(), edges.end(), key );
+            if( first + 1 != edges.end() && *( first + 1 ) == key )
+                continue;
+            const AVertex& p = in_verticies[ u ];
+            const AVertex& q = in_verticies[ v ];
+            const double edge[ 3 ] = { (double)q.x - p.x, (double)q.y - p.y, (double)q.z - p.z };
+            double side[ 3 ] = {
+                edge[ 1 ] * normal[ 2 ] - edge[ 2 ] * normal[ 1 ],
+                edge[ 2 ] * normal[ 0 ] - edge[ 0 ] * normal[ 2 ],
+                edge[ 0 ] * normal[ 1 ] - edge[ 1 ] * normal[ 0 ] };
+            const double length = Length( side );
+            if( length <= 0.0 )
+                continue;
+            side[ 0 ] /= length;
+            side[ 1 ] /= length;
+            side[ 2 ] /= length;
+            const double d = -( side[ 0 ] * p.x + side[ 1 ] * p.y + side[ 2 ] * p.z );
+            const double weight = BOUNDARY_WEIGHT * Length( edge ) * Length( edge );
+            ( *out_quadrics )[ u ].addPlane( side[ 0 ], side[ 1 ], side[ 2 ], d, weight, false );
+            ( *out_quadrics )[ v ].addPlane( side[ 0 ], side[ 1 ], side[ 2 ], d, weight, false );
+        }
+    }
+}
+
+// Would moving in_from onto in_to flip or crush a face around in_from?
+bool Flips( const std::vector< AVertex >& in_verticies, const std::vector< unsigned int >& in_corners,
+    const std::vector< unsigned int >& in_offsets, const std::vector< unsigned int >& in_adjacency,
+    const unsigned int in_from, const unsigned int in_to ) {
+    for( unsigned int it = in_offsets[ in_from ]; it < in_offsets[ in_from + 1U ]; it += 1U ) {
+        const unsigned int* face = &in_corners[ in_adjacency[ it ] * 3U ];
+        if( face[ 0 ] == in_to || face[ 1 ] == in_to || face[ 2 ] == in_to )
+            continue;
+        const AVertex* corners[ 3 ] = {
+            &in_verticies[ face[ 0 ] ], &in_verticies[ face[ 1 ] ], &in_verticies[ face[ 2 ] ] };
+        double before[ 3 ], after[ 3 ];
+        Cross( *corners[ 0 ], *corners[ 1 ], *corners[ 2 ], before );
+        for( unsigned int k = 0U; k < 3U; k += 1U ) {
+            if( face[ k ] == in_from )
+                corners[ k ] = &in_verticies[ in_to ];
+        }
+        Cross( *corners[ 0 ], *corners[ 1 ], *corners[ 2 ], after );
+        const double dot = before[ 0 ] * after[ 0 ] + before[ 1 ] * after[ 1 ] + before[ 2 ] * after[ 2 ];
+        if( dot <= MAX_NORMAL_TURN_COS * Length( before ) * Length( after ) )
+            return true;
+    }
+    return false;
+}
+
+}
+
+float SimplifyMesh( const std::vector< AVertex >& in_verticies, const std::vector< AIndex >& in_indicies,
+    const size_t in_targetFaces, std::vector< AIndex >* out_indicies ) {
+    const unsigned int vertexCount = (unsigned int)in_verticies.size();
+    std::vector< unsigned int > corners( in_indicies.size() * 3U );
+    if( corners.empty() == false )
+        memcpy( &corners[ 0 ], &in_indicies[ 0 ], sizeof( AIndex ) * in_indicies.size() );
+
+    std::vector< Quadric > quadrics;
+    BuildQuadrics( in_verticies, corners, &quadrics );
+
+    // Passes only shrink the mesh, so the first sizes every array once.
+    double maxError = 0.0;
+    std::vector< unsigned int > offsets, fill, adjacency, remap;
+    std::vector< unsigned long long > edges;
+    std::vector< Collapse > collapses;
+    std::vector< char > locked;
+    edges.reserve( corners.size() );
+    while( corners.size() / 3U > in_targetFaces ) {
+        const size_t faceCount = corners.size() / 3U;
+
+        // Vertex to face adjacency of the current pass.
+        offsets.assign( vertexCount + 1U, 0U );
+        for( size_t corner = 0U; corner < corners.size(); corner += 1U )
+            offsets[ corners[ corner ] + 1U ] += 1U;
+        for( unsigned int vertex = 0U; vertex < vertexCount; vertex += 1U )
+            offsets[ vertex + 1U ] += offsets[ vertex ];
+        adjacency.resize( corners.size() );
+        fill.assign( offsets.begin(), offsets.end() - 1 );
+        for( size_t corner = 0U; corner < corners.size(); corner += 1U )
+            adjacency[ fill[ corners[ corner ] ]++ ] = (unsigned int)( corner / 3U );
+
+        // Every edge once, collapsing towards the cheaper endpoint.
+        edges.clear();
+        for( size_t corner = 0U; corner < corners.size(); corner += 3U ) {
+            for( unsigned int k = 0U; k < 3U; k += 1U )
+                edges.push_back( EdgeKey( corners[ corner + k ], corners[ corner + ( k + 1U ) % 3U ] ) );
+        }
+        std::sort( edges.begin(), edges.end() );
+        edges.erase( std::unique( edges.begin(), edges.end() ), edges.end() );
+        collapses.clear();
+        collapses.reserve( edges.size() );
+        for( size_t edge = 0U; edge < edges.size(); edge += 1U ) {
+            const unsigned int u = (unsigned int)( edges[ edge ] >> 32 );
+            const unsigned int v = (unsigned int)( edges[ edge ] & 0xffffffffULL );
+            if( u == v )
+                continue;
+            Quadric merged = quadrics[ u ];
+            merged.add( quadrics[ v ] );
+            const double toV = merged.evaluate( in_verticies[ v ] );
+            const double toU = merged.evaluate( in_verticies[ u ] );
+            Collapse collapse = { std::min( toU, toV ), toV <= toU ? u : v, toV <= toU ? v : u };
+            collapses.push_back( collapse );
+        }
+        std::sort( collapses.begin(), collapses.end() );
+
+        // Apply the cheapest independent collapses of this pass.
+        locked.assign( vertexCount, 0 );
+        remap.resize( vertexCount );
+        for( unsigned int vertex = 0U; vertex < vertexCount; vertex += 1U )
+            remap[ vertex ] = vertex;
+        size_t removed = 0U, applied = 0U;
+        for( size_t index = 0U; index < collapses.size() && faceCount - removed > in_targetFaces; index += 1U ) {
+            const Collapse& collapse = collapses[ index ];
+            if( locked[ collapse.from ] || locked[ collapse.to ] )
+                continue;
+            if( Flips( in_verticies, corners, offsets, adjacency, collapse.from, collapse.to ) )
+                continue;
+            remap[ collapse.from ] = collapse.to;
+            quadrics[ collapse.to ].add( quadrics[ collapse.from ] );
+            for( unsigned int it = offsets[ collapse.from ]; it < offsets[ collapse.from + 1U ]; it += 1U ) {
+                const unsigned int* face = &corners[ adjacency[ it ] * 3U ];
+                if( face[ 0 ] == collapse.to || face[ 1 ] == collapse.to || face[ 2 ] == collapse.to )
+                    removed += 1U;
+                locked[ face[ 0 ] ] = locked[ face[ 1 ] ] = locked[ face[ 2 ] ] = 1;
+            }
+            locked[ collapse.to ] = 1;
+            maxError = std::max( maxError, collapse.error );
+            applied += 1U;
+        }
+        if( applied == 0U )
+            break;
+
+        size_t write = 0U;
+        for( size_t corner = 0U; corner < corners.size(); corner += 3U ) {
+            const unsigned int a = remap[ corners[ corner ] ];
+            const unsigned int b = remap[ corners[ corner + 1U ] ];
+            const unsigned int c = remap[ corners[ corner + 2U ] ];
+            if( a == b || b == c || c == a )
+                continue;
+            corners[ write++ ] = a;
+            corners[ write++ ] = b;
+            corners[ write++ ] = c;
+        }
+        corners.resize( write );
+    }
+
+    out_indicies->resize( corners.size() / 3U );
+    if( corners.empty() == false )
+        memcpy( &( *out_indicies )[ 0 ], &corners[ 0 ], sizeof( unsigned int ) * corners.size() );
+    return (float)std::sqrt( maxError );
+}
+
+void BuildLodChain( const std::vector< AVertex >& in_verticies, const std::vector< AIndex >& in_indicies,
+    const float* in_ratios, const unsigned int in_count,
+    std::vector< AIndex >* out_indicies, std::vector< MeshLod >* out_lods ) {
+    std::vector< std::vector< AIndex > > levels;
+    BuildLodLevels( in_verticies, in_indicies, in_ratios, in_count, &levels, out_lods );
+    out_indicies->clear();
+    if( out_lods->empty() == true )
+        return;
+    out_indicies->reserve( out_lods->back().firstFace + out_lods->back().faceCount );
+    out_indicies->insert( out_indicies->end(), in_indicies.begin(), in_indicies.end() );
+    for( size_t level = 0U; level < levels.size(); level += 1U )
+        out_indicies->insert( out_indicies->end(), levels[ level ].begin(), levels[ level ].end() );
+}
+
+void BuildLodLevels( const std::vector< AVertex >& in_verticies, const std::vector< AIndex >& in_indicies,
+    const float* in_ratios, const unsigned int in_count,
+    std::vector< std::vector< AIndex > >* out_levels, std::vector< MeshLod >* out_lods ) {
+    out_levels->assign( in_count > 0U ? in_count - 1U : 0U, std::vector< AIndex >() );
+    out_lods->clear();
+    float error = 0.f;
+    unsigned int firstFace = 0U;
+    for( unsigned int level = 0U; level < in_count; level += 1U ) {
+        const std::vector< AIndex >* current = &in_indicies;
+        if( level > 0U ) {
+            const size_t target = (size_t)( in_ratios[ level ] * in_indicies.size() );
+            const std::vector< AIndex >& previous = level > 1U ? ( *out_levels )[ level - 2U ] : in_indicies;
+            current = &( *out_levels )[ level - 1U ];
+            // Errors of successive levels add up.
+            error += SimplifyMesh( in_verticies, previous, target, &( *out_levels )[ level - 1U ] );
+            OptimizeVertexCache( &( *out_levels )[ level - 1U ], (unsigned int)in_verticies.size() );
+        }
+        MeshLod lod = { firstFace, (unsigned int)current->size(), error };
+        out_lods->push_back( lod );
+        firstFace += lod.faceCount;
+    }
+}
+
+unsigned int SelectLod( const MeshLod* in_lods, const unsigned int in_count,
+    const float in_pixelsPerUnit, const float in_tolerance ) {
+    for( unsigned int level = in_count; level > 1U; level -= 1U ) {
+        if( in_lods[ level - 1U ].error * in_pixelsPerUnit <= in_tolerance )
+            return level - 1U;
+    }
+    return 0U;
+}
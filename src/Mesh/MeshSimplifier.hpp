@@ -0,0 +1,54 @@
+#ifndef __MESH_SIMPLIFIER__
+#define __MESH_SIMPLIFIER__
+
+#include <stddef.h>
+#include <vector>
+
+#include "MeshBuffer.hpp"
+
+/*
+Quadric error metric simplification by half-edge collapse.
+Vertices never move: a collapse merges one endpoint into the other, so every
+level of detail indexes the same vertex buffer and only the index buffer
+changes.
+*/
+
+// Default chain: 100%, 50%, 25% and 10% of the triangles.
+static const float DEFAULT_LOD_RATIOS[] = { 1.f, 0.5f, 0.25f, 0.1f };
+static const unsigned int DEFAULT_LOD_COUNT = sizeof( DEFAULT_LOD_RATIOS ) / sizeof( DEFAULT_LOD_RATIOS[ 0 ] );
+
+/*
+Collapse edges of in_indicies until at most in_targetFaces triangles are
+left or no collapse passes the flip test. Return the largest collapse error
+as a distance in object units.
+*/
+float SimplifyMesh( const std::vector< AVertex >& in_verticies, const std::vector< AIndex >& in_indicies,
+    const size_t in_targetFaces, std::vector< AIndex >* out_indicies );
+
+/*
+Build a LOD chain for in_ratios of the input triangle count. Level 0 is the
+input unchanged; every other level is simplified from the previous one and
+optimized for the vertex cache. The levels are appended to out_indicies.
+*/
+void BuildLodChain( const std::vector< AVertex >& in_verticies, const std::vector< AIndex >& in_indicies,
+    const float* in_ratios, const unsigned int in_count,
+    std::vector< AIndex >* out_indicies, std::vector< MeshLod >* out_lods );
+
+/*
+The same chain without level 0 copied: out_levels gets levels 1 and up, one
+array each, and out_lods every level with offsets as if the arrays followed
+in_indicies. A caller building its own buffer never holds the chain twice.
+*/
+void BuildLodLevels( const std::vector< AVertex >& in_verticies, const std::vector< AIndex >& in_indicies,
+    const float* in_ratios, const unsigned int in_count,
+    std::vector< std::vector< AIndex > >* out_levels, std::vector< MeshLod >* out_lods );
+
+/*
+Pick the coarsest level whose error covers at most in_tolerance pixels.
+in_pixelsPerUnit is how many pixels one object-space unit spans at the
+object's distance (see main.cpp).
+*/
+unsigned int SelectLod( const MeshLod* in_lods, const unsigned int in_count,
+    const float in_pixelsPerUnit, const float in_tolerance = 1.f );
+
+#endif
@@ -0,0 +1,406 @@
+#include "ObjParser.hpp"
+#include "MappedFile.hpp"
+
+#include <limits.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+namespace {
+
+// Exact powers of ten representable by a double.
+const double POW10[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+const int MAX_EXACT_POW10 = 22;
+// Integers below 2^53 are exact in a double.
+const unsigned long long MAX_EXACT_MANTISSA = 1ULL << 53;
+
+inline bool IsSpace( const char c ) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+inline bool IsDigit( const char c ) {
+    return c >= '0' && c <= '9';
+}
+inline const char* SkipSpace( const char* it, const char* end ) {
+    while( it != end && IsSpace( *it ) )
+        ++it;
+    return it;
+}
+inline const char* SkipToken( const char* it, const char* end ) {
+    while( it != end && IsSpace( *it ) == false )
+        ++it;
+    return it;
+}
+inline const char* SkipToSlashOrSpace( const char* it, const char* end ) {
+    while( it != end && *it != '/' && IsSpace( *it ) == false )
+        ++it;
+    return it;
+}
+
+// Slow path: copy the token and let the C library handle it.
+// Same result as atof() on the token used by FileLoadMesh().
+const char* ScanFloatSlow( const char* it, const char* end, float* out_value ) {
+    const char* tokenEnd = SkipToken( it, end );
+    char buffer[ 128 ];
+    size_t length = (size_t)( tokenEnd - it );
+    if( length >= sizeof( buffer ) )
+        length = sizeof( buffer ) - 1U;
+    memcpy( buffer, it, length );
+    buffer[ length ] = '\0';
+    *out_value = (float)atof( buffer );
+    return tokenEnd;
+}
+
+/*
+Scan one decimal number at it, store it in out_value and return the position
+after the token.
+Decimal strings whose mantissa fits in 53 bits and whose scale is at most
+10^22 are converted with a single correctly-rounded multiply or divide
+(Clinger's fast path), which gives the same double as atof(). Everything
+else falls back to the C library.
+*/
+const char* ScanFloat( const char* it, const char* end, float* out_value ) {
+    const char* start = it;
+    bool negative = false;
+    if( it != end && ( *it == '-' || *it == '+' ) ) {
+        negative = ( *it == '-' );
+        ++it;
+    }
+
+    unsigned long long mantissa = 0ULL;
+    int scale = 0;
+    bool digits = false, exact = true;
+    for( ; it != end && IsDigit( *it ); ++it ) {
+        digits = true;
+        mantissa = mantissa * 10ULL + (unsigned long long)( *it - '0' );
+        exact = exact && mantissa < MAX_EXACT_MANTISSA;
+    }
+    if( it != end && *it == '.' ) {
+        for( ++it; it != end && IsDigit( *it ); ++it ) {
+            digits = true;
+            mantissa = mantissa * 10ULL + (unsigned long long)( *it - '0' );
+            exact = exact && mantissa < MAX_EXACT_MANTISSA;
+            scale -= 1;
+        }
+    }
+    if( digits == false ) {
+        // Empty token, "inf", "nan", ...
+        if( it == end || IsSpace( *it ) ) {
+            *out_value = 0.f;
+            return it;
+        }
+        return ScanFloatSlow( start, end, out_value );
+    }
+    if( it != end && ( *it == 'e' || *it == 'E' ) ) {
+        const char* expStart = it;
+        ++it;
+        bool expNegative = false;
+        if( it != end && ( *it == '-' || *it == '+' ) ) {
+            expNegative = ( *it == '-' );
+            ++it;
+        }
+        if( it == end || IsDigit( *it ) == false ) {
+            // "1e" is parsed as 1 by strtod.
+            it = expStart;
+        }
+        else {
+            int exponent = 0;
+            for( ; it != end && IsDigit( *it ); ++it ) {
+                if( exponent < 10000 )
+                    exponent = exponent * 10 + ( *it - '0' );
+            }
+            scale += expNegative ? -exponent : exponent;
+        }
+    }
+    if( it != end && IsSpace( *it ) == false )
+        return ScanFloatSlow( start, end, out_value );
+    if( exact == false || scale > MAX_EXACT_POW10 || scale < -MAX_EXACT_POW10 )
+        return ScanFloatSlow( start, end, out_value );
+
+    double value = (double)mantissa;
+    if( scale >= 0 )
+        value *= POW10[ scale ];
+    else
+        value /= POW10[ -scale ];
+    *out_value = (float)( negative ? -value : value );
+    return it;
+}
+
+// Same as atoi() over [it, end): stop at the first non-digit. Saturates
+// at INT_MAX, which no mesh reaches, so a huge index stays out of range.
+const char* ScanIndex( const char* it, const char* end, int* out_value ) {
+    bool negative = false;
+    if( it != end && ( *it == '-' || *it == '+' ) ) {
+        negative = ( *it == '-' );
+        ++it;
+    }
+    long long value = 0;
+    for( ; it != end && IsDigit( *it ); ++it )
+        value = std::min( value * 10 + ( *it - '0' ), (long long)INT_MAX );
+    *out_value = negative ? -(int)value : (int)value;
+    return it;
+}
+
+// A negative OBJ index counts back from the last record read, -1 being
+// that record itself. Return the absolute, one-based index; 0, the missing
+// index, when it counts back past the first record.
+inline unsigned int AbsoluteIndex( const int in_index, const size_t in_seen ) {
+    if( in_index >= 0 )
+        return (unsigned int)in_index;
+    const long long index = (long long)in_seen + 1LL + in_index;
+    return index > 0LL ? (unsigned int)index : 0U;
+}
+
+const char* ScanVector( const char* it, const char* end,
+    const unsigned int count, Vector3f* out_vector ) {
+    float* ref = reinterpret_cast<float*>( out_vector );
+    for( unsigned int w = 0U; w < count; w += 1U ) {
+        it = SkipSpace( it, end );
+        it = ScanFloat( it, end, &ref[ w ] );
+    }
+    return it;
+}
+
+// in_seen holds the records of each kind read before this face.
+void ScanFace( const char* it, const char* end, const MeshCounts& in_seen, Face* out_face ) {
+    *out_face = Face();
+    unsigned int w = 0U;
+    while( w < 3U ) {
+        it = SkipSpace( it, end );
+        if( it == end )
+            break;
+        Vertex& vertex = out_face->verticies[ w ];
+        // v/vt/vn
+        unsigned int* slots[ 3 ] = { &vertex.v, &vertex.vt, &vertex.vn };
+        const size_t seen[ 3 ] = { in_seen.v, in_seen.vt, in_seen.vn };
+        for( unsigned int ww = 0U; ww < 3U; ww += 1U ) {
+            int index = 0;
+            it = ScanIndex( it, end, &index );
+            *slots[ ww ] = AbsoluteIndex( index, seen[ ww ] );
+            it = SkipToSlashOrSpace( it, end );
+            if( it == end || *it != '/' )
+                break;
+            ++it;
+        }
+        it = SkipToken( it, end );
+        w += 1U;
+    }
+}
+
+// Files below this size are not worth a thread.
+const size_t MIN_CHUNK_SIZE = 256U * 1024U;
+// More chunks than threads keeps every worker busy when line density varies.
+const unsigned int CHUNKS_PER_THREAD = 4U;
+
+// Append the tail of in_from to out_to starting at in_offset.
+template< typename T >
+void CopyInto( const std::vector< T >& in_from, std::vector< T >* out_to, const size_t in_offset ) {
+    if( in_from.empty() == false )
+        memcpy( &( *out_to )[ in_offset ], &in_from[ 0 ], sizeof(T) * in_from.size() );
+}
+
+// Run work( index ) for index in [0, count) on the given number of threads.
+template< typename Work >
+void RunParallel( const unsigned int in_threads, const size_t in_count, Work work ) {
+    std::atomic< size_t > next( 0U );
+    std::vector< std::thread > workers;
+    for( unsigned int thread = 1U; thread < in_threads; thread += 1U ) {
+        workers.push_back( std::thread( [ &next, &work, in_count ]() {
+            for( size_t index = next++; index < in_count; index = next++ )
+                work( index );
+        } ) );
+    }
+    for( size_t index = next++; index < in_count; index = next++ )
+        work( index );
+    for( size_t thread = 0U; thread < workers.size(); thread += 1U )
+        workers[ thread ].join();
+}
+
+}
+
+void CountMesh( const char* in_begin, const char* in_end, MeshCounts* out_counts ) {
+    MeshCounts counts = { 0U, 0U, 0U, 0U };
+    const char* line = in_begin;
+    while( line < in_end ) {
+        const char* lineEnd = static_cast<const char*>(
+            memchr( line, '\n', (size_t)( in_end - line ) ) );
+        if( lineEnd == NULL )
+            lineEnd = in_end;
+        const char* it = SkipSpace( line, lineEnd );
+        // Same record test as ParseMesh, on the first two characters.
+        const char second = lineEnd - it > 1 ? it[ 1 ] : ' ';
+        if( it != lineEnd && it[ 0 ] == 'v' ) {
+            if( IsSpace( second ) )
+                counts.v += 1U;
+            else if( second == 'n' && ( lineEnd - it == 2 || IsSpace( it[ 2 ] ) ) )
+                counts.vn += 1U;
+            else if( second == 't' && ( lineEnd - it == 2 || IsSpace( it[ 2 ] ) ) )
+                counts.vt += 1U;
+        }
+        else if( it != lineEnd && it[ 0 ] == 'f' && IsSpace( second ) ) {
+            counts.f += 1U;
+        }
+        line = lineEnd + 1;
+    }
+    *out_counts = counts;
+}
+
+namespace {
+
+// Parse [in_begin, in_end), whose records CountMesh() gave as in_counts,
+// into out_mesh. in_before holds the records of the file before the range
+// that are not in out_mesh, for relative face indices.
+void ParseCounted( const char* in_begin, const char* in_end, const MeshCounts& in_counts,
+    const MeshCounts& in_before, Mesh* out_mesh ) {
+    out_mesh->v.reserve( out_mesh->v.size() + in_counts.v );
+    out_mesh->vn.reserve( out_mesh->vn.size() + in_counts.vn );
+    out_mesh->vt.reserve( out_mesh->vt.size() + in_counts.vt );
+    out_mesh->f.reserve( out_mesh->f.size() + in_counts.f );
+
+    const char* line = in_begin;
+    while( line < in_end ) {
+        const char* lineEnd = static_cast<const char*>(
+            memchr( line, '\n', (size_t)( in_end - line ) ) );
+        if( lineEnd == NULL )
+            lineEnd = in_end;
+
+        const char* it = SkipSpace( line, lineEnd );
+        const char* typeEnd = SkipToken( it, lineEnd );
+        const size_t typeLength = (size_t)( typeEnd - it );
+
+        if( typeLength == 1U && it[ 0 ] == 'v' ) {
+            Vector3f vertex;
+            ScanVector( typeEnd, lineEnd, 3U, &vertex );
+            out_mesh->v.push_back( vertex );
+        }
+        else if( typeLength == 2U && it[ 0 ] == 'v' && it[ 1 ] == 'n' ) {
+            Vector3f vertexNormal;
+            ScanVector( typeEnd, lineEnd, 3U, &vertexNormal );
+            out_mesh->vn.push_back( vertexNormal );
+        }
+        else if( typeLength == 2U && it[ 0 ] == 'v' && it[ 1 ] == 't' ) {
+            // The third texture coordinate is optional and defaults to 0.
+            Vector3f vertexTexture;
+            ScanVector( typeEnd, lineEnd, 3U, &vertexTexture );
+            out_mesh->vt.push_back( vertexTexture );
+        }
+        else if( typeLength == 1U && it[ 0 ] == 'f' ) {
+            const MeshCounts seen = { in_before.v + out_mesh->v.size(), in_before.vn + out_mesh->vn.size(),
+                in_before.vt + out_mesh->vt.size(), 0U };
+            Face face;
+            ScanFace( typeEnd, lineEnd, seen, &face );
+            out_mesh->f.push_back( face );
+        }
+        // Comments and unknown records are ignored.
+
+        line = lineEnd + 1;
+    }
+}
+
+}
+
+bool FacesInRange( const Mesh& in_mesh ) {
+    const size_t count = in_mesh.v.size();
+    for( size_t face = 0U; face < in_mesh.f.size(); face += 1U )
+        for( unsigned int corner = 0U; corner < 3U; corner += 1U ) {
+            const unsigned int index = in_mesh.f[ face ].verticies[ corner ].v;
+            if( index == 0U || index > count )
+                return false;
+        }
+    return true;
+}
+
+void ParseMesh( const char* in_begin, const char* in_end, Mesh* out_mesh ) {
+    MeshCounts counts;
+    CountMesh( in_begin, in_end, &counts );
+    const MeshCounts before = { 0U, 0U, 0U, 0U };
+    ParseCounted( in_begin, in_end, counts, before, out_mesh );
+}
+
+bool FileMapMesh( const char* in_fileName, Mesh* out_mesh ) {
+    App::MappedFile file;
+    if( file.open( in_fileName ) == false )
+        return false;
+    ParseMesh( file.data(), file.data() + file.size(), out_mesh );
+    return FacesInRange( *out_mesh );
+}
+
+bool FileMapMeshParallel( const char* in_fileName, Mesh* out_mesh,
+    unsigned int in_threads ) {
+    App::MappedFile file;
+    if( file.open( in_fileName ) == false )
+        return false;
+
+    if( in_threads == 0U )
+        in_threads = std::max( 1U, std::thread::hardware_concurrency() );
+    const char* begin = file.data();
+    const char* end = begin + file.size();
+    if( in_threads == 1U || file.size() < MIN_CHUNK_SIZE ) {
+        ParseMesh( begin, end, out_mesh );
+        return FacesInRange( *out_mesh );
+    }
+
+    // Split at newline boundaries.
+    size_t chunkCount = std::min< size_t >( in_threads * CHUNKS_PER_THREAD,
+        file.size() / ( MIN_CHUNK_SIZE / CHUNKS_PER_THREAD ) );
+    chunkCount = std::max< size_t >( chunkCount, 1U );
+    std::vector< const char* > bounds( 1U, begin );
+    for( size_t chunk = 1U; chunk < chunkCount; chunk += 1U ) {
+        const char* split = begin + file.size() * chunk / chunkCount;
+        if( split < bounds.back() )
+            split = bounds.back();
+        const char* newline = static_cast<const char*>(
+            memchr( split, '\n', (size_t)( end - split ) ) );
+        if( newline == NULL )
+            break;
+        bounds.push_back( newline + 1 );
+    }
+    bounds.push_back( end );
+    chunkCount = bounds.size() - 1U;
+
+    // Count, then parse each chunk knowing the records before it, which
+    // relative face indices count back from.
+    std::vector< MeshCounts > counts( chunkCount ), before( chunkCount );
+    RunParallel( in_threads, chunkCount, [ &bounds, &counts ]( const size_t chunk ) {
+        CountMesh( bounds[ chunk ], bounds[ chunk + 1U ], &counts[ chunk ] );
+    } );
+    const MeshCounts start = { out_mesh->v.size(), out_mesh->vn.size(), out_mesh->vt.size(), out_mesh->f.size() };
+    before[ 0 ] = start;
+    for( size_t chunk = 1U; chunk < chunkCount; chunk += 1U ) {
+        before[ chunk ].v = before[ chunk - 1U ].v + counts[ chunk - 1U ].v;
+        before[ chunk ].vn = before[ chunk - 1U ].vn + counts[ chunk - 1U ].vn;
+        before[ chunk ].vt = before[ chunk - 1U ].vt + counts[ chunk - 1U ].vt;
+        before[ chunk ].f = before[ chunk - 1U ].f + counts[ chunk - 1U ].f;
+    }
+    std::vector< Mesh > parts( chunkCount );
+    RunParallel( in_threads, chunkCount, [ & ]( const size_t chunk ) {
+        ParseCounted( bounds[ chunk ], bounds[ chunk + 1U ], counts[ chunk ], before[ chunk ], &parts[ chunk ] );
+    } );
+
+    // Merge in file order; every chunk copies into its own slice.
+    std::vector< size_t > v( chunkCount + 1U, 0U ), vn( v ), vt( v ), f( v );
+    v[ 0 ] = out_mesh->v.size();
+    vn[ 0 ] = out_mesh->vn.size();
+    vt[ 0 ] = out_mesh->vt.size();
+    f[ 0 ] = out_mesh->f.size();
+    for( size_t chunk = 0U; chunk < chunkCount; chunk += 1U ) {
+        v[ chunk + 1U ] = v[ chunk ] + parts[ chunk ].v.size();
+        vn[ chunk + 1U ] = vn[ chunk ] + parts[ chunk ].vn.size();
+        vt[ chunk + 1U ] = vt[ chunk ] + parts[ chunk ].vt.size();
+        f[ chunk + 1U ] = f[ chunk ] + parts[ chunk ].f.size();
+    }
+    out_mesh->v.resize( v[ chunkCount ] );
+    out_mesh->vn.resize( vn[ chunkCount ] );
+    out_mesh->vt.resize( vt[ chunkCount ] );
+    out_mesh->f.resize( f[ chunkCount ] );
+    RunParallel( in_threads, chunkCount, [ & ]( const size_t chunk ) {
+        CopyInto( parts[ chunk ].v, &out_mesh->v, v[ chunk ] );
+        CopyInto( parts[ chunk ].vn, &out_mesh->vn, vn[ chunk ] );
+        CopyInto( parts[ chunk ].vt, &out_mesh->vt, vt[ chunk ] );
+        CopyInto( parts[ chunk ].f, &out_mesh->f, f[ chunk ] );
+    } );
+    return FacesInRange( *out_mesh );
+}
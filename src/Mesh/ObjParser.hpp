@@ -0,0 +1,52 @@
+#ifndef __OBJ_PARSER__
+#define __OBJ_PARSER__
+
+#include "util.h"
+
+/*
+Zero-copy Wavefront OBJ loader.
+The file is mapped into memory and tokenized in place; no line or token is
+copied into a std::string. The resulting Mesh is identical to FileLoadMesh(),
+except that negative face indices are resolved, where FileLoadMesh() keeps
+them as wrapped unsigned values.
+*/
+
+// Records of each kind in a range of OBJ text.
+struct MeshCounts {
+    size_t  v;
+    size_t  vn;
+    size_t  vt;
+    size_t  f;
+};
+
+// Count the records of [in_begin, in_end) without parsing their values.
+void CountMesh( const char* in_begin, const char* in_end, MeshCounts* out_counts );
+
+// Parse OBJ text in [in_begin, in_end) and append records to out_mesh.
+// A counting pass sizes the arrays first, so they never reallocate.
+// Negative (relative) face indices are made absolute against the records
+// already in out_mesh and those read since. The range does not need to be
+// null-terminated.
+void ParseMesh( const char* in_begin, const char* in_end, Mesh* out_mesh );
+
+// True when every face corner references a vertex of in_mesh. A missing
+// corner, or a relative index counting back past the first vertex, reads
+// as 0 and fails.
+bool FacesInRange( const Mesh& in_mesh );
+
+// Map in_fileName and parse it. Return false if the file cannot be opened
+// or fails FacesInRange().
+bool FileMapMesh( const char* in_fileName, Mesh* out_mesh );
+
+/*
+Map in_fileName, split it at line boundaries and parse the chunks on
+in_threads worker threads (0 picks the hardware concurrency). The chunks are
+merged in file order, so the Mesh is identical to FileMapMesh().
+Negative face indices count back from the last record read; each chunk is
+counted first, so a chunk resolves them against every record before it.
+Fails as FileMapMesh() does.
+*/
+bool FileMapMeshParallel( const char* in_fileName, Mesh* out_mesh,
+    unsigned int in_threads = 0U );
+
+#endif
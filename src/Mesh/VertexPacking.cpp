@@ -0,0 +1,130 @@
+#include "VertexPacking.hpp"
+
+#include <cmath>
+#include <algorithm>
+
+namespace {
+
+const float POSITION_STEPS = 65535.f;
+const float COLOR_STEPS = 255.f;
+const float NORMAL_STEPS = 32767.f;
+
+float Clamp( const float in_value, const float in_low, const float in_high ) {
+    return std::min( std::max( in_value, in_low ), in_high );
+}
+
+float SignNotZero( const float in_value ) {
+    return in_value >= 0.f ? 1.f : -1.f;
+}
+
+// Fold the lower hemisphere of the octahedron over the upper one; the
+// mapping is its own inverse.
+void Fold( float* io_x, float* io_y ) {
+    const float x = *io_x, y = *io_y;
+    *io_x = ( 1.f - std::abs( y ) ) * SignNotZero( x );
+    *io_y = ( 1.f - std::abs( x ) ) * SignNotZero( y );
+}
+
+}
+
+const void* PackedMesh::indexData( void ) const {
+    if( indexSize == 2U )
+        return shortIndicies.empty() ? NULL : &shortIndicies[ 0 ];
+    return longIndicies.empty() ? NULL : &longIndicies[ 0 ];
+}
+
+size_t PackedMesh::indexBytes( void ) const {
+    return indexSize == 2U ? sizeof(unsigned short) * shortIndicies.size() : sizeof(AIndex) * longIndicies.size();
+}
+
+PositionDecode MakePositionDecode( const MeshVolume& in_volume ) {
+    PositionDecode decode;
+    for( unsigned int axis = 0U; axis < 3U; axis += 1U ) {
+        decode.offset[ axis ] = in_volume.min[ axis ];
+        decode.scale[ axis ] = in_volume.max[ axis ] - in_volume.min[ axis ];
+    }
+    return decode;
+}
+
+void PackPositions( const AVertex* in_verticies, const unsigned int in_count, const PositionDecode& in_decode,
+    std::vector< PVertex >* out_verticies ) {
+    out_verticies->resize( in_count );
+    float inverse[ 3 ];
+    for( unsigned int axis = 0U; axis < 3U; axis += 1U )
+        inverse[ axis ] = in_decode.scale[ axis ] > 0.f ? 1.f / in_decode.scale[ axis ] : 0.f;
+    for( unsigned int index = 0U; index < in_count; index += 1U ) {
+        const float* position = &in_verticies[ index ].x;
+        unsigned short* packed = &( *out_verticies )[ index ].x;
+        for( unsigned int axis = 0U; axis < 3U; axis += 1U ) {
+            const float unit = Clamp( ( position[ axis ] - in_decode.offset[ axis ] ) * inverse[ axis ], 0.f, 1.f );
+            packed[ axis ] = (unsigned short)( unit * POSITION_STEPS + 0.5f );
+        }
+        packed[ 3 ] = (unsigned short)POSITION_STEPS;
+    }
+}
+
+void UnpackPosition( const PVertex& in_vertex, const PositionDecode& in_decode, float out_position[ 3 ] ) {
+    const unsigned short* packed = &in_vertex.x;
+    for( unsigned int axis = 0U; axis < 3U; axis += 1U )
+        out_position[ axis ] = in_decode.offset[ axis ] + in_decode.scale[ axis ] * ( packed[ axis ] / POSITION_STEPS );
+}
+
+void PackColors( const AColor* in_colors, const unsigned int in_count, std::vector< PColor >* out_colors ) {
+    out_colors->resize( in_count );
+    for( unsigned int index = 0U; index < in_count; index += 1U ) {
+        const float* color = &in_colors[ index ].r;
+        unsigned char* packed = &( *out_colors )[ index ].r;
+        for( unsigned int channel = 0U; channel < 4U; channel += 1U )
+            packed[ channel ] = (unsigned char)( Clamp( color[ channel ], 0.f, 1.f ) * COLOR_STEPS + 0.5f );
+    }
+}
+
+void UnpackColor( const PColor& in_color, float out_color[ 4 ] ) {
+    const unsigned char* packed = &in_color.r;
+    for( unsigned int channel = 0U; channel < 4U; channel += 1U )
+        out_color[ channel ] = packed[ channel ] / COLOR_STEPS;
+}
+
+void PackNormal( const float in_normal[ 3 ], PNormal* out_normal ) {
+    const float length = std::abs( in_normal[ 0 ] ) + std::abs( in_normal[ 1 ] ) + std::abs( in_normal[ 2 ] );
+    float x = length > 0.f ? in_normal[ 0 ] / length : 0.f,
+        y = length > 0.f ? in_normal[ 1 ] / length : 0.f;
+    if( in_normal[ 2 ] < 0.f )
+        Fold( &x, &y );
+    out_normal->x = (short)std::floor( Clamp( x, -1.f, 1.f ) * NORMAL_STEPS + 0.5f );
+    out_normal->y = (short)std::floor( Clamp( y, -1.f, 1.f ) * NORMAL_STEPS + 0.5f );
+}
+
+void UnpackNormal( const PNormal& in_normal, float out_normal[ 3 ] ) {
+    // Signed normalized: -32768 and -32767 both read -1.
+    float x = std::max( in_normal.x / NORMAL_STEPS, -1.f ), y = std::max( in_normal.y / NORMAL_STEPS, -1.f );
+    const float z = 1.f - std::abs( x ) - std::abs( y );
+    if( z < 0.f )
+        Fold( &x, &y );
+    const float length = std::sqrt( x * x + y * y + z * z );
+    out_normal[ 0 ] = x / length;
+    out_normal[ 1 ] = y / length;
+    out_normal[ 2 ] = z / length;
+}
+
+void PackMesh( const App::MeshBuffer& in_mesh, PackedMesh* out_mesh ) {
+    PackMesh( in_mesh.verticies(), in_mesh.colors(), in_mesh.vertexCount(), in_mesh.indicies(), in_mesh.faceCount(),
+        in_mesh.volume(), out_mesh );
+}
+
+void PackMesh( const AVertex* in_verticies, const AColor* in_colors, const unsigned int in_vertexCount,
+    const AIndex* in_indicies, const unsigned int in_faceCount, const MeshVolume& in_volume, PackedMesh* out_mesh ) {
+    out_mesh->decode = MakePositionDecode( in_volume );
+    PackPositions( in_verticies, in_vertexCount, out_mesh->decode, &out_mesh->verticies );
+    PackColors( in_colors, in_vertexCount, &out_mesh->colors );
+    out_mesh->shortIndicies.clear();
+    out_mesh->longIndicies.clear();
+    if( in_vertexCount <= SHORT_INDEX_LIMIT ) {
+        out_mesh->indexSize = 2U;
+        const unsigned int* corners = reinterpret_cast< const unsigned int* >( in_indicies );
+        out_mesh->shortIndicies.assign( corners, corners + 3U * in_faceCount );
+    } else {
+        out_mesh->indexSize = 4U;
+        out_mesh->longIndicies.assign( in_indicies, in_indicies + in_faceCount );
+    }
+}
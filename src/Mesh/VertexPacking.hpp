@@ -0,0 +1,74 @@
+#ifndef __VERTEX_PACKING__
+#define __VERTEX_PACKING__
+
+#include <stddef.h>
+#include <vector>
+
+#include "MeshBuffer.hpp"
+
+/*
+Compressed vertex and index formats for upload.
+Positions are quantized to 16 bits per axis across the mesh's bounding box
+and read as normalized unsigned shorts; the shader maps [ 0, 1 ] back with
+the box (see PositionDecode). Colors become normalized RGBA8 and indices
+16 bits whenever every vertex can be addressed. Normals, for meshes that
+carry them, use the octahedral mapping into two signed 16-bit values.
+
+AVertex and AColor take 28 bytes per vertex; PVertex and PColor take 12.
+*/
+
+// x, y, z in [ 0, 65535 ] across the box; w is always 65535 so the
+// normalized attribute reads 1.
+struct PVertex {
+    unsigned short  x, y, z, w;
+};
+struct PColor {
+    unsigned char   r, g, b, a;
+};
+// Octahedral unit vector, both components normalized to [ -1, 1 ].
+struct PNormal {
+    short           x, y;
+};
+
+// Object position = offset + scale * normalized attribute.
+struct PositionDecode {
+    float           offset[ 3 ];
+    float           scale[ 3 ];
+};
+
+// A mesh ready for glBufferData in packed formats.
+struct PackedMesh {
+    std::vector< PVertex >          verticies;
+    std::vector< PColor >           colors;
+    std::vector< unsigned short >   shortIndicies;  // Used when indexSize is 2.
+    std::vector< AIndex >           longIndicies;   // Used when indexSize is 4.
+    unsigned int                    indexSize;      // Bytes per index.
+    PositionDecode                  decode;
+
+    const void* indexData( void ) const;
+    size_t indexBytes( void ) const;
+};
+
+// Largest vertex count 16-bit indices can address.
+static const unsigned int SHORT_INDEX_LIMIT = 65536U;
+
+PositionDecode MakePositionDecode( const MeshVolume& in_volume );
+void PackPositions( const AVertex* in_verticies, const unsigned int in_count, const PositionDecode& in_decode,
+    std::vector< PVertex >* out_verticies );
+void UnpackPosition( const PVertex& in_vertex, const PositionDecode& in_decode, float out_position[ 3 ] );
+
+// Components are clamped to [ 0, 1 ].
+void PackColors( const AColor* in_colors, const unsigned int in_count, std::vector< PColor >* out_colors );
+void UnpackColor( const PColor& in_color, float out_color[ 4 ] );
+
+void PackNormal( const float in_normal[ 3 ], PNormal* out_normal );
+void UnpackNormal( const PNormal& in_normal, float out_normal[ 3 ] );
+
+// Pack every array of in_mesh. Indices are copied as they are when the
+// vertex count exceeds SHORT_INDEX_LIMIT.
+void PackMesh( const App::MeshBuffer& in_mesh, PackedMesh* out_mesh );
+// Same for loose arrays.
+void PackMesh( const AVertex* in_verticies, const AColor* in_colors, const unsigned int in_vertexCount,
+    const AIndex* in_indicies, const unsigned int in_faceCount, const MeshVolume& in_volume, PackedMesh* out_mesh );
+
+#endif
@@ -0,0 +1,121 @@
+#include "PhysicsMesh.hpp"
+#include "MeshCache.hpp"
+
+#include <string.h>
+#include <stdint.h>
+#include <fstream>
+
+namespace {
+
+const char BVH_MAGIC[ 8 ] = { 'B', 'T', 'Q', 'B', 'V', 'H', '0', '1' };
+
+// Serialized BVH file: this header, then btOptimizedBvh::serializeInPlace() output.
+struct BvhFileHeader {
+    char        magic[ 8 ];
+    uint64_t    geometryHash;
+    uint64_t    size;
+};
+
+}
+
+App::PhysicsMesh::PhysicsMesh( const MeshBuffer& in_mesh, const unsigned int in_lod ) {
+    const MeshLod& lod = in_mesh.lods()[ in_lod < in_mesh.lodCount() ? in_lod : 0U ];
+    _part.m_numTriangles = (int)lod.faceCount;
+    _part.m_triangleIndexBase = reinterpret_cast<const unsigned char*>( in_mesh.indicies() + lod.firstFace );
+    _part.m_triangleIndexStride = sizeof(AIndex);
+    _part.m_indexType = PHY_INTEGER;
+    _part.m_numVertices = (int)in_mesh.vertexCount();
+    _part.m_vertexBase = reinterpret_cast<const unsigned char*>( in_mesh.verticies() );
+    _part.m_vertexStride = sizeof(AVertex);
+    _part.m_vertexType = PHY_FLOAT;
+    _array.addIndexedMesh( _part, PHY_INTEGER );
+}
+
+App::PhysicsMesh::~PhysicsMesh( void ) {
+    for( size_t index = 0U; index < _bvhBuffers.size(); index += 1U )
+        btAlignedFree( _bvhBuffers[ index ] );
+}
+
+btBvhTriangleMeshShape* App::PhysicsMesh::createStaticShape( const char* in_bvhFileName ) {
+    btBvhTriangleMeshShape* shape = NULL;
+    if( in_bvhFileName != NULL && loadBvh( in_bvhFileName, &shape ) == true )
+        return shape;
+    // Quantized AABB compression keeps BVH nodes at 16 bytes.
+    shape = new btBvhTriangleMeshShape( &_array, true, true );
+    if( in_bvhFileName != NULL )
+        saveBvh( in_bvhFileName, shape );
+    return shape;
+}
+
+btGImpactMeshShape* App::PhysicsMesh::createDynamicShape( void ) {
+    btGImpactMeshShape* shape = new btGImpactMeshShape( &_array );
+    shape->updateBound();
+    return shape;
+}
+
+btStridingMeshInterface* App::PhysicsMesh::meshInterface( void ) {
+    return &_array;
+}
+
+size_t App::PhysicsMesh::sharedBytes( void ) const {
+    return (size_t)_part.m_numVertices * _part.m_vertexStride
+        + (size_t)_part.m_numTriangles * _part.m_triangleIndexStride;
+}
+
+unsigned long long App::PhysicsMesh::geometryHash( void ) const {
+    const uint64_t vertexHash = Checksum64( _part.m_vertexBase,
+        (size_t)_part.m_numVertices * _part.m_vertexStride );
+    const uint64_t indexHash = Checksum64( _part.m_triangleIndexBase,
+        (size_t)_part.m_numTriangles * _part.m_triangleIndexStride );
+    return vertexHash ^ ( indexHash * 0x9e3779b97f4a7c15ULL );
+}
+
+bool App::PhysicsMesh::loadBvh( const char* in_fileName, btBvhTriangleMeshShape** out_shape ) {
+    std::ifstream file( in_fileName, std::ios::binary );
+    BvhFileHeader header;
+    if( file.read( reinterpret_cast<char*>( &header ), sizeof( header ) ).good() == false
+        || memcmp( header.magic, BVH_MAGIC, sizeof( BVH_MAGIC ) ) != 0
+        || header.geometryHash != geometryHash() )
+        return false;
+
+    // deSerializeInPlace() fixes pointers up inside the buffer, so the buffer
+    // must be 16-byte aligned, writable and alive as long as the shape.
+    void* buffer = btAlignedAlloc( (size_t)header.size, 16 );
+    if( file.read( static_cast<char*>( buffer ), (std::streamsize)header.size ).good() == false ) {
+        btAlignedFree( buffer );
+        return false;
+    }
+    btOptimizedBvh* bvh = btOptimizedBvh::deSerializeInPlace( buffer, (unsigned int)header.size, false );
+    if( bvh == NULL ) {
+        btAlignedFree( buffer );
+        return false;
+    }
+    _bvhBuffers.push_back( buffer );
+
+    btBvhTriangleMeshShape* shape = new btBvhTriangleMeshShape( &_array, true, false );
+    shape->setOptimizedBvh( bvh );
+    *out_shape = shape;
+    return true;
+}
+
+bool App::PhysicsMesh::saveBvh( const char* in_fileName, btBvhTriangleMeshShape* in_shape ) const {
+    btOptimizedBvh* bvh = in_shape->getOptimizedBvh();
+    if( bvh == NULL )
+        return false;
+    BvhFileHeader header;
+    memcpy( header.magic, BVH_MAGIC, sizeof( BVH_MAGIC ) );
+    header.geometryHash = geometryHash();
+    header.size = bvh->calculateSerializeBufferSize();
+
+    void* buffer = btAlignedAlloc( (size_t)header.size, 16 );
+    const bool serialized = bvh->serializeInPlace( buffer, (unsigned int)header.size, false );
+    bool written = false;
+    if( serialized == true ) {
+        std::ofstream file( in_fileName, std::ios::binary | std::ios::trunc );
+        file.write( reinterpret_cast<const char*>( &header ), sizeof( header ) );
+        file.write( static_cast<const char*>( buffer ), (std::streamsize)header.size );
+        written = file.good();
+    }
+    btAlignedFree( buffer );
+    return written;
+}
@@ -0,0 +1,56 @@
+#ifndef __PHYSICS_MESH__
+#define __PHYSICS_MESH__
+
+#include <vector>
+
+#include "btBulletCollisionCommon.h"
+#include "BulletCollision/Gimpact/btGImpactShape.h"
+
+#include "MeshBuffer.hpp"
+
+namespace App {
+
+/*
+Bullet view of a MeshBuffer.
+btTriangleIndexVertexArray only points at the vertex and index arrays the
+renderer uploads, so render and physics share one copy of the geometry.
+The MeshBuffer must outlive this object and every shape created from it.
+*/
+class PhysicsMesh {
+public:
+    // Wrap level in_lod of in_mesh; coarser levels make cheaper colliders.
+    explicit PhysicsMesh( const MeshBuffer& in_mesh, const unsigned int in_lod = 0U );
+    ~PhysicsMesh( void );
+
+    /*
+    Static triangle mesh with a quantized BVH. When in_bvhFileName is given
+    the BVH is restored from that file if it matches the mesh, and written
+    there after a fresh build otherwise.
+    */
+    btBvhTriangleMeshShape* createStaticShape( const char* in_bvhFileName = NULL );
+    // Concave shape for moving bodies. The world's dispatcher must have
+    // btGImpactCollisionAlgorithm registered.
+    btGImpactMeshShape* createDynamicShape( void );
+
+    btStridingMeshInterface* meshInterface( void );
+    // Bytes of geometry referenced, not owned.
+    size_t sharedBytes( void ) const;
+
+private:
+    PhysicsMesh( const PhysicsMesh& );
+    PhysicsMesh& operator=( const PhysicsMesh& );
+
+    bool loadBvh( const char* in_fileName, btBvhTriangleMeshShape** out_shape );
+    bool saveBvh( const char* in_fileName, btBvhTriangleMeshShape* in_shape ) const;
+    unsigned long long geometryHash( void ) const;
+
+private:
+    btIndexedMesh                   _part;
+    btTriangleIndexVertexArray      _array;
+    // Deserialized BVHs live inside these buffers.
+    std::vector< void* >            _bvhBuffers;
+};
+
+}
+
+#endif
@@ -0,0 +1,136 @@
+#include "PhysicsThread.hpp"
+#include "Profiler.hpp"
+
+#include <cmath>
+
+namespace {
+
+// Steps recorded for jitter statistics before the record wraps.
+const size_t MAX_RECORDED_STEPS = 1U << 20;
+// When the simulation falls this many steps behind, drop the backlog
+// instead of spiralling.
+const unsigned int MAX_STEPS_BEHIND = 5U;
+
+void Interpolate( const App::BodyTransform& in_from, const App::BodyTransform& in_to,
+    const float in_alpha, App::BodyTransform* out_transform ) {
+    for( unsigned int axis = 0U; axis < 3U; axis += 1U )
+        out_transform->position[ axis ] = in_from.position[ axis ]
+            + ( in_to.position[ axis ] - in_from.position[ axis ] ) * in_alpha;
+
+    // Normalized lerp along the shorter arc; close enough to slerp for the
+    // small rotation of one step.
+    float dot = 0.f;
+    for( unsigned int axis = 0U; axis < 4U; axis += 1U )
+        dot += in_from.rotation[ axis ] * in_to.rotation[ axis ];
+    const float sign = dot < 0.f ? -1.f : 1.f;
+    float length = 0.f;
+    for( unsigned int axis = 0U; axis < 4U; axis += 1U ) {
+        out_transform->rotation[ axis ] = in_from.rotation[ axis ]
+            + ( sign * in_to.rotation[ axis ] - in_from.rotation[ axis ] ) * in_alpha;
+        length += out_transform->rotation[ axis ] * out_transform->rotation[ axis ];
+    }
+    length = std::sqrt( length );
+    for( unsigned int axis = 0U; axis < 4U; axis += 1U )
+        out_transform->rotation[ axis ] /= length;
+}
+
+}
+
+App::PhysicsThread::PhysicsThread( PhysicsWorld* in_world, const double in_stepRate )
+    : _world( in_world ), _stepInterval( 1.0 / in_stepRate ), _running( false ) {}
+
+App::PhysicsThread::~PhysicsThread( void ) {
+    stop();
+}
+
+void App::PhysicsThread::start( void ) {
+    if( _running == true )
+        return;
+    _stepStarts.clear();
+    _stepDurations.clear();
+    _stepStarts.reserve( MAX_RECORDED_STEPS );
+    _stepDurations.reserve( MAX_RECORDED_STEPS );
+    _running = true;
+    _thread = std::thread( &PhysicsThread::run, this );
+}
+
+void App::PhysicsThread::stop( void ) {
+    if( _running == false )
+        return;
+    _running = false;
+    _thread.join();
+}
+
+void App::PhysicsThread::run( void ) {
+    PROFILE_THREAD( "physics" );
+    const Clock::duration interval = std::chrono::duration_cast< Clock::duration >(
+        std::chrono::duration< double >( _stepInterval ) );
+    _startTime = Clock::now();
+    Clock::time_point next = _startTime;
+    std::vector< BodyTransform > last;
+    _world->readTransforms( &last );
+    unsigned long long step = 0U;
+
+    while( _running == true ) {
+        const Clock::time_point begin = Clock::now();
+        {
+            PROFILE_SCOPE( "physics_step" );
+            _world->step( (btScalar)_stepInterval );
+        }
+        const Clock::time_point end = Clock::now();
+        if( _stepStarts.size() < MAX_RECORDED_STEPS ) {
+            _stepStarts.push_back( std::chrono::duration< double >( begin - _startTime ).count() );
+            _stepDurations.push_back( std::chrono::duration< double >( end - begin ).count() );
+        }
+
+        next += interval;
+        step += 1U;
+        {
+            PROFILE_SCOPE( "physics_publish" );
+            Snapshot& snapshot = _snapshots.writeBuffer();
+            snapshot.time = next;
+            snapshot.step = step;
+            snapshot.previous.swap( last );
+            _world->readTransforms( &snapshot.current );
+            last = snapshot.current;
+            _snapshots.publish();
+        }
+
+        const Clock::time_point now = Clock::now();
+        if( now - next > interval * MAX_STEPS_BEHIND )
+            next = now;
+        std::this_thread::sleep_until( next );
+    }
+}
+
+bool App::PhysicsThread::read( const Clock::time_point in_time, std::vector< BodyTransform >* out_transforms ) {
+    _snapshots.update();
+    const Snapshot& snapshot = _snapshots.readBuffer();
+    if( snapshot.step == 0U )
+        return false;
+
+    // current is the state due at snapshot.time and previous the one due an
+    // interval earlier. Steps run ahead of their due time, so in_time
+    // normally falls between the two.
+    const double late = std::chrono::duration< double >( in_time - snapshot.time ).count();
+    float alpha = (float)( late / _stepInterval ) + 1.f;
+    alpha = alpha < 0.f ? 0.f : ( alpha > 1.f ? 1.f : alpha );
+
+    out_transforms->resize( snapshot.current.size() );
+    for( size_t index = 0U; index < snapshot.current.size(); index += 1U ) {
+        const BodyTransform& from = index < snapshot.previous.size()
+            ? snapshot.previous[ index ] : snapshot.current[ index ];
+        Interpolate( from, snapshot.current[ index ], alpha, &( *out_transforms )[ index ] );
+    }
+    return true;
+}
+
+double App::PhysicsThread::stepInterval( void ) const {
+    return _stepInterval;
+}
+const std::vector< double >& App::PhysicsThread::stepStarts( void ) const {
+    return _stepStarts;
+}
+const std::vector< double >& App::PhysicsThread::stepDurations( void ) const {
+    return _stepDurations;
+}
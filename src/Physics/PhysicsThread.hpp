@@ -0,0 +1,72 @@
+#ifndef __PHYSICS_THREAD__
+#define __PHYSICS_THREAD__
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "PhysicsWorld.hpp"
+#include "TripleBuffer.hpp"
+
+namespace App {
+
+/*
+Steps a PhysicsWorld at a fixed rate on its own thread.
+After every step the body transforms are published through a triple buffer;
+the render thread reads the newest pair of steps and interpolates between
+them without ever blocking the simulation.
+Bodies must be added before start() and the world must not be touched
+from another thread until stop().
+*/
+class PhysicsThread {
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    explicit PhysicsThread( PhysicsWorld* in_world, const double in_stepRate = 60.0 );
+    ~PhysicsThread( void );
+
+    void start( void );
+    void stop( void );
+
+    /*
+    Render side: transforms interpolated for in_time. The simulation runs up
+    to one step ahead of the wall clock, so in_time falls between the two
+    newest steps. Return false until the first step is published.
+    */
+    bool read( const Clock::time_point in_time, std::vector< BodyTransform >* out_transforms );
+
+    double stepInterval( void ) const;
+    // Start time and duration of every step, in seconds since start().
+    // Only valid after stop().
+    const std::vector< double >& stepStarts( void ) const;
+    const std::vector< double >& stepDurations( void ) const;
+
+private:
+    PhysicsThread( const PhysicsThread& );
+    PhysicsThread& operator=( const PhysicsThread& );
+
+    void run( void );
+
+    struct Snapshot {
+        Snapshot( void ) : step( 0U ) {}
+        Clock::time_point               time;       // When current is due.
+        unsigned long long              step;
+        std::vector< BodyTransform >    previous;
+        std::vector< BodyTransform >    current;
+    };
+
+private:
+    PhysicsWorld*               _world;
+    const double                _stepInterval;
+    std::thread                 _thread;
+    std::atomic< bool >         _running;
+    TripleBuffer< Snapshot >    _snapshots;
+    Clock::time_point           _startTime;
+    std::vector< double >       _stepStarts;
+    std::vector< double >       _stepDurations;
+};
+
+}
+
+#endif
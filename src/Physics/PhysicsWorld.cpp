@@ -0,0 +1,218 @@
+#include "PhysicsWorld.hpp"
+#include "SpatialHashBroadphase.hpp"
+
+#include "BulletCollision/CollisionDispatch/btCollisionDispatcherMt.h"
+#include "BulletDynamics/ConstraintSolver/btSequentialImpulseConstraintSolverMt.h"
+#include "BulletDynamics/Dynamics/btDiscreteDynamicsWorldMt.h"
+#include "LinearMath/btThreads.h"
+
+// btSequentialImpulseConstraintSolverMt, and the btDiscreteDynamicsWorldMt
+// constructor taking it, first shipped in Bullet 2.88.
+#if BT_BULLET_VERSION < 288
+#error "Bullet 2.88 or newer is required; make bullet checks out BULLET_TAG"
+#endif
+
+namespace {
+
+// Manifolds and collision algorithms of a multithreaded world come from
+// pools shared by every thread; past these sizes they fall back to the heap.
+const int MT_POOL_SIZE = 80000;
+// Pairs per narrowphase task.
+const int MT_DISPATCH_GRAIN = 40;
+// Most proxies btAxisSweep3 can index with its 16 bit handles.
+const unsigned int SWEEP_MAX_PROXIES = 32766U;
+
+// Bullet's schedulers live as long as the process. Without BT_THREADSAFE,
+// or BT_USE_OPENMP for OpenMP, Bullet returns none.
+btITaskScheduler* TaskScheduler( const App::PhysicsScheduler in_scheduler ) {
+    static btITaskScheduler* pool = NULL;
+    switch( in_scheduler ) {
+    case App::SchedulerPool:
+        if( pool == NULL )
+            pool = btCreateDefaultTaskScheduler();
+        return pool;
+    case App::SchedulerOpenMP:
+        return btGetOpenMPTaskScheduler();
+    default:
+        return NULL;
+    }
+}
+
+}
+
+bool App::PhysicsSchedulerAvailable( const PhysicsScheduler in_scheduler ) {
+    return TaskScheduler( in_scheduler ) != NULL;
+}
+
+unsigned int App::PhysicsMaxThreads( const PhysicsScheduler in_scheduler ) {
+    btITaskScheduler* scheduler = TaskScheduler( in_scheduler );
+    return scheduler != NULL ? (unsigned int)scheduler->getMaxNumThreads() : 1U;
+}
+
+App::BroadphaseOptions::BroadphaseOptions( void )
+    : type( BroadphaseTree ), maxProxies( 16384U ), cellSize( 2.f ) {
+    for( int axis = 0; axis < 3; axis += 1 ) {
+        worldMin[ axis ] = -1000.f;
+        worldMax[ axis ] = 1000.f;
+    }
+}
+
+btBroadphaseInterface* App::CreateBroadphase( const BroadphaseOptions& in_options ) {
+    const btVector3 worldMin( in_options.worldMin[ 0 ], in_options.worldMin[ 1 ], in_options.worldMin[ 2 ] );
+    const btVector3 worldMax( in_options.worldMax[ 0 ], in_options.worldMax[ 1 ], in_options.worldMax[ 2 ] );
+    switch( in_options.type ) {
+    case BroadphaseSweep:
+        // Too many proxies for 16 bit handles takes the 32 bit sweep.
+        if( in_options.maxProxies <= SWEEP_MAX_PROXIES )
+            return new btAxisSweep3( worldMin, worldMax, (unsigned short)in_options.maxProxies );
+        return new bt32BitAxisSweep3( worldMin, worldMax, in_options.maxProxies );
+    case BroadphaseSweep32:
+        return new bt32BitAxisSweep3( worldMin, worldMax, in_options.maxProxies );
+    case BroadphaseHash:
+        return new SpatialHashBroadphase( in_options.cellSize );
+    default:
+        return new btDbvtBroadphase();
+    }
+}
+
+App::PhysicsWorld::PhysicsWorld( const PhysicsScheduler in_scheduler, const unsigned int in_threads,
+    const BroadphaseOptions& in_broadphase )
+    : _broadphaseType( in_broadphase.type ), _islandSolver( NULL ), _scheduler( SchedulerNone ), _threads( 1U ) {
+    _broadphase = CreateBroadphase( in_broadphase );
+    if( PhysicsSchedulerAvailable( in_scheduler ) == true ) {
+        const unsigned int maxThreads = PhysicsMaxThreads( in_scheduler );
+        _scheduler = in_scheduler;
+        _threads = in_threads == 0U || in_threads > maxThreads ? maxThreads : in_threads;
+        btDefaultCollisionConstructionInfo info;
+        info.m_defaultMaxPersistentManifoldPoolSize = MT_POOL_SIZE;
+        info.m_defaultMaxCollisionAlgorithmPoolSize = MT_POOL_SIZE;
+        _configuration = new btDefaultCollisionConfiguration( info );
+        _dispatcher = new btCollisionDispatcherMt( _configuration, MT_DISPATCH_GRAIN );
+        // One island solver per thread, and a parallel one for islands too
+        // large to leave to a single thread.
+        btConstraintSolverPoolMt* solverPool = new btConstraintSolverPoolMt( (int)_threads );
+        _solver = solverPool;
+        _islandSolver = new btSequentialImpulseConstraintSolverMt();
+        _world = new btDiscreteDynamicsWorldMt( _dispatcher, _broadphase, solverPool, _islandSolver, _configuration );
+    } else {
+        _configuration = new btDefaultCollisionConfiguration();
+        _dispatcher = new btCollisionDispatcher( _configuration );
+        _solver = new btSequentialImpulseConstraintSolver();
+        _world = new btDiscreteDynamicsWorld( _dispatcher, _broadphase, _solver, _configuration );
+    }
+    _world->setGravity( btVector3( 0.f, -9.8f, 0.f ) );
+}
+
+App::PhysicsWorld::~PhysicsWorld( void ) {
+    clear();
+    delete _world;
+    delete _islandSolver;
+    delete _solver;
+    delete _broadphase;
+    delete _dispatcher;
+    delete _configuration;
+}
+
+btRigidBody* App::PhysicsWorld::addBody( btCollisionShape* in_shape, const btScalar in_mass,
+    const btTransform& in_transform ) {
+    btVector3 inertia( 0.f, 0.f, 0.f );
+    if( in_mass != 0.f )
+        in_shape->calculateLocalInertia( in_mass, inertia );
+    btDefaultMotionState* motionState = new btDefaultMotionState( in_transform );
+    btRigidBody::btRigidBodyConstructionInfo info( in_mass, motionState, in_shape, inertia );
+    btRigidBody* body = new btRigidBody( info );
+    _world->addRigidBody( body );
+    _bodies.push_back( body );
+    return body;
+}
+
+void App::PhysicsWorld::adoptConstraint( btTypedConstraint* in_constraint ) {
+    _constraints.push_back( in_constraint );
+}
+
+void App::PhysicsWorld::clear( void ) {
+    // Constraints reference bodies, so they go first.
+    for( size_t index = _constraints.size(); index > 0U; index -= 1U ) {
+        _world->removeConstraint( _constraints[ index - 1U ] );
+        delete _constraints[ index - 1U ];
+    }
+    _constraints.clear();
+    for( size_t index = _bodies.size(); index > 0U; index -= 1U ) {
+        btRigidBody* body = _bodies[ index - 1U ];
+        _world->removeRigidBody( body );
+        delete body->getMotionState();
+        delete body;
+    }
+    _bodies.clear();
+}
+
+void App::PhysicsWorld::step( const btScalar in_timeStep ) {
+    if( _scheduler != SchedulerNone )
+        installScheduler();
+    // No sub-stepping: the caller already runs at a fixed rate.
+    _world->stepSimulation( in_timeStep, 0 );
+}
+
+void App::PhysicsWorld::resetCaches( void ) {
+    // Removing from the back keeps the world's object arrays in order.
+    // Without proxies the pair cache and manifolds are empty, and an empty
+    // broadphase resets its tree and counters.
+    for( size_t index = _bodies.size(); index > 0U; index -= 1U )
+        _world->removeRigidBody( _bodies[ index - 1U ] );
+    _broadphase->resetPool( _dispatcher );
+    _solver->reset();
+    for( size_t index = 0U; index < _bodies.size(); index += 1U ) {
+        // Adding a body gives it the world's gravity; keep its own.
+        btRigidBody* body = _bodies[ index ];
+        const btVector3 gravity = body->getGravity();
+        _world->addRigidBody( body );
+        body->setGravity( gravity );
+    }
+}
+
+void App::PhysicsWorld::readTransforms( std::vector< BodyTransform >* out_transforms ) const {
+    out_transforms->resize( _bodies.size() );
+    for( size_t index = 0U; index < _bodies.size(); index += 1U ) {
+        const btTransform& transform = _bodies[ index ]->getWorldTransform();
+        const btVector3& origin = transform.getOrigin();
+        const btQuaternion rotation = transform.getRotation();
+        BodyTransform& out = ( *out_transforms )[ index ];
+        out.position[ 0 ] = origin.x();
+        out.position[ 1 ] = origin.y();
+        out.position[ 2 ] = origin.z();
+        out.rotation[ 0 ] = rotation.x();
+        out.rotation[ 1 ] = rotation.y();
+        out.rotation[ 2 ] = rotation.z();
+        out.rotation[ 3 ] = rotation.w();
+    }
+}
+
+unsigned int App::PhysicsWorld::bodyCount( void ) const {
+    return (unsigned int)_bodies.size();
+}
+
+btDiscreteDynamicsWorld* App::PhysicsWorld::world( void ) {
+    return _world;
+}
+
+App::PhysicsBroadphase App::PhysicsWorld::broadphase( void ) const {
+    return _broadphaseType;
+}
+
+App::PhysicsScheduler App::PhysicsWorld::scheduler( void ) const {
+    return _scheduler;
+}
+
+unsigned int App::PhysicsWorld::threadCount( void ) const {
+    return _threads;
+}
+
+void App::PhysicsWorld::installScheduler( void ) {
+    // Worlds share the scheduler, so put back this one's thread count
+    // when another world changed it.
+    btITaskScheduler* scheduler = TaskScheduler( _scheduler );
+    if( btGetTaskScheduler() != scheduler )
+        btSetTaskScheduler( scheduler );
+    if( scheduler->getNumThreads() != (int)_threads )
+        scheduler->setNumThreads( (int)_threads );
+}
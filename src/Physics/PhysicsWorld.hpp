@@ -0,0 +1,128 @@
+#ifndef __PHYSICS_WORLD__
+#define __PHYSICS_WORLD__
+
+#include <vector>
+
+#include "btBulletDynamicsCommon.h"
+
+namespace App {
+
+// Rigid body pose copied out of Bullet for the renderer.
+struct BodyTransform {
+    float position[ 3 ];
+    float rotation[ 4 ];    // Quaternion x, y, z, w.
+};
+
+// Who runs the tasks of a multithreaded world: nobody (one thread), Bullet's
+// own thread pool, or OpenMP. Pool and OpenMP need Bullet built with
+// BT_THREADSAFE, OpenMP also with BT_USE_OPENMP; see BULLET_MT in the makefile.
+enum PhysicsScheduler {
+    SchedulerNone, SchedulerPool, SchedulerOpenMP
+};
+
+// Whether this build of Bullet has in_scheduler, and how many threads it
+// can run, the calling thread included.
+bool PhysicsSchedulerAvailable( const PhysicsScheduler in_scheduler );
+unsigned int PhysicsMaxThreads( const PhysicsScheduler in_scheduler );
+
+// How a world finds the pairs of bodies whose bounds overlap. The tree
+// (btDbvtBroadphase) needs no bounds and suits open worlds. Sweep and prune
+// (btAxisSweep3, or bt32BitAxisSweep3 past 32766 proxies) suits an arena
+// with bounds known up front; bodies outside them still collide, slowly.
+// The hash (SpatialHashBroadphase) suits many bodies of one size spread
+// evenly.
+enum PhysicsBroadphase {
+    BroadphaseTree, BroadphaseSweep, BroadphaseSweep32, BroadphaseHash
+};
+
+struct BroadphaseOptions {
+    BroadphaseOptions( void );
+
+    PhysicsBroadphase   type;
+    btScalar            worldMin[ 3 ];  // Sweep and prune: the arena.
+    btScalar            worldMax[ 3 ];
+    unsigned int        maxProxies;     // Sweep and prune: proxies allocated up front.
+    btScalar            cellSize;       // Hash: about the size of the larger bodies.
+};
+
+btBroadphaseInterface* CreateBroadphase( const BroadphaseOptions& in_options );
+
+/*
+Bullet dynamics world and the rigid bodies and constraints in it.
+Shapes are not owned: they must outlive the world.
+
+With a scheduler the world is a btDiscreteDynamicsWorldMt: narrowphase,
+islands and integration run in parallel, and islands too large for one
+thread are split by btSequentialImpulseConstraintSolverMt. Contacts are
+then found in a thread-dependent order, so runs are stable but not bit
+for bit repeatable. The scheduler is installed by the first step():
+Bullet numbers threads as they first use it and wants the stepping thread
+to be its first, so every multithreaded world must be stepped from that
+one thread.
+
+    App::PhysicsWorld physics( App::SchedulerPool, 4U );
+    App::PhysicsThread simulation( &physics );  // Steps on its own thread.
+
+The broadphase is the tree unless given:
+
+    App::BroadphaseOptions broadphase;
+    broadphase.type = App::BroadphaseHash;
+    App::PhysicsWorld particles( App::SchedulerNone, 1U, broadphase );
+*/
+class PhysicsWorld {
+public:
+    // in_threads of zero takes every thread the scheduler has. A scheduler
+    // this build lacks gives a single-threaded world.
+    explicit PhysicsWorld( const PhysicsScheduler in_scheduler = SchedulerNone,
+        const unsigned int in_threads = 0U, const BroadphaseOptions& in_broadphase = BroadphaseOptions() );
+    ~PhysicsWorld( void );
+
+    // A mass of zero makes a static body.
+    btRigidBody* addBody( btCollisionShape* in_shape, const btScalar in_mass,
+        const btTransform& in_transform );
+    // Take ownership of a constraint already added to world().
+    void adoptConstraint( btTypedConstraint* in_constraint );
+    // Remove and delete every constraint and body.
+    void clear( void );
+    void step( const btScalar in_timeStep );
+
+    /*
+    Forget everything a step carries over besides the bodies themselves:
+    contact manifolds and their warm-start impulses, broadphase pairs and
+    tree, solver seed. Bodies are removed and added back in order, so the
+    world then steps exactly like one rebuilt from a snapshot of it.
+    */
+    void resetCaches( void );
+
+    // Transforms of every body, in the order they were added.
+    void readTransforms( std::vector< BodyTransform >* out_transforms ) const;
+    unsigned int bodyCount( void ) const;
+    btDiscreteDynamicsWorld* world( void );
+    PhysicsBroadphase broadphase( void ) const;
+    PhysicsScheduler scheduler( void ) const;
+    // Threads a step uses: one without a scheduler.
+    unsigned int threadCount( void ) const;
+
+private:
+    PhysicsWorld( const PhysicsWorld& );
+    PhysicsWorld& operator=( const PhysicsWorld& );
+
+    void installScheduler( void );
+
+private:
+    btDefaultCollisionConfiguration*        _configuration;
+    btCollisionDispatcher*                  _dispatcher;
+    btBroadphaseInterface*                  _broadphase;
+    PhysicsBroadphase                       _broadphaseType;
+    btConstraintSolver*                     _solver;
+    btConstraintSolver*                     _islandSolver;  // Large islands, multithreaded only.
+    btDiscreteDynamicsWorld*                _world;
+    PhysicsScheduler                        _scheduler;
+    unsigned int                            _threads;
+    std::vector< btRigidBody* >             _bodies;
+    std::vector< btTypedConstraint* >       _constraints;
+};
+
+}
+
+#endif
@@ -0,0 +1,253 @@
+#include "SpatialHashBroadphase.hpp"
+
+#include <stdio.h>
+
+#include "LinearMath/btAabbUtil2.h"
+
+namespace {
+
+// Beyond this a cell index no longer fits an int.
+const btScalar MAX_CELL = 1e9f;
+
+inline unsigned int CellHash( const int in_x, const int in_y, const int in_z ) {
+    return ( (unsigned int)in_x * 73856093U ) ^ ( (unsigned int)in_y * 19349663U ) ^ ( (unsigned int)in_z * 83492791U );
+}
+
+inline bool Overlap( const btBroadphaseProxy* in_proxy0, const btBroadphaseProxy* in_proxy1 ) {
+    return TestAabbAgainstAabb2( in_proxy0->m_aabbMin, in_proxy0->m_aabbMax,
+        in_proxy1->m_aabbMin, in_proxy1->m_aabbMax );
+}
+
+}
+
+App::SpatialHashBroadphase::SpatialHashBroadphase( const btScalar in_cellSize )
+    : _cellSize( in_cellSize ), _inverseCellSize( 1.f / in_cellSize ), _proxyCount( 0U ), _lastUniqueId( 0 ),
+    _dirty( false ) {
+    _pairCache = new btHashedOverlappingPairCache();
+}
+
+App::SpatialHashBroadphase::~SpatialHashBroadphase( void ) {
+    for( size_t slot = 0U; slot < _proxies.size(); slot += 1U )
+        delete _proxies[ slot ];
+    delete _pairCache;
+}
+
+btBroadphaseProxy* App::SpatialHashBroadphase::createProxy( const btVector3& in_aabbMin, const btVector3& in_aabbMax,
+    int, void* in_userPointer, int in_collisionFilterGroup, int in_collisionFilterMask, btDispatcher* ) {
+    HashProxy* proxy = new HashProxy( in_aabbMin, in_aabbMax, in_userPointer, in_collisionFilterGroup,
+        in_collisionFilterMask );
+    proxy->m_uniqueId = ++_lastUniqueId;
+    if( _freeSlots.empty() == true ) {
+        proxy->slot = (unsigned int)_proxies.size();
+        _proxies.push_back( proxy );
+    } else {
+        proxy->slot = _freeSlots.back();
+        _freeSlots.pop_back();
+        _proxies[ proxy->slot ] = proxy;
+    }
+    _proxyCount += 1U;
+    _dirty = true;
+    return proxy;
+}
+
+void App::SpatialHashBroadphase::destroyProxy( btBroadphaseProxy* in_proxy, btDispatcher* in_dispatcher ) {
+    HashProxy* proxy = static_cast< HashProxy* >( in_proxy );
+    _pairCache->removeOverlappingPairsContainingProxy( proxy, in_dispatcher );
+    _proxies[ proxy->slot ] = NULL;
+    _freeSlots.push_back( proxy->slot );
+    _proxyCount -= 1U;
+    _dirty = true;
+    delete proxy;
+}
+
+void App::SpatialHashBroadphase::setAabb( btBroadphaseProxy* in_proxy, const btVector3& in_aabbMin,
+    const btVector3& in_aabbMax, btDispatcher* ) {
+    in_proxy->m_aabbMin = in_aabbMin;
+    in_proxy->m_aabbMax = in_aabbMax;
+    _dirty = true;
+}
+
+void App::SpatialHashBroadphase::getAabb( btBroadphaseProxy* in_proxy, btVector3& out_aabbMin,
+    btVector3& out_aabbMax ) const {
+    out_aabbMin = in_proxy->m_aabbMin;
+    out_aabbMax = in_proxy->m_aabbMax;
+}
+
+void App::SpatialHashBroadphase::rayTest( const btVector3& in_rayFrom, const btVector3&,
+    btBroadphaseRayCallback& io_callback, const btVector3& in_aabbMin, const btVector3& in_aabbMax ) {
+    for( size_t slot = 0U; slot < _proxies.size(); slot += 1U ) {
+        HashProxy* proxy = _proxies[ slot ];
+        if( proxy == NULL )
+            continue;
+        // Grown by the swept box, as btDbvt does.
+        const btVector3 bounds[ 2 ] = { proxy->m_aabbMin - in_aabbMax, proxy->m_aabbMax - in_aabbMin };
+        btScalar distance = 0.f;
+        if( btRayAabb2( in_rayFrom, io_callback.m_rayDirectionInverse, io_callback.m_signs, bounds, distance,
+                0.f, io_callback.m_lambda_max ) == true )
+            io_callback.process( proxy );
+    }
+}
+
+void App::SpatialHashBroadphase::aabbTest( const btVector3& in_aabbMin, const btVector3& in_aabbMax,
+    btBroadphaseAabbCallback& io_callback ) {
+    for( size_t slot = 0U; slot < _proxies.size(); slot += 1U ) {
+        HashProxy* proxy = _proxies[ slot ];
+        if( proxy != NULL && TestAabbAgainstAabb2( in_aabbMin, in_aabbMax, proxy->m_aabbMin, proxy->m_aabbMax ) == true )
+            io_callback.process( proxy );
+    }
+}
+
+void App::SpatialHashBroadphase::calculateOverlappingPairs( btDispatcher* in_dispatcher ) {
+    if( _dirty == false )
+        return;
+    _dirty = false;
+
+    // Cell ranges; large proxies are set aside.
+    _large.clear();
+    size_t entryCount = 0U;
+    for( size_t slot = 0U; slot < _proxies.size(); slot += 1U ) {
+        HashProxy* proxy = _proxies[ slot ];
+        if( proxy == NULL )
+            continue;
+        proxy->large = cellRange( proxy->m_aabbMin, proxy->m_aabbMax, proxy->cellMin, proxy->cellMax ) == false;
+        if( proxy->large == true ) {
+            _large.push_back( (unsigned int)slot );
+            continue;
+        }
+        entryCount += (size_t)( proxy->cellMax[ 0 ] - proxy->cellMin[ 0 ] + 1 )
+            * ( proxy->cellMax[ 1 ] - proxy->cellMin[ 1 ] + 1 ) * ( proxy->cellMax[ 2 ] - proxy->cellMin[ 2 ] + 1 );
+    }
+
+    // Counting sort of the entries into at least twice as many buckets, so
+    // that few cells share one.
+    size_t bucketCount = 1U;
+    while( bucketCount < 2U * entryCount )
+        bucketCount <<= 1U;
+    const unsigned int mask = (unsigned int)bucketCount - 1U;
+    _bucketStarts.assign( bucketCount + 1U, 0U );
+    for( size_t slot = 0U; slot < _proxies.size(); slot += 1U ) {
+        const HashProxy* proxy = _proxies[ slot ];
+        if( proxy == NULL || proxy->large == true )
+            continue;
+        for( int z = proxy->cellMin[ 2 ]; z <= proxy->cellMax[ 2 ]; z += 1 )
+            for( int y = proxy->cellMin[ 1 ]; y <= proxy->cellMax[ 1 ]; y += 1 )
+                for( int x = proxy->cellMin[ 0 ]; x <= proxy->cellMax[ 0 ]; x += 1 )
+                    _bucketStarts[ ( CellHash( x, y, z ) & mask ) + 1U ] += 1U;
+    }
+    for( size_t bucket = 1U; bucket <= bucketCount; bucket += 1U )
+        _bucketStarts[ bucket ] += _bucketStarts[ bucket - 1U ];
+    _bucketFill.assign( _bucketStarts.begin(), _bucketStarts.end() - 1 );
+    _entries.resize( entryCount );
+    for( size_t slot = 0U; slot < _proxies.size(); slot += 1U ) {
+        const HashProxy* proxy = _proxies[ slot ];
+        if( proxy == NULL || proxy->large == true )
+            continue;
+        for( int z = proxy->cellMin[ 2 ]; z <= proxy->cellMax[ 2 ]; z += 1 )
+            for( int y = proxy->cellMin[ 1 ]; y <= proxy->cellMax[ 1 ]; y += 1 )
+                for( int x = proxy->cellMin[ 0 ]; x <= proxy->cellMax[ 0 ]; x += 1 ) {
+                    CellEntry& entry = _entries[ _bucketFill[ CellHash( x, y, z ) & mask ]++ ];
+                    entry.cell[ 0 ] = x;
+                    entry.cell[ 1 ] = y;
+                    entry.cell[ 2 ] = z;
+                    entry.slot = (unsigned int)slot;
+                }
+    }
+
+    // Pairs within each cell. Buckets also hold other cells that hash alike.
+    for( size_t bucket = 0U; bucket < bucketCount; bucket += 1U ) {
+        const unsigned int end = _bucketStarts[ bucket + 1U ];
+        for( unsigned int first = _bucketStarts[ bucket ]; first < end; first += 1U ) {
+            const CellEntry& a = _entries[ first ];
+            HashProxy* proxy0 = _proxies[ a.slot ];
+            for( unsigned int second = first + 1U; second < end; second += 1U ) {
+                const CellEntry& b = _entries[ second ];
+                if( a.cell[ 0 ] != b.cell[ 0 ] || a.cell[ 1 ] != b.cell[ 1 ] || a.cell[ 2 ] != b.cell[ 2 ] )
+                    continue;
+                HashProxy* proxy1 = _proxies[ b.slot ];
+                // Only the lowest cell both cover reports the pair.
+                if( btMax( proxy0->cellMin[ 0 ], proxy1->cellMin[ 0 ] ) != a.cell[ 0 ]
+                    || btMax( proxy0->cellMin[ 1 ], proxy1->cellMin[ 1 ] ) != a.cell[ 1 ]
+                    || btMax( proxy0->cellMin[ 2 ], proxy1->cellMin[ 2 ] ) != a.cell[ 2 ] )
+                    continue;
+                addPair( proxy0, proxy1 );
+            }
+        }
+    }
+
+    // Large proxies against every other, and each other once.
+    for( size_t index = 0U; index < _large.size(); index += 1U ) {
+        HashProxy* large = _proxies[ _large[ index ] ];
+        for( size_t slot = 0U; slot < _proxies.size(); slot += 1U ) {
+            HashProxy* proxy = _proxies[ slot ];
+            if( proxy == NULL || proxy == large || ( proxy->large == true && slot < large->slot ) )
+                continue;
+            addPair( large, proxy );
+        }
+    }
+
+    // Drop the pairs that stopped overlapping. Removal moves the last pair
+    // into the hole, so walk from the back.
+    btBroadphasePairArray& pairs = _pairCache->getOverlappingPairArray();
+    for( int index = pairs.size() - 1; index >= 0; index -= 1 ) {
+        btBroadphaseProxy* proxy0 = pairs[ index ].m_pProxy0;
+        btBroadphaseProxy* proxy1 = pairs[ index ].m_pProxy1;
+        if( Overlap( proxy0, proxy1 ) == false )
+            _pairCache->removeOverlappingPair( proxy0, proxy1, in_dispatcher );
+    }
+}
+
+btOverlappingPairCache* App::SpatialHashBroadphase::getOverlappingPairCache( void ) {
+    return _pairCache;
+}
+
+const btOverlappingPairCache* App::SpatialHashBroadphase::getOverlappingPairCache( void ) const {
+    return _pairCache;
+}
+
+void App::SpatialHashBroadphase::getBroadphaseAabb( btVector3& out_aabbMin, btVector3& out_aabbMax ) const {
+    out_aabbMin.setValue( -BT_LARGE_FLOAT, -BT_LARGE_FLOAT, -BT_LARGE_FLOAT );
+    out_aabbMax.setValue( BT_LARGE_FLOAT, BT_LARGE_FLOAT, BT_LARGE_FLOAT );
+}
+
+void App::SpatialHashBroadphase::resetPool( btDispatcher* ) {
+    if( _proxyCount != 0U )
+        return;
+    _proxies.clear();
+    _freeSlots.clear();
+    _lastUniqueId = 0;
+}
+
+void App::SpatialHashBroadphase::printStats( void ) {
+    printf( "SpatialHashBroadphase: cell %f, %u proxies, %u large, %d pairs\n", (double)_cellSize, _proxyCount,
+        (unsigned int)_large.size(), _pairCache->getNumOverlappingPairs() );
+}
+
+btScalar App::SpatialHashBroadphase::cellSize( void ) const {
+    return _cellSize;
+}
+
+unsigned int App::SpatialHashBroadphase::proxyCount( void ) const {
+    return _proxyCount;
+}
+
+bool App::SpatialHashBroadphase::cellRange( const btVector3& in_aabbMin, const btVector3& in_aabbMax,
+    int out_cellMin[ 3 ], int out_cellMax[ 3 ] ) const {
+    btScalar cells = 1.f;
+    for( int axis = 0; axis < 3; axis += 1 ) {
+        const btScalar low = btFloor( in_aabbMin[ axis ] * _inverseCellSize );
+        const btScalar high = btFloor( in_aabbMax[ axis ] * _inverseCellSize );
+        cells *= high - low + 1.f;
+        // Written so that NaN fails too.
+        if( ( cells <= (btScalar)LARGE_CELLS && low >= -MAX_CELL && high <= MAX_CELL ) == false )
+            return false;
+        out_cellMin[ axis ] = (int)low;
+        out_cellMax[ axis ] = (int)high;
+    }
+    return true;
+}
+
+void App::SpatialHashBroadphase::addPair( HashProxy* in_proxy0, HashProxy* in_proxy1 ) {
+    // The cache filters by collision group and ignores pairs it holds.
+    if( Overlap( in_proxy0, in_proxy1 ) == true )
+        _pairCache->addOverlappingPair( in_proxy0, in_proxy1 );
+}
@@ -0,0 +1,104 @@
+#ifndef __SPATIAL_HASH_BROADPHASE__
+#define __SPATIAL_HASH_BROADPHASE__
+
+#include <vector>
+
+#include "btBulletCollisionCommon.h"
+
+namespace App {
+
+/*
+Broadphase over a uniform grid of cubic cells, hashed so the world needs
+no bounds. When a proxy has moved, calculateOverlappingPairs() rebuilds
+the grid: every proxy is entered in each cell its AABB touches, the
+entries are bucketed by a counting sort, and proxies sharing a cell are
+tested pairwise. A pair is reported only from the lowest cell both
+cover, so never twice. Proxies over more than LARGE_CELLS cells, such as
+ground planes, stay out of the grid and are tested against every proxy.
+Suits many objects of about one size spread evenly, with in_cellSize
+near the size of the larger ones. Clusters crowd one cell and fall back
+towards testing every pair in it.
+
+    App::SpatialHashBroadphase broadphase( 2.f );
+    btDiscreteDynamicsWorld world( dispatcher, &broadphase, solver, configuration );
+*/
+class SpatialHashBroadphase : public btBroadphaseInterface {
+public:
+    explicit SpatialHashBroadphase( const btScalar in_cellSize );
+    virtual ~SpatialHashBroadphase( void );
+
+    virtual btBroadphaseProxy* createProxy( const btVector3& in_aabbMin, const btVector3& in_aabbMax,
+        int in_shapeType, void* in_userPointer, int in_collisionFilterGroup, int in_collisionFilterMask,
+        btDispatcher* in_dispatcher );
+    virtual void destroyProxy( btBroadphaseProxy* in_proxy, btDispatcher* in_dispatcher );
+    virtual void setAabb( btBroadphaseProxy* in_proxy, const btVector3& in_aabbMin, const btVector3& in_aabbMax,
+        btDispatcher* in_dispatcher );
+    virtual void getAabb( btBroadphaseProxy* in_proxy, btVector3& out_aabbMin, btVector3& out_aabbMax ) const;
+
+    // Both test every proxy: queries are rare next to pair finding.
+    virtual void rayTest( const btVector3& in_rayFrom, const btVector3& in_rayTo, btBroadphaseRayCallback& io_callback,
+        const btVector3& in_aabbMin = btVector3( 0.f, 0.f, 0.f ),
+        const btVector3& in_aabbMax = btVector3( 0.f, 0.f, 0.f ) );
+    virtual void aabbTest( const btVector3& in_aabbMin, const btVector3& in_aabbMax,
+        btBroadphaseAabbCallback& io_callback );
+
+    virtual void calculateOverlappingPairs( btDispatcher* in_dispatcher );
+    virtual btOverlappingPairCache* getOverlappingPairCache( void );
+    virtual const btOverlappingPairCache* getOverlappingPairCache( void ) const;
+    virtual void getBroadphaseAabb( btVector3& out_aabbMin, btVector3& out_aabbMax ) const;
+    // Restart proxy ids once every proxy is gone, as a new broadphase would.
+    virtual void resetPool( btDispatcher* in_dispatcher );
+    virtual void printStats( void );
+
+    btScalar cellSize( void ) const;
+    unsigned int proxyCount( void ) const;
+
+    static const unsigned int LARGE_CELLS = 512U;
+
+private:
+    SpatialHashBroadphase( const SpatialHashBroadphase& );
+    SpatialHashBroadphase& operator=( const SpatialHashBroadphase& );
+
+    struct HashProxy : public btBroadphaseProxy {
+        HashProxy( const btVector3& in_aabbMin, const btVector3& in_aabbMax, void* in_userPointer,
+            int in_collisionFilterGroup, int in_collisionFilterMask )
+            : btBroadphaseProxy( in_aabbMin, in_aabbMax, in_userPointer, in_collisionFilterGroup,
+                in_collisionFilterMask ), slot( 0U ), large( false ) {}
+
+        unsigned int    slot;           // Index in _proxies.
+        bool            large;          // Out of the grid.
+        int             cellMin[ 3 ];
+        int             cellMax[ 3 ];
+    };
+
+    // One proxy in one cell.
+    struct CellEntry {
+        int             cell[ 3 ];
+        unsigned int    slot;
+    };
+
+    // Cells the AABB covers; false when they are more than LARGE_CELLS.
+    bool cellRange( const btVector3& in_aabbMin, const btVector3& in_aabbMax,
+        int out_cellMin[ 3 ], int out_cellMax[ 3 ] ) const;
+    void addPair( HashProxy* in_proxy0, HashProxy* in_proxy1 );
+
+private:
+    btScalar                        _cellSize;
+    btScalar                        _inverseCellSize;
+    btHashedOverlappingPairCache*   _pairCache;
+    std::vector< HashProxy* >       _proxies;       // NULL in free slots.
+    std::vector< unsigned int >     _freeSlots;
+    unsigned int                    _proxyCount;
+    int                             _lastUniqueId;
+    // Set when a proxy moved, came or went since the last pair update.
+    bool                            _dirty;
+    // Rebuilt by every pair update, kept to reuse their memory.
+    std::vector< unsigned int >     _large;
+    std::vector< unsigned int >     _bucketStarts;
+    std::vector< unsigned int >     _bucketFill;
+    std::vector< CellEntry >        _entries;
+};
+
+}
+
+#endif
@@ -0,0 +1,59 @@
+#ifndef __TRIPLE_BUFFER__
+#define __TRIPLE_BUFFER__
+
+#include <atomic>
+
+namespace App {
+
+/*
+Lock-free single-producer single-consumer triple buffer.
+The writer fills writeBuffer() and publish()es it; the reader calls update()
+and then reads readBuffer(). Neither side ever waits: the third buffer sits
+in the middle and is swapped with one atomic exchange. The reader always
+sees the newest complete value; intermediate values may be skipped.
+*/
+template< typename T >
+class TripleBuffer {
+public:
+    TripleBuffer( void ) : _middle( 1U ), _write( 0U ), _read( 2U ) {}
+
+    // Writer side.
+    T& writeBuffer( void ) {
+        return _buffers[ _write ];
+    }
+    void publish( void ) {
+        const unsigned int previous = _middle.exchange( _write | DIRTY, std::memory_order_acq_rel );
+        _write = previous & INDEX_MASK;
+    }
+
+    // Reader side. Return true if a newer value was taken.
+    bool update( void ) {
+        if( ( _middle.load( std::memory_order_relaxed ) & DIRTY ) == 0U )
+            return false;
+        const unsigned int previous = _middle.exchange( _read, std::memory_order_acq_rel );
+        _read = previous & INDEX_MASK;
+        return true;
+    }
+    const T& readBuffer( void ) const {
+        return _buffers[ _read ];
+    }
+
+private:
+    TripleBuffer( const TripleBuffer& );
+    TripleBuffer& operator=( const TripleBuffer& );
+
+    static const unsigned int INDEX_MASK = 3U;
+    static const unsigned int DIRTY = 4U;
+
+private:
+    T                           _buffers[ 3 ];
+    // Index of the middle buffer plus the DIRTY flag. Writer and reader
+    // indices are each touched by one thread only; keep them apart.
+    alignas( 64 ) std::atomic< unsigned int >   _middle;
+    alignas( 64 ) unsigned int                  _write;
+    alignas( 64 ) unsigned int                  _read;
+};
+
+}
+
+#endif
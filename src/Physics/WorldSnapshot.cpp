@@ -0,0 +1,147 @@
+#include "WorldSnapshot.hpp"
+
+#include <fstream>
+#include <vector>
+
+#include "LinearMath/btSerializer.h"
+#include "BulletFileLoader/btBulletFile.h"
+#include "BulletWorldImporter/btBulletWorldImporter.h"
+
+namespace {
+
+// Creates bodies in the PhysicsWorld, which owns them, and remembers them
+// in file order.
+class SnapshotImporter : public btBulletWorldImporter {
+public:
+    explicit SnapshotImporter( App::PhysicsWorld* io_world )
+        : btBulletWorldImporter( io_world->world() ), _physics( io_world ) {}
+
+    virtual btRigidBody* createRigidBody( bool in_isDynamic, btScalar in_mass,
+        const btTransform& in_transform, btCollisionShape* in_shape, const char* ) {
+        btRigidBody* body = _physics->addBody( in_shape, in_isDynamic == true ? in_mass : 0.f, in_transform );
+        _bodies.push_back( body );
+        return body;
+    }
+
+    // Hand the constraints to the world and stop referring to it: the
+    // world goes away before the shapes do.
+    void detach( void ) {
+        for( int index = 0; index < m_allocatedConstraints.size(); index += 1 )
+            _physics->adoptConstraint( m_allocatedConstraints[ index ] );
+        m_allocatedConstraints.clear();
+        m_dynamicsWorld = NULL;
+    }
+
+    const std::vector< btRigidBody* >& bodies( void ) const {
+        return _bodies;
+    }
+
+private:
+    App::PhysicsWorld*          _physics;
+    std::vector< btRigidBody* > _bodies;
+};
+
+// The importer restores shape, transform, mass, friction, restitution and
+// the linear and angular factors. The rest of what a step reads comes from
+// the record here. Mass is exact: 1 / ( 1 / m ) round trips for every
+// inverse mass a float mass produces.
+void RestoreBody( const btRigidBodyData& in_data, btRigidBody* io_body ) {
+    const btCollisionObjectData& object = in_data.m_collisionObjectData;
+    btTransform transform;
+    btVector3 vector;
+    transform.deSerialize( object.m_interpolationWorldTransform );
+    io_body->setInterpolationWorldTransform( transform );
+    vector.deSerialize( object.m_interpolationLinearVelocity );
+    io_body->setInterpolationLinearVelocity( vector );
+    vector.deSerialize( object.m_interpolationAngularVelocity );
+    io_body->setInterpolationAngularVelocity( vector );
+    vector.deSerialize( object.m_anisotropicFriction );
+    io_body->setAnisotropicFriction( vector, object.m_hasAnisotropicFriction );
+    io_body->setContactProcessingThreshold( object.m_contactProcessingThreshold );
+    io_body->setRollingFriction( object.m_rollingFriction );
+    io_body->setHitFraction( object.m_hitFraction );
+    io_body->setCcdSweptSphereRadius( object.m_ccdSweptSphereRadius );
+    io_body->setCcdMotionThreshold( object.m_ccdMotionThreshold );
+    io_body->setCollisionFlags( object.m_collisionFlags );
+    io_body->forceActivationState( object.m_activationState1 );
+    io_body->setDeactivationTime( object.m_deactivationTime );
+
+    // The importer derives inertia from the mass; take the saved one.
+    vector.deSerialize( in_data.m_invInertiaLocal );
+    io_body->setInvInertiaDiagLocal( vector );
+    io_body->updateInertiaTensor();
+    vector.deSerialize( in_data.m_gravity_acceleration );
+    io_body->setGravity( vector );
+    vector.deSerialize( in_data.m_linearVelocity );
+    io_body->setLinearVelocity( vector );
+    vector.deSerialize( in_data.m_angularVelocity );
+    io_body->setAngularVelocity( vector );
+    io_body->setDamping( in_data.m_linearDamping, in_data.m_angularDamping );
+    io_body->setSleepingThresholds( in_data.m_linearSleepingThreshold, in_data.m_angularSleepingThreshold );
+}
+
+}
+
+bool App::WorldSnapshot::save( PhysicsWorld* io_world, const char* in_fileName ) {
+    io_world->resetCaches();
+    btDefaultSerializer serializer;
+    io_world->world()->serialize( &serializer );
+    std::ofstream file( in_fileName, std::ios::binary | std::ios::trunc );
+    file.write( reinterpret_cast<const char*>( serializer.getBufferPointer() ),
+        (std::streamsize)serializer.getCurrentBufferSize() );
+    return file.good();
+}
+
+bool App::WorldSnapshot::load( const char* in_fileName, PhysicsWorld* io_world ) {
+    release();
+    if( io_world->bodyCount() != 0U )
+        return false;
+    // The parser fixes pointers up in place, so read rather than map.
+    std::ifstream file( in_fileName, std::ios::binary | std::ios::ate );
+    if( file.is_open() == false )
+        return false;
+    std::vector< char > buffer( (size_t)file.tellg() );
+    file.seekg( 0 );
+    if( buffer.empty() == true || file.read( buffer.data(), (std::streamsize)buffer.size() ).good() == false )
+        return false;
+
+    bParse::btBulletFile bulletFile( buffer.data(), (int)buffer.size() );
+    // The records are read as this build's btRigidBodyData below.
+#ifdef BT_USE_DOUBLE_PRECISION
+    const bool samePrecision = ( bulletFile.getFlags() & bParse::FD_DOUBLE_PRECISION ) != 0;
+#else
+    const bool samePrecision = ( bulletFile.getFlags() & bParse::FD_DOUBLE_PRECISION ) == 0;
+#endif
+    if( ( bulletFile.getFlags() & bParse::FD_OK ) == 0 || samePrecision == false )
+        return false;
+
+    SnapshotImporter* importer = new SnapshotImporter( io_world );
+    _importer = importer;
+    const bool loaded = importer->loadFileFromMemory( &bulletFile );
+    const std::vector< btRigidBody* >& bodies = importer->bodies();
+    // A body whose shape failed to load is skipped, which would pair the
+    // records below with the wrong bodies.
+    if( loaded == false || bodies.size() != (size_t)bulletFile.m_rigidBodies.size() ) {
+        importer->detach();
+        io_world->clear();
+        release();
+        return false;
+    }
+    for( size_t index = 0U; index < bodies.size(); index += 1U )
+        RestoreBody( *reinterpret_cast<const btRigidBodyData*>( bulletFile.m_rigidBodies[ (int)index ] ),
+            bodies[ index ] );
+    importer->detach();
+    return true;
+}
+
+void App::WorldSnapshot::release( void ) {
+    if( _importer == NULL )
+        return;
+    _importer->deleteAllData();
+    delete _importer;
+    _importer = NULL;
+}
+
+unsigned int App::WorldSnapshot::shapeCount( void ) const {
+    return _importer != NULL ? (unsigned int)_importer->getNumCollisionShapes() : 0U;
+}
@@ -0,0 +1,57 @@
+#ifndef __WORLD_SNAPSHOT__
+#define __WORLD_SNAPSHOT__
+
+#include <stddef.h>
+
+#include "PhysicsWorld.hpp"
+
+class btBulletWorldImporter;
+
+namespace App {
+
+/*
+Whole simulation state in one .bullet file, for a warm restart without
+parsing meshes or building shapes and BVHs.
+save() writes the bodies, their shapes (triangle meshes with their
+quantized BVHs), the constraints and the world settings through
+btDefaultSerializer. load() rebuilds them into an empty PhysicsWorld with
+btBulletWorldImporter, then puts back the per-body state the importer
+skips: velocities, damping, gravity, inertia and activation.
+The restored world steps bit for bit like the saved one. Contact caches
+are not part of the format, so save() resets the saved world's first
+(PhysicsWorld::resetCaches()).
+The snapshot owns the shapes it loaded and must outlive the world.
+
+    App::WorldSnapshot::save( &physics, "bin/scene.bullet" );
+    ...
+    App::PhysicsWorld physics;
+    App::WorldSnapshot snapshot;
+    if( snapshot.load( "bin/scene.bullet", &physics ) == false )
+        BuildScene( &physics );
+*/
+class WorldSnapshot {
+public:
+    WorldSnapshot( void ) : _importer( NULL ) {}
+    ~WorldSnapshot( void ) {
+        release();
+    }
+
+    static bool save( PhysicsWorld* io_world, const char* in_fileName );
+    // io_world must be empty; it is left empty on failure.
+    bool load( const char* in_fileName, PhysicsWorld* io_world );
+    // Delete the loaded shapes. The world must be gone or cleared first.
+    void release( void );
+
+    unsigned int shapeCount( void ) const;
+
+private:
+    WorldSnapshot( const WorldSnapshot& );
+    WorldSnapshot& operator=( const WorldSnapshot& );
+
+private:
+    btBulletWorldImporter*  _importer;
+};
+
+}
+
+#endif
@@ -0,0 +1,161 @@
+#include "Profiler.hpp"
+
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <algorithm>
+#include <vector>
+
+namespace {
+
+struct ProfileEvent {
+    const char*     name;
+    uint64_t        begin;
+    uint64_t        end;
+};
+
+// Written by one thread, read by writeTrace(). written counts every span
+// ever recorded; slot written % RING_CAPACITY is the next to fill.
+struct ThreadRing {
+    ThreadRing( const unsigned int in_track ) : track( in_track ), written( 0U ) {
+        strcpy( name, "thread" );
+    }
+
+    char                    name[ 32 ];
+    unsigned int            track;
+    ProfileEvent            events[ App::Profiler::RING_CAPACITY ];
+    std::atomic< uint64_t > written;
+};
+
+// Rings live until exit so spans of finished threads can still be exported.
+std::mutex& RegistryMutex( void ) {
+    static std::mutex mutex;
+    return mutex;
+}
+std::vector< ThreadRing* >& Registry( void ) {
+    static std::vector< ThreadRing* > rings;
+    return rings;
+}
+
+ThreadRing* NewRing( void ) {
+    std::lock_guard< std::mutex > lock( RegistryMutex() );
+    ThreadRing* ring = new ThreadRing( (unsigned int)Registry().size() + 1U );
+    Registry().push_back( ring );
+    return ring;
+}
+
+thread_local ThreadRing* threadRing = NULL;
+
+ThreadRing* CurrentRing( void ) {
+    if( threadRing == NULL )
+        threadRing = NewRing();
+    return threadRing;
+}
+
+// Only the GL thread records GPU spans.
+ThreadRing* GpuRing( void ) {
+    static ThreadRing* ring = NULL;
+    if( ring == NULL ) {
+        ring = NewRing();
+        strcpy( ring->name, "GPU" );
+    }
+    return ring;
+}
+
+void Push( ThreadRing* io_ring, const char* in_name, const uint64_t in_begin, const uint64_t in_end ) {
+    const uint64_t written = io_ring->written.load( std::memory_order_relaxed );
+    ProfileEvent& event = io_ring->events[ written % App::Profiler::RING_CAPACITY ];
+    event.name = in_name;
+    event.begin = in_begin;
+    event.end = in_end;
+    io_ring->written.store( written + 1U, std::memory_order_release );
+}
+
+// Copy the spans of in_ring that are not overwritten while copying.
+void Snapshot( const ThreadRing* in_ring, std::vector< ProfileEvent >* out_events ) {
+    const uint64_t capacity = App::Profiler::RING_CAPACITY;
+    const uint64_t written = in_ring->written.load( std::memory_order_acquire );
+    const uint64_t first = written > capacity ? written - capacity : 0U;
+    std::vector< ProfileEvent > events;
+    events.reserve( (size_t)( written - first ) );
+    for( uint64_t index = first; index < written; index += 1U )
+        events.push_back( in_ring->events[ index % capacity ] );
+    // Slots the writer reused meanwhile hold newer spans; drop them.
+    const uint64_t after = in_ring->written.load( std::memory_order_acquire );
+    const uint64_t valid = after > capacity ? after - capacity : 0U;
+    const size_t skip = (size_t)std::min< uint64_t >( valid > first ? valid - first : 0U, events.size() );
+    out_events->assign( events.begin() + skip, events.end() );
+}
+
+// Minimal JSON string escaping for span and thread names.
+void WriteString( std::ostream& out_stream, const char* in_text ) {
+    out_stream << '"';
+    for( const char* cursor = in_text; *cursor != '\0'; cursor += 1 ) {
+        if( *cursor == '"' || *cursor == '\\' )
+            out_stream << '\\';
+        if( (unsigned char)*cursor >= 0x20U )
+            out_stream << *cursor;
+    }
+    out_stream << '"';
+}
+
+}
+
+uint64_t App::Profiler::now( void ) {
+    return (uint64_t)std::chrono::duration_cast< std::chrono::nanoseconds >(
+        std::chrono::steady_clock::now().time_since_epoch() ).count();
+}
+
+void App::Profiler::setThreadName( const char* in_name ) {
+    ThreadRing* ring = CurrentRing();
+    strncpy( ring->name, in_name, sizeof(ring->name) - 1U );
+    ring->name[ sizeof(ring->name) - 1U ] = '\0';
+}
+
+void App::Profiler::record( const char* in_name, const uint64_t in_begin, const uint64_t in_end ) {
+    Push( CurrentRing(), in_name, in_begin, in_end );
+}
+
+void App::Profiler::recordGpu( const char* in_name, const uint64_t in_begin, const uint64_t in_duration ) {
+    Push( GpuRing(), in_name, in_begin, in_begin + in_duration );
+}
+
+bool App::Profiler::writeTrace( const char* in_fileName ) {
+    std::vector< ThreadRing* > rings;
+    {
+        std::lock_guard< std::mutex > lock( RegistryMutex() );
+        rings = Registry();
+    }
+    std::vector< std::vector< ProfileEvent > > tracks( rings.size() );
+    uint64_t origin = UINT64_MAX;
+    for( size_t ring = 0U; ring < rings.size(); ring += 1U ) {
+        Snapshot( rings[ ring ], &tracks[ ring ] );
+        for( size_t index = 0U; index < tracks[ ring ].size(); index += 1U )
+            origin = std::min( origin, tracks[ ring ][ index ].begin );
+    }
+
+    std::ofstream file( in_fileName );
+    file << std::fixed << std::setprecision( 3 ) << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    for( size_t ring = 0U; ring < rings.size(); ring += 1U ) {
+        file << ( first ? "\n" : ",\n" ) << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+            << rings[ ring ]->track << ",\"args\":{\"name\":";
+        WriteString( file, rings[ ring ]->name );
+        file << "}}";
+        first = false;
+        for( size_t index = 0U; index < tracks[ ring ].size(); index += 1U ) {
+            const ProfileEvent& event = tracks[ ring ][ index ];
+            // Chrome trace times are in microseconds.
+            file << ",\n{\"name\":";
+            WriteString( file, event.name );
+            file << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << rings[ ring ]->track
+                << ",\"ts\":" << ( event.begin - origin ) * 1e-3
+                << ",\"dur\":" << ( event.end - event.begin ) * 1e-3 << "}";
+        }
+    }
+    file << "\n]}" << std::endl;
+    return file.good();
+}
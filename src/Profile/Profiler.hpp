@@ -0,0 +1,73 @@
+#ifndef __PROFILER__
+#define __PROFILER__
+
+#include <stdint.h>
+
+/*
+Frame profiler. CPU scopes go to a ring per thread, GPU spans measured by
+App::GpuTimer (Render/GpuTimer.hpp) to a track of their own, and the lot is
+exported as a Chrome trace (chrome://tracing, ui.perfetto.dev).
+
+    PROFILE_THREAD( "render" );
+    {
+        PROFILE_SCOPE( "draw" );    // Names must be string literals.
+        ...
+    }
+    PROFILE_WRITE_TRACE( "profile.json" );
+
+The macros compile to nothing unless APP_PROFILE is defined.
+*/
+
+namespace App {
+
+class Profiler {
+public:
+    // Monotonic nanoseconds.
+    static uint64_t now( void );
+    // Name the calling thread's track.
+    static void setThreadName( const char* in_name );
+    // Record a CPU span on the calling thread. Oldest spans are overwritten
+    // once the ring is full.
+    static void record( const char* in_name, const uint64_t in_begin, const uint64_t in_end );
+    // Record a GPU span, placed at the CPU time its commands were issued.
+    static void recordGpu( const char* in_name, const uint64_t in_begin, const uint64_t in_duration );
+    // Write every ring as Chrome trace JSON. Safe while other threads record;
+    // spans overwritten during the export are left out.
+    static bool writeTrace( const char* in_fileName );
+
+    // Spans kept per thread.
+    static const unsigned int RING_CAPACITY = 1U << 14;
+};
+
+class ProfileScope {
+public:
+    explicit ProfileScope( const char* in_name ) : _name( in_name ), _begin( Profiler::now() ) {}
+    ~ProfileScope( void ) {
+        Profiler::record( _name, _begin, Profiler::now() );
+    }
+
+private:
+    ProfileScope( const ProfileScope& );
+    ProfileScope& operator=( const ProfileScope& );
+
+private:
+    const char*     _name;
+    uint64_t        _begin;
+};
+
+}
+
+#define PROFILE_CONCAT_INNER( a, b ) a##b
+#define PROFILE_CONCAT( a, b ) PROFILE_CONCAT_INNER( a, b )
+
+#ifdef APP_PROFILE
+#define PROFILE_SCOPE( name ) App::ProfileScope PROFILE_CONCAT( profileScope, __LINE__ )( name )
+#define PROFILE_THREAD( name ) App::Profiler::setThreadName( name )
+#define PROFILE_WRITE_TRACE( fileName ) App::Profiler::writeTrace( fileName )
+#else
+#define PROFILE_SCOPE( name ) do {} while( false )
+#define PROFILE_THREAD( name ) do {} while( false )
+#define PROFILE_WRITE_TRACE( fileName ) false
+#endif
+
+#endif
@@ -0,0 +1,418 @@
+#include "AssetStreamer.hpp"
+#include "GLFunctions.hpp"
+#include "GLState.hpp"
+
+#include <string.h>
+#include <algorithm>
+
+namespace {
+
+// Unit cube drawn while an asset streams in.
+const AVertex CUBE_VERTICIES[ 8 ] = {
+    { -1.f, -1.f, -1.f }, { 1.f, -1.f, -1.f }, { 1.f, 1.f, -1.f }, { -1.f, 1.f, -1.f },
+    { -1.f, -1.f, 1.f }, { 1.f, -1.f, 1.f }, { 1.f, 1.f, 1.f }, { -1.f, 1.f, 1.f } };
+const AIndex CUBE_INDICIES[ 12 ] = {
+    { 0U, 2U, 1U }, { 0U, 3U, 2U }, { 4U, 5U, 6U }, { 4U, 6U, 7U },
+    { 0U, 1U, 5U }, { 0U, 5U, 4U }, { 3U, 6U, 2U }, { 3U, 7U, 6U },
+    { 0U, 4U, 7U }, { 0U, 7U, 3U }, { 1U, 2U, 6U }, { 1U, 6U, 5U } };
+const AColor PLACEHOLDER_COLOR = { 0.5f, 0.5f, 0.5f, 1.f };
+
+// Turn the 16-bit indices of io_mesh into 32-bit ones.
+void WidenIndicies( PackedMesh* io_mesh ) {
+    const std::vector< unsigned short >& indicies = io_mesh->shortIndicies;
+    io_mesh->longIndicies.resize( indicies.size() / 3U );
+    for( size_t face = 0U; face < io_mesh->longIndicies.size(); face += 1U ) {
+        AIndex& index = io_mesh->longIndicies[ face ];
+        index.a = indicies[ 3U * face ];
+        index.b = indicies[ 3U * face + 1U ];
+        index.c = indicies[ 3U * face + 2U ];
+    }
+    std::vector< unsigned short >().swap( io_mesh->shortIndicies );
+    io_mesh->indexSize = 4U;
+}
+
+GLuint CreateBuffer( const GLenum in_target, const GLsizeiptr in_size, const void* in_data ) {
+    GLuint buffer = 0U;
+    glGenBuffers( 1, &buffer );
+    App::GetGLState().bindBuffer( in_target, buffer );
+    glBufferData( in_target, in_size, in_data, GL_STATIC_DRAW );
+    return buffer;
+}
+
+}
+
+App::AssetStreamer::AssetStreamer( void ) : _stopping( false ), _staging( 0U ), _pool( NULL ), _budget( 0U ),
+    _region( 0U ), _frameBytes( 0U ), _stalls( 0U ) {
+    for( unsigned int index = 0U; index < REGIONS; index += 1U )
+        _fences[ index ] = NULL;
+}
+
+App::AssetStreamer::~AssetStreamer( void ) {
+    release();
+}
+
+bool App::AssetStreamer::create( const unsigned int in_workers, const size_t in_budget, GeometryPool* io_pool ) {
+    release();
+    if( in_workers == 0U || in_budget == 0U )
+        return false;
+    _budget = in_budget;
+    _pool = io_pool;
+    glGenBuffers( 1, &_staging );
+    GetGLState().bindBuffer( GL_COPY_READ_BUFFER, _staging );
+    glBufferData( GL_COPY_READ_BUFFER, (GLsizeiptr)( _budget * REGIONS ), NULL, GL_STREAM_DRAW );
+    _region = REGIONS - 1U;
+    if( createPlaceholder() == false )
+        return false;
+
+    _stopping = false;
+    for( unsigned int worker = 0U; worker < in_workers; worker += 1U )
+        _workers.push_back( std::thread( &AssetStreamer::work, this ) );
+    return glGetError() == GL_NO_ERROR;
+}
+
+void App::AssetStreamer::release( void ) {
+    {
+        std::lock_guard< std::mutex > lock( _mutex );
+        _stopping = true;
+    }
+    _work.notify_all();
+    for( size_t worker = 0U; worker < _workers.size(); worker += 1U )
+        _workers[ worker ].join();
+    _workers.clear();
+    // Only now: a worker mid-parse still pushes its asset to _parsed, and
+    // every asset is deleted below.
+    _requests.clear();
+    _parsed.clear();
+
+    for( unsigned int index = 0U; index < REGIONS; index += 1U ) {
+        if( _fences[ index ] != NULL )
+            glDeleteSync( _fences[ index ] );
+        _fences[ index ] = NULL;
+    }
+    for( size_t handle = 0U; handle < _assets.size(); handle += 1U ) {
+        releaseResource( &_assets[ handle ]->resource );
+        delete _assets[ handle ];
+    }
+    _assets.clear();
+    for( size_t reload = 0U; reload < _reloading.size(); reload += 1U ) {
+        releaseResource( &_reloading[ reload ]->resource );
+        delete _reloading[ reload ];
+    }
+    _reloading.clear();
+    _reloads.clear();
+    _uploads.clear();
+    releaseResource( &_placeholder );
+    if( _staging != 0U )
+        GetGLState().deleteBuffers( 1, &_staging );
+    _staging = 0U;
+    _pool = NULL;
+    _budget = 0U;
+    _frameBytes = 0U;
+}
+
+unsigned int App::AssetStreamer::request( const char* in_fileName, const bool in_useCache ) {
+    for( size_t handle = 0U; handle < _assets.size(); handle += 1U ) {
+        if( _assets[ handle ]->fileName == in_fileName )
+            return (unsigned int)handle;
+    }
+    Asset* asset = new Asset();
+    asset->fileName = in_fileName;
+    asset->useCache = in_useCache;
+    asset->state.store( AssetQueued );
+    asset->uploaded = 0U;
+    asset->handle = (unsigned int)_assets.size();
+    asset->reload = false;
+    asset->version = asset->requested = 0U;
+    _assets.push_back( asset );
+    {
+        std::lock_guard< std::mutex > lock( _mutex );
+        _requests.push_back( asset );
+    }
+    _work.notify_one();
+    return (unsigned int)( _assets.size() - 1U );
+}
+
+void App::AssetStreamer::reload( const unsigned int in_handle ) {
+    if( in_handle >= _assets.size() )
+        return;
+    Asset* target = _assets[ in_handle ];
+    Asset* asset = new Asset();
+    asset->fileName = target->fileName;
+    asset->useCache = target->useCache;
+    asset->state.store( AssetQueued );
+    asset->uploaded = 0U;
+    asset->handle = in_handle;
+    asset->reload = true;
+    target->requested += 1U;
+    asset->version = asset->requested = target->requested;
+    _reloading.push_back( asset );
+    {
+        std::lock_guard< std::mutex > lock( _mutex );
+        _requests.push_back( asset );
+    }
+    _work.notify_one();
+}
+
+void App::AssetStreamer::update( void ) {
+    _frameBytes = 0U;
+    swapReloads();
+    {
+        std::lock_guard< std::mutex > lock( _mutex );
+        _uploads.insert( _uploads.end(), _parsed.begin(), _parsed.end() );
+        _parsed.clear();
+    }
+    if( _uploads.empty() == true || _staging == 0U )
+        return;
+
+    _region = ( _region + 1U ) % REGIONS;
+    if( _fences[ _region ] != NULL ) {
+        if( WaitFence( _fences[ _region ] ) == true )
+            _stalls += 1U;
+        glDeleteSync( _fences[ _region ] );
+        _fences[ _region ] = NULL;
+    }
+    // The fence already guarantees the region is idle.
+    const GLintptr regionOffset = (GLintptr)( _budget * _region );
+    GetGLState().bindBuffer( GL_COPY_READ_BUFFER, _staging );
+    char* staging = static_cast< char* >( glMapBufferRange( GL_COPY_READ_BUFFER, regionOffset,
+        (GLsizeiptr)_budget, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT ) );
+    if( staging == NULL )
+        return;
+
+    // Fill the region front to back with the oldest assets first. Each
+    // asset is its vertex, color and index arrays back to back.
+    _copies.clear();
+    _completed.clear();
+    while( _uploads.empty() == false && _frameBytes < _budget ) {
+        Asset* asset = _uploads.front();
+        if( asset->uploaded == 0U )
+            allocate( asset );
+        const PackedMesh& mesh = asset->packed;
+        const size_t vertexBytes = sizeof(PVertex) * mesh.verticies.size(),
+            colorBytes = sizeof(PColor) * mesh.colors.size(),
+            indexBytes = mesh.indexBytes();
+        const void* sources[ 3 ] = { mesh.verticies.data(), mesh.colors.data(), mesh.indexData() };
+        const size_t sizes[ 3 ] = { vertexBytes, colorBytes, indexBytes };
+
+        size_t begin = 0U;
+        for( unsigned int array = 0U; array < 3U && _frameBytes < _budget; array += 1U ) {
+            const size_t end = begin + sizes[ array ];
+            if( asset->uploaded < end ) {
+                const size_t offset = asset->uploaded - begin,
+                    size = std::min( end - asset->uploaded, _budget - _frameBytes );
+                memcpy( staging + _frameBytes, static_cast< const char* >( sources[ array ] ) + offset, size );
+                Copy copy = { asset, array, (GLintptr)offset, regionOffset + (GLintptr)_frameBytes, (GLsizeiptr)size };
+                _copies.push_back( copy );
+                asset->uploaded += size;
+                _frameBytes += size;
+            }
+            begin = end;
+        }
+        if( asset->uploaded == vertexBytes + colorBytes + indexBytes ) {
+            _completed.push_back( asset );
+            _uploads.pop_front();
+        }
+    }
+    // A pool rebuild in allocate() binds buffers of its own.
+    GetGLState().bindBuffer( GL_COPY_READ_BUFFER, _staging );
+    glUnmapBuffer( GL_COPY_READ_BUFFER );
+
+    for( size_t index = 0U; index < _copies.size(); index += 1U ) {
+        const Copy& copy = _copies[ index ];
+        GLuint buffer = 0U;
+        GLintptr offset = 0;
+        target( *copy.asset, copy.array, &buffer, &offset );
+        GetGLState().bindBuffer( GL_COPY_WRITE_BUFFER, buffer );
+        glCopyBufferSubData( GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, copy.stagingOffset, offset + copy.offset,
+            copy.size );
+    }
+    _fences[ _region ] = glFenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0U );
+
+    // Draws issued after the copies see the data, so the asset is usable
+    // from this frame on.
+    for( size_t index = 0U; index < _completed.size(); index += 1U ) {
+        _completed[ index ]->packed = PackedMesh();
+        _completed[ index ]->state.store( AssetResident );
+    }
+}
+
+App::AssetState App::AssetStreamer::state( const unsigned int in_handle ) const {
+    if( in_handle >= _assets.size() )
+        return AssetFailed;
+    return (AssetState)_assets[ in_handle ]->state.load();
+}
+
+bool App::AssetStreamer::resident( const unsigned int in_handle ) const {
+    return state( in_handle ) == AssetResident;
+}
+
+const App::MeshResource& App::AssetStreamer::resource( const unsigned int in_handle ) const {
+    if( resident( in_handle ) == false )
+        return _placeholder;
+    return _assets[ in_handle ]->resource;
+}
+
+const App::MeshResource& App::AssetStreamer::placeholder( void ) const {
+    return _placeholder;
+}
+
+unsigned int App::AssetStreamer::version( const unsigned int in_handle ) const {
+    if( in_handle >= _assets.size() )
+        return 0U;
+    return _assets[ in_handle ]->version;
+}
+
+const std::vector< App::AssetReload >& App::AssetStreamer::reloads( void ) const {
+    return _reloads;
+}
+
+size_t App::AssetStreamer::frameBytes( void ) const {
+    return _frameBytes;
+}
+
+unsigned long long App::AssetStreamer::stalls( void ) const {
+    return _stalls;
+}
+
+bool App::AssetStreamer::busy( void ) const {
+    for( size_t handle = 0U; handle < _assets.size(); handle += 1U ) {
+        const int state = _assets[ handle ]->state.load();
+        if( state != AssetResident && state != AssetFailed )
+            return true;
+    }
+    return _reloading.empty() == false;
+}
+
+// Worker thread: parse queued assets until release().
+void App::AssetStreamer::work( void ) {
+    while( true ) {
+        Asset* asset = NULL;
+        {
+            std::unique_lock< std::mutex > lock( _mutex );
+            _work.wait( lock, [ this ]() { return _stopping == true || _requests.empty() == false; } );
+            if( _stopping == true )
+                return;
+            asset = _requests.front();
+            _requests.pop_front();
+        }
+        asset->state.store( AssetLoading );
+        if( asset->mesh.load( asset->fileName.c_str(), asset->useCache ) == false || asset->mesh.faceCount() == 0U ) {
+            asset->mesh.release();
+            asset->state.store( AssetFailed );
+            continue;
+        }
+
+        MeshResource& resource = asset->resource;
+        const MeshBuffer& mesh = asset->mesh;
+        resource.vertexCount = mesh.vertexCount();
+        resource.faceCount = mesh.faceCount();
+        resource.lods.assign( mesh.lods(), mesh.lods() + mesh.lodCount() );
+        resource.volume = mesh.volume();
+        PackMesh( mesh, &asset->packed );
+        if( _pool != NULL && _pool->indexSize() == 4U && asset->packed.indexSize == 2U )
+            WidenIndicies( &asset->packed );
+        resource.indexSize = asset->packed.indexSize;
+        resource.indexType = resource.indexSize == 2U ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+        resource.decode = asset->packed.decode;
+        asset->mesh.release();
+
+        asset->state.store( AssetUploading );
+        std::lock_guard< std::mutex > lock( _mutex );
+        _parsed.push_back( asset );
+    }
+}
+
+// Storage for the three arrays, in the pool when the indices fit it; the
+// data follows through the staging ring.
+void App::AssetStreamer::allocate( Asset* io_asset ) {
+    MeshResource& resource = io_asset->resource;
+    if( _pool != NULL && resource.indexSize == _pool->indexSize() ) {
+        resource.poolMesh = _pool->allocate( resource.vertexCount, 3U * resource.faceCount, resource.decode );
+        if( resource.poolMesh != GeometryPool::INVALID )
+            return;
+    }
+    resource.vertexBuffer = CreateBuffer( GL_COPY_WRITE_BUFFER, sizeof(PVertex) * resource.vertexCount, NULL );
+    resource.colorBuffer = CreateBuffer( GL_COPY_WRITE_BUFFER, sizeof(PColor) * resource.vertexCount, NULL );
+    resource.indexBuffer = CreateBuffer( GL_COPY_WRITE_BUFFER, 3U * resource.indexSize * resource.faceCount, NULL );
+}
+
+// Settle reloads: a resident one replaces the buffers of its asset, unless a
+// newer version is already in place, and a failed one leaves them alone.
+// An asset still streaming in keeps its reloads waiting.
+void App::AssetStreamer::swapReloads( void ) {
+    _reloads.clear();
+    for( size_t index = 0U; index < _reloading.size(); ) {
+        Asset* reload = _reloading[ index ];
+        Asset* target = _assets[ reload->handle ];
+        const int state = reload->state.load(), targetState = target->state.load();
+        if( ( state != AssetResident && state != AssetFailed )
+            || ( targetState != AssetResident && targetState != AssetFailed ) ) {
+            index += 1U;
+            continue;
+        }
+        const AssetReload result = { reload->handle, state == AssetResident };
+        if( state == AssetResident && reload->version > target->version ) {
+            releaseResource( &target->resource );
+            target->resource = reload->resource;
+            target->version = reload->version;
+            target->state.store( AssetResident );
+        } else {
+            releaseResource( &reload->resource );
+        }
+        _reloads.push_back( result );
+        delete reload;
+        _reloading[ index ] = _reloading.back();
+        _reloading.pop_back();
+    }
+}
+
+bool App::AssetStreamer::createPlaceholder( void ) {
+    AColor colors[ 8 ];
+    for( unsigned int index = 0U; index < 8U; index += 1U )
+        colors[ index ] = PLACEHOLDER_COLOR;
+    MeasureVolume( CUBE_VERTICIES, 8U, &_placeholder.volume );
+    PackedMesh packed;
+    PackMesh( CUBE_VERTICIES, colors, 8U, CUBE_INDICIES, 12U, _placeholder.volume, &packed );
+    _placeholder.vertexBuffer = CreateBuffer( GL_ARRAY_BUFFER, sizeof(PVertex) * 8U, packed.verticies.data() );
+    _placeholder.colorBuffer = CreateBuffer( GL_ARRAY_BUFFER, sizeof(PColor) * 8U, packed.colors.data() );
+    _placeholder.indexBuffer = CreateBuffer( GL_ARRAY_BUFFER, packed.indexBytes(), packed.indexData() );
+    _placeholder.vertexCount = 8U;
+    _placeholder.faceCount = 12U;
+    _placeholder.indexSize = packed.indexSize;
+    _placeholder.indexType = packed.indexSize == 2U ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+    _placeholder.decode = packed.decode;
+    const MeshLod lod = { 0U, 12U, 0.f };
+    _placeholder.lods.assign( 1U, lod );
+    return _placeholder.indexBuffer != 0U;
+}
+
+// Where array in_array of in_asset goes: its own buffer, or the range of
+// the pool at its current place.
+void App::AssetStreamer::target( const Asset& in_asset, const unsigned int in_array, GLuint* out_buffer,
+    GLintptr* out_offset ) const {
+    const MeshResource& resource = in_asset.resource;
+    if( resource.poolMesh == GeometryPool::INVALID ) {
+        const GLuint buffers[ 3 ] = { resource.vertexBuffer, resource.colorBuffer, resource.indexBuffer };
+        *out_buffer = buffers[ in_array ];
+        *out_offset = 0;
+        return;
+    }
+    const PoolMesh& mesh = _pool->mesh( resource.poolMesh );
+    const GLuint buffers[ 3 ] = { _pool->vertexBuffer(), _pool->colorBuffer(), _pool->indexBuffer() };
+    const GLintptr offsets[ 3 ] = { (GLintptr)( sizeof(PVertex) * mesh.baseVertex ),
+        (GLintptr)( sizeof(PColor) * mesh.baseVertex ), (GLintptr)_pool->indexSize() * mesh.firstIndex };
+    *out_buffer = buffers[ in_array ];
+    *out_offset = offsets[ in_array ];
+}
+
+void App::AssetStreamer::releaseResource( MeshResource* io_resource ) {
+    if( io_resource->poolMesh != GeometryPool::INVALID && _pool != NULL )
+        _pool->remove( io_resource->poolMesh );
+    io_resource->poolMesh = GeometryPool::INVALID;
+    const GLuint buffers[ 3 ] = { io_resource->vertexBuffer, io_resource->colorBuffer, io_resource->indexBuffer };
+    for( unsigned int index = 0U; index < 3U; index += 1U ) {
+        if( buffers[ index ] != 0U )
+            GetGLState().deleteBuffers( 1, &buffers[ index ] );
+    }
+    io_resource->vertexBuffer = io_resource->colorBuffer = io_resource->indexBuffer = 0U;
+}
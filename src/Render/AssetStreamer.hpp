@@ -0,0 +1,177 @@
+#ifndef __ASSET_STREAMER__
+#define __ASSET_STREAMER__
+
+#include <stddef.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "glad/glad.h"
+#include "MeshBuffer.hpp"
+#include "VertexPacking.hpp"
+#include "GeometryPool.hpp"
+
+namespace App {
+
+enum AssetState {
+    AssetQueued, AssetLoading, AssetUploading, AssetResident, AssetFailed
+};
+
+// GL buffers of a mesh in the packed formats of VertexPacking.hpp: its own,
+// or a range of the streamer's GeometryPool when poolMesh is valid.
+struct MeshResource {
+    MeshResource( void ) : vertexBuffer( 0U ), colorBuffer( 0U ), indexBuffer( 0U ), poolMesh( GeometryPool::INVALID ),
+        vertexCount( 0U ), faceCount( 0U ), indexType( GL_UNSIGNED_INT ), indexSize( 4U ) {}
+
+    GLuint                  vertexBuffer;   // PVertex
+    GLuint                  colorBuffer;    // PColor
+    GLuint                  indexBuffer;
+    unsigned int            poolMesh;       // Handle in the pool, INVALID for own buffers.
+    unsigned int            vertexCount;
+    unsigned int            faceCount;
+    GLenum                  indexType;      // GL_UNSIGNED_SHORT or GL_UNSIGNED_INT.
+    unsigned int            indexSize;      // Bytes per index.
+    PositionDecode          decode;
+    std::vector< MeshLod >  lods;
+    MeshVolume              volume;
+};
+
+// A reload finished by AssetStreamer::update().
+struct AssetReload {
+    unsigned int    handle;
+    bool            succeeded;      // False: the file did not parse, the old mesh stays.
+};
+
+/*
+Loads meshes without stalling the render loop.
+Worker threads parse and convert meshes with MeshBuffer::load and pack them
+with PackMesh, dropping the float arrays. The GL thread
+then copies at most the per-frame byte budget into a ring of staging
+regions and from there into the mesh buffers with glCopyBufferSubData, so a
+large mesh is spread over several frames. Until an asset is resident,
+resource() returns a placeholder cube. The packed copy is freed once the
+last byte is uploaded.
+reload() streams an asset's file again into buffers of its own; the current
+buffers stay drawn until the new ones are resident and are swapped at the
+start of an update(), or kept when the file no longer parses.
+
+Given a GeometryPool, meshes stream into ranges of the pool instead, so
+every resident mesh shares one set of buffers. Short indices are widened
+for a pool of 32-bit indices; a mesh whose indices do not fit the pool's
+size gets buffers of its own. The pool must outlive the streamer.
+
+    streamer.create( 2U, 256U * 1024U, &pool );   // or NULL for own buffers
+    const unsigned int teapot = streamer.request( "res/teapot" );
+    ...
+    streamer.update();                      // once per frame
+    const MeshResource& mesh = streamer.resource( teapot );
+
+Every method except the workers' runs on the thread owning the context.
+Buffers are bound through GetGLState() and left bound.
+*/
+class AssetStreamer {
+public:
+    AssetStreamer( void );
+    ~AssetStreamer( void );
+
+    // Start in_workers parse threads and upload at most in_budget bytes per
+    // update(), into io_pool when given. Needs a current context.
+    bool create( const unsigned int in_workers, const size_t in_budget, GeometryPool* io_pool = NULL );
+    void release( void );
+
+    // Queue in_fileName and return its handle. Requesting a file again
+    // returns the first handle.
+    unsigned int request( const char* in_fileName, const bool in_useCache = true );
+    // Parse the file of in_handle again and replace its buffers once the
+    // new ones are resident.
+    void reload( const unsigned int in_handle );
+    // Swap in finished reloads, move parsed assets to the upload queue and
+    // upload up to the budget.
+    void update( void );
+
+    AssetState state( const unsigned int in_handle ) const;
+    bool resident( const unsigned int in_handle ) const;
+    // The asset once resident, the placeholder until then.
+    const MeshResource& resource( const unsigned int in_handle ) const;
+    const MeshResource& placeholder( void ) const;
+    // Bumped whenever a reload replaces the buffers of in_handle.
+    unsigned int version( const unsigned int in_handle ) const;
+    // Reloads finished by the last update().
+    const std::vector< AssetReload >& reloads( void ) const;
+
+    // Bytes uploaded by the last update().
+    size_t frameBytes( void ) const;
+    // Times update() found its staging region still in use by the GPU.
+    unsigned long long stalls( void ) const;
+    // True while an asset or a reload is queued, parsing or uploading.
+    bool busy( void ) const;
+
+    static const unsigned int REGIONS = 3U;
+
+private:
+    AssetStreamer( const AssetStreamer& );
+    AssetStreamer& operator=( const AssetStreamer& );
+
+    struct Asset {
+        std::string             fileName;
+        bool                    useCache;
+        std::atomic< int >      state;
+        MeshBuffer              mesh;       // Freed once packed.
+        PackedMesh              packed;     // Freed once resident.
+        MeshResource            resource;
+        size_t                  uploaded;   // Bytes copied so far.
+        unsigned int            handle;
+        bool                    reload;     // Replaces the buffers of _assets[ handle ].
+        unsigned int            version;    // Of the buffers; a reload's is the one it installs.
+        unsigned int            requested;  // Last version handed to a reload.
+    };
+
+    // A staged range waiting for glCopyBufferSubData. The destination is
+    // looked up when the copy is issued, after any pool rebuild.
+    struct Copy {
+        const Asset*    asset;
+        unsigned int    array;      // Vertices, colors, indices.
+        GLintptr        offset;     // Into the array.
+        GLintptr        stagingOffset;
+        GLsizeiptr      size;
+    };
+
+    void work( void );
+    void allocate( Asset* io_asset );
+    void swapReloads( void );
+    bool createPlaceholder( void );
+    void target( const Asset& in_asset, const unsigned int in_array, GLuint* out_buffer, GLintptr* out_offset ) const;
+    void releaseResource( MeshResource* io_resource );
+
+private:
+    std::vector< Asset* >       _assets;    // Handle order.
+    std::vector< Asset* >       _reloading;
+    std::vector< AssetReload >  _reloads;
+    std::vector< std::thread >  _workers;
+
+    std::mutex                  _mutex;
+    std::condition_variable     _work;
+    std::deque< Asset* >        _requests;  // Guarded by _mutex.
+    std::deque< Asset* >        _parsed;    // Guarded by _mutex.
+    bool                        _stopping;  // Guarded by _mutex.
+
+    std::deque< Asset* >        _uploads;
+    std::vector< Copy >         _copies;
+    std::vector< Asset* >       _completed;
+    GLuint                      _staging;
+    GeometryPool*               _pool;
+    size_t                      _budget;
+    unsigned int                _region;
+    GLsync                      _fences[ REGIONS ];
+    MeshResource                _placeholder;
+    size_t                      _frameBytes;
+    unsigned long long          _stalls;
+};
+
+}
+
+#endif
@@ -0,0 +1,73 @@
+#include "BatchTransform.hpp"
+#include "BatchTransformKernel.hpp"
+
+namespace {
+
+App::TransformKernel DetectKernel( void ) {
+#if defined( BATCH_TRANSFORM_X86 )
+    // Reads CPUID, and XCR0 for AVX, so the OS must save the YMM registers.
+    __builtin_cpu_init();
+    if( __builtin_cpu_supports( "avx" ) )
+        return App::KernelAVX;
+    if( __builtin_cpu_supports( "sse2" ) )
+        return App::KernelSSE;
+#endif
+    return App::KernelScalar;
+}
+
+}
+
+void App::BatchTransform( const TransformSoA& in_bodies, const unsigned int in_count, const float in_base[ 16 ],
+    const float* in_viewProjection, float* out_models, float* out_mvps, const size_t in_stride,
+    const TransformKernel in_kernel ) {
+    const float* viewProjection = out_mvps == NULL ? NULL : in_viewProjection;
+    unsigned int done = 0U;
+    if( TransformKernelSupported( in_kernel ) == true ) {
+        switch( in_kernel ) {
+#if defined( BATCH_TRANSFORM_X86 )
+            case KernelAVX :
+            done = BatchTransformAVX( in_bodies, 0U, in_count, in_base, viewProjection,
+                out_models, out_mvps, in_stride );
+            break;
+#endif
+#if defined( __SSE2__ )
+            case KernelSSE :
+            done = TransformSteps< SseOps >( in_bodies, 0U, in_count, in_base, viewProjection,
+                out_models, out_mvps, in_stride );
+            break;
+#endif
+            default :
+            break;
+        }
+    }
+    TransformSteps< ScalarOps >( in_bodies, done, in_count - done, in_base, viewProjection,
+        out_models, out_mvps, in_stride );
+}
+
+void App::BatchTransform( const TransformSoA& in_bodies, const unsigned int in_count, const float in_base[ 16 ],
+    const float* in_viewProjection, float* out_models, float* out_mvps, const size_t in_stride ) {
+    BatchTransform( in_bodies, in_count, in_base, in_viewProjection, out_models, out_mvps, in_stride,
+        BestTransformKernel() );
+}
+
+App::TransformKernel App::BestTransformKernel( void ) {
+    static const TransformKernel best = DetectKernel();
+    return best;
+}
+
+bool App::TransformKernelSupported( const TransformKernel in_kernel ) {
+    return in_kernel <= BestTransformKernel();
+}
+
+const char* App::TransformKernelName( const TransformKernel in_kernel ) {
+    switch( in_kernel ) {
+        case KernelSSE :
+        return "sse";
+
+        case KernelAVX :
+        return "avx";
+
+        default :
+        return "scalar";
+    }
+}
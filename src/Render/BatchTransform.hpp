@@ -0,0 +1,50 @@
+#ifndef __BATCH_TRANSFORM__
+#define __BATCH_TRANSFORM__
+
+#include <stddef.h>
+
+namespace App {
+
+// Body state as structure of arrays, one float per body in each array.
+struct TransformSoA {
+    const float*    position[ 3 ];  // x, y, z
+    const float*    rotation[ 4 ];  // Unit quaternion x, y, z, w.
+    const float*    scale[ 3 ];     // x, y, z; all NULL for unit scale.
+};
+
+enum TransformKernel {
+    KernelScalar, KernelSSE, KernelAVX
+};
+
+/*
+Model and MVP matrices for many bodies at once:
+
+    model = [ rotation * scale | position ] * in_base
+    mvp   = in_viewProjection * model
+
+Matrices are column-major, 16 floats each, and consecutive bodies are
+in_stride bytes apart in out_models and out_mvps, so the models can be
+written straight into an array of AInstance. in_viewProjection and out_mvps
+may both be NULL.
+
+The SSE and AVX kernels take 4 and 8 bodies per step with the same
+operations in the same order as the scalar kernel and no fused
+multiply-add, so every kernel gives bit-identical results. Bodies left
+over after the last full step go through the scalar kernel.
+*/
+void BatchTransform( const TransformSoA& in_bodies, const unsigned int in_count, const float in_base[ 16 ],
+    const float* in_viewProjection, float* out_models, float* out_mvps, const size_t in_stride,
+    const TransformKernel in_kernel );
+// Same with the best kernel this CPU supports.
+void BatchTransform( const TransformSoA& in_bodies, const unsigned int in_count, const float in_base[ 16 ],
+    const float* in_viewProjection, float* out_models, float* out_mvps, const size_t in_stride );
+
+// Picked once by CPUID: AVX when the CPU and OS support it, then SSE on
+// x86, otherwise scalar.
+TransformKernel BestTransformKernel( void );
+bool TransformKernelSupported( const TransformKernel in_kernel );
+const char* TransformKernelName( const TransformKernel in_kernel );
+
+}
+
+#endif
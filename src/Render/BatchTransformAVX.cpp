@@ -0,0 +1,17 @@
+// Compiled with -mavx; only called after BestTransformKernel() saw AVX.
+#include "BatchTransformKernel.hpp"
+
+#if defined( BATCH_TRANSFORM_X86 )
+
+#if !defined( __AVX__ )
+#error "BatchTransformAVX.cpp must be compiled with -mavx."
+#endif
+
+unsigned int App::BatchTransformAVX( const TransformSoA& in_bodies, const unsigned int in_first,
+    const unsigned int in_count, const float in_base[ 16 ], const float* in_viewProjection,
+    float* out_models, float* out_mvps, const size_t in_stride ) {
+    return TransformSteps< AvxOps >( in_bodies, in_first, in_count, in_base, in_viewProjection,
+        out_models, out_mvps, in_stride );
+}
+
+#endif
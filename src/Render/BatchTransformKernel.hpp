@@ -0,0 +1,187 @@
+#ifndef __BATCH_TRANSFORM_KERNEL__
+#define __BATCH_TRANSFORM_KERNEL__
+
+/*
+Kernel shared by BatchTransform.cpp and BatchTransformAVX.cpp, which is
+compiled with -mavx. Everything here has internal linkage so the linker
+never merges an AVX-compiled copy into the portable translation unit.
+*/
+
+#include <stddef.h>
+
+#if defined( __SSE2__ )
+#include <emmintrin.h>
+#include <xmmintrin.h>
+#endif
+#if defined( __AVX__ )
+#include <immintrin.h>
+#endif
+
+#include "BatchTransform.hpp"
+
+#if defined( __x86_64__ ) || defined( __i386__ )
+#define BATCH_TRANSFORM_X86
+#endif
+
+namespace App {
+
+// Bodies [ in_first, in_first + 8 * n ) with n as large as fits in_count.
+// Returns the bodies done. Defined in BatchTransformAVX.cpp.
+unsigned int BatchTransformAVX( const TransformSoA& in_bodies, const unsigned int in_first,
+    const unsigned int in_count, const float in_base[ 16 ], const float* in_viewProjection,
+    float* out_models, float* out_mvps, const size_t in_stride );
+
+}
+
+namespace {
+
+// One body per lane.
+struct ScalarOps {
+    typedef float Vector;
+    static const unsigned int WIDTH = 1U;
+
+    static Vector Load( const float* in_source ) { return *in_source; }
+    static Vector Set( const float in_value ) { return in_value; }
+    static Vector Add( const Vector a, const Vector b ) { return a + b; }
+    static Vector Sub( const Vector a, const Vector b ) { return a - b; }
+    static Vector Mul( const Vector a, const Vector b ) { return a * b; }
+    static void StoreMatrix( const Vector in_matrix[ 16 ], float* out_matrix, const size_t ) {
+        for( unsigned int element = 0U; element < 16U; element += 1U )
+            out_matrix[ element ] = in_matrix[ element ];
+    }
+};
+
+#if defined( __SSE2__ )
+struct SseOps {
+    typedef __m128 Vector;
+    static const unsigned int WIDTH = 4U;
+
+    static Vector Load( const float* in_source ) { return _mm_loadu_ps( in_source ); }
+    static Vector Set( const float in_value ) { return _mm_set1_ps( in_value ); }
+    static Vector Add( const Vector a, const Vector b ) { return _mm_add_ps( a, b ); }
+    static Vector Sub( const Vector a, const Vector b ) { return _mm_sub_ps( a, b ); }
+    static Vector Mul( const Vector a, const Vector b ) { return _mm_mul_ps( a, b ); }
+    // Lanes are bodies: transpose each column so every body gets its own.
+    static void StoreMatrix( const Vector in_matrix[ 16 ], float* out_matrix, const size_t in_stride ) {
+        char* out = reinterpret_cast< char* >( out_matrix );
+        for( unsigned int column = 0U; column < 4U; column += 1U ) {
+            __m128 r0 = in_matrix[ 4U * column ], r1 = in_matrix[ 4U * column + 1U ],
+                r2 = in_matrix[ 4U * column + 2U ], r3 = in_matrix[ 4U * column + 3U ];
+            _MM_TRANSPOSE4_PS( r0, r1, r2, r3 );
+            _mm_storeu_ps( reinterpret_cast< float* >( out ) + 4U * column, r0 );
+            _mm_storeu_ps( reinterpret_cast< float* >( out + in_stride ) + 4U * column, r1 );
+            _mm_storeu_ps( reinterpret_cast< float* >( out + 2U * in_stride ) + 4U * column, r2 );
+            _mm_storeu_ps( reinterpret_cast< float* >( out + 3U * in_stride ) + 4U * column, r3 );
+        }
+    }
+};
+#endif
+
+#if defined( __AVX__ )
+struct AvxOps {
+    typedef __m256 Vector;
+    static const unsigned int WIDTH = 8U;
+
+    static Vector Load( const float* in_source ) { return _mm256_loadu_ps( in_source ); }
+    static Vector Set( const float in_value ) { return _mm256_set1_ps( in_value ); }
+    static Vector Add( const Vector a, const Vector b ) { return _mm256_add_ps( a, b ); }
+    static Vector Sub( const Vector a, const Vector b ) { return _mm256_sub_ps( a, b ); }
+    static Vector Mul( const Vector a, const Vector b ) { return _mm256_mul_ps( a, b ); }
+    // Bodies 0 to 3 are the low halves, 4 to 7 the high halves.
+    static void StoreMatrix( const Vector in_matrix[ 16 ], float* out_matrix, const size_t in_stride ) {
+        char* out = reinterpret_cast< char* >( out_matrix );
+        for( unsigned int half = 0U; half < 2U; half += 1U ) {
+            for( unsigned int column = 0U; column < 4U; column += 1U ) {
+                const Vector* rows = in_matrix + 4U * column;
+                __m128 r0 = half == 0U ? _mm256_castps256_ps128( rows[ 0 ] ) : _mm256_extractf128_ps( rows[ 0 ], 1 ),
+                    r1 = half == 0U ? _mm256_castps256_ps128( rows[ 1 ] ) : _mm256_extractf128_ps( rows[ 1 ], 1 ),
+                    r2 = half == 0U ? _mm256_castps256_ps128( rows[ 2 ] ) : _mm256_extractf128_ps( rows[ 2 ], 1 ),
+                    r3 = half == 0U ? _mm256_castps256_ps128( rows[ 3 ] ) : _mm256_extractf128_ps( rows[ 3 ], 1 );
+                _MM_TRANSPOSE4_PS( r0, r1, r2, r3 );
+                char* body = out + 4U * half * in_stride;
+                _mm_storeu_ps( reinterpret_cast< float* >( body ) + 4U * column, r0 );
+                _mm_storeu_ps( reinterpret_cast< float* >( body + in_stride ) + 4U * column, r1 );
+                _mm_storeu_ps( reinterpret_cast< float* >( body + 2U * in_stride ) + 4U * column, r2 );
+                _mm_storeu_ps( reinterpret_cast< float* >( body + 3U * in_stride ) + 4U * column, r3 );
+            }
+        }
+    }
+};
+#endif
+
+// Bodies [ in_first, in_first + Ops::WIDTH ). The operation order matches
+// App::ComposeInstance, so unit scale reproduces it bit for bit.
+template< typename Ops >
+inline void TransformStep( const App::TransformSoA& in_bodies, const unsigned int in_first, const float in_base[ 16 ],
+    const float* in_viewProjection, float* out_model, float* out_mvp, const size_t in_stride ) {
+    typedef typename Ops::Vector Vector;
+    const Vector one = Ops::Set( 1.f ), two = Ops::Set( 2.f );
+    const Vector x = Ops::Load( in_bodies.rotation[ 0 ] + in_first ), y = Ops::Load( in_bodies.rotation[ 1 ] + in_first ),
+        z = Ops::Load( in_bodies.rotation[ 2 ] + in_first ), w = Ops::Load( in_bodies.rotation[ 3 ] + in_first );
+    const Vector p[ 3 ] = { Ops::Load( in_bodies.position[ 0 ] + in_first ),
+        Ops::Load( in_bodies.position[ 1 ] + in_first ), Ops::Load( in_bodies.position[ 2 ] + in_first ) };
+
+    // Rotation matrix, column-major.
+    Vector r[ 9 ] = {
+        Ops::Sub( one, Ops::Mul( two, Ops::Add( Ops::Mul( y, y ), Ops::Mul( z, z ) ) ) ),
+        Ops::Mul( two, Ops::Add( Ops::Mul( x, y ), Ops::Mul( w, z ) ) ),
+        Ops::Mul( two, Ops::Sub( Ops::Mul( x, z ), Ops::Mul( w, y ) ) ),
+        Ops::Mul( two, Ops::Sub( Ops::Mul( x, y ), Ops::Mul( w, z ) ) ),
+        Ops::Sub( one, Ops::Mul( two, Ops::Add( Ops::Mul( x, x ), Ops::Mul( z, z ) ) ) ),
+        Ops::Mul( two, Ops::Add( Ops::Mul( y, z ), Ops::Mul( w, x ) ) ),
+        Ops::Mul( two, Ops::Add( Ops::Mul( x, z ), Ops::Mul( w, y ) ) ),
+        Ops::Mul( two, Ops::Sub( Ops::Mul( y, z ), Ops::Mul( w, x ) ) ),
+        Ops::Sub( one, Ops::Mul( two, Ops::Add( Ops::Mul( x, x ), Ops::Mul( y, y ) ) ) ) };
+    if( in_bodies.scale[ 0 ] != NULL ) {
+        for( unsigned int axis = 0U; axis < 3U; axis += 1U ) {
+            const Vector scale = Ops::Load( in_bodies.scale[ axis ] + in_first );
+            for( unsigned int row = 0U; row < 3U; row += 1U )
+                r[ 3U * axis + row ] = Ops::Mul( r[ 3U * axis + row ], scale );
+        }
+    }
+
+    Vector model[ 16 ];
+    for( unsigned int column = 0U; column < 4U; column += 1U ) {
+        const float* b = in_base + 4U * column;
+        const Vector b0 = Ops::Set( b[ 0 ] ), b1 = Ops::Set( b[ 1 ] ), b2 = Ops::Set( b[ 2 ] ), b3 = Ops::Set( b[ 3 ] );
+        for( unsigned int row = 0U; row < 3U; row += 1U )
+            model[ 4U * column + row ] = Ops::Add( Ops::Add( Ops::Add( Ops::Mul( r[ row ], b0 ),
+                Ops::Mul( r[ 3U + row ], b1 ) ), Ops::Mul( r[ 6U + row ], b2 ) ), Ops::Mul( p[ row ], b3 ) );
+        model[ 4U * column + 3U ] = b3;
+    }
+    Ops::StoreMatrix( model, out_model, in_stride );
+    if( in_viewProjection == NULL )
+        return;
+
+    const float* vp = in_viewProjection;
+    Vector mvp[ 16 ];
+    for( unsigned int row = 0U; row < 4U; row += 1U ) {
+        const Vector a0 = Ops::Set( vp[ row ] ), a1 = Ops::Set( vp[ 4U + row ] ),
+            a2 = Ops::Set( vp[ 8U + row ] ), a3 = Ops::Set( vp[ 12U + row ] );
+        for( unsigned int column = 0U; column < 4U; column += 1U ) {
+            const Vector* m = model + 4U * column;
+            mvp[ 4U * column + row ] = Ops::Add( Ops::Add( Ops::Add( Ops::Mul( a0, m[ 0 ] ),
+                Ops::Mul( a1, m[ 1 ] ) ), Ops::Mul( a2, m[ 2 ] ) ), Ops::Mul( a3, m[ 3 ] ) );
+        }
+    }
+    Ops::StoreMatrix( mvp, out_mvp, in_stride );
+}
+
+// Whole steps of Ops::WIDTH bodies from in_first; returns the bodies done.
+template< typename Ops >
+inline unsigned int TransformSteps( const App::TransformSoA& in_bodies, const unsigned int in_first,
+    const unsigned int in_count, const float in_base[ 16 ], const float* in_viewProjection,
+    float* out_models, float* out_mvps, const size_t in_stride ) {
+    const unsigned int done = in_count / Ops::WIDTH * Ops::WIDTH;
+    for( unsigned int index = in_first; index < in_first + done; index += Ops::WIDTH ) {
+        float* model = reinterpret_cast< float* >( reinterpret_cast< char* >( out_models ) + in_stride * index );
+        float* mvp = out_mvps == NULL ? NULL
+            : reinterpret_cast< float* >( reinterpret_cast< char* >( out_mvps ) + in_stride * index );
+        TransformStep< Ops >( in_bodies, index, in_base, in_viewProjection, model, mvp, in_stride );
+    }
+    return done;
+}
+
+}
+
+#endif
@@ -0,0 +1,182 @@
+#include "DrawList.hpp"
+#include "MeshSimplifier.hpp"
+#include "BatchTransform.hpp"
+
+#include <string.h>
+#include <cmath>
+#include <algorithm>
+
+namespace {
+
+// Nearest distance used for LOD selection, so a camera inside the bounding
+// sphere still selects the full mesh instead of dividing by zero.
+const float MIN_LOD_DISTANCE = 0.1f;
+
+// Column-major out = a * b.
+void Multiply( const float* a, const float* b, float* out ) {
+    for( unsigned int column = 0U; column < 4U; column += 1U )
+        for( unsigned int row = 0U; row < 4U; row += 1U )
+            out[ 4U * column + row ] = a[ row ] * b[ 4U * column ] + a[ 4U + row ] * b[ 4U * column + 1U ]
+                + a[ 8U + row ] * b[ 4U * column + 2U ] + a[ 12U + row ] * b[ 4U * column + 3U ];
+}
+
+}
+
+App::DrawList::DrawList( void ) : _boundRadius( 0.f ), _modelScale( 1.f ), _lods( NULL ),
+    _lodCount( 0U ), _pixelScale( 1.f ), _lodTolerance( 1.f ), _visibleCount( 0U ) {
+    const CullStats none = { 0U, 0U, 0U, 0U };
+    _cullStats = none;
+    for( unsigned int index = 0U; index < 16U; index += 1U ) {
+        _base[ index ] = index % 5U == 0U ? 1.f : 0.f;
+        _view[ index ] = _base[ index ];
+    }
+    for( unsigned int axis = 0U; axis < 3U; axis += 1U )
+        _boundCenter[ axis ] = 0.f;
+    memset( _planes, 0, sizeof(_planes) );
+}
+
+void App::DrawList::setMesh( const float in_base[ 16 ], const float in_boundCenter[ 3 ],
+    const float in_boundRadius, const MeshLod* in_lods, const unsigned int in_lodCount ) {
+    memcpy( _base, in_base, sizeof(_base) );
+    memcpy( _boundCenter, in_boundCenter, sizeof(_boundCenter) );
+    _boundRadius = in_boundRadius;
+    // Rotations keep lengths; the base may scale.
+    _modelScale = std::sqrt( in_base[ 0 ] * in_base[ 0 ] + in_base[ 1 ] * in_base[ 1 ] + in_base[ 2 ] * in_base[ 2 ] );
+    _lods = in_lods;
+    _lodCount = in_lodCount;
+}
+
+void App::DrawList::setCamera( const float in_view[ 16 ], const float in_projection[ 16 ],
+    const float in_viewportHeight, const float in_lodTolerance ) {
+    memcpy( _view, in_view, sizeof(_view) );
+    _pixelScale = in_projection[ 5 ] * 0.5f * in_viewportHeight;
+    _lodTolerance = in_lodTolerance;
+
+    // Frustum planes from the rows of projection * view.
+    float clip[ 16 ];
+    Multiply( in_projection, in_view, clip );
+    for( unsigned int plane = 0U; plane < 6U; plane += 1U ) {
+        const unsigned int row = plane / 2U;
+        const float sign = plane % 2U == 0U ? 1.f : -1.f;
+        for( unsigned int column = 0U; column < 4U; column += 1U )
+            _planes[ plane ][ column ] = clip[ 4U * column + 3U ] + sign * clip[ 4U * column + row ];
+        const float length = std::sqrt( _planes[ plane ][ 0 ] * _planes[ plane ][ 0 ]
+            + _planes[ plane ][ 1 ] * _planes[ plane ][ 1 ] + _planes[ plane ][ 2 ] * _planes[ plane ][ 2 ] );
+        if( length > 0.f )
+            for( unsigned int column = 0U; column < 4U; column += 1U )
+                _planes[ plane ][ column ] /= length;
+    }
+}
+
+void App::DrawList::transform( const float* in_positions, const float* in_rotations, const size_t in_stride,
+    const float* in_colors, const unsigned int in_count ) {
+    _composed.resize( in_count );
+    _spheres.resize( 4U * in_count );
+    if( in_count == 0U )
+        return;
+
+    // Gather into seven arrays for the SIMD kernel.
+    _soa.resize( 7U * in_count );
+    TransformSoA bodies;
+    for( unsigned int axis = 0U; axis < 3U; axis += 1U ) {
+        bodies.position[ axis ] = &_soa[ axis * in_count ];
+        bodies.scale[ axis ] = NULL;
+    }
+    for( unsigned int axis = 0U; axis < 4U; axis += 1U )
+        bodies.rotation[ axis ] = &_soa[ ( 3U + axis ) * in_count ];
+    for( unsigned int index = 0U; index < in_count; index += 1U ) {
+        const float* position = reinterpret_cast< const float* >(
+            reinterpret_cast< const char* >( in_positions ) + in_stride * index );
+        const float* rotation = reinterpret_cast< const float* >(
+            reinterpret_cast< const char* >( in_rotations ) + in_stride * index );
+        for( unsigned int axis = 0U; axis < 3U; axis += 1U )
+            _soa[ axis * in_count + index ] = position[ axis ];
+        for( unsigned int axis = 0U; axis < 4U; axis += 1U )
+            _soa[ ( 3U + axis ) * in_count + index ] = rotation[ axis ];
+    }
+    BatchTransform( bodies, in_count, _base, NULL, _composed[ 0 ].model, NULL, sizeof(AInstance) );
+
+    const float radius = _boundRadius * _modelScale;
+    for( unsigned int index = 0U; index < in_count; index += 1U ) {
+        AInstance& instance = _composed[ index ];
+        memcpy( instance.color, in_colors + 4U * index, sizeof(instance.color) );
+        float* sphere = &_spheres[ 4U * index ];
+        for( unsigned int axis = 0U; axis < 3U; axis += 1U )
+            sphere[ axis ] = instance.model[ axis ] * _boundCenter[ 0 ] + instance.model[ 4U + axis ] * _boundCenter[ 1 ]
+                + instance.model[ 8U + axis ] * _boundCenter[ 2 ] + instance.model[ 12U + axis ];
+        sphere[ 3 ] = radius;
+    }
+}
+
+void App::DrawList::cull( const CullMethod in_method ) {
+    const unsigned int count = (unsigned int)_composed.size();
+    _lodOf.assign( count, -1 );
+    _visible.clear();
+    const float* spheres = _spheres.empty() ? NULL : &_spheres[ 0 ];
+    if( in_method == CullTree ) {
+        _tree.update( spheres, count );
+        _tree.cull( _planes, &_visible, &_cullStats );
+    } else {
+        CullSpheres( _planes, spheres, count, &_visible, &_cullStats );
+    }
+    if( _lodCount == 0U ) {
+        _cullStats.culled = count;
+        _cullStats.submitted = 0U;
+        return;
+    }
+    for( size_t index = 0U; index < _visible.size(); index += 1U ) {
+        const float* sphere = &_spheres[ 4U * _visible[ index ] ];
+        // Pixels covered by one object unit at the sphere center's depth.
+        const float viewZ = _view[ 2 ] * sphere[ 0 ] + _view[ 6 ] * sphere[ 1 ] + _view[ 10 ] * sphere[ 2 ] + _view[ 14 ];
+        const float distance = std::max( -viewZ, MIN_LOD_DISTANCE );
+        _lodOf[ _visible[ index ] ] = (int)SelectLod( _lods, _lodCount, _pixelScale * _modelScale / distance, _lodTolerance );
+    }
+}
+
+void App::DrawList::build( void ) {
+    const unsigned int count = (unsigned int)_composed.size();
+    std::vector< unsigned int >& first = _first;
+    first.assign( _lodCount + 1U, 0U );
+    for( unsigned int index = 0U; index < count; index += 1U )
+        if( _lodOf[ index ] >= 0 )
+            first[ _lodOf[ index ] + 1U ] += 1U;
+    for( unsigned int level = 0U; level < _lodCount; level += 1U )
+        first[ level + 1U ] += first[ level ];
+    _visibleCount = _lodCount > 0U ? first[ _lodCount ] : 0U;
+
+    _ranges.clear();
+    for( unsigned int level = 0U; level < _lodCount; level += 1U ) {
+        if( first[ level + 1U ] == first[ level ] )
+            continue;
+        DrawRange range;
+        range.lod = level;
+        range.firstInstance = first[ level ];
+        range.instanceCount = first[ level + 1U ] - first[ level ];
+        _ranges.push_back( range );
+    }
+
+    _sorted.resize( _visibleCount );
+    for( unsigned int index = 0U; index < count; index += 1U )
+        if( _lodOf[ index ] >= 0 )
+            _sorted[ first[ _lodOf[ index ] ]++ ] = _composed[ index ];
+}
+
+const App::AInstance* App::DrawList::instances( void ) const {
+    return _sorted.empty() ? NULL : &_sorted[ 0 ];
+}
+
+unsigned int App::DrawList::visibleCount( void ) const {
+    return _visibleCount;
+}
+
+unsigned int App::DrawList::totalCount( void ) const {
+    return (unsigned int)_composed.size();
+}
+
+const App::CullStats& App::DrawList::cullStats( void ) const {
+    return _cullStats;
+}
+
+const std::vector< App::DrawRange >& App::DrawList::ranges( void ) const {
+    return _ranges;
+}
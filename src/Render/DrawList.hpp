@@ -0,0 +1,91 @@
+#ifndef __DRAW_LIST__
+#define __DRAW_LIST__
+
+#include <stddef.h>
+#include <vector>
+
+#include "MeshBuffer.hpp"
+#include "InstanceBuffer.hpp"
+#include "FrustumCull.hpp"
+
+namespace App {
+
+// Instances [ firstInstance, firstInstance + instanceCount ) drawn at one LOD.
+struct DrawRange {
+    unsigned int    lod;
+    unsigned int    firstInstance;
+    unsigned int    instanceCount;
+};
+
+// Test every sphere, or walk a tree refitted over them each frame. With
+// every body moving the refit costs more than the linear test saves; see
+// bench/FrustumCull.cpp.
+enum CullMethod {
+    CullLinear, CullTree
+};
+
+/*
+Per-frame list of instanced draws of one mesh, built in three passes so each
+can be timed on its own:
+
+    list.transform( ... );  // model matrices and world bounding spheres
+    list.cull();            // frustum test and LOD per instance
+    list.build();           // visible instances grouped by LOD
+
+instances() is then one contiguous block to copy into an InstanceBuffer
+region, and each DrawRange is one glDrawElementsInstanced call.
+*/
+class DrawList {
+public:
+    DrawList( void );
+
+    // in_base maps object space to body space, column-major. The bounding
+    // sphere is in object space.
+    void setMesh( const float in_base[ 16 ], const float in_boundCenter[ 3 ], const float in_boundRadius,
+        const MeshLod* in_lods, const unsigned int in_lodCount );
+    // Column-major matrices; in_viewportHeight in pixels.
+    void setCamera( const float in_view[ 16 ], const float in_projection[ 16 ],
+        const float in_viewportHeight, const float in_lodTolerance );
+
+    // Bodies are read with in_stride bytes between consecutive positions
+    // and rotations, e.g. straight out of a std::vector< BodyTransform >.
+    void transform( const float* in_positions, const float* in_rotations, const size_t in_stride,
+        const float* in_colors, const unsigned int in_count );
+    void cull( const CullMethod in_method = CullLinear );
+    void build( void );
+
+    const AInstance* instances( void ) const;
+    unsigned int visibleCount( void ) const;
+    unsigned int totalCount( void ) const;
+    // Of the last cull().
+    const CullStats& cullStats( void ) const;
+    const std::vector< DrawRange >& ranges( void ) const;
+
+private:
+    float                       _base[ 16 ];
+    float                       _boundCenter[ 3 ];
+    float                       _boundRadius;
+    float                       _modelScale;
+    const MeshLod*              _lods;
+    unsigned int                _lodCount;
+    float                       _view[ 16 ];
+    float                       _planes[ 6 ][ 4 ];   // Normalized, pointing inwards.
+    float                       _pixelScale;        // projection[ 1 ][ 1 ] * height / 2
+    float                       _lodTolerance;
+
+    std::vector< float >        _soa;               // Positions, then rotations, by component.
+    std::vector< AInstance >    _composed;
+    std::vector< float >        _spheres;           // World center and radius.
+    SphereBvh                   _tree;
+    std::vector< unsigned int > _visible;           // Instances passing the frustum test.
+    CullStats                   _cullStats;
+    std::vector< int >          _lodOf;             // -1 when culled.
+    std::vector< unsigned int > _first;             // Start of each LOD in _sorted.
+    std::vector< AInstance >    _sorted;
+    std::vector< DrawRange >    _ranges;
+    unsigned int                _visibleCount;
+};
+
+}
+
+#endif
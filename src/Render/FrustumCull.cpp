@@ -0,0 +1,394 @@
+#include "FrustumCull.hpp"
+
+#include <stddef.h>
+#include <cmath>
+#include <algorithm>
+#include <limits>
+
+#if defined( __SSE2__ )
+#include <xmmintrin.h>
+#endif
+
+namespace {
+
+const unsigned int ALL_PLANES = 0x3FU;
+// Slot of a padding sphere.
+const unsigned int PADDING = ~0U;
+// Deeper than a median-split tree over 2^32 spheres.
+const unsigned int STACK_SIZE = 64U;
+
+// Planes by component; planes 6 and 7 pad the second SSE step and contain
+// everything.
+struct Frustum {
+    alignas( 16 ) float x[ 8 ];
+    alignas( 16 ) float y[ 8 ];
+    alignas( 16 ) float z[ 8 ];
+    alignas( 16 ) float w[ 8 ];
+    alignas( 16 ) float absX[ 8 ];
+    alignas( 16 ) float absY[ 8 ];
+    alignas( 16 ) float absZ[ 8 ];
+#if defined( __SSE2__ )
+    __m128              splat[ 6 ][ 4 ];    // Each coefficient in every lane.
+#endif
+};
+
+void LoadFrustum( const float in_planes[ 6 ][ 4 ], Frustum* out_frustum ) {
+    for( unsigned int plane = 0U; plane < 8U; plane += 1U ) {
+        const bool pad = plane >= 6U;
+        out_frustum->x[ plane ] = pad ? 0.f : in_planes[ plane ][ 0 ];
+        out_frustum->y[ plane ] = pad ? 0.f : in_planes[ plane ][ 1 ];
+        out_frustum->z[ plane ] = pad ? 0.f : in_planes[ plane ][ 2 ];
+        out_frustum->w[ plane ] = pad ? 1.f : in_planes[ plane ][ 3 ];
+        out_frustum->absX[ plane ] = std::abs( out_frustum->x[ plane ] );
+        out_frustum->absY[ plane ] = std::abs( out_frustum->y[ plane ] );
+        out_frustum->absZ[ plane ] = std::abs( out_frustum->z[ plane ] );
+    }
+#if defined( __SSE2__ )
+    for( unsigned int plane = 0U; plane < 6U; plane += 1U )
+        for( unsigned int column = 0U; column < 4U; column += 1U )
+            out_frustum->splat[ plane ][ column ] = _mm_set1_ps( in_planes[ plane ][ column ] );
+#endif
+}
+
+// Bit p of out_outside is set when the box lies behind plane p, bit p of
+// out_inside when it lies in front of it.
+void ClassifyBox( const Frustum& in_frustum, const float in_center[ 3 ], const float in_extent[ 3 ],
+    unsigned int* out_outside, unsigned int* out_inside ) {
+#if defined( __SSE2__ )
+    const __m128 centerX = _mm_set1_ps( in_center[ 0 ] ), centerY = _mm_set1_ps( in_center[ 1 ] ),
+        centerZ = _mm_set1_ps( in_center[ 2 ] ), extentX = _mm_set1_ps( in_extent[ 0 ] ),
+        extentY = _mm_set1_ps( in_extent[ 1 ] ), extentZ = _mm_set1_ps( in_extent[ 2 ] );
+    *out_outside = 0U;
+    *out_inside = 0U;
+    for( unsigned int step = 0U; step < 8U; step += 4U ) {
+        const __m128 distance = _mm_add_ps( _mm_add_ps( _mm_add_ps(
+            _mm_mul_ps( centerX, _mm_load_ps( in_frustum.x + step ) ),
+            _mm_mul_ps( centerY, _mm_load_ps( in_frustum.y + step ) ) ),
+            _mm_mul_ps( centerZ, _mm_load_ps( in_frustum.z + step ) ) ),
+            _mm_load_ps( in_frustum.w + step ) );
+        const __m128 radius = _mm_add_ps( _mm_add_ps(
+            _mm_mul_ps( extentX, _mm_load_ps( in_frustum.absX + step ) ),
+            _mm_mul_ps( extentY, _mm_load_ps( in_frustum.absY + step ) ) ),
+            _mm_mul_ps( extentZ, _mm_load_ps( in_frustum.absZ + step ) ) );
+        *out_outside |= (unsigned int)_mm_movemask_ps(
+            _mm_cmplt_ps( distance, _mm_sub_ps( _mm_setzero_ps(), radius ) ) ) << step;
+        *out_inside |= (unsigned int)_mm_movemask_ps( _mm_cmpge_ps( distance, radius ) ) << step;
+    }
+#else
+    *out_outside = 0U;
+    *out_inside = 0U;
+    for( unsigned int plane = 0U; plane < 6U; plane += 1U ) {
+        const float distance = in_center[ 0 ] * in_frustum.x[ plane ] + in_center[ 1 ] * in_frustum.y[ plane ]
+            + in_center[ 2 ] * in_frustum.z[ plane ] + in_frustum.w[ plane ];
+        const float radius = in_extent[ 0 ] * in_frustum.absX[ plane ] + in_extent[ 1 ] * in_frustum.absY[ plane ]
+            + in_extent[ 2 ] * in_frustum.absZ[ plane ];
+        if( distance < -radius )
+            *out_outside |= 1U << plane;
+        if( distance >= radius )
+            *out_inside |= 1U << plane;
+    }
+#endif
+}
+
+bool SphereVisible( const Frustum& in_frustum, const unsigned int in_planes,
+    const float x, const float y, const float z, const float radius ) {
+    for( unsigned int plane = 0U; plane < 6U; plane += 1U )
+        if( ( in_planes & ( 1U << plane ) ) != 0U && x * in_frustum.x[ plane ] + y * in_frustum.y[ plane ]
+            + z * in_frustum.z[ plane ] + in_frustum.w[ plane ] < -radius )
+            return false;
+    return true;
+}
+
+#if defined( __SSE2__ )
+// Bit n is set when sphere n of the four lanes is visible.
+unsigned int SpheresVisible( const Frustum& in_frustum, const unsigned int in_planes,
+    const __m128 x, const __m128 y, const __m128 z, const __m128 radius ) {
+    const __m128 negative = _mm_sub_ps( _mm_setzero_ps(), radius );
+    __m128 visible = _mm_cmpeq_ps( negative, negative );
+    for( unsigned int index = 0U; index < 6U; index += 1U ) {
+        if( ( in_planes & ( 1U << index ) ) == 0U )
+            continue;
+        const __m128* plane = in_frustum.splat[ index ];
+        const __m128 distance = _mm_add_ps( _mm_add_ps( _mm_add_ps( _mm_mul_ps( x, plane[ 0 ] ),
+            _mm_mul_ps( y, plane[ 1 ] ) ), _mm_mul_ps( z, plane[ 2 ] ) ), plane[ 3 ] );
+        visible = _mm_and_ps( visible, _mm_cmpge_ps( distance, negative ) );
+    }
+    return (unsigned int)_mm_movemask_ps( visible );
+}
+#endif
+
+// Four spheres stored by component.
+unsigned int GroupVisible( const Frustum& in_frustum, const unsigned int in_planes,
+    const float* x, const float* y, const float* z, const float* radius ) {
+#if defined( __SSE2__ )
+    return SpheresVisible( in_frustum, in_planes, _mm_loadu_ps( x ), _mm_loadu_ps( y ),
+        _mm_loadu_ps( z ), _mm_loadu_ps( radius ) );
+#else
+    unsigned int visible = 0U;
+    for( unsigned int lane = 0U; lane < 4U; lane += 1U )
+        if( SphereVisible( in_frustum, in_planes, x[ lane ], y[ lane ], z[ lane ], radius[ lane ] ) == true )
+            visible |= 1U << lane;
+    return visible;
+#endif
+}
+
+struct CenterLess {
+    const float*    spheres;
+    unsigned int    axis;
+
+    bool operator()( const unsigned int a, const unsigned int b ) const {
+        return spheres[ 4U * a + axis ] < spheres[ 4U * b + axis ];
+    }
+};
+
+}
+
+void App::CullSpheres( const float in_planes[ 6 ][ 4 ], const float* in_spheres, const unsigned int in_count,
+    std::vector< unsigned int >* out_visible, CullStats* out_stats ) {
+    Frustum frustum;
+    LoadFrustum( in_planes, &frustum );
+    // Room for every sphere, trimmed to the visible ones at the end.
+    const size_t first = out_visible->size();
+    out_visible->resize( first + in_count + 1U );
+    unsigned int* visible = &( *out_visible )[ first ];
+    unsigned int index = 0U;
+#if defined( __SSE2__ )
+    for( ; index + 4U <= in_count; index += 4U ) {
+        // Four ( x, y, z, radius ) rows to x, y, z and radius columns.
+        __m128 x = _mm_loadu_ps( in_spheres + 4U * index ), y = _mm_loadu_ps( in_spheres + 4U * index + 4U ),
+            z = _mm_loadu_ps( in_spheres + 4U * index + 8U ), radius = _mm_loadu_ps( in_spheres + 4U * index + 12U );
+        _MM_TRANSPOSE4_PS( x, y, z, radius );
+        const unsigned int lanes = SpheresVisible( frustum, ALL_PLANES, x, y, z, radius );
+        for( unsigned int lane = 0U; lane < 4U; lane += 1U ) {
+            *visible = index + lane;
+            visible += ( lanes >> lane ) & 1U;
+        }
+    }
+#endif
+    for( ; index < in_count; index += 1U ) {
+        const float* sphere = in_spheres + 4U * index;
+        *visible = index;
+        visible += SphereVisible( frustum, ALL_PLANES, sphere[ 0 ], sphere[ 1 ], sphere[ 2 ], sphere[ 3 ] ) ? 1U : 0U;
+    }
+    out_visible->resize( visible - &( *out_visible )[ 0 ] );
+    if( out_stats != NULL ) {
+        out_stats->nodes = 0U;
+        out_stats->tested = in_count;
+        out_stats->submitted = (unsigned int)( out_visible->size() - first );
+        out_stats->culled = in_count - out_stats->submitted;
+    }
+}
+
+const float App::SphereBvh::REBUILD_GROWTH = 2.f;
+
+App::SphereBvh::SphereBvh( void ) : _count( 0U ), _area( 0.f ), _builtArea( 0.f ), _rebuilds( 0U ) {
+}
+
+void App::SphereBvh::update( const float* in_spheres, const unsigned int in_count ) {
+    if( in_count != _count ) {
+        build( in_spheres, in_count );
+        return;
+    }
+    refit( in_spheres );
+    if( _area > REBUILD_GROWTH * _builtArea )
+        build( in_spheres, in_count );
+}
+
+void App::SphereBvh::build( const float* in_spheres, const unsigned int in_count ) {
+    _count = in_count;
+    _nodes.clear();
+    _ids.clear();
+    _rebuilds += 1U;
+    if( in_count == 0U ) {
+        _slots.clear();
+        _area = 0.f;
+        _builtArea = 0.f;
+        return;
+    }
+    std::vector< unsigned int > ids( in_count );
+    for( unsigned int index = 0U; index < in_count; index += 1U )
+        ids[ index ] = index;
+    _nodes.reserve( 4U * in_count / LEAF_SIZE + 1U );
+    _ids.reserve( in_count + in_count / 2U + 4U );
+    _nodes.resize( 1U );
+    split( in_spheres, &ids[ 0 ], in_count, 0U );
+
+    // Padding slots keep the sphere that is never visible.
+    const size_t slots = _ids.size();
+    _slots.assign( 4U * slots, 0.f );
+    for( size_t slot = 0U; slot < slots; slot += 1U )
+        if( _ids[ slot ] == PADDING )
+            _slots[ 3U * slots + slot ] = -std::numeric_limits< float >::infinity();
+    refit( in_spheres );
+    _builtArea = _area;
+}
+
+// Fill node in_node with in_ids, appending its slots.
+void App::SphereBvh::split( const float* in_spheres, unsigned int* io_ids, const unsigned int in_count,
+    const unsigned int in_node ) {
+    _nodes[ in_node ].begin = (unsigned int)_ids.size();
+    if( in_count <= LEAF_SIZE ) {
+        _nodes[ in_node ].child = 0U;
+        _ids.insert( _ids.end(), io_ids, io_ids + in_count );
+        _ids.resize( ( _ids.size() + 3U ) & ~(size_t)3U, PADDING );
+        _nodes[ in_node ].end = (unsigned int)_ids.size();
+        return;
+    }
+
+    float low[ 3 ], high[ 3 ];
+    for( unsigned int axis = 0U; axis < 3U; axis += 1U )
+        low[ axis ] = high[ axis ] = in_spheres[ 4U * io_ids[ 0 ] + axis ];
+    for( unsigned int index = 1U; index < in_count; index += 1U )
+        for( unsigned int axis = 0U; axis < 3U; axis += 1U ) {
+            low[ axis ] = std::min( low[ axis ], in_spheres[ 4U * io_ids[ index ] + axis ] );
+            high[ axis ] = std::max( high[ axis ], in_spheres[ 4U * io_ids[ index ] + axis ] );
+        }
+    CenterLess less = { in_spheres, 0U };
+    for( unsigned int axis = 1U; axis < 3U; axis += 1U )
+        if( high[ axis ] - low[ axis ] > high[ less.axis ] - low[ less.axis ] )
+            less.axis = axis;
+    // A left half that is a multiple of 4 fills its leaves without padding.
+    const unsigned int half = ( in_count / 2U + 3U ) & ~3U;
+    std::nth_element( io_ids, io_ids + half, io_ids + in_count, less );
+
+    const unsigned int child = (unsigned int)_nodes.size();
+    _nodes.resize( child + 2U );
+    _nodes[ in_node ].child = child;
+    split( in_spheres, io_ids, half, child );
+    split( in_spheres, io_ids + half, in_count - half, child + 1U );
+    _nodes[ in_node ].end = (unsigned int)_ids.size();
+}
+
+void App::SphereBvh::refit( const float* in_spheres ) {
+    const size_t slots = _ids.size();
+    float* x = _slots.empty() ? NULL : &_slots[ 0 ];
+    float* y = x + slots;
+    float* z = y + slots;
+    float* radius = z + slots;
+    _area = 0.f;
+    for( size_t index = _nodes.size(); index > 0U; index -= 1U ) {
+        Node& node = _nodes[ index - 1U ];
+        float low[ 3 ], high[ 3 ];
+        if( node.child == 0U ) {
+#if defined( __SSE2__ )
+            __m128 lowest = _mm_set1_ps( std::numeric_limits< float >::infinity() );
+            __m128 highest = _mm_sub_ps( _mm_setzero_ps(), lowest );
+#else
+            for( unsigned int axis = 0U; axis < 3U; axis += 1U ) {
+                low[ axis ] = std::numeric_limits< float >::infinity();
+                high[ axis ] = -std::numeric_limits< float >::infinity();
+            }
+#endif
+            for( unsigned int slot = node.begin; slot < node.end && _ids[ slot ] != PADDING; slot += 1U ) {
+                const float* sphere = in_spheres + 4U * _ids[ slot ];
+                x[ slot ] = sphere[ 0 ];
+                y[ slot ] = sphere[ 1 ];
+                z[ slot ] = sphere[ 2 ];
+                radius[ slot ] = sphere[ 3 ];
+#if defined( __SSE2__ )
+                const __m128 center = _mm_loadu_ps( sphere );
+                const __m128 size = _mm_shuffle_ps( center, center, _MM_SHUFFLE( 3, 3, 3, 3 ) );
+                lowest = _mm_min_ps( lowest, _mm_sub_ps( center, size ) );
+                highest = _mm_max_ps( highest, _mm_add_ps( center, size ) );
+#else
+                for( unsigned int axis = 0U; axis < 3U; axis += 1U ) {
+                    low[ axis ] = std::min( low[ axis ], sphere[ axis ] - sphere[ 3 ] );
+                    high[ axis ] = std::max( high[ axis ], sphere[ axis ] + sphere[ 3 ] );
+                }
+#endif
+            }
+#if defined( __SSE2__ )
+            float lanes[ 2 ][ 4 ];
+            _mm_storeu_ps( lanes[ 0 ], lowest );
+            _mm_storeu_ps( lanes[ 1 ], highest );
+            for( unsigned int axis = 0U; axis < 3U; axis += 1U ) {
+                low[ axis ] = lanes[ 0 ][ axis ];
+                high[ axis ] = lanes[ 1 ][ axis ];
+            }
+#endif
+        } else {
+            const Node& left = _nodes[ node.child ];
+            const Node& right = _nodes[ node.child + 1U ];
+            for( unsigned int axis = 0U; axis < 3U; axis += 1U ) {
+                low[ axis ] = std::min( left.center[ axis ] - left.extent[ axis ],
+                    right.center[ axis ] - right.extent[ axis ] );
+                high[ axis ] = std::max( left.center[ axis ] + left.extent[ axis ],
+                    right.center[ axis ] + right.extent[ axis ] );
+            }
+        }
+        for( unsigned int axis = 0U; axis < 3U; axis += 1U ) {
+            node.center[ axis ] = ( low[ axis ] + high[ axis ] ) * 0.5f;
+            node.extent[ axis ] = ( high[ axis ] - low[ axis ] ) * 0.5f;
+        }
+        _area += node.extent[ 0 ] * node.extent[ 1 ] + node.extent[ 1 ] * node.extent[ 2 ]
+            + node.extent[ 2 ] * node.extent[ 0 ];
+    }
+}
+
+void App::SphereBvh::cull( const float in_planes[ 6 ][ 4 ], std::vector< unsigned int >* out_visible,
+    CullStats* out_stats ) const {
+    CullStats stats = { 0U, 0U, 0U, 0U };
+    const size_t first = out_visible->size();
+    out_visible->resize( first + _count + 1U );
+    unsigned int* visible = &( *out_visible )[ first ];
+    if( _nodes.empty() == false ) {
+        Frustum frustum;
+        LoadFrustum( in_planes, &frustum );
+        const size_t slots = _ids.size();
+        const float* x = &_slots[ 0 ];
+        const float* y = x + slots;
+        const float* z = y + slots;
+        const float* radius = z + slots;
+
+        // Node and the planes still cutting its parent.
+        unsigned int stack[ STACK_SIZE ][ 2 ];
+        unsigned int depth = 1U;
+        stack[ 0 ][ 0 ] = 0U;
+        stack[ 0 ][ 1 ] = ALL_PLANES;
+        while( depth > 0U ) {
+            depth -= 1U;
+            const Node& node = _nodes[ stack[ depth ][ 0 ] ];
+            unsigned int outside, inside;
+            ClassifyBox( frustum, node.center, node.extent, &outside, &inside );
+            stats.nodes += 1U;
+            if( ( outside & stack[ depth ][ 1 ] ) != 0U )
+                continue;
+            const unsigned int planes = stack[ depth ][ 1 ] & ~inside;
+            if( planes == 0U ) {
+                for( unsigned int slot = node.begin; slot < node.end; slot += 1U ) {
+                    *visible = _ids[ slot ];
+                    visible += _ids[ slot ] != PADDING ? 1U : 0U;
+                }
+            } else if( node.child == 0U ) {
+                for( unsigned int slot = node.begin; slot < node.end; slot += 4U ) {
+                    const unsigned int lanes = GroupVisible( frustum, planes, x + slot, y + slot, z + slot, radius + slot );
+                    for( unsigned int lane = 0U; lane < 4U; lane += 1U ) {
+                        *visible = _ids[ slot + lane ];
+                        visible += ( lanes >> lane ) & 1U;
+                    }
+                }
+                for( unsigned int slot = node.begin; slot < node.end && _ids[ slot ] != PADDING; slot += 1U )
+                    stats.tested += 1U;
+            } else {
+                stack[ depth ][ 0 ] = node.child + 1U;
+                stack[ depth ][ 1 ] = planes;
+                stack[ depth + 1U ][ 0 ] = node.child;
+                stack[ depth + 1U ][ 1 ] = planes;
+                depth += 2U;
+            }
+        }
+    }
+    out_visible->resize( visible - &( *out_visible )[ 0 ] );
+    stats.submitted = (unsigned int)( out_visible->size() - first );
+    stats.culled = _count - stats.submitted;
+    if( out_stats != NULL )
+        *out_stats = stats;
+}
+
+unsigned int App::SphereBvh::nodeCount( void ) const {
+    return (unsigned int)_nodes.size();
+}
+
+unsigned int App::SphereBvh::rebuilds( void ) const {
+    return _rebuilds;
+}
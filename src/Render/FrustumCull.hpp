@@ -0,0 +1,90 @@
+#ifndef __FRUSTUM_CULL__
+#define __FRUSTUM_CULL__
+
+#include <vector>
+
+namespace App {
+
+// Work done by one cull.
+struct CullStats {
+    unsigned int    nodes;          // Tree nodes tested against the frustum.
+    unsigned int    tested;         // Spheres tested one by one.
+    unsigned int    culled;
+    unsigned int    submitted;      // Visible, with those accepted by a node.
+};
+
+/*
+Frustum culling of bounding spheres stored as ( x, y, z, radius ) floats.
+in_planes are normalized and point inwards, as DrawList::setCamera extracts
+them from projection * view. A sphere is visible unless it lies entirely
+behind one plane; both functions below give the same set, in a different
+order. On x86 four spheres are tested per SSE step.
+*/
+
+// Test every sphere; append the visible indices to out_visible.
+void CullSpheres( const float in_planes[ 6 ][ 4 ], const float* in_spheres, const unsigned int in_count,
+    std::vector< unsigned int >* out_visible, CullStats* out_stats );
+
+/*
+Bounding volume tree over spheres that move every frame.
+The tree is built by median splits on the longest axis down to leaves of at
+most LEAF_SIZE spheres, then refitted in place each frame: leaves copy
+their spheres into SSE-ready arrays and boxes are merged bottom-up. It is
+rebuilt when the sphere count changes or refitting has grown the total box
+area past REBUILD_GROWTH times its size after the last build.
+
+A cull walks the tree carrying the planes that still cut the current box:
+a box outside one plane is rejected whole, a box inside every plane is
+accepted whole, and only leaves that straddle the frustum test their
+spheres, against the remaining planes only.
+*/
+class SphereBvh {
+public:
+    SphereBvh( void );
+
+    // Refit, or rebuild when needed, to the current spheres.
+    void update( const float* in_spheres, const unsigned int in_count );
+    void build( const float* in_spheres, const unsigned int in_count );
+    void refit( const float* in_spheres );
+
+    // Visible indices as of the last update() are appended to out_visible.
+    void cull( const float in_planes[ 6 ][ 4 ], std::vector< unsigned int >* out_visible,
+        CullStats* out_stats ) const;
+
+    unsigned int nodeCount( void ) const;
+    unsigned int rebuilds( void ) const;
+
+    static const unsigned int LEAF_SIZE = 8U;      // A multiple of 4.
+    static const float REBUILD_GROWTH;
+
+private:
+    SphereBvh( const SphereBvh& );
+    SphereBvh& operator=( const SphereBvh& );
+
+    void split( const float* in_spheres, unsigned int* io_ids, const unsigned int in_count,
+        const unsigned int in_node );
+
+private:
+    // Children of an inner node are nodes child and child + 1. Slots
+    // [ begin, end ) hold the spheres below the node; a leaf pads its own
+    // slots to a multiple of 4 with spheres that are never visible.
+    struct Node {
+        float           center[ 3 ];
+        float           extent[ 3 ];
+        unsigned int    child;          // 0 for leaves.
+        unsigned int    begin;
+        unsigned int    end;
+    };
+
+    std::vector< Node >         _nodes;         // Parents before children.
+    std::vector< unsigned int > _ids;           // Sphere index per slot.
+    std::vector< float >        _slots;         // x, y, z and radius arrays of _ids.size() each.
+    unsigned int                _count;
+    float                       _area;          // Sum of box half-areas after the last refit.
+    float                       _builtArea;
+    unsigned int                _rebuilds;
+};
+
+}
+
+#endif
@@ -0,0 +1,55 @@
+#include "GLFunctions.hpp"
+
+namespace {
+
+App::GLFunctions functions = { NULL, NULL, NULL, NULL, NULL, NULL, NULL };
+
+// Poll interval while a fence is pending, in nanoseconds.
+const GLuint64 FENCE_TIMEOUT = 1000000U;
+
+// Try the core name first, then the extension names.
+void* Resolve( GLADloadproc in_load, const char* in_core, const char* in_arb ) {
+    void* proc = in_load( in_core );
+    if( proc == NULL && in_arb != NULL )
+        proc = in_load( in_arb );
+    return proc;
+}
+
+}
+
+void App::LoadGLFunctions( GLADloadproc in_load ) {
+    functions.bufferStorage = reinterpret_cast<BufferStorageProc>(
+        Resolve( in_load, "glBufferStorage", "glBufferStorageARB" ) );
+    functions.vertexAttribDivisor = reinterpret_cast<VertexAttribDivisorProc>(
+        Resolve( in_load, "glVertexAttribDivisor", "glVertexAttribDivisorARB" ) );
+    // ARB_timer_query has no suffixed names; EXT_timer_query does.
+    functions.getQueryObjectui64v = reinterpret_cast<GetQueryObjectui64vProc>(
+        Resolve( in_load, "glGetQueryObjectui64v", "glGetQueryObjectui64vEXT" ) );
+    // ARB_get_program_binary has no suffixed names either.
+    functions.getProgramBinary = reinterpret_cast<GetProgramBinaryProc>(
+        Resolve( in_load, "glGetProgramBinary", NULL ) );
+    functions.programBinary = reinterpret_cast<ProgramBinaryProc>(
+        Resolve( in_load, "glProgramBinary", NULL ) );
+    functions.programParameteri = reinterpret_cast<ProgramParameteriProc>(
+        Resolve( in_load, "glProgramParameteri", NULL ) );
+    functions.multiDrawElementsIndirect = reinterpret_cast<MultiDrawElementsIndirectProc>(
+        Resolve( in_load, "glMultiDrawElementsIndirect", NULL ) );
+}
+
+const App::GLFunctions& App::GetGLFunctions( void ) {
+    return functions;
+}
+
+bool App::WaitFence( GLsync in_fence ) {
+    GLbitfield flags = 0U;
+    bool stalled = false;
+    while( true ) {
+        const GLenum status = glClientWaitSync( in_fence, flags, flags == 0U ? 0U : FENCE_TIMEOUT );
+        if( status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED || status == GL_WAIT_FAILED )
+            break;
+        // The fence may still sit in an unflushed command buffer.
+        flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+        stalled = true;
+    }
+    return stalled;
+}
@@ -0,0 +1,67 @@
+#ifndef __GL_FUNCTIONS__
+#define __GL_FUNCTIONS__
+
+#include "glad/glad.h"
+
+/*
+Entry points above the OpenGL 3.2 core the glad loader is generated for.
+They are resolved at runtime; a NULL pointer means the driver lacks them.
+*/
+
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT   0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT     0x0080
+#endif
+#ifndef GL_TIME_ELAPSED
+#define GL_TIME_ELAPSED         0x88BF
+#endif
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT  0x8257
+#endif
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_LENGTH            0x8741
+#endif
+#ifndef GL_NUM_PROGRAM_BINARY_FORMATS
+#define GL_NUM_PROGRAM_BINARY_FORMATS       0x87FE
+#endif
+#ifndef GL_DRAW_INDIRECT_BUFFER
+#define GL_DRAW_INDIRECT_BUFFER             0x8F3F
+#endif
+
+namespace App {
+
+typedef void ( APIENTRYP BufferStorageProc )( GLenum target, GLsizeiptr size,
+    const void* data, GLbitfield flags );
+typedef void ( APIENTRYP VertexAttribDivisorProc )( GLuint index, GLuint divisor );
+typedef void ( APIENTRYP GetQueryObjectui64vProc )( GLuint id, GLenum pname, GLuint64* params );
+typedef void ( APIENTRYP GetProgramBinaryProc )( GLuint program, GLsizei bufSize, GLsizei* length,
+    GLenum* binaryFormat, void* binary );
+typedef void ( APIENTRYP ProgramBinaryProc )( GLuint program, GLenum binaryFormat, const void* binary,
+    GLsizei length );
+typedef void ( APIENTRYP ProgramParameteriProc )( GLuint program, GLenum pname, GLint value );
+typedef void ( APIENTRYP MultiDrawElementsIndirectProc )( GLenum mode, GLenum type, const void* indirect,
+    GLsizei drawcount, GLsizei stride );
+
+struct GLFunctions {
+    BufferStorageProc           bufferStorage;          // GL 4.4 / ARB_buffer_storage
+    VertexAttribDivisorProc     vertexAttribDivisor;    // GL 3.3 / ARB_instanced_arrays
+    GetQueryObjectui64vProc     getQueryObjectui64v;    // GL 3.3 / ARB_timer_query
+    GetProgramBinaryProc        getProgramBinary;       // GL 4.1 / ARB_get_program_binary
+    ProgramBinaryProc           programBinary;          // GL 4.1 / ARB_get_program_binary
+    ProgramParameteriProc       programParameteri;      // GL 4.1 / ARB_get_program_binary
+    MultiDrawElementsIndirectProc multiDrawElementsIndirect; // GL 4.3 / ARB_multi_draw_indirect
+};
+
+// Resolve every entry point with in_load (e.g. glfwGetProcAddress).
+// Call once after the context is current.
+void LoadGLFunctions( GLADloadproc in_load );
+const GLFunctions& GetGLFunctions( void );
+
+// Block until in_fence is signaled. Returns true when it was not already.
+bool WaitFence( GLsync in_fence );
+
+}
+
+#endif
@@ -0,0 +1,235 @@
+#include "GLState.hpp"
+#include "GLFunctions.hpp"
+
+namespace {
+
+// Never a valid name or enum here; forces the next call through.
+const GLuint UNKNOWN = 0xFFFFFFFFU;
+
+const GLenum CAPABILITY_ENUMS[ App::GLState::CAPABILITIES ] = {
+    GL_DEPTH_TEST, GL_CULL_FACE, GL_BLEND, GL_SCISSOR_TEST, GL_STENCIL_TEST, GL_POLYGON_OFFSET_FILL };
+const GLenum TARGET_ENUMS[ App::GLState::TARGETS ] = {
+    GL_ARRAY_BUFFER, GL_ELEMENT_ARRAY_BUFFER, GL_UNIFORM_BUFFER, GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+    GL_PIXEL_UNPACK_BUFFER, GL_DRAW_INDIRECT_BUFFER };
+const unsigned int ELEMENT_SLOT = 1U;
+const unsigned int UNIFORM_SLOT = 2U;
+
+// Slot of in_value in in_enums, or in_count when it has none.
+unsigned int Slot( const GLenum* in_enums, const unsigned int in_count, const GLenum in_value ) {
+    unsigned int slot = 0U;
+    while( slot < in_count && in_enums[ slot ] != in_value )
+        slot += 1U;
+    return slot;
+}
+
+App::GLState state;
+
+}
+
+App::GLState::GLState( void ) {
+    const GLStateStats zero = { 0U, 0U };
+    _frame = zero;
+    _lastFrame = zero;
+    _total = zero;
+    invalidate();
+}
+
+void App::GLState::beginFrame( void ) {
+    _lastFrame = _frame;
+    _frame.issued = 0U;
+    _frame.skipped = 0U;
+}
+
+const App::GLStateStats& App::GLState::frameStats( void ) const {
+    return _lastFrame;
+}
+
+const App::GLStateStats& App::GLState::totalStats( void ) const {
+    return _total;
+}
+
+void App::GLState::invalidate( void ) {
+    for( unsigned int slot = 0U; slot < CAPABILITIES; slot += 1U )
+        _capabilities[ slot ] = UNKNOWN;
+    _cullFace = UNKNOWN;
+    _polygonMode = UNKNOWN;
+    _viewport[ 0 ] = _viewport[ 1 ] = 0;
+    _viewport[ 2 ] = _viewport[ 3 ] = -1;
+    _clearColorKnown = false;
+    _program = UNKNOWN;
+    _vertexArray = UNKNOWN;
+    for( unsigned int slot = 0U; slot < TARGETS; slot += 1U )
+        _buffers[ slot ] = UNKNOWN;
+    for( unsigned int index = 0U; index < UNIFORM_BINDINGS; index += 1U )
+        _uniformBuffers[ index ] = UNKNOWN;
+    _blockBindings.clear();
+}
+
+void App::GLState::enable( const GLenum in_capability ) {
+    setCapability( in_capability, 1U );
+}
+
+void App::GLState::disable( const GLenum in_capability ) {
+    setCapability( in_capability, 0U );
+}
+
+void App::GLState::cullFace( const GLenum in_face ) {
+    if( issue( _cullFace != in_face ) == false )
+        return;
+    _cullFace = in_face;
+    glCullFace( in_face );
+}
+
+void App::GLState::polygonMode( const GLenum in_mode ) {
+    if( issue( _polygonMode != in_mode ) == false )
+        return;
+    _polygonMode = in_mode;
+    glPolygonMode( GL_FRONT_AND_BACK, in_mode );
+}
+
+void App::GLState::viewport( const GLint in_x, const GLint in_y, const GLsizei in_width, const GLsizei in_height ) {
+    if( issue( _viewport[ 0 ] != in_x || _viewport[ 1 ] != in_y || _viewport[ 2 ] != in_width
+        || _viewport[ 3 ] != in_height ) == false )
+        return;
+    _viewport[ 0 ] = in_x;
+    _viewport[ 1 ] = in_y;
+    _viewport[ 2 ] = in_width;
+    _viewport[ 3 ] = in_height;
+    glViewport( in_x, in_y, in_width, in_height );
+}
+
+void App::GLState::clearColor( const GLfloat in_red, const GLfloat in_green, const GLfloat in_blue,
+    const GLfloat in_alpha ) {
+    if( issue( _clearColorKnown == false || _clearColor[ 0 ] != in_red || _clearColor[ 1 ] != in_green
+        || _clearColor[ 2 ] != in_blue || _clearColor[ 3 ] != in_alpha ) == false )
+        return;
+    _clearColor[ 0 ] = in_red;
+    _clearColor[ 1 ] = in_green;
+    _clearColor[ 2 ] = in_blue;
+    _clearColor[ 3 ] = in_alpha;
+    _clearColorKnown = true;
+    glClearColor( in_red, in_green, in_blue, in_alpha );
+}
+
+void App::GLState::useProgram( const GLuint in_program ) {
+    if( issue( _program != in_program ) == false )
+        return;
+    _program = in_program;
+    glUseProgram( in_program );
+}
+
+void App::GLState::bindVertexArray( const GLuint in_array ) {
+    if( issue( _vertexArray != in_array ) == false )
+        return;
+    _vertexArray = in_array;
+    _buffers[ ELEMENT_SLOT ] = UNKNOWN;
+    glBindVertexArray( in_array );
+}
+
+void App::GLState::bindBuffer( const GLenum in_target, const GLuint in_buffer ) {
+    const unsigned int slot = Slot( TARGET_ENUMS, TARGETS, in_target );
+    if( issue( slot == TARGETS || _buffers[ slot ] != in_buffer ) == false )
+        return;
+    if( slot < TARGETS )
+        _buffers[ slot ] = in_buffer;
+    glBindBuffer( in_target, in_buffer );
+}
+
+void App::GLState::bindBufferBase( const GLenum in_target, const GLuint in_index, const GLuint in_buffer ) {
+    const bool tracked = in_target == GL_UNIFORM_BUFFER && in_index < UNIFORM_BINDINGS;
+    if( issue( tracked == false || _uniformBuffers[ in_index ] != in_buffer ) == false )
+        return;
+    if( tracked == true ) {
+        _uniformBuffers[ in_index ] = in_buffer;
+        // Binding a range also binds the generic target.
+        _buffers[ UNIFORM_SLOT ] = in_buffer;
+    } else {
+        const unsigned int slot = Slot( TARGET_ENUMS, TARGETS, in_target );
+        if( slot < TARGETS )
+            _buffers[ slot ] = UNKNOWN;
+    }
+    glBindBufferBase( in_target, in_index, in_buffer );
+}
+
+void App::GLState::uniformBlockBinding( const GLuint in_program, const GLuint in_block, const GLuint in_binding ) {
+    size_t index = 0U;
+    while( index < _blockBindings.size()
+        && ( _blockBindings[ index ].program != in_program || _blockBindings[ index ].block != in_block ) )
+        index += 1U;
+    if( issue( index == _blockBindings.size() || _blockBindings[ index ].binding != in_binding ) == false )
+        return;
+    if( index == _blockBindings.size() ) {
+        const BlockBinding binding = { in_program, in_block, in_binding };
+        _blockBindings.push_back( binding );
+    } else {
+        _blockBindings[ index ].binding = in_binding;
+    }
+    glUniformBlockBinding( in_program, in_block, in_binding );
+}
+
+void App::GLState::deleteBuffers( const GLsizei in_count, const GLuint* in_buffers ) {
+    for( GLsizei buffer = 0; buffer < in_count; buffer += 1 ) {
+        if( in_buffers[ buffer ] == 0U )
+            continue;
+        for( unsigned int slot = 0U; slot < TARGETS; slot += 1U )
+            if( _buffers[ slot ] == in_buffers[ buffer ] )
+                _buffers[ slot ] = UNKNOWN;
+        for( unsigned int index = 0U; index < UNIFORM_BINDINGS; index += 1U )
+            if( _uniformBuffers[ index ] == in_buffers[ buffer ] )
+                _uniformBuffers[ index ] = UNKNOWN;
+    }
+    glDeleteBuffers( in_count, in_buffers );
+}
+
+void App::GLState::deleteVertexArrays( const GLsizei in_count, const GLuint* in_arrays ) {
+    for( GLsizei array = 0; array < in_count; array += 1 ) {
+        if( in_arrays[ array ] != 0U && in_arrays[ array ] == _vertexArray ) {
+            _vertexArray = UNKNOWN;
+            _buffers[ ELEMENT_SLOT ] = UNKNOWN;
+        }
+    }
+    glDeleteVertexArrays( in_count, in_arrays );
+}
+
+void App::GLState::deleteProgram( const GLuint in_program ) {
+    // A program in use lives on until replaced; forget it anyway.
+    if( in_program != 0U && in_program == _program )
+        _program = UNKNOWN;
+    for( size_t index = 0U; index < _blockBindings.size(); ) {
+        if( _blockBindings[ index ].program == in_program ) {
+            _blockBindings[ index ] = _blockBindings.back();
+            _blockBindings.pop_back();
+        } else {
+            index += 1U;
+        }
+    }
+    glDeleteProgram( in_program );
+}
+
+// Count a call as issued when in_changed, as skipped otherwise.
+bool App::GLState::issue( const bool in_changed ) {
+    if( in_changed == true ) {
+        _frame.issued += 1U;
+        _total.issued += 1U;
+    } else {
+        _frame.skipped += 1U;
+        _total.skipped += 1U;
+    }
+    return in_changed;
+}
+
+void App::GLState::setCapability( const GLenum in_capability, const GLuint in_value ) {
+    const unsigned int slot = Slot( CAPABILITY_ENUMS, CAPABILITIES, in_capability );
+    if( issue( slot == CAPABILITIES || _capabilities[ slot ] != in_value ) == false )
+        return;
+    if( slot < CAPABILITIES )
+        _capabilities[ slot ] = in_value;
+    if( in_value == 1U )
+        glEnable( in_capability );
+    else
+        glDisable( in_capability );
+}
+
+App::GLState& App::GetGLState( void ) {
+    return state;
+}
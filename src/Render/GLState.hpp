@@ -0,0 +1,110 @@
+#ifndef __GL_STATE__
+#define __GL_STATE__
+
+#include <vector>
+
+#include "glad/glad.h"
+
+namespace App {
+
+// Driver calls made and avoided through GLState.
+struct GLStateStats {
+    unsigned long long  issued;
+    unsigned long long  skipped;
+};
+
+/*
+Shadow copy of the context state the renderer touches: capabilities, cull
+face, polygon mode, viewport, clear color, the program, the vertex array,
+buffer bindings and uniform block bindings. Each setter compares against
+the copy and calls GL only when the value changes, so callers can state
+what they need every frame instead of restoring what they changed.
+
+Every module sharing the context has to go through the cache once one
+does; a direct glBindBuffer leaves the copy stale. A value is unknown until
+it is first set, and after invalidate(), so the first call always reaches
+the driver.
+
+The element array binding belongs to the vertex array object; it is
+forgotten whenever another one is bound.
+
+    GetGLState().beginFrame();
+    GetGLState().enable( GL_DEPTH_TEST );   // issued once, skipped after
+    ...
+    GetGLState().frameStats().skipped;      // counts of the last frame
+*/
+class GLState {
+public:
+    GLState( void );
+
+    // Close the frame's counters and start new ones.
+    void beginFrame( void );
+    // Counters of the last frame closed by beginFrame().
+    const GLStateStats& frameStats( void ) const;
+    // Counters since construction.
+    const GLStateStats& totalStats( void ) const;
+    // Forget every value, e.g. after a new context is made current.
+    void invalidate( void );
+
+    void enable( const GLenum in_capability );
+    void disable( const GLenum in_capability );
+    void cullFace( const GLenum in_face );
+    // Core profiles only accept GL_FRONT_AND_BACK.
+    void polygonMode( const GLenum in_mode );
+    void viewport( const GLint in_x, const GLint in_y, const GLsizei in_width, const GLsizei in_height );
+    void clearColor( const GLfloat in_red, const GLfloat in_green, const GLfloat in_blue, const GLfloat in_alpha );
+
+    void useProgram( const GLuint in_program );
+    void bindVertexArray( const GLuint in_array );
+    void bindBuffer( const GLenum in_target, const GLuint in_buffer );
+    void bindBufferBase( const GLenum in_target, const GLuint in_index, const GLuint in_buffer );
+    void uniformBlockBinding( const GLuint in_program, const GLuint in_block, const GLuint in_binding );
+
+    // Delete through the cache so no binding keeps a dead name.
+    void deleteBuffers( const GLsizei in_count, const GLuint* in_buffers );
+    void deleteVertexArrays( const GLsizei in_count, const GLuint* in_arrays );
+    void deleteProgram( const GLuint in_program );
+
+    // Capabilities and buffer targets with a slot of their own; others are
+    // passed through and counted as issued.
+    static const unsigned int CAPABILITIES = 6U;
+    static const unsigned int TARGETS = 7U;
+    // Indexed uniform buffer binding points tracked.
+    static const unsigned int UNIFORM_BINDINGS = 16U;
+
+private:
+    GLState( const GLState& );
+    GLState& operator=( const GLState& );
+
+    bool issue( const bool in_changed );
+    void setCapability( const GLenum in_capability, const GLuint in_value );
+
+    struct BlockBinding {
+        GLuint  program;
+        GLuint  block;
+        GLuint  binding;
+    };
+
+private:
+    GLuint          _capabilities[ CAPABILITIES ];
+    GLenum          _cullFace;
+    GLenum          _polygonMode;
+    GLint           _viewport[ 4 ];
+    GLfloat         _clearColor[ 4 ];
+    bool            _clearColorKnown;
+    GLuint          _program;
+    GLuint          _vertexArray;
+    GLuint          _buffers[ TARGETS ];
+    GLuint          _uniformBuffers[ UNIFORM_BINDINGS ];
+    std::vector< BlockBinding > _blockBindings;
+    GLStateStats    _frame;
+    GLStateStats    _lastFrame;
+    GLStateStats    _total;
+};
+
+// The cache of the one context the application renders with.
+GLState& GetGLState( void );
+
+}
+
+#endif
@@ -0,0 +1,387 @@
+#include "GeometryPool.hpp"
+#include "GLFunctions.hpp"
+#include "GLState.hpp"
+
+#include <algorithm>
+
+namespace {
+
+GLuint CreateBuffer( const GLsizeiptr in_size ) {
+    GLuint buffer = 0U;
+    glGenBuffers( 1, &buffer );
+    App::GetGLState().bindBuffer( GL_COPY_WRITE_BUFFER, buffer );
+    glBufferData( GL_COPY_WRITE_BUFFER, in_size, NULL, GL_STATIC_DRAW );
+    return buffer;
+}
+
+void Upload( const GLuint in_buffer, const GLintptr in_offset, const GLsizeiptr in_size, const void* in_data ) {
+    App::GetGLState().bindBuffer( GL_COPY_WRITE_BUFFER, in_buffer );
+    glBufferSubData( GL_COPY_WRITE_BUFFER, in_offset, in_size, in_data );
+}
+
+void Copy( const GLuint in_from, const GLuint in_to, const GLintptr in_fromOffset, const GLintptr in_toOffset,
+    const GLsizeiptr in_size ) {
+    App::GetGLState().bindBuffer( GL_COPY_READ_BUFFER, in_from );
+    App::GetGLState().bindBuffer( GL_COPY_WRITE_BUFFER, in_to );
+    glCopyBufferSubData( GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, in_fromOffset, in_toOffset, in_size );
+}
+
+bool ByBaseVertex( const App::PoolMesh* in_left, const App::PoolMesh* in_right ) {
+    return in_left->baseVertex < in_right->baseVertex;
+}
+
+}
+
+App::RangeAllocator::RangeAllocator( void ) : _capacity( 0U ), _used( 0U ) {
+}
+
+void App::RangeAllocator::reset( const unsigned int in_capacity ) {
+    _free.clear();
+    _capacity = in_capacity;
+    _used = 0U;
+    if( in_capacity > 0U ) {
+        const Range all = { 0U, in_capacity };
+        _free.push_back( all );
+    }
+}
+
+bool App::RangeAllocator::allocate( const unsigned int in_size, unsigned int* out_offset ) {
+    for( size_t index = 0U; index < _free.size(); index += 1U ) {
+        Range& range = _free[ index ];
+        if( range.size < in_size )
+            continue;
+        *out_offset = range.offset;
+        range.offset += in_size;
+        range.size -= in_size;
+        if( range.size == 0U )
+            _free.erase( _free.begin() + index );
+        _used += in_size;
+        return true;
+    }
+    return false;
+}
+
+void App::RangeAllocator::free( const unsigned int in_offset, const unsigned int in_size ) {
+    size_t index = 0U;
+    while( index < _free.size() && _free[ index ].offset < in_offset )
+        index += 1U;
+    const Range range = { in_offset, in_size };
+    _free.insert( _free.begin() + index, range );
+    // Merge with the next range, then with the previous one.
+    if( index + 1U < _free.size() && _free[ index ].offset + _free[ index ].size == _free[ index + 1U ].offset ) {
+        _free[ index ].size += _free[ index + 1U ].size;
+        _free.erase( _free.begin() + index + 1U );
+    }
+    if( index > 0U && _free[ index - 1U ].offset + _free[ index - 1U ].size == _free[ index ].offset ) {
+        _free[ index - 1U ].size += _free[ index ].size;
+        _free.erase( _free.begin() + index );
+    }
+    _used -= in_size;
+}
+
+unsigned int App::RangeAllocator::capacity( void ) const {
+    return _capacity;
+}
+
+unsigned int App::RangeAllocator::used( void ) const {
+    return _used;
+}
+
+unsigned int App::RangeAllocator::largestFree( void ) const {
+    unsigned int largest = 0U;
+    for( size_t index = 0U; index < _free.size(); index += 1U )
+        largest = std::max( largest, _free[ index ].size );
+    return largest;
+}
+
+unsigned int App::RangeAllocator::freeRanges( void ) const {
+    return (unsigned int)_free.size();
+}
+
+float App::RangeAllocator::fragmentation( void ) const {
+    const unsigned int free = _capacity - _used;
+    if( free == 0U )
+        return 0.f;
+    return 1.f - (float)largestFree() / (float)free;
+}
+
+App::GeometryPool::GeometryPool( void ) : _vertexBuffer( 0U ), _colorBuffer( 0U ), _indexBuffer( 0U ),
+    _commandBuffer( 0U ), _indexSize( 2U ), _generation( 0U ), _indirect( true ), _compactions( 0U ), _grows( 0U ) {
+}
+
+App::GeometryPool::~GeometryPool( void ) {
+    release();
+}
+
+bool App::GeometryPool::create( const unsigned int in_vertices, const unsigned int in_indices,
+    const unsigned int in_indexSize ) {
+    release();
+    if( in_vertices == 0U || in_indices == 0U || ( in_indexSize != 2U && in_indexSize != 4U ) )
+        return false;
+    _indexSize = in_indexSize;
+    _vertexRanges.reset( in_vertices );
+    _indexRanges.reset( in_indices );
+    _vertexBuffer = CreateBuffer( (GLsizeiptr)( sizeof(PVertex) * in_vertices ) );
+    _colorBuffer = CreateBuffer( (GLsizeiptr)( sizeof(PColor) * in_vertices ) );
+    _indexBuffer = CreateBuffer( (GLsizeiptr)_indexSize * in_indices );
+    glGenBuffers( 1, &_commandBuffer );
+    _generation += 1U;
+    return glGetError() == GL_NO_ERROR;
+}
+
+void App::GeometryPool::release( void ) {
+    const GLuint buffers[ 4 ] = { _vertexBuffer, _colorBuffer, _indexBuffer, _commandBuffer };
+    for( unsigned int index = 0U; index < 4U; index += 1U ) {
+        if( buffers[ index ] != 0U )
+            GetGLState().deleteBuffers( 1, &buffers[ index ] );
+    }
+    _vertexBuffer = _colorBuffer = _indexBuffer = _commandBuffer = 0U;
+    _meshes.clear();
+    _freeHandles.clear();
+    _vertexRanges.reset( 0U );
+    _indexRanges.reset( 0U );
+    _compactions = _grows = 0U;
+}
+
+unsigned int App::GeometryPool::add( const PackedMesh& in_mesh ) {
+    const unsigned int vertexCount = (unsigned int)in_mesh.verticies.size(),
+        indexCount = (unsigned int)( in_mesh.indexBytes() / in_mesh.indexSize );
+    if( in_mesh.indexSize > _indexSize )
+        return INVALID;
+    const unsigned int handle = allocate( vertexCount, indexCount, in_mesh.decode );
+    if( handle == INVALID )
+        return INVALID;
+
+    const PoolMesh& mesh = _meshes[ handle ];
+    Upload( _vertexBuffer, (GLintptr)( sizeof(PVertex) * mesh.baseVertex ),
+        (GLsizeiptr)( sizeof(PVertex) * vertexCount ), in_mesh.verticies.data() );
+    Upload( _colorBuffer, (GLintptr)( sizeof(PColor) * mesh.baseVertex ),
+        (GLsizeiptr)( sizeof(PColor) * vertexCount ), in_mesh.colors.data() );
+    const void* indicies = in_mesh.indexData();
+    if( in_mesh.indexSize < _indexSize ) {
+        _longIndicies.assign( in_mesh.shortIndicies.begin(), in_mesh.shortIndicies.end() );
+        indicies = _longIndicies.data();
+    }
+    Upload( _indexBuffer, (GLintptr)_indexSize * mesh.firstIndex, (GLsizeiptr)_indexSize * indexCount, indicies );
+    return handle;
+}
+
+unsigned int App::GeometryPool::allocate( const unsigned int in_vertexCount, const unsigned int in_indexCount,
+    const PositionDecode& in_decode ) {
+    if( _vertexBuffer == 0U || in_vertexCount == 0U || in_indexCount == 0U )
+        return INVALID;
+
+    PoolMesh mesh;
+    mesh.vertexCount = in_vertexCount;
+    mesh.indexCount = in_indexCount;
+    mesh.decode = in_decode;
+    mesh.live = true;
+    reserve( in_vertexCount, in_indexCount, &mesh.baseVertex, &mesh.firstIndex );
+
+    if( _freeHandles.empty() == false ) {
+        const unsigned int handle = _freeHandles.back();
+        _freeHandles.pop_back();
+        _meshes[ handle ] = mesh;
+        return handle;
+    }
+    _meshes.push_back( mesh );
+    return (unsigned int)( _meshes.size() - 1U );
+}
+
+void App::GeometryPool::remove( const unsigned int in_handle ) {
+    if( in_handle >= _meshes.size() || _meshes[ in_handle ].live == false )
+        return;
+    PoolMesh& mesh = _meshes[ in_handle ];
+    _vertexRanges.free( mesh.baseVertex, mesh.vertexCount );
+    _indexRanges.free( mesh.firstIndex, mesh.indexCount );
+    mesh.live = false;
+    _freeHandles.push_back( in_handle );
+}
+
+const App::PoolMesh& App::GeometryPool::mesh( const unsigned int in_handle ) const {
+    return _meshes[ in_handle ];
+}
+
+void App::GeometryPool::compact( void ) {
+    if( _vertexBuffer != 0U )
+        rebuild( _vertexRanges.capacity(), _indexRanges.capacity() );
+}
+
+void App::GeometryPool::bind( const GLuint in_positionLoc, const GLuint in_colorLoc ) const {
+    GLState& glState = GetGLState();
+    glState.bindBuffer( GL_ARRAY_BUFFER, _vertexBuffer );
+    glVertexAttribPointer( in_positionLoc, 4, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(PVertex), (GLvoid*) 0 );
+    glEnableVertexAttribArray( in_positionLoc );
+    glState.bindBuffer( GL_ARRAY_BUFFER, _colorBuffer );
+    glVertexAttribPointer( in_colorLoc, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(PColor), (GLvoid*) 0 );
+    glEnableVertexAttribArray( in_colorLoc );
+    glState.bindBuffer( GL_ELEMENT_ARRAY_BUFFER, _indexBuffer );
+}
+
+unsigned int App::GeometryPool::generation( void ) const {
+    return _generation;
+}
+
+GLenum App::GeometryPool::indexType( void ) const {
+    return _indexSize == 2U ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+}
+
+unsigned int App::GeometryPool::indexSize( void ) const {
+    return _indexSize;
+}
+
+GLuint App::GeometryPool::vertexBuffer( void ) const {
+    return _vertexBuffer;
+}
+
+GLuint App::GeometryPool::colorBuffer( void ) const {
+    return _colorBuffer;
+}
+
+GLuint App::GeometryPool::indexBuffer( void ) const {
+    return _indexBuffer;
+}
+
+void App::GeometryPool::appendCommand( const unsigned int in_handle, const unsigned int in_instanceCount,
+    const unsigned int in_baseInstance, std::vector< DrawElementsIndirectCommand >* io_commands,
+    const unsigned int in_firstFace, const unsigned int in_faceCount ) const {
+    const PoolMesh& mesh = _meshes[ in_handle ];
+    const unsigned int first = 3U * in_firstFace;
+    if( mesh.live == false || first >= mesh.indexCount )
+        return;
+    DrawElementsIndirectCommand command;
+    command.count = in_faceCount == 0U ? mesh.indexCount - first : std::min( 3U * in_faceCount, mesh.indexCount - first );
+    command.instanceCount = in_instanceCount;
+    command.firstIndex = mesh.firstIndex + first;
+    command.baseVertex = (GLint)mesh.baseVertex;
+    command.baseInstance = in_baseInstance;
+    io_commands->push_back( command );
+}
+
+void App::GeometryPool::draw( const std::vector< DrawElementsIndirectCommand >& in_commands,
+    InstanceBuffer* io_instances ) {
+    if( in_commands.empty() == true )
+        return;
+    const GLenum type = indexType();
+    const MultiDrawElementsIndirectProc multiDrawElementsIndirect = GetGLFunctions().multiDrawElementsIndirect;
+    if( io_instances != NULL && _indirect == true && multiDrawElementsIndirect != NULL ) {
+        // Orphan last frame's commands instead of waiting for them.
+        io_instances->bind( 0U );
+        GetGLState().bindBuffer( GL_DRAW_INDIRECT_BUFFER, _commandBuffer );
+        glBufferData( GL_DRAW_INDIRECT_BUFFER, (GLsizeiptr)( sizeof(DrawElementsIndirectCommand) * in_commands.size() ),
+            in_commands.data(), GL_STREAM_DRAW );
+        multiDrawElementsIndirect( GL_TRIANGLES, type, (GLvoid*) 0, (GLsizei)in_commands.size(), 0 );
+    } else if( io_instances != NULL ) {
+        // Without base instances the attributes themselves are rebased.
+        for( size_t index = 0U; index < in_commands.size(); index += 1U ) {
+            const DrawElementsIndirectCommand& command = in_commands[ index ];
+            io_instances->bind( command.baseInstance );
+            glDrawElementsInstancedBaseVertex( GL_TRIANGLES, (GLsizei)command.count, type,
+                (GLvoid*)( (size_t)_indexSize * command.firstIndex ), (GLsizei)command.instanceCount,
+                command.baseVertex );
+        }
+    } else {
+        _counts.resize( in_commands.size() );
+        _offsets.resize( in_commands.size() );
+        _baseVerticies.resize( in_commands.size() );
+        for( size_t index = 0U; index < in_commands.size(); index += 1U ) {
+            _counts[ index ] = (GLsizei)in_commands[ index ].count;
+            _offsets[ index ] = (const GLvoid*)( (size_t)_indexSize * in_commands[ index ].firstIndex );
+            _baseVerticies[ index ] = in_commands[ index ].baseVertex;
+        }
+        glMultiDrawElementsBaseVertex( GL_TRIANGLES, _counts.data(), type, _offsets.data(),
+            (GLsizei)in_commands.size(), _baseVerticies.data() );
+    }
+}
+
+void App::GeometryPool::setIndirect( const bool in_indirect ) {
+    _indirect = in_indirect;
+}
+
+bool App::GeometryPool::indirect( void ) const {
+    return _indirect == true && GetGLFunctions().multiDrawElementsIndirect != NULL;
+}
+
+App::GeometryPoolStats App::GeometryPool::stats( void ) const {
+    GeometryPoolStats stats;
+    stats.meshes = (unsigned int)( _meshes.size() - _freeHandles.size() );
+    stats.vertexCapacity = _vertexRanges.capacity();
+    stats.verticesUsed = _vertexRanges.used();
+    stats.vertexFragmentation = _vertexRanges.fragmentation();
+    stats.indexCapacity = _indexRanges.capacity();
+    stats.indicesUsed = _indexRanges.used();
+    stats.indexFragmentation = _indexRanges.fragmentation();
+    stats.compactions = _compactions;
+    stats.grows = _grows;
+    return stats;
+}
+
+// Copy every live mesh, in buffer order, to the front of new buffers with
+// room for in_vertices and in_indices.
+void App::GeometryPool::rebuild( const unsigned int in_vertices, const unsigned int in_indices ) {
+    std::vector< PoolMesh* > live;
+    for( size_t handle = 0U; handle < _meshes.size(); handle += 1U ) {
+        if( _meshes[ handle ].live == true )
+            live.push_back( &_meshes[ handle ] );
+    }
+    std::sort( live.begin(), live.end(), ByBaseVertex );
+
+    const GLuint vertexBuffer = CreateBuffer( (GLsizeiptr)( sizeof(PVertex) * in_vertices ) ),
+        colorBuffer = CreateBuffer( (GLsizeiptr)( sizeof(PColor) * in_vertices ) ),
+        indexBuffer = CreateBuffer( (GLsizeiptr)_indexSize * in_indices );
+    _vertexRanges.reset( in_vertices );
+    _indexRanges.reset( in_indices );
+    for( size_t index = 0U; index < live.size(); index += 1U ) {
+        PoolMesh& mesh = *live[ index ];
+        unsigned int baseVertex = 0U, firstIndex = 0U;
+        _vertexRanges.allocate( mesh.vertexCount, &baseVertex );
+        _indexRanges.allocate( mesh.indexCount, &firstIndex );
+        Copy( _vertexBuffer, vertexBuffer, (GLintptr)( sizeof(PVertex) * mesh.baseVertex ),
+            (GLintptr)( sizeof(PVertex) * baseVertex ), (GLsizeiptr)( sizeof(PVertex) * mesh.vertexCount ) );
+        Copy( _colorBuffer, colorBuffer, (GLintptr)( sizeof(PColor) * mesh.baseVertex ),
+            (GLintptr)( sizeof(PColor) * baseVertex ), (GLsizeiptr)( sizeof(PColor) * mesh.vertexCount ) );
+        Copy( _indexBuffer, indexBuffer, (GLintptr)_indexSize * mesh.firstIndex, (GLintptr)_indexSize * firstIndex,
+            (GLsizeiptr)_indexSize * mesh.indexCount );
+        mesh.baseVertex = baseVertex;
+        mesh.firstIndex = firstIndex;
+    }
+    const GLuint buffers[ 3 ] = { _vertexBuffer, _colorBuffer, _indexBuffer };
+    GetGLState().deleteBuffers( 3, buffers );
+    _vertexBuffer = vertexBuffer;
+    _colorBuffer = colorBuffer;
+    _indexBuffer = indexBuffer;
+    _generation += 1U;
+    _compactions += 1U;
+}
+
+// Allocate both ranges, rebuilding first when either does not fit.
+void App::GeometryPool::reserve( const unsigned int in_vertices, const unsigned int in_indices,
+    unsigned int* out_baseVertex, unsigned int* out_firstIndex ) {
+    if( _vertexRanges.allocate( in_vertices, out_baseVertex ) == true ) {
+        if( _indexRanges.allocate( in_indices, out_firstIndex ) == true )
+            return;
+        _vertexRanges.free( *out_baseVertex, in_vertices );
+    }
+    // Compacting alone frees one range of all the free space; grow when
+    // even that is too small.
+    unsigned int vertices = _vertexRanges.capacity(), indices = _indexRanges.capacity();
+    while( vertices - _vertexRanges.used() < in_vertices )
+        vertices *= 2U;
+    while( indices - _indexRanges.used() < in_indices )
+        indices *= 2U;
+    if( vertices != _vertexRanges.capacity() || indices != _indexRanges.capacity() )
+        _grows += 1U;
+    rebuild( vertices, indices );
+    _vertexRanges.allocate( in_vertices, out_baseVertex );
+    _indexRanges.allocate( in_indices, out_firstIndex );
+}
+
+void App::FoldDecode( const float in_model[ 16 ], const PositionDecode& in_decode, float out_model[ 16 ] ) {
+    for( unsigned int row = 0U; row < 4U; row += 1U ) {
+        out_model[ 12U + row ] = in_model[ 12U + row ];
+        for( unsigned int column = 0U; column < 3U; column += 1U ) {
+            out_model[ 4U * column + row ] = in_model[ 4U * column + row ] * in_decode.scale[ column ];
+            out_model[ 12U + row ] += in_model[ 4U * column + row ] * in_decode.offset[ column ];
+        }
+    }
+}
@@ -0,0 +1,188 @@
+#ifndef __GEOMETRY_POOL__
+#define __GEOMETRY_POOL__
+
+#include <vector>
+
+#include "glad/glad.h"
+#include "VertexPacking.hpp"
+#include "InstanceBuffer.hpp"
+
+namespace App {
+
+// Layout glMultiDrawElementsIndirect reads from GL_DRAW_INDIRECT_BUFFER.
+struct DrawElementsIndirectCommand {
+    GLuint  count;          // Indices.
+    GLuint  instanceCount;
+    GLuint  firstIndex;
+    GLint   baseVertex;
+    GLuint  baseInstance;   // First instance of the InstanceBuffer region.
+};
+
+// First-fit allocator of [ offset, offset + size ) ranges in units of
+// vertices or indices. Freed ranges merge with their neighbors.
+class RangeAllocator {
+public:
+    RangeAllocator( void );
+
+    // Forget every allocation; everything is free.
+    void reset( const unsigned int in_capacity );
+    // Returns false when no free range is large enough.
+    bool allocate( const unsigned int in_size, unsigned int* out_offset );
+    void free( const unsigned int in_offset, const unsigned int in_size );
+
+    unsigned int capacity( void ) const;
+    unsigned int used( void ) const;
+    unsigned int largestFree( void ) const;
+    unsigned int freeRanges( void ) const;
+    // 1 - largest free range / free space: 0 when the free space is one
+    // range, towards 1 as it splits into slivers.
+    float fragmentation( void ) const;
+
+private:
+    struct Range {
+        unsigned int    offset;
+        unsigned int    size;
+    };
+
+    std::vector< Range >    _free;      // By offset, never adjacent.
+    unsigned int            _capacity;
+    unsigned int            _used;
+};
+
+// Where a mesh lives in the pool.
+struct PoolMesh {
+    unsigned int    baseVertex;
+    unsigned int    vertexCount;
+    unsigned int    firstIndex;
+    unsigned int    indexCount;
+    PositionDecode  decode;
+    bool            live;
+};
+
+struct GeometryPoolStats {
+    unsigned int        meshes;
+    unsigned int        vertexCapacity;
+    unsigned int        verticesUsed;
+    float               vertexFragmentation;
+    unsigned int        indexCapacity;
+    unsigned int        indicesUsed;
+    float               indexFragmentation;
+    unsigned long long  compactions;    // Every rebuild, grown or not.
+    unsigned long long  grows;
+};
+
+/*
+Many meshes in one vertex, one color and one index buffer.
+Indices stay relative to their mesh and each draw adds the mesh's base
+vertex, so 16-bit indices address any mesh below SHORT_INDEX_LIMIT
+vertices wherever it sits, and switching meshes binds nothing. Vertex and
+index ranges are sub-allocated first-fit from free lists. When no free
+range fits, the pool is rebuilt: live meshes are copied front to back with
+glCopyBufferSubData into new buffers, twice as large when the free space
+alone would not do. Handles stay valid; offsets and buffer names change,
+so bind() again whenever generation() moves.
+
+Positions keep the per-mesh quantization of PackMesh. With one command
+per draw there is no per-draw uniform, so callers fold the decode into
+the instance's model matrix (FoldDecode) and set the decode uniforms to
+the identity.
+
+    pool.create( 1U << 20, 3U << 20, 2U );
+    const unsigned int teapot = pool.add( packedTeapot );
+    pool.bind( posLoc, colLoc );            // with the VAO bound
+    pool.appendCommand( teapot, 1U, instance, &commands );
+    ...
+    pool.draw( commands, &instances );      // one call with MDI
+
+draw() submits with glMultiDrawElementsIndirect (GL 4.3) from a buffer of
+commands built on the CPU. Without it every command becomes a
+glDrawElementsInstancedBaseVertex after rebasing the instance attributes;
+without instance data, one glMultiDrawElementsBaseVertex draws them all.
+*/
+class GeometryPool {
+public:
+    GeometryPool( void );
+    ~GeometryPool( void );
+
+    // Room for in_vertices and in_indices to start with; in_indexSize is 2
+    // or 4 bytes. Needs a current context and LoadGLFunctions().
+    bool create( const unsigned int in_vertices, const unsigned int in_indices, const unsigned int in_indexSize );
+    void release( void );
+
+    // Copy in_mesh into the pool. Returns INVALID when its indices do not
+    // fit the pool's index size.
+    unsigned int add( const PackedMesh& in_mesh );
+    // Room for a mesh whose arrays the caller copies in itself, at the
+    // offsets mesh() gives, in units of PVertex, PColor and indexSize().
+    // Any allocate() or add() may move the ranges to new buffers, taking
+    // along whatever was copied so far, so look both up again after one.
+    unsigned int allocate( const unsigned int in_vertexCount, const unsigned int in_indexCount,
+        const PositionDecode& in_decode );
+    void remove( const unsigned int in_handle );
+    const PoolMesh& mesh( const unsigned int in_handle ) const;
+    // Rebuild with every live mesh packed to the front.
+    void compact( void );
+
+    // Point in_positionLoc, in_colorLoc and the element array of the bound
+    // VAO at the pool.
+    void bind( const GLuint in_positionLoc, const GLuint in_colorLoc ) const;
+    // Bumped whenever the buffers are replaced.
+    unsigned int generation( void ) const;
+    GLenum indexType( void ) const;
+    unsigned int indexSize( void ) const;
+    GLuint vertexBuffer( void ) const;  // PVertex
+    GLuint colorBuffer( void ) const;   // PColor
+    GLuint indexBuffer( void ) const;
+
+    // Faces [ in_firstFace, in_firstFace + in_faceCount ) of the mesh, e.g.
+    // one LOD; in_faceCount 0 draws the rest of the mesh.
+    void appendCommand( const unsigned int in_handle, const unsigned int in_instanceCount,
+        const unsigned int in_baseInstance, std::vector< DrawElementsIndirectCommand >* io_commands,
+        const unsigned int in_firstFace = 0U, const unsigned int in_faceCount = 0U ) const;
+    // Draw in_commands with the pool bound. in_instances, bound at instance
+    // 0 for indirect draws, supplies baseInstance; NULL draws one instance
+    // per command with the current attribute values.
+    void draw( const std::vector< DrawElementsIndirectCommand >& in_commands, InstanceBuffer* io_instances );
+    // Use glMultiDrawElementsIndirect when the driver has it.
+    void setIndirect( const bool in_indirect );
+    bool indirect( void ) const;
+
+    GeometryPoolStats stats( void ) const;
+
+    static const unsigned int INVALID = 0xFFFFFFFFU;
+
+private:
+    GeometryPool( const GeometryPool& );
+    GeometryPool& operator=( const GeometryPool& );
+
+    void rebuild( const unsigned int in_vertices, const unsigned int in_indices );
+    void reserve( const unsigned int in_vertices, const unsigned int in_indices, unsigned int* out_baseVertex,
+        unsigned int* out_firstIndex );
+
+private:
+    std::vector< PoolMesh >     _meshes;
+    std::vector< unsigned int > _freeHandles;
+    RangeAllocator              _vertexRanges;
+    RangeAllocator              _indexRanges;
+    GLuint                      _vertexBuffer;  // PVertex
+    GLuint                      _colorBuffer;   // PColor
+    GLuint                      _indexBuffer;
+    GLuint                      _commandBuffer;
+    unsigned int                _indexSize;
+    unsigned int                _generation;
+    bool                        _indirect;
+    std::vector< unsigned int > _longIndicies;      // Widened 16-bit indices.
+    std::vector< const GLvoid* > _offsets;          // glMultiDrawElementsBaseVertex arguments.
+    std::vector< GLsizei >      _counts;
+    std::vector< GLint >        _baseVerticies;
+    unsigned long long          _compactions;
+    unsigned long long          _grows;
+};
+
+// out_model = in_model * translate( decode.offset ) * scale( decode.scale ),
+// column-major, so the shader's own decode can be the identity.
+void FoldDecode( const float in_model[ 16 ], const PositionDecode& in_decode, float out_model[ 16 ] );
+
+}
+
+#endif
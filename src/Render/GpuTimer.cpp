@@ -0,0 +1,101 @@
+#include "GpuTimer.hpp"
+#include "GLFunctions.hpp"
+#include "Profiler.hpp"
+
+App::GpuTimer::GpuTimer( void ) : _frame( 0U ), _dropped( 0U ), _open( false ), _created( false ) {
+    for( unsigned int frame = 0U; frame < FRAMES; frame += 1U ) {
+        _count[ frame ] = 0U;
+        for( unsigned int query = 0U; query < MAX_QUERIES; query += 1U )
+            _queries[ frame ][ query ] = 0U;
+    }
+}
+
+App::GpuTimer::~GpuTimer( void ) {
+    release();
+}
+
+bool App::GpuTimer::create( void ) {
+    release();
+    if( GetGLFunctions().getQueryObjectui64v == NULL )
+        return false;
+    for( unsigned int frame = 0U; frame < FRAMES; frame += 1U ) {
+        glGenQueries( MAX_QUERIES, _queries[ frame ] );
+        _count[ frame ] = 0U;
+    }
+    _frame = 0U;
+    _created = true;
+    return glGetError() == GL_NO_ERROR;
+}
+
+void App::GpuTimer::release( void ) {
+    if( _created == false )
+        return;
+    if( _open == true )
+        glEndQuery( GL_TIME_ELAPSED );
+    for( unsigned int frame = 0U; frame < FRAMES; frame += 1U ) {
+        glDeleteQueries( MAX_QUERIES, _queries[ frame ] );
+        _count[ frame ] = 0U;
+    }
+    _open = false;
+    _created = false;
+}
+
+void App::GpuTimer::beginFrame( void ) {
+    if( _created == false )
+        return;
+    if( _open == true ) {
+        glEndQuery( GL_TIME_ELAPSED );
+        _open = false;
+    }
+    _frame = ( _frame + 1U ) % FRAMES;
+    collect( _frame );
+}
+
+void App::GpuTimer::begin( const char* in_name ) {
+    if( _created == false )
+        return;
+    unsigned int& count = _count[ _frame ];
+    if( _open == true || count == MAX_QUERIES ) {
+        _dropped += 1U;
+        return;
+    }
+    _spans[ _frame ][ count ].name = in_name;
+    _spans[ _frame ][ count ].begin = Profiler::now();
+    glBeginQuery( GL_TIME_ELAPSED, _queries[ _frame ][ count ] );
+    count += 1U;
+    _open = true;
+}
+
+void App::GpuTimer::end( void ) {
+    if( _open == false )
+        return;
+    glEndQuery( GL_TIME_ELAPSED );
+    _open = false;
+}
+
+unsigned long long App::GpuTimer::dropped( void ) const {
+    return _dropped;
+}
+
+void App::GpuTimer::collect( const unsigned int in_frame ) {
+    const uint64_t now = Profiler::now();
+    for( unsigned int query = 0U; query < _count[ in_frame ]; query += 1U ) {
+        GLint available = GL_FALSE;
+        glGetQueryObjectiv( _queries[ in_frame ][ query ], GL_QUERY_RESULT_AVAILABLE, &available );
+        if( available == GL_FALSE ) {
+            _dropped += 1U;
+            continue;
+        }
+        GLuint64 elapsed = 0U;
+        GetGLFunctions().getQueryObjectui64v( _queries[ in_frame ][ query ], GL_QUERY_RESULT, &elapsed );
+        // Work cannot outlast the wall time since it was issued; some
+        // drivers report garbage for the first query of a context.
+        const Span& span = _spans[ in_frame ][ query ];
+        if( elapsed > now - span.begin ) {
+            _dropped += 1U;
+            continue;
+        }
+        Profiler::recordGpu( span.name, span.begin, elapsed );
+    }
+    _count[ in_frame ] = 0U;
+}
@@ -0,0 +1,88 @@
+#ifndef __GPU_TIMER__
+#define __GPU_TIMER__
+
+#include <stdint.h>
+
+#include "glad/glad.h"
+
+namespace App {
+
+/*
+GL_TIME_ELAPSED queries for GPU spans, handed to App::Profiler.
+Results are collected FRAMES frames after issue and never waited for; a
+query still pending by then is dropped. Elapsed-time queries cannot nest,
+so a begin() inside an open span is ignored.
+
+    timer.beginFrame();
+    timer.begin( "draw" );
+    glDrawElements...
+    timer.end();
+*/
+class GpuTimer {
+public:
+    GpuTimer( void );
+    ~GpuTimer( void );
+
+    // Needs a current context and LoadGLFunctions().
+    bool create( void );
+    void release( void );
+
+    // Collect finished queries of the frame slot about to be reused.
+    void beginFrame( void );
+    // in_name must be a string literal.
+    void begin( const char* in_name );
+    void end( void );
+
+    // Spans lost to a full frame, a nested begin() or a late result.
+    unsigned long long dropped( void ) const;
+
+    static const unsigned int FRAMES = 4U;
+    static const unsigned int MAX_QUERIES = 32U;
+
+private:
+    GpuTimer( const GpuTimer& );
+    GpuTimer& operator=( const GpuTimer& );
+
+    void collect( const unsigned int in_frame );
+
+private:
+    struct Span {
+        const char*     name;
+        uint64_t        begin;      // Profiler::now() when issued.
+    };
+
+    GLuint              _queries[ FRAMES ][ MAX_QUERIES ];
+    Span                _spans[ FRAMES ][ MAX_QUERIES ];
+    unsigned int        _count[ FRAMES ];
+    unsigned int        _frame;
+    unsigned long long  _dropped;
+    bool                _open;
+    bool                _created;
+};
+
+class GpuScope {
+public:
+    GpuScope( GpuTimer* io_timer, const char* in_name ) : _timer( io_timer ) {
+        _timer->begin( in_name );
+    }
+    ~GpuScope( void ) {
+        _timer->end();
+    }
+
+private:
+    GpuScope( const GpuScope& );
+    GpuScope& operator=( const GpuScope& );
+
+private:
+    GpuTimer*   _timer;
+};
+
+}
+
+#ifdef APP_PROFILE
+#define PROFILE_GPU_SCOPE( timer, name ) App::GpuScope PROFILE_CONCAT( gpuScope, __LINE__ )( timer, name )
+#else
+#define PROFILE_GPU_SCOPE( timer, name ) do {} while( false )
+#endif
+
+#endif
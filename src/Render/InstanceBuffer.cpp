@@ -0,0 +1,177 @@
+#include "InstanceBuffer.hpp"
+#include "GLFunctions.hpp"
+#include "GLState.hpp"
+
+namespace {
+
+const GLbitfield PERSISTENT_FLAGS = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+}
+
+void App::ComposeInstance( const float in_position[ 3 ], const float in_rotation[ 4 ],
+    const float in_base[ 16 ], const float in_color[ 4 ], App::AInstance* out_instance ) {
+    const float x = in_rotation[ 0 ], y = in_rotation[ 1 ], z = in_rotation[ 2 ], w = in_rotation[ 3 ];
+    // Rotation matrix, column-major.
+    const float r[ 9 ] = {
+        1.f - 2.f * ( y * y + z * z ), 2.f * ( x * y + w * z ), 2.f * ( x * z - w * y ),
+        2.f * ( x * y - w * z ), 1.f - 2.f * ( x * x + z * z ), 2.f * ( y * z + w * x ),
+        2.f * ( x * z + w * y ), 2.f * ( y * z - w * x ), 1.f - 2.f * ( x * x + y * y ) };
+    for( unsigned int column = 0U; column < 4U; column += 1U ) {
+        const float* b = in_base + 4U * column;
+        float* m = out_instance->model + 4U * column;
+        m[ 0 ] = r[ 0 ] * b[ 0 ] + r[ 3 ] * b[ 1 ] + r[ 6 ] * b[ 2 ] + in_position[ 0 ] * b[ 3 ];
+        m[ 1 ] = r[ 1 ] * b[ 0 ] + r[ 4 ] * b[ 1 ] + r[ 7 ] * b[ 2 ] + in_position[ 1 ] * b[ 3 ];
+        m[ 2 ] = r[ 2 ] * b[ 0 ] + r[ 5 ] * b[ 1 ] + r[ 8 ] * b[ 2 ] + in_position[ 2 ] * b[ 3 ];
+        m[ 3 ] = b[ 3 ];
+    }
+    out_instance->color[ 0 ] = in_color[ 0 ];
+    out_instance->color[ 1 ] = in_color[ 1 ];
+    out_instance->color[ 2 ] = in_color[ 2 ];
+    out_instance->color[ 3 ] = in_color[ 3 ];
+}
+
+App::InstanceBuffer::InstanceBuffer( void ) : _buffer( 0U ), _capacity( 0U ), _region( 0U ),
+    _modelLoc( 0U ), _colorLoc( 0U ), _mapped( NULL ), _current( NULL ), _stalls( 0U ),
+    _persistent( false ), _attached( false ) {
+    for( unsigned int index = 0U; index < REGIONS; index += 1U )
+        _fences[ index ] = NULL;
+}
+
+App::InstanceBuffer::~InstanceBuffer( void ) {
+    release();
+}
+
+bool App::InstanceBuffer::create( const unsigned int in_capacity ) {
+    release();
+    if( in_capacity == 0U )
+        return false;
+    _capacity = in_capacity;
+    const GLsizeiptr size = regionSize() * REGIONS;
+
+    glGenBuffers( 1, &_buffer );
+    GetGLState().bindBuffer( GL_ARRAY_BUFFER, _buffer );
+    const BufferStorageProc bufferStorage = GetGLFunctions().bufferStorage;
+    if( bufferStorage != NULL ) {
+        // Immutable storage, mapped for the lifetime of the buffer. Coherent
+        // writes become visible to commands issued after them.
+        bufferStorage( GL_ARRAY_BUFFER, size, NULL, PERSISTENT_FLAGS );
+        _mapped = glMapBufferRange( GL_ARRAY_BUFFER, 0, size, PERSISTENT_FLAGS );
+        _persistent = _mapped != NULL;
+    }
+    if( _persistent == false ) {
+        // A buffer made with glBufferStorage stays immutable; start over.
+        if( bufferStorage != NULL ) {
+            GetGLState().deleteBuffers( 1, &_buffer );
+            glGenBuffers( 1, &_buffer );
+            GetGLState().bindBuffer( GL_ARRAY_BUFFER, _buffer );
+        }
+        glBufferData( GL_ARRAY_BUFFER, size, NULL, GL_STREAM_DRAW );
+    }
+    _region = REGIONS - 1U;
+    return glGetError() == GL_NO_ERROR;
+}
+
+void App::InstanceBuffer::release( void ) {
+    for( unsigned int index = 0U; index < REGIONS; index += 1U ) {
+        if( _fences[ index ] != NULL )
+            glDeleteSync( _fences[ index ] );
+        _fences[ index ] = NULL;
+    }
+    if( _buffer != 0U ) {
+        unmap();
+        if( _mapped != NULL ) {
+            GetGLState().bindBuffer( GL_ARRAY_BUFFER, _buffer );
+            glUnmapBuffer( GL_ARRAY_BUFFER );
+        }
+        GetGLState().deleteBuffers( 1, &_buffer );
+    }
+    _buffer = 0U;
+    _capacity = 0U;
+    _mapped = NULL;
+    _current = NULL;
+    _persistent = false;
+    _attached = false;
+}
+
+void App::InstanceBuffer::attach( const GLuint in_modelLoc, const GLuint in_colorLoc ) {
+    const VertexAttribDivisorProc vertexAttribDivisor = GetGLFunctions().vertexAttribDivisor;
+    _modelLoc = in_modelLoc;
+    _colorLoc = in_colorLoc;
+    for( GLuint column = 0U; column < 4U; column += 1U ) {
+        glEnableVertexAttribArray( _modelLoc + column );
+        vertexAttribDivisor( _modelLoc + column, 1U );
+    }
+    glEnableVertexAttribArray( _colorLoc );
+    vertexAttribDivisor( _colorLoc, 1U );
+    _attached = true;
+}
+
+App::AInstance* App::InstanceBuffer::begin( void ) {
+    if( _buffer == 0U )
+        return NULL;
+    _region = ( _region + 1U ) % REGIONS;
+    if( _fences[ _region ] != NULL ) {
+        if( WaitFence( _fences[ _region ] ) == true )
+            _stalls += 1U;
+        glDeleteSync( _fences[ _region ] );
+        _fences[ _region ] = NULL;
+    }
+    if( _persistent == true ) {
+        _current = reinterpret_cast< AInstance* >(
+            static_cast< char* >( _mapped ) + regionSize() * _region );
+    } else {
+        // The fence already guarantees the region is idle, so skip the
+        // driver's own synchronization.
+        GetGLState().bindBuffer( GL_ARRAY_BUFFER, _buffer );
+        _current = static_cast< AInstance* >( glMapBufferRange( GL_ARRAY_BUFFER,
+            regionSize() * _region, regionSize(),
+            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT ) );
+    }
+    return _current;
+}
+
+void App::InstanceBuffer::bind( const unsigned int in_firstInstance ) {
+    if( _attached == false )
+        return;
+    unmap();
+    const GLsizeiptr offset = regionSize() * _region + sizeof(AInstance) * in_firstInstance;
+    GetGLState().bindBuffer( GL_ARRAY_BUFFER, _buffer );
+    for( GLuint column = 0U; column < 4U; column += 1U )
+        glVertexAttribPointer( _modelLoc + column, 4, GL_FLOAT, GL_FALSE, sizeof(AInstance),
+            (GLvoid*)( offset + sizeof(float) * 4U * column ) );
+    glVertexAttribPointer( _colorLoc, 4, GL_FLOAT, GL_FALSE, sizeof(AInstance),
+        (GLvoid*)( offset + sizeof(float) * 16U ) );
+}
+
+void App::InstanceBuffer::end( void ) {
+    if( _buffer == 0U )
+        return;
+    unmap();
+    _current = NULL;
+    _fences[ _region ] = glFenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0U );
+}
+
+unsigned int App::InstanceBuffer::capacity( void ) const {
+    return _capacity;
+}
+
+bool App::InstanceBuffer::persistent( void ) const {
+    return _persistent;
+}
+
+unsigned long long App::InstanceBuffer::stalls( void ) const {
+    return _stalls;
+}
+
+GLsizeiptr App::InstanceBuffer::regionSize( void ) const {
+    return sizeof(AInstance) * _capacity;
+}
+
+// Unmap the current region on the per-frame mapping path.
+void App::InstanceBuffer::unmap( void ) {
+    if( _persistent == true || _current == NULL )
+        return;
+    GetGLState().bindBuffer( GL_ARRAY_BUFFER, _buffer );
+    glUnmapBuffer( GL_ARRAY_BUFFER );
+    _current = NULL;
+}
@@ -0,0 +1,91 @@
+#ifndef __INSTANCE_BUFFER__
+#define __INSTANCE_BUFFER__
+
+#include "glad/glad.h"
+
+namespace App {
+
+// Per-instance attributes, read by vertex.shader with divisor 1.
+struct AInstance {
+    float model[ 16 ];      // Column-major model matrix.
+    float color[ 4 ];
+};
+
+// out_instance->model = [ rotation | position ] * in_base, with in_rotation
+// a unit quaternion ( x, y, z, w ) and in_base column-major. Every field of
+// out_instance is written once and never read back, so it may point straight
+// into write-combined mapped memory.
+void ComposeInstance( const float in_position[ 3 ], const float in_rotation[ 4 ],
+    const float in_base[ 16 ], const float in_color[ 4 ], AInstance* out_instance );
+
+/*
+Ring of per-frame regions for per-instance data.
+With GL 4.4 buffer storage the whole ring is mapped once, persistently and
+coherently; otherwise each region is mapped unsynchronized every frame. In
+both cases a fence per region keeps the CPU from overwriting data the GPU
+has not consumed yet. The buffer is bound through GetGLState() and left
+bound, so consecutive bind() calls rebind nothing.
+
+    buffer.attach( modelLoc, colorLoc );   // once, with the VAO bound
+    ...
+    AInstance* instances = buffer.begin();
+    ... fill up to capacity() instances ...
+    buffer.bind( 0U );                      // with the VAO bound
+    glDrawElementsInstanced( ..., count );
+    buffer.end();
+*/
+class InstanceBuffer {
+public:
+    InstanceBuffer( void );
+    ~InstanceBuffer( void );
+
+    // Room for in_capacity instances per frame. Needs a current context and
+    // LoadGLFunctions().
+    bool create( const unsigned int in_capacity );
+    void release( void );
+
+    // Enable the instanced attributes on the bound VAO. in_modelLoc is the
+    // first of the four columns of the mat4 attribute.
+    void attach( const GLuint in_modelLoc, const GLuint in_colorLoc );
+    // Wait until the next region is free and return it for writing. The
+    // pointer is valid until the first bind() of the frame.
+    AInstance* begin( void );
+    // Point the attached attributes of the bound VAO at instance
+    // in_firstInstance of the current region.
+    void bind( const unsigned int in_firstInstance );
+    // Fence the current region after the draw calls that read it.
+    void end( void );
+
+    unsigned int capacity( void ) const;
+    // True when the ring is mapped once with GL 4.4 buffer storage.
+    bool persistent( void ) const;
+    // Times begin() found its region still in use by the GPU.
+    unsigned long long stalls( void ) const;
+
+    // Regions in flight: the CPU writes one while the GPU reads the others.
+    static const unsigned int REGIONS = 3U;
+
+private:
+    InstanceBuffer( const InstanceBuffer& );
+    InstanceBuffer& operator=( const InstanceBuffer& );
+
+    GLsizeiptr regionSize( void ) const;
+    void unmap( void );
+
+private:
+    GLuint          _buffer;
+    unsigned int    _capacity;
+    unsigned int    _region;
+    GLuint          _modelLoc;
+    GLuint          _colorLoc;
+    void*           _mapped;        // Whole ring, persistent path only.
+    AInstance*      _current;
+    GLsync          _fences[ REGIONS ];
+    unsigned long long _stalls;
+    bool            _persistent;
+    bool            _attached;
+};
+
+}
+
+#endif
@@ -0,0 +1,223 @@
+#include "ProgramCache.hpp"
+#include "GLFunctions.hpp"
+#include "MeshCache.hpp"
+
+#include <stdio.h>
+#include <string.h>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+namespace {
+
+const char* GLText( const GLenum in_name ) {
+    const GLubyte* text = glGetString( in_name );
+    return text != NULL ? reinterpret_cast< const char* >( text ) : "";
+}
+
+// Drop errors a rejected binary may have raised, so later glGetError()
+// checks only see their own.
+void ClearErrors( void ) {
+    while( glGetError() != GL_NO_ERROR ) {}
+}
+
+App::ProgramCacheStatus ReadCache( const char* in_cacheName, const uint64_t in_key, GLenum* out_format,
+    std::vector< char >* out_binary ) {
+    std::ifstream file( in_cacheName, std::ios::binary );
+    if( file.good() == false )
+        return App::ProgramCacheMissing;
+    App::ProgramCacheHeader header;
+    if( file.read( reinterpret_cast< char* >( &header ), sizeof( App::ProgramCacheHeader ) ).good() == false
+        || memcmp( header.magic, App::PROGRAM_CACHE_MAGIC, sizeof( App::PROGRAM_CACHE_MAGIC ) ) != 0
+        || header.version != App::PROGRAM_CACHE_VERSION || header.size == 0U || header.size > 0x7fffffffULL )
+        return App::ProgramCacheCorrupt;
+    if( header.key != in_key )
+        return App::ProgramCacheStale;
+    out_binary->resize( (size_t)header.size );
+    if( file.read( &( *out_binary )[ 0 ], (std::streamsize)header.size ).good() == false
+        || Checksum64( &( *out_binary )[ 0 ], out_binary->size() ) != header.checksum )
+        return App::ProgramCacheCorrupt;
+    *out_format = header.binaryFormat;
+    return App::ProgramCacheHit;
+}
+
+bool WriteCache( const char* in_cacheName, const uint64_t in_key, const GLuint in_program ) {
+    const App::GLFunctions& functions = App::GetGLFunctions();
+    GLint length = 0;
+    glGetProgramiv( in_program, GL_PROGRAM_BINARY_LENGTH, &length );
+    if( length <= 0 )
+        return false;
+    std::vector< char > binary( (size_t)length );
+    GLsizei written = 0;
+    GLenum format = 0U;
+    functions.getProgramBinary( in_program, length, &written, &format, &binary[ 0 ] );
+    if( written <= 0 )
+        return false;
+
+    App::ProgramCacheHeader header;
+    memset( &header, 0, sizeof( App::ProgramCacheHeader ) );
+    memcpy( header.magic, App::PROGRAM_CACHE_MAGIC, sizeof( App::PROGRAM_CACHE_MAGIC ) );
+    header.version = App::PROGRAM_CACHE_VERSION;
+    header.binaryFormat = format;
+    header.key = in_key;
+    header.size = (uint64_t)written;
+    header.checksum = Checksum64( &binary[ 0 ], (size_t)written );
+
+    const std::string tempName = std::string( in_cacheName ) + ".tmp";
+    {
+        std::ofstream file( tempName.c_str(), std::ios::binary | std::ios::trunc );
+        file.write( reinterpret_cast< const char* >( &header ), sizeof( App::ProgramCacheHeader ) );
+        file.write( &binary[ 0 ], written );
+        if( file.good() == false ) {
+            remove( tempName.c_str() );
+            return false;
+        }
+    }
+    return rename( tempName.c_str(), in_cacheName ) == 0;
+}
+
+GLuint Link( const GLuint in_vertexShader, const GLuint in_fragmentShader, const bool in_retrievable ) {
+    const GLuint program = glCreateProgram();
+    if( program == 0U )
+        return 0U;
+    // Without the hint a driver may keep no binary to hand back.
+    if( in_retrievable == true )
+        App::GetGLFunctions().programParameteri( program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE );
+    glAttachShader( program, in_vertexShader );
+    glAttachShader( program, in_fragmentShader );
+    glLinkProgram( program );
+    GLint linked = GL_FALSE;
+    glGetProgramiv( program, GL_LINK_STATUS, &linked );
+    if( linked == GL_FALSE ) {
+        GLint infoLen = 0;
+        glGetProgramiv( program, GL_INFO_LOG_LENGTH, &infoLen );
+        if( infoLen > 1 ) {
+            std::vector< char > infoLog( (size_t)infoLen );
+            glGetProgramInfoLog( program, infoLen, NULL, &infoLog[ 0 ] );
+            std::cout << &infoLog[ 0 ];
+        }
+        glDeleteProgram( program );
+        return 0U;
+    }
+    glDetachShader( program, in_vertexShader );
+    glDetachShader( program, in_fragmentShader );
+    return program;
+}
+
+}
+
+bool App::ReadShaderSource( const char* in_fileName, std::string* out_source ) {
+    std::ifstream file( in_fileName, std::ios::binary );
+    if( file.good() == false ) {
+        std::cout << "Error: File not exist, " << in_fileName << std::endl;
+        return false;
+    }
+    std::ostringstream text;
+    text << file.rdbuf();
+    *out_source = text.str();
+    return true;
+}
+
+GLuint App::CompileShader( const GLenum in_type, const char* in_source ) {
+    const GLuint shader = glCreateShader( in_type );
+    if( shader == 0U )
+        return 0U;
+    glShaderSource( shader, 1, &in_source, NULL );
+    glCompileShader( shader );
+    GLint compiled = GL_FALSE;
+    glGetShaderiv( shader, GL_COMPILE_STATUS, &compiled );
+    if( compiled == GL_FALSE ) {
+        GLint infoLen = 0;
+        glGetShaderiv( shader, GL_INFO_LOG_LENGTH, &infoLen );
+        if( infoLen > 1 ) {
+            std::vector< char > infoLog( (size_t)infoLen );
+            glGetShaderInfoLog( shader, infoLen, NULL, &infoLog[ 0 ] );
+            std::cout << &infoLog[ 0 ];
+        }
+        glDeleteShader( shader );
+        return 0U;
+    }
+    return shader;
+}
+
+GLuint App::LinkProgram( const GLuint in_vertexShader, const GLuint in_fragmentShader ) {
+    return Link( in_vertexShader, in_fragmentShader, false );
+}
+
+uint64_t App::ProgramCacheKey( const std::string& in_vertexSource, const std::string& in_fragmentSource ) {
+    // Separators keep "ab" + "c" apart from "a" + "bc".
+    std::string key;
+    key.append( GLText( GL_VENDOR ) ).push_back( '\0' );
+    key.append( GLText( GL_RENDERER ) ).push_back( '\0' );
+    key.append( GLText( GL_VERSION ) ).push_back( '\0' );
+    key.append( in_vertexSource ).push_back( '\0' );
+    key.append( in_fragmentSource );
+    return Checksum64( key.data(), key.size() );
+}
+
+GLuint App::LoadProgram( const std::string& in_vertexSource, const std::string& in_fragmentSource,
+    const char* in_cacheName, ProgramCacheStatus* out_status ) {
+    const GLFunctions& functions = GetGLFunctions();
+    GLint formats = 0;
+    if( functions.getProgramBinary != NULL && functions.programBinary != NULL
+        && functions.programParameteri != NULL )
+        glGetIntegerv( GL_NUM_PROGRAM_BINARY_FORMATS, &formats );
+    const bool binaries = formats > 0;
+
+    ProgramCacheStatus status = ProgramCacheUnsupported;
+    uint64_t key = 0U;
+    if( binaries == true ) {
+        key = ProgramCacheKey( in_vertexSource, in_fragmentSource );
+        GLenum format = 0U;
+        std::vector< char > binary;
+        status = ReadCache( in_cacheName, key, &format, &binary );
+        if( status == ProgramCacheHit ) {
+            const GLuint program = glCreateProgram();
+            functions.programBinary( program, format, &binary[ 0 ], (GLsizei)binary.size() );
+            GLint linked = GL_FALSE;
+            glGetProgramiv( program, GL_LINK_STATUS, &linked );
+            if( linked == GL_TRUE ) {
+                *out_status = ProgramCacheHit;
+                return program;
+            }
+            glDeleteProgram( program );
+            ClearErrors();
+            status = ProgramCacheRejected;
+        }
+    }
+    *out_status = status;
+
+    const GLuint vertexShader = CompileShader( GL_VERTEX_SHADER, in_vertexSource.c_str() );
+    const GLuint fragmentShader = CompileShader( GL_FRAGMENT_SHADER, in_fragmentSource.c_str() );
+    GLuint program = 0U;
+    if( vertexShader != 0U && fragmentShader != 0U )
+        program = Link( vertexShader, fragmentShader, binaries );
+    glDeleteShader( vertexShader );
+    glDeleteShader( fragmentShader );
+    if( program != 0U && binaries == true && WriteCache( in_cacheName, key, program ) == false )
+        std::cout << "Warning: Cannot write " << in_cacheName << std::endl;
+    return program;
+}
+
+const char* App::ProgramCacheStatusName( const ProgramCacheStatus in_status ) {
+    switch( in_status ) {
+        case ProgramCacheHit :
+        return "hit";
+
+        case ProgramCacheMissing :
+        return "missing";
+
+        case ProgramCacheStale :
+        return "stale";
+
+        case ProgramCacheCorrupt :
+        return "corrupt";
+
+        case ProgramCacheRejected :
+        return "rejected";
+
+        default :
+        return "unsupported";
+    }
+}
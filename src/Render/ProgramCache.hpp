@@ -0,0 +1,66 @@
+#ifndef __PROGRAM_CACHE__
+#define __PROGRAM_CACHE__
+
+#include <stdint.h>
+#include <string>
+
+#include "glad/glad.h"
+
+namespace App {
+
+/*
+Linked shader programs cached on disk with glGetProgramBinary.
+
+    ProgramCacheHeader
+    char[ size ]                the driver's binary, in binaryFormat
+
+The key hashes both shader sources together with GL_VENDOR, GL_RENDERER and
+GL_VERSION, so an edited shader or another driver misses. A driver may still
+reject a binary it wrote (glProgramBinary then leaves the link status false);
+the program is compiled from source and the cache written again. Without
+binary formats, as on macOS, every load compiles.
+*/
+
+static const char PROGRAM_CACHE_MAGIC[ 8 ] = { 'P', 'R', 'O', 'G', 'C', 'A', 'C', 'H' };
+static const uint32_t PROGRAM_CACHE_VERSION = 1U;
+
+struct ProgramCacheHeader {
+    char        magic[ 8 ];
+    uint32_t    version;
+    uint32_t    binaryFormat;   // GLenum from glGetProgramBinary.
+    uint64_t    key;            // ProgramCacheKey() of the sources.
+    uint64_t    size;           // Bytes of binary after the header.
+    uint64_t    checksum;       // Checksum64 of the binary.
+};
+
+enum ProgramCacheStatus {
+    ProgramCacheHit,            // Restored from the cache.
+    ProgramCacheMissing,        // Compiled; no cache yet.
+    ProgramCacheStale,          // Compiled; sources or driver changed.
+    ProgramCacheCorrupt,        // Compiled; the file did not validate.
+    ProgramCacheRejected,       // Compiled; the driver refused the binary.
+    ProgramCacheUnsupported     // Compiled; the driver has no binary formats.
+};
+
+// The whole of in_fileName as text.
+bool ReadShaderSource( const char* in_fileName, std::string* out_source );
+
+// Compile one stage. Prints the info log and returns 0 on failure.
+GLuint CompileShader( const GLenum in_type, const char* in_source );
+// Link both stages. Prints the info log and returns 0 on failure.
+GLuint LinkProgram( const GLuint in_vertexShader, const GLuint in_fragmentShader );
+
+// Needs a current context: the driver strings are part of the key.
+uint64_t ProgramCacheKey( const std::string& in_vertexSource, const std::string& in_fragmentSource );
+
+// Restore the program from in_cacheName when its key matches, otherwise
+// compile, link and write the cache atomically (temporary file and rename).
+// Returns 0 when compiling or linking fails. Needs LoadGLFunctions().
+GLuint LoadProgram( const std::string& in_vertexSource, const std::string& in_fragmentSource,
+    const char* in_cacheName, ProgramCacheStatus* out_status );
+
+const char* ProgramCacheStatusName( const ProgramCacheStatus in_status );
+
+}
+
+#endif
@@ -0,0 +1,118 @@
+#include "ProgramReloader.hpp"
+
+App::ProgramReloader::ProgramReloader( void ) : _requested( false ), _building( false ), _stopping( false ) {
+}
+
+App::ProgramReloader::~ProgramReloader( void ) {
+    release();
+}
+
+bool App::ProgramReloader::create( const char* in_vertexFileName, const char* in_fragmentFileName,
+    const char* in_cacheName, const ContextCall& in_bindContext, const ContextCall& in_unbindContext ) {
+    release();
+    _vertexFileName = in_vertexFileName;
+    _fragmentFileName = in_fragmentFileName;
+    _cacheName = in_cacheName;
+    _bindContext = in_bindContext;
+    _unbindContext = in_unbindContext;
+    _requested = false;
+    _building = false;
+    _stopping = false;
+    _thread = std::thread( &ProgramReloader::work, this );
+    return true;
+}
+
+void App::ProgramReloader::release( void ) {
+    {
+        std::lock_guard< std::mutex > lock( _mutex );
+        _stopping = true;
+    }
+    _work.notify_all();
+    if( _thread.joinable() == true )
+        _thread.join();
+    for( size_t build = 0U; build < _builds.size(); build += 1U ) {
+        if( _builds[ build ].fence != NULL )
+            glDeleteSync( _builds[ build ].fence );
+        if( _builds[ build ].reload.program != 0U )
+            glDeleteProgram( _builds[ build ].reload.program );
+    }
+    _builds.clear();
+    _requested = false;
+}
+
+void App::ProgramReloader::request( const Clock::time_point in_time ) {
+    {
+        std::lock_guard< std::mutex > lock( _mutex );
+        if( _requested == true )
+            return;
+        _requested = true;
+        _requestTime = in_time;
+    }
+    _work.notify_one();
+}
+
+bool App::ProgramReloader::poll( ProgramReload* out_reload ) {
+    std::lock_guard< std::mutex > lock( _mutex );
+    if( _builds.empty() == true )
+        return false;
+    Build& build = _builds.front();
+    if( build.fence != NULL ) {
+        // Commands of another context: only the fence tells whether the
+        // link has completed.
+        const GLenum result = glClientWaitSync( build.fence, 0U, 0U );
+        if( result == GL_TIMEOUT_EXPIRED )
+            return false;
+        glDeleteSync( build.fence );
+        build.fence = NULL;
+        if( result == GL_WAIT_FAILED ) {
+            glDeleteProgram( build.reload.program );
+            build.reload.program = 0U;
+        }
+    }
+    *out_reload = build.reload;
+    _builds.pop_front();
+    return true;
+}
+
+bool App::ProgramReloader::busy( void ) {
+    std::lock_guard< std::mutex > lock( _mutex );
+    return _requested == true || _building == true || _builds.empty() == false;
+}
+
+// Build thread: rebuild the program once per batch of requests until
+// release().
+void App::ProgramReloader::work( void ) {
+    _bindContext();
+    while( true ) {
+        Build build;
+        {
+            std::unique_lock< std::mutex > lock( _mutex );
+            _work.wait( lock, [ this ]() { return _stopping == true || _requested == true; } );
+            if( _stopping == true )
+                break;
+            build.reload.requested = _requestTime;
+            _requested = false;
+            _building = true;
+        }
+        const Clock::time_point begin = Clock::now();
+        std::string vertexSource, fragmentSource;
+        build.reload.program = 0U;
+        build.reload.status = ProgramCacheMissing;
+        if( ReadShaderSource( _vertexFileName.c_str(), &vertexSource ) == true
+            && ReadShaderSource( _fragmentFileName.c_str(), &fragmentSource ) == true )
+            build.reload.program = LoadProgram( vertexSource, fragmentSource, _cacheName.c_str(), &build.reload.status );
+        build.fence = NULL;
+        if( build.reload.program != 0U ) {
+            build.fence = glFenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0U );
+            // The render context waits on the fence, so it must reach the
+            // GPU.
+            glFlush();
+        }
+        build.reload.buildSeconds = std::chrono::duration< double >( Clock::now() - begin ).count();
+
+        std::lock_guard< std::mutex > lock( _mutex );
+        _builds.push_back( build );
+        _building = false;
+    }
+    _unbindContext();
+}
@@ -0,0 +1,97 @@
+#ifndef __PROGRAM_RELOADER__
+#define __PROGRAM_RELOADER__
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "glad/glad.h"
+#include "ProgramCache.hpp"
+
+namespace App {
+
+struct ProgramReload {
+    typedef std::chrono::steady_clock Clock;
+
+    GLuint              program;        // 0 when a source was unreadable or did not build.
+    ProgramCacheStatus  status;
+    Clock::time_point   requested;      // Time given to the first request() served.
+    double              buildSeconds;   // Reading, compiling and linking.
+};
+
+/*
+Rebuilds a shader program from its sources without stalling the render
+loop. A thread of its own makes a context shared with the render context
+current (in_bindContext, e.g. a hidden GLFW window created with the render
+window as share) and builds with LoadProgram, which also refreshes the
+program cache. Programs are shared between the contexts; the render thread
+receives one only once a fence issued after the link has signaled.
+
+    reloader.create( "src/shader/vertex.shader", "src/shader/fragment.shader",
+        PROGRAM_CACHE, bind, unbind );
+    reloader.request( changeTime );         // a source was written
+    ...
+    if( reloader.poll( &reload ) == true )  // once per frame
+        use reload.program unless it is 0
+
+Requests made while a build runs collapse into one more build. A failed
+build hands back program 0, so the caller keeps the program it has.
+Every method runs on the thread owning the render context.
+*/
+class ProgramReloader {
+public:
+    typedef ProgramReload::Clock Clock;
+    typedef std::function< void( void ) > ContextCall;
+
+    ProgramReloader( void );
+    ~ProgramReloader( void );
+
+    // in_bindContext and in_unbindContext run on the build thread, first
+    // and last.
+    bool create( const char* in_vertexFileName, const char* in_fragmentFileName, const char* in_cacheName,
+        const ContextCall& in_bindContext, const ContextCall& in_unbindContext );
+    // Stop the thread and delete programs never handed out.
+    void release( void );
+
+    void request( const Clock::time_point in_time );
+    // The oldest finished build whose program is complete; false when none.
+    // The caller owns out_reload->program.
+    bool poll( ProgramReload* out_reload );
+    // True while a build is requested, running or not yet polled.
+    bool busy( void );
+
+private:
+    ProgramReloader( const ProgramReloader& );
+    ProgramReloader& operator=( const ProgramReloader& );
+
+    struct Build {
+        ProgramReload   reload;
+        GLsync          fence;
+    };
+
+    void work( void );
+
+private:
+    std::string                 _vertexFileName;
+    std::string                 _fragmentFileName;
+    std::string                 _cacheName;
+    ContextCall                 _bindContext;
+    ContextCall                 _unbindContext;
+    std::thread                 _thread;
+
+    std::mutex                  _mutex;
+    std::condition_variable     _work;
+    bool                        _requested;     // Guarded by _mutex.
+    bool                        _building;      // Guarded by _mutex.
+    Clock::time_point           _requestTime;   // Guarded by _mutex.
+    std::deque< Build >         _builds;        // Guarded by _mutex.
+    bool                        _stopping;      // Guarded by _mutex.
+};
+
+}
+
+#endif
@@ -6,30 +6,113 @@
 #include <cstdarg>
 #include <string>
 #include <cmath>
+#include <algorithm>
+#include <vector>
+#include <cstring>
+#include <chrono>
+#include <deque>
 
 #include "glm/glm.hpp"
 #include "glm/gtc/matrix_transform.hpp"
 #include "glm/gtc/type_ptr.hpp"
+#include "glm/gtc/quaternion.hpp"
 
 #include "Application.hpp"
 #include "util.h"
-
-char* vertex_shader_text;
-char* fragment_shader_text;
+#include "MeshBuffer.hpp"
+#include "MeshSimplifier.hpp"
+#include "PhysicsWorld.hpp"
+#include "PhysicsThread.hpp"
+#include "GLFunctions.hpp"
+#include "GLState.hpp"
+#include "ProgramCache.hpp"
+#include "InstanceBuffer.hpp"
+#include "DrawList.hpp"
+#include "FrameStats.hpp"
+#include "Profiler.hpp"
+#include "GpuTimer.hpp"
+#include "AssetStreamer.hpp"
+#include "GeometryPool.hpp"
+#include "ProgramReloader.hpp"
+#include "FileWatcher.hpp"
 
 static void error_callback( int error, const char* description );
 static void key_callback( GLFWwindow* window,
         int key, int scancode, int action, int mods );
 
-void LoadShaderCode( char** out_shaderCode, unsigned int* out_length, const char* in_fileName );
-GLuint LoadShader( GLenum type, const char* shaderCode );
-GLuint LinkProgram( GLuint vertexShader, GLuint fragmentShader );
+struct MeshBounds {
+        glm::vec3       center;
+        float           radius;
+};
+// Attribute, uniform and block locations of the shader program.
+struct ProgramLocations {
+        GLuint          position;
+        GLuint          color;
+        GLuint          model;          // A mat4 attribute takes four locations, one per column.
+        GLuint          instanceColor;
+        GLint           viewProjection;
+        GLint           positionOffset; // Positions are 16-bit offsets into the mesh's bounding box.
+        GLint           positionScale;
+        GLuint          prefixBlock;
+        GLuint          suffixBlock;
+};
+static glm::mat4 MeshBase( const MeshBounds& in_bounds );
+static MeshBounds FitBounds( const MeshVolume& in_volume );
+static void ResolveLocations( const GLuint in_program, ProgramLocations* out_locations );
+static void DisableAttributes( const ProgramLocations& in_locations );
+static void BindMesh( const App::MeshResource& in_mesh, const App::GeometryPool& in_pool,
+        const ProgramLocations& in_locations );
+static App::PhysicsScheduler PhysicsSchedulerFor( const App::RunOptions& in_options );
+static App::BroadphaseOptions BroadphaseFor( const App::RunOptions& in_options );
+static void BuildScene( App::PhysicsWorld* io_physics, btCollisionShape* in_shape,
+        std::vector< glm::vec4 >* out_colors );
+static void CameraMatrices( const int in_width, const int in_height,
+        glm::mat4* out_view, glm::mat4* out_projection );
+static void RunHeadless( const App::RunOptions& in_options );
 
 #define CLEAR_COLOR     0.f, 0.f, 0.f, 1.f
-
-int main( void )
+// Largest on-screen geometric error, in pixels, a LOD may introduce.
+#define LOD_TOLERANCE   1.f
+// Fixed simulation rate, independent of the swap interval.
+#define PHYSICS_RATE    60.0
+// Bodies per side of the square grid of instances.
+#define INSTANCE_GRID   32U
+// Every mesh is scaled to this bounding radius, so any asset fits the grid.
+#define BODY_RADIUS     13.f
+// Distance between neighbor bodies.
+#define BODY_SPACING    24.f
+// Mesh parse threads and bytes uploaded per frame while streaming.
+#define STREAM_WORKERS  2U
+#define UPLOAD_BUDGET   ( 256U * 1024U )
+// First room of the pool streamed meshes share; it grows when they need more.
+#define POOL_VERTICES   ( 64U * 1024U )
+#define POOL_INDICES    ( 192U * 1024U )
+// Mesh loads the headless run times from the text, then from the cache.
+#define HEADLESS_LOADS  10U
+// Chrome trace written on the P key and at exit when built with APP_PROFILE.
+#define PROFILE_TRACE   "profile.json"
+// Shader sources, watched and rebuilt when saved.
+#define VERTEX_SHADER   "src/shader/vertex.shader"
+#define FRAGMENT_SHADER "src/shader/fragment.shader"
+// Linked shader program, reused while the sources and the driver match.
+#define PROGRAM_CACHE   "src/shader/program.cache"
+
+static const char* MESH_PATH = "res/pumpkin";
+// Streamed at startup; keys 1 to 3 pick the one drawn.
+static const char* ASSET_PATHS[] = { "res/pumpkin", "res/sphere", "res/teapot" };
+static const unsigned int ASSET_COUNT = sizeof(ASSET_PATHS) / sizeof(ASSET_PATHS[ 0 ]);
+static unsigned int selectedAsset = 0U;
+
+int main( int argc, char** argv )
 {
-        App::Application* app = App::Application::getInstance();
+        App::Application* app = App::Application::getInstance( argc, argv );
+
+        // Headless: no window and no GL, only the CPU side of every frame.
+        if( app->headless() == true ) {
+                RunHeadless( app->options() );
+                delete app;
+                return EXIT_SUCCESS;
+        }
 
         /* Set default error-callback. */
         glfwSetErrorCallback( error_callback );
@@ -74,6 +157,13 @@ int main( void )
         // Load pointers to openGL and its extension functions at runtime.
         // It is required above openGL 1.2.
         gladLoadGLLoader( (GLADloadproc) glfwGetProcAddress );
+        // Entry points above openGL 3.2: instanced arrays and buffer storage.
+        App::LoadGLFunctions( (GLADloadproc) glfwGetProcAddress );
+        if( App::GetGLFunctions().vertexAttribDivisor == NULL ) {
+                std::cout << "Error: Instanced arrays are not supported." << std::endl;
+                glfwTerminate();
+                exit( EXIT_FAILURE );
+        }
         // glfw supports a double-buffering.
         // A swap interval restricts buffer-swap. Even if the back-buffer is
         // filled and the graphic device is ready to swap buffer, do not swap
@@ -81,185 +171,398 @@ int main( void )
         // draw all fragments from the front-buffer.
         glfwSwapInterval( 1 );
 
-        // Load shader code.
-        unsigned int vertexShaderCodeLength = 0U, fragmentShaderCodeLength = 0U;
-        LoadShaderCode( &vertex_shader_text, &vertexShaderCodeLength, "src/shader/vertex.shader" );
-        LoadShaderCode( &fragment_shader_text, &fragmentShaderCodeLength, "src/shader/fragment.shader" );
+        // GPU spans of the frame profiler; a no-op unless it is created.
+        PROFILE_THREAD( "render" );
+        App::GpuTimer gpuTimer;
+#ifdef APP_PROFILE
+        if( gpuTimer.create() == false )
+                std::cout << "Warning: GL timer queries are not supported." << std::endl;
+#endif
 
-        // Shader compile.
-        GLuint vertex_shader
-                = LoadShader( GL_VERTEX_SHADER, vertex_shader_text );
-        GLuint fragment_shader
-                = LoadShader( GL_FRAGMENT_SHADER, fragment_shader_text );
+        // Load shader code.
+        std::string vertexShaderCode, fragmentShaderCode;
+        App::ReadShaderSource( VERTEX_SHADER, &vertexShaderCode );
+        App::ReadShaderSource( FRAGMENT_SHADER, &fragmentShaderCode );
 
         // Program link.
         // openGL ES 3.0 require one and only one vertex and fragment shader.
-        GLuint program = LinkProgram( vertex_shader, fragment_shader );
+        // The driver's binary of the last link is restored when the sources
+        // and the driver are unchanged; otherwise both stages are compiled
+        // and the binary is stored for the next launch.
+        const App::PhysicsThread::Clock::time_point programStart = App::PhysicsThread::Clock::now();
+        App::ProgramCacheStatus programStatus;
+        GLuint program = App::LoadProgram( vertexShaderCode, fragmentShaderCode, PROGRAM_CACHE, &programStatus );
+        if( program == 0U ) {
+                glfwTerminate();
+                exit( EXIT_FAILURE );
+        }
+        std::cout << "Info: Shader program "
+                << ( programStatus == App::ProgramCacheHit ? "restored" : "compiled" ) << " in "
+                << std::chrono::duration< double, std::milli >(
+                        App::PhysicsThread::Clock::now() - programStart ).count()
+                << " ms, cache " << App::ProgramCacheStatusName( programStatus ) << "." << std::endl;
 
-        // Run program.
-        glUseProgram( program );
+        // Every state change below goes through the cache, which drops the
+        // ones that would not change anything.
+        App::GLState& glState = App::GetGLState();
 
-        // Import mesh.
-        Mesh mesh;
-        const char* meshPath = "res/pumpkin";
-        if( FileLoadMesh( meshPath, &mesh ) == false ) {
-                std::cout << "Error: Parse error! " << meshPath << std::endl;
+        // Run program.
+        glState.useProgram( program );
+
+        // Hot reload.
+        // Saved shaders are rebuilt on a thread of their own, in a hidden
+        // window whose context shares objects with this one; saved meshes
+        // stream in again through the streamer. Either is swapped in at the
+        // start of a frame, and one that fails to build or parse leaves the
+        // current version in place.
+        app->hint( GLFW_VISIBLE, GLFW_FALSE );
+        GLFWwindow* reloadContext = glfwCreateWindow( 1, 1, "reload", NULL, window );
+        App::ProgramReloader reloader;
+        if( reloadContext == NULL ) {
+                std::cout << "Warning: No shared context, shaders will not reload." << std::endl;
+        }
+        else {
+                reloader.create( VERTEX_SHADER, FRAGMENT_SHADER, PROGRAM_CACHE,
+                        [ reloadContext ]() { glfwMakeContextCurrent( reloadContext ); },
+                        []() { glfwMakeContextCurrent( NULL ); } );
         }
 
-        // Convert struct Mesh to struct AVertex and AColor.
-        struct AVertex {
-                float x, y, z;
-        } *verticies;
-        struct AColor {
-                float r, g, b, a;
-        } *colors;
-        unsigned int index = 0U, size = 0U;
-        verticies = (AVertex*)malloc( sizeof(AVertex) * mesh.v.size() );
-        colors = (AColor*)malloc( sizeof(AColor)* mesh.v.size() );
-        for( unsigned int index = 0U; index < mesh.v.size(); index += 1U ) {
-                verticies[ index ] = *reinterpret_cast<AVertex*>( &mesh.v[ index ] );
-                colors[ index ].r = std::abs( mesh.v[ index ].x ) / 50.f;
-                colors[ index ].g = std::abs( mesh.v[ index ].y ) / 50.f;
-                colors[ index ].b = (std::abs( mesh.v[ index ].z ) - 100.f) / 50.f;
-                colors[ index ].a = 1.f;
+        // Import meshes.
+        // Worker threads parse them, from the binary cache when it is up to
+        // date, and each frame uploads a bounded slice. A placeholder cube is
+        // drawn until the selected mesh is resident.
+        // Resident meshes share the buffers of one pool, so every LOD range
+        // of a frame goes out in one multi-draw. A mesh too large for its
+        // 16-bit indices keeps buffers of its own.
+        App::GeometryPool pool;
+        if( pool.create( POOL_VERTICES, POOL_INDICES, 2U ) == false ) {
+                std::cout << "Warning: Geometry pool creation failed, meshes keep their own buffers." << std::endl;
+        }
+        std::cout << "Info: Pooled meshes drawn " << ( pool.indirect() ? "with one multi-draw indirect." : "one range at a time." )
+                << std::endl;
+        App::AssetStreamer streamer;
+        if( streamer.create( STREAM_WORKERS, UPLOAD_BUDGET, &pool ) == false ) {
+                std::cout << "Error: Asset streamer creation failed." << std::endl;
         }
+        unsigned int assets[ ASSET_COUNT ];
+        std::vector< bool > announced( ASSET_COUNT, false );
+        for( unsigned int asset = 0U; asset < ASSET_COUNT; asset += 1U )
+                assets[ asset ] = streamer.request( ASSET_PATHS[ asset ] );
+        const App::PhysicsThread::Clock::time_point streamStart = App::PhysicsThread::Clock::now();
+
+        // Both sources and every streamed mesh.
+        App::FileWatcher watcher;
+        const unsigned int vertexFile = watcher.watch( VERTEX_SHADER ),
+                fragmentFile = watcher.watch( FRAGMENT_SHADER );
+        std::vector< unsigned int > assetFiles( ASSET_COUNT );
+        for( unsigned int asset = 0U; asset < ASSET_COUNT; asset += 1U )
+                assetFiles[ asset ] = watcher.watch( ASSET_PATHS[ asset ] );
+        watcher.start();
+        std::cout << "Info: Watching shaders and meshes " << ( watcher.native() ? "with inotify." : "by polling." )
+                << std::endl;
+        std::vector< App::FileWatcher::Change > changes;
+        // Save times of the reloads in flight, per asset, and of the swaps
+        // to report once their first frame is out.
+        std::vector< std::deque< App::FileWatcher::Clock::time_point > > meshSaves( ASSET_COUNT );
+        std::vector< std::pair< std::string, App::FileWatcher::Clock::time_point > > swapped;
 
         // Dissolve attribute location.
-        GLuint posLoc = glGetAttribLocation( program, "in_position" );  // loc 0
-        GLuint colLoc = glGetAttribLocation( program, "in_color" );     // loc 1
-        GLuint mvpLoc = glGetUniformLocation( program, "in_mvp" );// loc 2
+        ProgramLocations locations;
+        ResolveLocations( program, &locations );
 
         GLuint VAOs[ 1 ];
-        GLuint VBOs[ 5 ];
-        GLuint VBOvertexPosition, VBOvertexColor, VBOelementArray,
-                VBOuniformBlockPrefix, VBOuniformBlockSuffix;
+        GLuint VBOs[ 2 ];
+        GLuint VBOuniformBlockPrefix, VBOuniformBlockSuffix;
 
         // Create and bind the vertex array object.
         glGenVertexArrays( 1, VAOs );
-        glBindVertexArray( VAOs[ 0 ] );
-
-        // Create four vertex buffer objects.
-        glGenBuffers( 5, VBOs );
-        VBOvertexPosition       = VBOs[ 0 ];
-        VBOvertexColor          = VBOs[ 1 ];
-        VBOelementArray         = VBOs[ 2 ];
-        VBOuniformBlockPrefix   = VBOs[ 3 ];
-        VBOuniformBlockSuffix   = VBOs[ 4 ];
-
-        // Use vertex buffer objects as GL_ARRAY_BUFFER for a position.
-        glBindBuffer( GL_ARRAY_BUFFER, VBOvertexPosition );
-        glBufferData( GL_ARRAY_BUFFER,
-                sizeof(AVertex) * mesh.v.size(),
-                verticies,
-                GL_STATIC_DRAW );
-        // Mapping VBO and attribute location of in_position.
-        glVertexAttribPointer( posLoc, 3, GL_FLOAT, GL_FALSE,
-                sizeof(AVertex), (GLvoid*) 0 );
-        glEnableVertexAttribArray( posLoc );
-
-        // Use vertex buffer objects as GL_ARRAY_BUFFER for a color.
-        glBindBuffer( GL_ARRAY_BUFFER, VBOvertexColor );
-        glBufferData( GL_ARRAY_BUFFER,
-                sizeof(AColor) * mesh.v.size(),
-                colors,
-                GL_STATIC_DRAW );
-        // Mapping VBO and attribute location of in_color.
-        glVertexAttribPointer( colLoc, 4, GL_FLOAT, GL_FALSE,
-                sizeof(AColor), (GLvoid*) 0 );
-        glEnableVertexAttribArray( colLoc );
-
-        // Bind buffer to NULL is ignored, but just call it.
-        glBindBuffer( GL_ARRAY_BUFFER, NULL );
+        glState.bindVertexArray( VAOs[ 0 ] );
+
+        // Create two buffer objects for the uniform blocks. Vertex, color
+        // and index buffers belong to the pool or the streamer; BindMesh()
+        // points the VAO at the drawn mesh.
+        glGenBuffers( 2, VBOs );
+        VBOuniformBlockPrefix   = VBOs[ 0 ];
+        VBOuniformBlockSuffix   = VBOs[ 1 ];
+        const App::MeshResource* boundMesh = &streamer.placeholder();
+        unsigned int boundVersion = 0U, boundGeneration = pool.generation();
+        std::vector< App::DrawElementsIndirectCommand > commands;
+        BindMesh( *boundMesh, pool, locations );
+        MeshBounds bounds = FitBounds( boundMesh->volume );
+
+        // Per-instance model matrices and colors.
+        // A ring of three frames, persistently mapped where buffer storage
+        // is available, feeds in_model and in_instanceColor once per instance.
+        const unsigned int instanceCount = INSTANCE_GRID * INSTANCE_GRID;
+        App::InstanceBuffer instances;
+        if( instances.create( instanceCount ) == false ) {
+                std::cout << "Error: Instance buffer creation failed." << std::endl;
+        }
+        instances.attach( locations.model, locations.instanceColor );
+        std::cout << "Info: " << instanceCount << " instances, "
+                << ( instances.persistent() ? "persistently mapped ring." : "ring mapped per frame." )
+                << std::endl;
 
         // Bind multiple uniform buffers.
         const float prefixColor[ 2 ] = { 1.f, 1.f },    // r, g
                 suffixColor[ 2 ] = { 1.f, 1.f };        // b, a
         GLuint prefixBindPoint = 1U,    // Allocate binding point 1.
                 suffixBindPoint = 2U;   // Allocate binding point 2.
-        GLuint prefixBlockLoc = glGetUniformBlockIndex( program, "ColorPrefix" ),
-                suffixBlockLoc = glGetUniformBlockIndex( program, "ColorSuffix" );
-        glUniformBlockBinding( program, prefixBlockLoc, prefixBindPoint );
-        glUniformBlockBinding( program, suffixBlockLoc, suffixBindPoint );
+        glState.uniformBlockBinding( program, locations.prefixBlock, prefixBindPoint );
+        glState.uniformBlockBinding( program, locations.suffixBlock, suffixBindPoint );
 
-        glBindBuffer( GL_UNIFORM_BUFFER, VBOuniformBlockPrefix );
+        glState.bindBuffer( GL_UNIFORM_BUFFER, VBOuniformBlockPrefix );
         glBufferData( GL_UNIFORM_BUFFER, sizeof(GLfloat) * 2, prefixColor, GL_STATIC_DRAW );
-        glBindBuffer( GL_UNIFORM_BUFFER, VBOuniformBlockSuffix );
+        glState.bindBuffer( GL_UNIFORM_BUFFER, VBOuniformBlockSuffix );
         glBufferData( GL_UNIFORM_BUFFER, sizeof(GLfloat) * 2, suffixColor, GL_STATIC_DRAW );
 
-        // Bind buffer to NULL is ignored, but just call it.
-        glBindBuffer( GL_UNIFORM_BUFFER, NULL );
-
-        glBindBufferBase( GL_UNIFORM_BUFFER, prefixBindPoint, VBOuniformBlockPrefix );
-        glBindBufferBase( GL_UNIFORM_BUFFER, suffixBindPoint, VBOuniformBlockSuffix );
-
-        // Bind index buffer;
-        struct AIndex {
-                unsigned int a, b, c;
-        } *indicies ;
-        indicies = (AIndex*)malloc( sizeof(AIndex) * mesh.f.size() );
-        for( unsigned int index = 0U; index < mesh.f.size(); index += 1U ) {
-                indicies[ index ].a = mesh.f[ index ].verticies[ 0 ].v - 1;
-                indicies[ index ].b = mesh.f[ index ].verticies[ 1 ].v - 1;
-                indicies[ index ].c = mesh.f[ index ].verticies[ 2 ].v - 1;
-        }
-        glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, VBOelementArray );
-        glBufferData( GL_ELEMENT_ARRAY_BUFFER,
-                sizeof(AIndex) * mesh.f.size(),
-                indicies,
-                GL_STATIC_DRAW );
-
-        // Detach VAO.
-        glBindVertexArray( NULL );
+        glState.bindBufferBase( GL_UNIFORM_BUFFER, prefixBindPoint, VBOuniformBlockPrefix );
+        glState.bindBufferBase( GL_UNIFORM_BUFFER, suffixBindPoint, VBOuniformBlockSuffix );
+
+        // Physics.
+        // Every mesh spins as a free rigid body. The world is stepped at a
+        // fixed rate on its own thread; the render loop only reads the
+        // interpolated transforms and never waits for a step.
+        App::PhysicsWorld physics( PhysicsSchedulerFor( app->options() ), app->options().physicsThreads,
+                BroadphaseFor( app->options() ) );
+        // A sphere, not a PhysicsMesh of the drawn mesh: see BuildScene().
+        btSphereShape spinnerShape( 1.f );
+        std::vector< glm::vec4 > instanceColors;
+        BuildScene( &physics, &spinnerShape, &instanceColors );
+        App::PhysicsThread simulation( &physics, PHYSICS_RATE );
+        simulation.start();
+        std::vector< App::BodyTransform > bodies;
+
+        // Visible instances grouped by LOD, one instanced draw per level.
+        App::DrawList drawList;
+        drawList.setMesh( glm::value_ptr( MeshBase( bounds ) ), glm::value_ptr( bounds.center ), bounds.radius,
+                boundMesh->lods.data(), (unsigned int)boundMesh->lods.size() );
+        unsigned long long frames = 0U, drawCalls = 0U, culled = 0U, submitted = 0U;
+        const App::GLStateStats stateStart = glState.totalStats();
 
         // Run application.
         while( glfwWindowShouldClose( window ) == GLFW_FALSE ) {
+                PROFILE_SCOPE( "frame" );
+                gpuTimer.beginFrame();
+                glState.beginFrame();
                 int width, height;
-                glfwGetFramebufferSize( window, &width, &height );
-                glViewport( 0, 0, width, height );
-                glClearColor( CLEAR_COLOR );
-                glEnable( GL_DEPTH_TEST );
-                glEnable( GL_CULL_FACE );
-                glCullFace( GL_BACK );
-                glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
+                {
+                        PROFILE_SCOPE( "clear" );
+                        PROFILE_GPU_SCOPE( &gpuTimer, "clear" );
+                        glfwGetFramebufferSize( window, &width, &height );
+                        glState.viewport( 0, 0, width, height );
+                        glState.clearColor( CLEAR_COLOR );
+                        glState.enable( GL_DEPTH_TEST );
+                        glState.enable( GL_CULL_FACE );
+                        glState.cullFace( GL_BACK );
+                        glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
+                }
 
                 // Draw here.
                 //=============================================================
-                glBindVertexArray( VAOs[ 0 ] );
-
-                glm::mat4 Projection = 
-                        glm::perspectiveFov( glm::radians( 45.0f ), (float)width, (float)height, 0.1f, 100.f );
-                glm::mat4 View = glm::lookAt(
-                        glm::vec3( 0.f, 65.f, 30.f),    // camera center
-                        glm::vec3( 0.f, 50.f, 0.f ),     // camera look at
-                        glm::vec3( 0.f, 1.f, 0.f ) );   // camera up vector
-                glm::mat4 Model =
-                        glm::translate( glm::mat4( 1.f ), glm::vec3( 0.f, 50.f, 0.f ) )
-                        * glm::rotate( glm::mat4( 1.f ), (float)glm::radians( glfwGetTime()*50 ), glm::vec3( 0.f, 1.f, 0.f ) )
-                        * glm::rotate( glm::mat4( 1.f ), (float)glm::radians( -90.f), glm::vec3( 1.f, 0.f, 0.f ) )
-                        * glm::scale( glm::mat4( 1.f ), glm::vec3( 0.2f, 0.2f, 0.2f ) )
-                        * glm::translate( glm::mat4( 1.f ), glm::vec3( 0.f, 0.f, 100.f ) );
-                glm::mat4 MVP = Projection * View * Model;
-                glUniformMatrix4fv( mvpLoc, 1, GL_FALSE, glm::value_ptr(MVP) );
-
-                glPolygonMode( GL_FRONT_AND_BACK, GL_LINE );
-                glDrawElements( GL_TRIANGLES, 3 * mesh.f.size(), GL_UNSIGNED_INT, 0 );
-                glPolygonMode( GL_FRONT_AND_BACK, GL_FILL );
-                
-                glBindVertexArray( NULL );
+                glState.bindVertexArray( VAOs[ 0 ] );
+
+                // Swap in a rebuilt program; reloads of saved meshes are
+                // queued here and swapped in by the streamer.
+                {
+                        PROFILE_SCOPE( "reload" );
+                        watcher.poll( &changes );
+                        for( size_t change = 0U; change < changes.size(); change += 1U ) {
+                                const App::FileWatcher::Change& file = changes[ change ];
+                                if( file.file == vertexFile || file.file == fragmentFile ) {
+                                        reloader.request( file.time );
+                                        continue;
+                                }
+                                for( unsigned int asset = 0U; asset < ASSET_COUNT; asset += 1U ) {
+                                        if( file.file != assetFiles[ asset ] )
+                                                continue;
+                                        meshSaves[ asset ].push_back( file.time );
+                                        streamer.reload( assets[ asset ] );
+                                }
+                        }
+                        App::ProgramReload reload;
+                        while( reloader.poll( &reload ) == true ) {
+                                if( reload.program == 0U ) {
+                                        std::cout << "Warning: Shader reload failed, keeping the current program." << std::endl;
+                                        continue;
+                                }
+                                // Attribute locations may move between links.
+                                DisableAttributes( locations );
+                                glState.deleteProgram( program );
+                                program = reload.program;
+                                ResolveLocations( program, &locations );
+                                glState.useProgram( program );
+                                glState.uniformBlockBinding( program, locations.prefixBlock, prefixBindPoint );
+                                glState.uniformBlockBinding( program, locations.suffixBlock, suffixBindPoint );
+                                BindMesh( *boundMesh, pool, locations );
+                                instances.attach( locations.model, locations.instanceColor );
+                                std::cout << "Info: Shader program rebuilt in " << reload.buildSeconds * 1e3 << " ms, cache "
+                                        << App::ProgramCacheStatusName( reload.status ) << "." << std::endl;
+                                swapped.push_back( std::make_pair( std::string( "Shader program" ), reload.requested ) );
+                        }
+                }
+
+                // Upload this frame's slice of streamed meshes, then swap in
+                // the selected one once it is resident.
+                {
+                        PROFILE_SCOPE( "stream" );
+                        streamer.update();
+                        for( size_t index = 0U; index < streamer.reloads().size(); index += 1U ) {
+                                const App::AssetReload& reload = streamer.reloads()[ index ];
+                                for( unsigned int asset = 0U; asset < ASSET_COUNT; asset += 1U ) {
+                                        if( assets[ asset ] != reload.handle || meshSaves[ asset ].empty() == true )
+                                                continue;
+                                        if( reload.succeeded == true )
+                                                swapped.push_back( std::make_pair( std::string( ASSET_PATHS[ asset ] ),
+                                                        meshSaves[ asset ].front() ) );
+                                        else
+                                                std::cout << "Warning: Parse error! " << ASSET_PATHS[ asset ]
+                                                        << ", keeping the current mesh." << std::endl;
+                                        meshSaves[ asset ].pop_front();
+                                }
+                        }
+                        for( unsigned int asset = 0U; asset < ASSET_COUNT; asset += 1U ) {
+                                const App::AssetState state = streamer.state( assets[ asset ] );
+                                if( announced[ asset ] == true || ( state != App::AssetResident && state != App::AssetFailed ) )
+                                        continue;
+                                announced[ asset ] = true;
+                                if( state == App::AssetFailed ) {
+                                        std::cout << "Warning: Parse error! " << ASSET_PATHS[ asset ] << std::endl;
+                                        continue;
+                                }
+                                std::cout << "Info: " << ASSET_PATHS[ asset ] << " resident after " << frames << " frames, "
+                                        << std::chrono::duration< double, std::milli >(
+                                                App::PhysicsThread::Clock::now() - streamStart ).count() << " ms." << std::endl;
+                        }
+                        // Uploads may have rebuilt the pool into new buffers.
+                        const App::MeshResource& mesh = streamer.resource( assets[ selectedAsset ] );
+                        const unsigned int version = streamer.version( assets[ selectedAsset ] );
+                        if( mesh.poolMesh != App::GeometryPool::INVALID && pool.generation() != boundGeneration ) {
+                                boundGeneration = pool.generation();
+                                BindMesh( mesh, pool, locations );
+                        }
+                        if( &mesh != boundMesh || version != boundVersion ) {
+                                boundMesh = &mesh;
+                                boundVersion = version;
+                                BindMesh( mesh, pool, locations );
+                                bounds = FitBounds( mesh.volume );
+                                drawList.setMesh( glm::value_ptr( MeshBase( bounds ) ), glm::value_ptr( bounds.center ),
+                                        bounds.radius, mesh.lods.data(), (unsigned int)mesh.lods.size() );
+                        }
+                }
+
+                glm::mat4 Projection, View;
+                {
+                        PROFILE_SCOPE( "matrices" );
+                        CameraMatrices( width, height, &View, &Projection );
+                        glm::mat4 ViewProjection = Projection * View;
+                        glUniformMatrix4fv( locations.viewProjection, 1, GL_FALSE, glm::value_ptr(ViewProjection) );
+                }
+
+                // Compose model matrices, cull against the frustum and select
+                // a LOD for each body by its projected size.
+                {
+                        PROFILE_SCOPE( "draw_list" );
+                        if( simulation.read( App::PhysicsThread::Clock::now(), &bodies ) == false )
+                                bodies.clear();
+                        const unsigned int bodyCount = std::min( (unsigned int)bodies.size(), instanceCount );
+                        drawList.setCamera( glm::value_ptr( View ), glm::value_ptr( Projection ), (float)height, LOD_TOLERANCE );
+                        drawList.transform( bodies.empty() ? NULL : bodies[ 0 ].position,
+                                bodies.empty() ? NULL : bodies[ 0 ].rotation, sizeof(App::BodyTransform),
+                                glm::value_ptr( instanceColors[ 0 ] ), bodyCount );
+                        drawList.cull();
+                        drawList.build();
+                        culled += drawList.cullStats().culled;
+                        submitted += drawList.cullStats().submitted;
+                }
+
+                // One sequential copy into the mapped region. Mapped memory
+                // is write-combined: write it sequentially, never read it.
+                App::AInstance* mapped = NULL;
+                {
+                        PROFILE_SCOPE( "upload" );
+                        mapped = instances.begin();
+                        if( mapped != NULL && drawList.visibleCount() > 0U )
+                                std::memcpy( mapped, drawList.instances(), sizeof(App::AInstance) * drawList.visibleCount() );
+                }
+
+                {
+                        PROFILE_SCOPE( "draw" );
+                        PROFILE_GPU_SCOPE( &gpuTimer, "draw" );
+                        glState.polygonMode( GL_LINE );
+                        if( boundMesh->poolMesh != App::GeometryPool::INVALID ) {
+                                commands.clear();
+                                for( size_t range = 0U; mapped != NULL && range < drawList.ranges().size(); range += 1U ) {
+                                        const App::DrawRange& draw = drawList.ranges()[ range ];
+                                        const MeshLod& lod = boundMesh->lods[ draw.lod ];
+                                        pool.appendCommand( boundMesh->poolMesh, draw.instanceCount, draw.firstInstance,
+                                                &commands, lod.firstFace, lod.faceCount );
+                                }
+                                pool.draw( commands, &instances );
+                                if( commands.empty() == false )
+                                        drawCalls += pool.indirect() ? 1U : commands.size();
+                        }
+                        else {
+                                for( size_t range = 0U; mapped != NULL && range < drawList.ranges().size(); range += 1U ) {
+                                        const App::DrawRange& draw = drawList.ranges()[ range ];
+                                        const MeshLod& lod = boundMesh->lods[ draw.lod ];
+                                        instances.bind( draw.firstInstance );
+                                        glDrawElementsInstanced( GL_TRIANGLES, 3 * lod.faceCount, boundMesh->indexType,
+                                                (GLvoid*)( (size_t)3U * boundMesh->indexSize * lod.firstFace ), draw.instanceCount );
+                                        drawCalls += 1U;
+                                }
+                        }
+                        instances.end();
+                }
+                frames += 1U;
                 //=============================================================
 
-                glDisable( GL_CULL_FACE );
-                glDisable( GL_DEPTH_TEST );
-                glfwSwapBuffers( window );
-                glfwPollEvents();
+                {
+                        PROFILE_SCOPE( "swap" );
+                        glfwSwapBuffers( window );
+                }
+                // Save to the first frame drawn with the new version.
+                for( size_t reload = 0U; reload < swapped.size(); reload += 1U ) {
+                        std::cout << "Info: " << swapped[ reload ].first << " reloaded, "
+                                << std::chrono::duration< double, std::milli >(
+                                        App::FileWatcher::Clock::now() - swapped[ reload ].second ).count()
+                                << " ms from save to first frame." << std::endl;
+                }
+                swapped.clear();
+                {
+                        PROFILE_SCOPE( "poll" );
+                        glfwPollEvents();
+                }
+        }
+
+        simulation.stop();
+        // One glDrawElements and one glUniformMatrix4fv per body without
+        // instancing.
+        if( frames > 0U ) {
+                std::cout << "Info: " << (double)drawCalls / frames << " draw calls per frame for "
+                        << instanceCount << " bodies, " << instances.stalls() << " fence stalls." << std::endl;
+                std::cout << "Info: " << (double)submitted / frames << " bodies submitted and "
+                        << (double)culled / frames << " culled per frame." << std::endl;
+                const App::GLStateStats& stateEnd = glState.totalStats();
+                std::cout << "Info: " << (double)( stateEnd.issued - stateStart.issued ) / frames
+                        << " GL state calls issued and " << (double)( stateEnd.skipped - stateStart.skipped ) / frames
+                        << " skipped per frame." << std::endl;
         }
+        watcher.stop();
+        reloader.release();
+        if( reloadContext != NULL )
+                glfwDestroyWindow( reloadContext );
+        instances.release();
+        gpuTimer.release();
+        streamer.release();
+        pool.release();
+        if( PROFILE_WRITE_TRACE( PROFILE_TRACE ) == true )
+                std::cout << "Info: Profile written to " << PROFILE_TRACE << std::endl;
 
         // Destroy unuse objects.
-        glDeleteBuffers( 1, VBOs );
-        glDeleteVertexArrays( 1, VAOs );
-        glDeleteShader( vertex_shader );
-        glDeleteShader( fragment_shader );
-        glDeleteProgram( program );
+        glState.deleteBuffers( 2, VBOs );
+        glState.deleteVertexArrays( 1, VAOs );
+        glState.deleteProgram( program );
 
         glfwDestroyWindow(window);
 
@@ -280,95 +583,254 @@ static void key_callback( GLFWwindow* window,
                 || key == GLFW_KEY_SPACE )
                 && action == GLFW_PRESS )
                 glfwSetWindowShouldClose( window, GLFW_TRUE );
+        else if( key == GLFW_KEY_P && action == GLFW_PRESS ) {
+                if( PROFILE_WRITE_TRACE( PROFILE_TRACE ) == true )
+                        std::cout << "Info: Profile written to " << PROFILE_TRACE << std::endl;
+                else
+                        std::cout << "Warning: Profiling is not compiled in." << std::endl;
+        }
+        else if( key >= GLFW_KEY_1 && key < GLFW_KEY_1 + (int)ASSET_COUNT && action == GLFW_PRESS )
+                selectedAsset = (unsigned int)( key - GLFW_KEY_1 );
         else
                 std::cout
                         << "Warning: Not implemented." << std::endl;
 }
 
 
-void LoadShaderCode( char** out_shaderCode, unsigned int* out_length, const char* in_fileName ) {
-        if( FileExist( in_fileName ) == false ) {
-                std::cout
-                        << "Error: File not exist, " << in_fileName << std::endl;
+// Object space to body space: meshes are modeled Z-up. The bounding sphere
+// is centered on the body and scaled to BODY_RADIUS.
+static glm::mat4 MeshBase( const MeshBounds& in_bounds ) {
+        const float scale = in_bounds.radius > 0.f ? BODY_RADIUS / in_bounds.radius : 1.f;
+        return glm::rotate( glm::mat4( 1.f ), (float)glm::radians( -90.f), glm::vec3( 1.f, 0.f, 0.f ) )
+                * glm::scale( glm::mat4( 1.f ), glm::vec3( scale, scale, scale ) )
+                * glm::translate( glm::mat4( 1.f ), -in_bounds.center );
+}
+
+// Bounding sphere measured at load, in object space.
+static MeshBounds FitBounds( const MeshVolume& in_volume ) {
+        MeshBounds bounds;
+        bounds.center = glm::make_vec3( in_volume.center );
+        bounds.radius = in_volume.radius;
+        return bounds;
+}
+
+static void ResolveLocations( const GLuint in_program, ProgramLocations* out_locations ) {
+        out_locations->position = glGetAttribLocation( in_program, "in_position" );
+        out_locations->color = glGetAttribLocation( in_program, "in_color" );
+        out_locations->model = glGetAttribLocation( in_program, "in_model" );
+        out_locations->instanceColor = glGetAttribLocation( in_program, "in_instanceColor" );
+        out_locations->viewProjection = glGetUniformLocation( in_program, "in_viewProjection" );
+        out_locations->positionOffset = glGetUniformLocation( in_program, "in_positionOffset" );
+        out_locations->positionScale = glGetUniformLocation( in_program, "in_positionScale" );
+        out_locations->prefixBlock = glGetUniformBlockIndex( in_program, "ColorPrefix" );
+        out_locations->suffixBlock = glGetUniformBlockIndex( in_program, "ColorSuffix" );
+}
+
+// Disable the arrays of the bound VAO enabled for in_locations.
+static void DisableAttributes( const ProgramLocations& in_locations ) {
+        glDisableVertexAttribArray( in_locations.position );
+        glDisableVertexAttribArray( in_locations.color );
+        for( GLuint column = 0U; column < 4U; column += 1U )
+                glDisableVertexAttribArray( in_locations.model + column );
+        glDisableVertexAttribArray( in_locations.instanceColor );
+}
+
+// Point the bound VAO at the vertex, color and index buffers of in_mesh, the
+// pool's when it lives there, and load its position decode.
+static void BindMesh( const App::MeshResource& in_mesh, const App::GeometryPool& in_pool,
+        const ProgramLocations& in_locations ) {
+        glUniform3fv( in_locations.positionOffset, 1, in_mesh.decode.offset );
+        glUniform3fv( in_locations.positionScale, 1, in_mesh.decode.scale );
+        if( in_mesh.poolMesh != App::GeometryPool::INVALID ) {
+                in_pool.bind( in_locations.position, in_locations.color );
                 return;
         }
-        std::ifstream file( in_fileName );
-        std::string result, input;
-        while( std::getline( file, input ) ) {
-                result += input + "\n";
+        App::GLState& glState = App::GetGLState();
+        glState.bindBuffer( GL_ARRAY_BUFFER, in_mesh.vertexBuffer );
+        glVertexAttribPointer( in_locations.position, 4, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(PVertex), (GLvoid*) 0 );
+        glEnableVertexAttribArray( in_locations.position );
+        glState.bindBuffer( GL_ARRAY_BUFFER, in_mesh.colorBuffer );
+        glVertexAttribPointer( in_locations.color, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(PColor), (GLvoid*) 0 );
+        glEnableVertexAttribArray( in_locations.color );
+        glState.bindBuffer( GL_ELEMENT_ARRAY_BUFFER, in_mesh.indexBuffer );
+}
+
+// One thread needs no scheduler. Falls back to one thread, with a warning,
+// when Bullet was built without the one asked for.
+static App::PhysicsScheduler PhysicsSchedulerFor( const App::RunOptions& in_options ) {
+        if( in_options.physicsThreads == 1U )
+                return App::SchedulerNone;
+        const App::PhysicsScheduler scheduler = in_options.physicsOpenMP == true ? App::SchedulerOpenMP : App::SchedulerPool;
+        if( App::PhysicsSchedulerAvailable( scheduler ) == false ) {
+                std::cerr << "Warning: Bullet was built without " << ( in_options.physicsOpenMP == true ? "OpenMP" : "threads" )
+                        << "; physics runs on one thread." << std::endl;
+                return App::SchedulerNone;
         }
-        *out_length = result.length();
-        *out_shaderCode = (char*) malloc( sizeof(char) * ( *out_length + 1) );
-        std::strcpy( *out_shaderCode, result.c_str() );
+        return scheduler;
 }
 
-GLuint LoadShader( GLenum type, const char* shaderCode ) {
-        GLuint shader;
-        GLint compiled;
+// Sweep and prune gets the arena of the grid BuildScene() fills, the hash
+// cells as wide as a spinner. Unknown names keep the tree, with a warning.
+static App::BroadphaseOptions BroadphaseFor( const App::RunOptions& in_options ) {
+        App::BroadphaseOptions broadphase;
+        const std::string& name = in_options.physicsBroadphase;
+        if( name == "sweep" )
+                broadphase.type = App::BroadphaseSweep;
+        else if( name == "sweep32" )
+                broadphase.type = App::BroadphaseSweep32;
+        else if( name == "hash" )
+                broadphase.type = App::BroadphaseHash;
+        else if( name != "tree" )
+                std::cerr << "Warning: Unknown broadphase " << name << "; using the tree." << std::endl;
+        const btScalar extent = 0.5f * INSTANCE_GRID * BODY_SPACING;
+        broadphase.worldMin[ 0 ] = -extent;
+        broadphase.worldMin[ 1 ] = 0.f;
+        broadphase.worldMin[ 2 ] = -2.f * extent;
+        broadphase.worldMax[ 0 ] = extent;
+        broadphase.worldMax[ 1 ] = 100.f;
+        broadphase.worldMax[ 2 ] = BODY_SPACING;
+        broadphase.maxProxies = INSTANCE_GRID * INSTANCE_GRID;
+        broadphase.cellSize = 2.f;     // Spinner spheres have a radius of one.
+        return broadphase;
+}
 
-        shader = glCreateShader( type );
-        if( shader == 0U )
-                return 0U;
-        
-        glShaderSource( shader, 1, &shaderCode, NULL );
-        glCompileShader( shader );
-        glGetShaderiv( shader, GL_COMPILE_STATUS, &compiled );
-
-        if( compiled == GLFW_FALSE ) {
-                GLint infoLen = 0;
-
-                glGetShaderiv( shader, GL_INFO_LOG_LENGTH, &infoLen );
-                if( infoLen > 1 ) {
-                        char* infoLog
-                                = (char*)malloc( sizeof(char) * infoLen );
-
-                        glGetShaderInfoLog(
-                                shader,
-                                infoLen,
-                                NULL,
-                                infoLog );
-                        std::cout
-                                << infoLog;
-
-                        free( infoLog );
+// A square grid of spinning bodies that starts in front of the camera and
+// runs away from it. Spinners have no gravity and never touch, so their
+// shape only sets their inertia, and a sphere does. They are drawn with
+// whichever asset is selected and reloaded at run time, whose MeshBuffer
+// the streamer releases once packed; a PhysicsMesh needs its MeshBuffer
+// for as long as the shape lives, so it is not used here.
+static void BuildScene( App::PhysicsWorld* io_physics, btCollisionShape* in_shape,
+        std::vector< glm::vec4 >* out_colors ) {
+        out_colors->clear();
+        for( unsigned int row = 0U; row < INSTANCE_GRID; row += 1U ) {
+                for( unsigned int column = 0U; column < INSTANCE_GRID; column += 1U ) {
+                        const float u = column / (float)( INSTANCE_GRID - 1U ),
+                                v = row / (float)( INSTANCE_GRID - 1U );
+                        btTransform spinnerStart;
+                        spinnerStart.setIdentity();
+                        spinnerStart.setOrigin( btVector3(
+                                ( column - 0.5f * ( INSTANCE_GRID - 1U ) ) * BODY_SPACING, 50.f, -( row * BODY_SPACING ) ) );
+                        btRigidBody* spinner = io_physics->addBody( in_shape, 1.f, spinnerStart );
+                        spinner->setGravity( btVector3( 0.f, 0.f, 0.f ) );
+                        spinner->setDamping( 0.f, 0.f );
+                        spinner->setAngularVelocity(
+                                btVector3( 0.f, glm::radians( 50.f * ( 0.5f + u ) ), 0.f ) );
+                        spinner->setActivationState( DISABLE_DEACTIVATION );
+                        out_colors->push_back( glm::vec4( 0.5f + 0.5f * u, 0.5f + 0.5f * v, 1.f, 1.f ) );
                 }
-                glDeleteShader( shader );
-                return 0U;
         }
-        return shader;
 }
-GLuint LinkProgram( GLuint vertexShader, GLuint fragmentShader ) {
-        GLuint program;
-        GLint linked;
 
-        program = glCreateProgram();
-        if( program == 0U ) {
-                glfwTerminate();
-                exit( EXIT_FAILURE );
+static void CameraMatrices( const int in_width, const int in_height,
+        glm::mat4* out_view, glm::mat4* out_projection ) {
+        *out_projection = glm::perspectiveFov( glm::radians( 45.0f ), (float)in_width, (float)in_height, 0.1f,
+                100.f + INSTANCE_GRID * BODY_SPACING );
+        *out_view = glm::lookAt(
+                glm::vec3( 0.f, 65.f, 30.f),    // camera center
+                glm::vec3( 0.f, 50.f, 0.f ),     // camera look at
+                glm::vec3( 0.f, 1.f, 0.f ) );   // camera up vector
+}
+
+/*
+Run the CPU side of the frame pipeline for in_options.frames frames without
+a window: mesh loading, a fixed physics step, then transform, cull and
+draw-list building. Loads from the OBJ text and from the binary cache are
+separate stages, so neither skews the other's percentiles. Per-stage timings are written as JSON to
+in_options.report, or to stdout. Physics is stepped inline so every run
+does the same work.
+*/
+static void RunHeadless( const App::RunOptions& in_options ) {
+        App::FrameStats stats;
+        const unsigned int textLoadStage = stats.addStage( "mesh_load_text" ),
+                cachedLoadStage = stats.addStage( "mesh_load_cached" ),
+                physicsStage = stats.addStage( "physics_step" ),
+                transformStage = stats.addStage( "transform" ),
+                cullStage = stats.addStage( "cull" ),
+                drawListStage = stats.addStage( "draw_list" ),
+                frameStage = stats.addStage( "frame" );
+
+        App::MeshBuffer mesh;
+        for( unsigned int load = 0U; load < HEADLESS_LOADS; load += 1U ) {
+                App::StageTimer timer( &stats, textLoadStage );
+                if( mesh.load( MESH_PATH, false ) == false ) {
+                        std::cerr << "Error: Parse error! " << MESH_PATH << std::endl;
+                        exit( EXIT_FAILURE );
+                }
+        }
+        // An untimed load writes the cache when it is missing or stale.
+        mesh.load( MESH_PATH );
+        for( unsigned int load = 0U; load < HEADLESS_LOADS; load += 1U ) {
+                App::StageTimer timer( &stats, cachedLoadStage );
+                if( mesh.load( MESH_PATH ) == false ) {
+                        std::cerr << "Error: Parse error! " << MESH_PATH << std::endl;
+                        exit( EXIT_FAILURE );
+                }
+        }
+        const MeshBounds bounds = FitBounds( mesh.volume() );
+
+        App::PhysicsWorld physics( PhysicsSchedulerFor( in_options ), in_options.physicsThreads,
+                BroadphaseFor( in_options ) );
+        // A sphere, not a PhysicsMesh of the drawn mesh: see BuildScene().
+        btSphereShape spinnerShape( 1.f );
+        std::vector< glm::vec4 > instanceColors;
+        BuildScene( &physics, &spinnerShape, &instanceColors );
+        std::vector< App::BodyTransform > bodies;
+
+        const int width = (int)App::DEFAULT_CONFIG.getWidth(), height = (int)App::DEFAULT_CONFIG.getHeight();
+        glm::mat4 Projection, View;
+        CameraMatrices( width, height, &View, &Projection );
+        App::DrawList drawList;
+        drawList.setMesh( glm::value_ptr( MeshBase( bounds ) ), glm::value_ptr( bounds.center ), bounds.radius,
+                mesh.lods(), mesh.lodCount() );
+        drawList.setCamera( glm::value_ptr( View ), glm::value_ptr( Projection ), (float)height, LOD_TOLERANCE );
+
+        unsigned long long visible = 0U, drawCalls = 0U, nodes = 0U, tested = 0U, culled = 0U;
+        for( unsigned int frame = 0U; frame < in_options.frames; frame += 1U ) {
+                App::StageTimer frameTimer( &stats, frameStage );
+                {
+                        App::StageTimer timer( &stats, physicsStage );
+                        physics.step( (btScalar)( 1.0 / PHYSICS_RATE ) );
+                        physics.readTransforms( &bodies );
+                }
+                {
+                        App::StageTimer timer( &stats, transformStage );
+                        drawList.transform( bodies[ 0 ].position, bodies[ 0 ].rotation, sizeof(App::BodyTransform),
+                                glm::value_ptr( instanceColors[ 0 ] ), (unsigned int)bodies.size() );
+                }
+                {
+                        App::StageTimer timer( &stats, cullStage );
+                        drawList.cull();
+                }
+                {
+                        App::StageTimer timer( &stats, drawListStage );
+                        drawList.build();
+                }
+                visible += drawList.visibleCount();
+                drawCalls += drawList.ranges().size();
+                nodes += drawList.cullStats().nodes;
+                tested += drawList.cullStats().tested;
+                culled += drawList.cullStats().culled;
         }
-        glAttachShader( program, vertexShader );
-        glAttachShader( program, fragmentShader );
-        glLinkProgram( program );
-        glGetProgramiv( program, GL_LINK_STATUS, &linked );
-
-        if( linked == GLFW_FALSE ) {
-                GLint infoLen = 0;
-                
-                glGetProgramiv( program, GL_INFO_LOG_LENGTH, &infoLen );
-                if( infoLen > 1 ) {
-                        char* infoLog 
-                                = (char*)malloc( sizeof(char) * infoLen );
-
-                        glGetProgramInfoLog(
-                                program,
-                                infoLen,
-                                NULL,
-                                infoLog );
-                        std::cout
-                                << infoLog;
+
+        stats.setInfo( "frames", in_options.frames );
+        stats.setInfo( "physics_threads", physics.threadCount() );
+        stats.setInfo( "bodies", (double)bodies.size() );
+        stats.setInfo( "mesh_faces", mesh.lodCount() > 0U ? mesh.lods()[ 0 ].faceCount : 0U );
+        stats.setInfo( "mesh_cached", mesh.cached() ? 1.0 : 0.0 );
+        stats.setInfo( "visible_per_frame", (double)visible / in_options.frames );
+        stats.setInfo( "cull_nodes_per_frame", (double)nodes / in_options.frames );
+        stats.setInfo( "cull_tested_per_frame", (double)tested / in_options.frames );
+        stats.setInfo( "culled_per_frame", (double)culled / in_options.frames );
+        stats.setInfo( "draw_calls_per_frame", (double)drawCalls / in_options.frames );
+        if( in_options.report.empty() == true ) {
+                stats.writeJson( std::cout );
+        } else {
+                std::ofstream report( in_options.report.c_str() );
+                stats.writeJson( report );
+                if( report.good() == false ) {
+                        std::cerr << "Error: Cannot write " << in_options.report << std::endl;
+                        exit( EXIT_FAILURE );
                 }
-                glDeleteProgram( program );
-                return 0U;
         }
-        return program;
-}
\ No newline at end of file
+}
@@ -1,12 +1,21 @@
 #version 330 core
-in vec3 in_position;
+// Normalized 16-bit offset into the mesh's bounding box; w reads 1.
+in vec4 in_position;
+// Normalized RGBA8.
 in vec4 in_color;
+// Per-instance attributes, advanced once per instance.
+in mat4 in_model;
+in vec4 in_instanceColor;
 
 out vec4 o_color;
 
-uniform mat4x4 in_mvp;
+uniform mat4x4 in_viewProjection;
+// Object position = in_positionOffset + in_positionScale * in_position.xyz
+uniform vec3 in_positionOffset;
+uniform vec3 in_positionScale;
 
 void main () {
-    gl_Position = in_mvp * vec4( in_position.xyz, 1.0 );
-    o_color = in_color;
+    vec3 position = in_positionOffset + in_positionScale * in_position.xyz;
+    gl_Position = in_viewProjection * in_model * vec4( position, 1.0 );
+    o_color = in_color * in_instanceColor;
 }
\ No newline at end of file
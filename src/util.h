@@ -25,14 +25,14 @@ struct Mesh {
     std::vector< Face > f;
 };
 
-static bool FileExist( const char* in_fileName ) {
+inline bool FileExist( const char* in_fileName ) {
         std::ifstream file( in_fileName );
         return file.good();
 }
 enum ObjectFormat {
     v, vn, vt, f, comment, unknown
 };
-static ObjectFormat FormatResolve( std::string const& str ) {
+inline ObjectFormat FormatResolve( std::string const& str ) {
     if( str == "v" ) return ::v;
     else if( str == "vn" ) return ::vn;
     else if( str == "vt" ) return ::vt;
@@ -40,7 +40,7 @@ static ObjectFormat FormatResolve( std::string const& str ) {
     else if( str == "#" ) return ::comment;
     else return ::unknown;
 }
-static bool FileLoadMesh( const char* in_fileName, Mesh* out_mesh ) {
+inline bool FileLoadMesh( const char* in_fileName, Mesh* out_mesh ) {
     if( FileExist( in_fileName ) == false ) {
         return false;
     }
@@ -92,10 +92,12 @@ static bool FileLoadMesh( const char* in_fileName, Mesh* out_mesh ) {
             break;
 
             case ::f : {
-                Face face;
+                // OBJ orders vertex references as v/vt/vn.
+                static const unsigned int slot[ 3 ] = { 0U, 2U, 1U };
+                Face face = Face();
                 unsigned int* ref = reinterpret_cast<unsigned int*>( &face );
                 unsigned int w = 0U;
-                while( iss ) {
+                while( iss && w < 3U ) {
                     std::string vertex;
                     std::string delimiter = "/";
                     size_t pos = 0;
@@ -103,13 +105,14 @@ static bool FileLoadMesh( const char* in_fileName, Mesh* out_mesh ) {
                     unsigned int ww = 0U;
 
                     iss >> vertex;
-                    while( (pos = vertex.find( delimiter )) != std::string::npos ) {
+                    while( (pos = vertex.find( delimiter )) != std::string::npos
+                        && ww < 2U ) {
                         token = vertex.substr( 0, pos );
                         vertex.erase( 0, pos + delimiter.length() );
-                        ref[ 3*w + ww ] = (unsigned int)atoi( token.c_str() );
+                        ref[ 3*w + slot[ ww ] ] = (unsigned int)atoi( token.c_str() );
                         ww += 1U;
                     }
-                    ref[ 3*w + ww ] = (unsigned int)atoi( vertex.c_str() );
+                    ref[ 3*w + slot[ ww ] ] = (unsigned int)atoi( vertex.c_str() );
                     w += 1U;
                 }
                 out_mesh->f.push_back( face );